@@ -0,0 +1,80 @@
+#ifndef ARITHMETIC_H
+#define ARITHMETIC_H
+
+#include <stdint.h>
+
+// Prismatic arithmetic, shared by every phase that evaluates expressions so
+// that folding at compile time and running the program always agree.
+// int is 32-bit two's complement and wraps on overflow; float is a double.
+
+static inline int32_t intAdd(int32_t a, int32_t b) { return (int32_t)((uint32_t)a + (uint32_t)b); }
+static inline int32_t intSub(int32_t a, int32_t b) { return (int32_t)((uint32_t)a - (uint32_t)b); }
+static inline int32_t intMul(int32_t a, int32_t b) { return (int32_t)((uint32_t)a * (uint32_t)b); }
+static inline int32_t intNeg(int32_t a) { return (int32_t)(0u - (uint32_t)a); }
+
+// Function to read a decimal int literal ("-" allowed), wrapping like arithmetic does
+static inline int32_t intFromText(const char* text) {
+    int negative = (*text == '-');
+    if (negative) text++;
+    uint32_t value = 0;
+    for (; *text >= '0' && *text <= '9'; text++) {
+        value = value * 10u + (uint32_t)(*text - '0');
+    }
+    return negative ? intNeg((int32_t)value) : (int32_t)value;
+}
+
+// `//`: quotient rounded toward negative infinity (b != 0)
+static inline int32_t intFloorDiv(int32_t a, int32_t b) {
+    if (b == -1) return intNeg(a); // INT32_MIN // -1 wraps instead of trapping
+    int32_t quotient = a / b;
+    if (a % b != 0 && ((a < 0) != (b < 0))) quotient--;
+    return quotient;
+}
+
+// `%`: remainder with the sign of the divisor, so a == (a // b) * b + a % b (b != 0)
+static inline int32_t intMod(int32_t a, int32_t b) {
+    if (b == -1) return 0;
+    int32_t remainder = a % b;
+    if (remainder != 0 && ((remainder < 0) != (b < 0))) remainder += b;
+    return remainder;
+}
+
+// `^` on ints: exponentiation by squaring, wrapping like `*`.
+// A negative exponent gives the reciprocal truncated toward zero.
+static inline int32_t intPow(int32_t base, int32_t exponent) {
+    if (exponent < 0) {
+        if (base == 1) return 1;
+        if (base == -1) return (exponent & 1) ? -1 : 1;
+        return 0;
+    }
+    uint32_t result = 1, factor = (uint32_t)base;
+    for (uint32_t n = (uint32_t)exponent; n; n >>= 1) {
+        if (n & 1) result *= factor;
+        factor *= factor;
+    }
+    return (int32_t)result;
+}
+
+// `^` with a float base (the exponent is always an int)
+static inline double floatPow(double base, int32_t exponent) {
+    double result = 1.0, factor = base;
+    uint32_t n = exponent < 0 ? 0u - (uint32_t)exponent : (uint32_t)exponent;
+    for (; n; n >>= 1) {
+        if (n & 1) result *= factor;
+        factor *= factor;
+    }
+    return exponent < 0 ? 1.0 / result : result;
+}
+
+// FNV-1a over a string's bytes: the bucket a string switch looks in, computed when
+// the cases are laid out and again for the value being switched on
+static inline uint32_t stringHash(const char* text) {
+    uint32_t hash = 2166136261u;
+    for (; *text; text++) {
+        hash ^= (unsigned char)*text;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+#endif // ARITHMETIC_H
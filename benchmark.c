@@ -0,0 +1,3059 @@
+#include "benchmark.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "incremental_lexer.h"
+#include "incremental_parser.h"
+#include "syntax_analyzer.h"
+#include "symbol_table.h"
+#include "type_checker.h"
+#include "constant_folder.h"
+#include "cfg.h"
+#include "bounds_check.h"
+#include "loop_vectorizer.h"
+#include "loop_optimizer.h"
+#include "value_numbering.h"
+#include "dead_code.h"
+#include "register_allocator.h"
+#include "bytecode.h"
+#include "vm.h"
+#include "c_emitter.h"
+#include "jit.h"
+#include "arithmetic.h"
+#include "value.h"
+#include "format.h"
+#include "vector_kernels.h"
+#include "dataflow.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <time.h>
+#endif
+
+// Function to read a monotonic high-resolution clock
+double benchmarkNow(void) {
+#ifdef _WIN32
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    if (frequency.QuadPart == 0) {
+        QueryPerformanceFrequency(&frequency);
+    }
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+#endif
+}
+
+// ---------------------------------------
+// Synthetic source generation
+// ---------------------------------------
+
+typedef struct {
+    char* text;
+    size_t length;
+    size_t capacity;
+} TextBuilder;
+
+static void appendText(TextBuilder* builder, const char* text) {
+    size_t length = strlen(text);
+    if (builder->length + length + 1 > builder->capacity) {
+        builder->capacity = (builder->capacity + length + 1) * 2;
+        builder->text = (char*)realloc(builder->text, builder->capacity);
+        if (!builder->text) {
+            fprintf(stderr, "Error: Memory allocation failed for benchmark source.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    memcpy(builder->text + builder->length, text, length + 1);
+    builder->length += length;
+}
+
+// Function to build a program of roughly `lines` lines mixing the statement forms
+static TextBuilder generateProgram(int lines) {
+    TextBuilder builder = {NULL, 0, 0};
+    char line[128];
+    int written = 0;
+    for (int i = 0; written < lines; i++) {
+        switch (i % 6) {
+            case 0:
+                snprintf(line, sizeof(line), "int value%d = %d;\n", i, i % 97);
+                written += 1;
+                break;
+            case 1:
+                snprintf(line, sizeof(line), "value%d = value%d * 2 + %d;\n", i - 1, i - 1, i % 13);
+                written += 1;
+                break;
+            case 2:
+                snprintf(line, sizeof(line), "~~ running total %d\n", i);
+                written += 1;
+                break;
+            case 3:
+                snprintf(line, sizeof(line), "for (int i = 0; i < %d; i++) {\n    printf(\"%%d\", i);\n}\n", i % 50);
+                written += 3;
+                break;
+            case 4:
+                snprintf(line, sizeof(line), "if (value%d > %d) {\n    printf(\"big\");\n}\n", i - 4, i % 31);
+                written += 3;
+                break;
+            default:
+                snprintf(line, sizeof(line), "~/ block comment %d\n   spanning lines /~\n", i);
+                written += 2;
+                break;
+        }
+        appendText(&builder, line);
+    }
+    return builder;
+}
+
+// Function to build a program of roughly `lines` lines made of large loop bodies
+static TextBuilder generateNestedProgram(int lines) {
+    TextBuilder builder = {NULL, 0, 0};
+    char line[128];
+    int written = 0;
+    for (int i = 0; written < lines; i++) {
+        snprintf(line, sizeof(line), "int total%d = 0;\nfor (int i = 0; i < %d; i++) {\n", i, 10 + i % 90);
+        appendText(&builder, line);
+        for (int j = 0; j < 8; j++) {
+            snprintf(line, sizeof(line), "    total%d = total%d + i * %d;\n", i, i, j + 1);
+            appendText(&builder, line);
+        }
+        snprintf(line, sizeof(line), "    if (total%d > %d) {\n        printf(\"%%d\", total%d);\n", i, 100 + i, i);
+        appendText(&builder, line);
+        for (int j = 0; j < 6; j++) {
+            snprintf(line, sizeof(line), "        total%d = total%d - %d;\n", i, i, j + 2);
+            appendText(&builder, line);
+        }
+        appendText(&builder, "    }\n}\n");
+        written += 20;
+    }
+    return builder;
+}
+
+// Function to build a program of roughly `lines` lines mixing int and float arithmetic.
+// Every `errorEvery`-th group also contains two type errors (0 = none).
+static TextBuilder generateTypedProgram(int lines, int errorEvery, int* expectedErrors) {
+    TextBuilder builder = {NULL, 0, 0};
+    char line[512];
+    int written = 0;
+    *expectedErrors = 0;
+    for (int i = 0; written < lines; i++) {
+        snprintf(line, sizeof(line),
+                 "int count%d = %d;\n"
+                 "float ratio%d = count%d / 4;\n"
+                 "float mixed%d = ratio%d * 2 + count%d;\n"
+                 "int half%d = count%d // 2 %% 7;\n"
+                 "int power%d = count%d ^ 2;\n"
+                 "if (ratio%d > count%d) {\n    ratio%d += 1;\n}\n"
+                 "for (int k = 0; k < count%d; k++) {\n    mixed%d -= k;\n}\n",
+                 i, i % 89, i, i, i, i, i, i, i, i, i, i, i, i, i, i);
+        appendText(&builder, line);
+        written += 11;
+
+        if (errorEvery && i % errorEvery == 0) {
+            snprintf(line, sizeof(line),
+                     "string label%d = \"total\";\nlabel%d //= 2;\nhalf%d = ratio%d;\n", i, i, i, i);
+            appendText(&builder, line);
+            written += 3;
+            *expectedErrors += 2;
+        }
+    }
+    return builder;
+}
+
+// ---------------------------------------
+// Benchmarks
+// ---------------------------------------
+
+// Function to compare an incrementally maintained stream with a fresh lex
+static int sameTokens(LexedSource* a, LexedSource* b) {
+    if (a->tokenCount != b->tokenCount) {
+        printf("  token count differs: %d vs %d\n", a->tokenCount, b->tokenCount);
+        return 0;
+    }
+    const Token* aTokens = lexedTokens(a);
+    const Token* bTokens = lexedTokens(b);
+    for (int i = 0; i < a->tokenCount; i++) {
+        const Token* x = &aTokens[i];
+        const Token* y = &bTokens[i];
+        if (strcmp(x->type, y->type) != 0 || strcmp(x->value, y->value) != 0 ||
+            x->lineNumber != y->lineNumber || x->column != y->column) {
+            printf("  token %d differs: %s '%s' %d:%d vs %s '%s' %d:%d\n", i,
+                   x->type, x->value, x->lineNumber, x->column,
+                   y->type, y->value, y->lineNumber, y->column);
+            return 0;
+        }
+    }
+    for (int i = 0; i <= a->source->lineCount; i++) {
+        if (a->lineFirstToken[i] != b->lineFirstToken[i] || a->lineEntryState[i] != b->lineEntryState[i]) {
+            printf("  line table differs at line %d\n", i + 1);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// An edit that re-lexes at most two lines must stay well below the cost of
+// shifting the token tail (3-28 ms for edits near the top of this file); the
+// source map still splices its text and line index, which is most of what
+// such an edit costs now
+#define RELEX_LOCAL_LINES 1
+#define RELEX_LOCAL_BOUND 2e-3
+
+// Function to time one relexEdit
+static double timeEdit(LexedSource* lexed, size_t offset, size_t deleted,
+                       const char* inserted, size_t insertedLength, TokenEdit* edit) {
+    double start = benchmarkNow();
+    relexEdit(lexed, offset, deleted, inserted, insertedLength, edit);
+    return benchmarkNow() - start;
+}
+
+// Random single-keystroke edits against a 100K-line file
+static int benchmarkRelex(void) {
+    const int lines = 100000;
+    const int edits = 20000;
+    static const char keys[] = "abcxyz019 ;+=(){}\n~/";
+
+    TextBuilder program = generateProgram(lines);
+
+    double start = benchmarkNow();
+    LexedSource* lexed = lexSource(program.text, program.length);
+    double fullLex = benchmarkNow() - start;
+    printf("relex: %d lines, %d tokens, full lex %.2f ms\n",
+           lexed->source->lineCount, lexed->tokenCount, fullLex * 1e3);
+
+    srand(12345);
+    double sameShape = 0.0, reshaped = 0.0, worst = 0.0, worstLocal = 0.0;
+    int sameShapeCount = 0, reshapedCount = 0;
+    long relexedTokens = 0;
+    for (int i = 0; i < edits; i++) {
+        size_t offset = (size_t)rand() % (lexed->source->length + 1);
+        TokenEdit edit;
+
+        // Alternate inserting a key and deleting the character at the same spot
+        char key = keys[rand() % (sizeof(keys) - 1)];
+        char removed = 0;
+        size_t deleted = 0, insertedLength = 1;
+        if (i % 2 != 0) {
+            insertedLength = 0;
+            if (offset < lexed->source->length) {
+                removed = lexed->source->text[offset];
+                deleted = 1;
+            }
+        }
+        double elapsed = timeEdit(lexed, offset, deleted, &key, insertedLength, &edit);
+
+        // Undo and replay a local edit over the bound, keeping the fastest run,
+        // so a preempted timing is not mistaken for a slow edit
+        int local = edit.lastLine - edit.firstLine <= RELEX_LOCAL_LINES;
+        for (int retry = 0; local && elapsed > RELEX_LOCAL_BOUND && retry < 2; retry++) {
+            relexEdit(lexed, offset, insertedLength, &removed, deleted, NULL);
+            double again = timeEdit(lexed, offset, deleted, &key, insertedLength, &edit);
+            if (again < elapsed) elapsed = again;
+        }
+
+        relexedTokens += edit.newEnd - edit.firstToken;
+        if (elapsed > worst) worst = elapsed;
+        if (local && elapsed > worstLocal) worstLocal = elapsed;
+        if (edit.newEnd == edit.oldEnd && edit.lastLine - edit.firstLine == 0) {
+            sameShape += elapsed;
+            sameShapeCount++;
+        } else {
+            reshaped += elapsed;
+            reshapedCount++;
+        }
+    }
+
+    printf("  %d edits, %.1f tokens re-lexed per edit\n", edits, (double)relexedTokens / edits);
+    if (sameShapeCount) {
+        printf("  in-place edits:  %6d, mean %8.2f us\n", sameShapeCount, sameShape / sameShapeCount * 1e6);
+    }
+    if (reshapedCount) {
+        printf("  shifting edits:  %6d, mean %8.2f us\n", reshapedCount, reshaped / reshapedCount * 1e6);
+    }
+    printf("  worst edit %.2f us, worst edit re-lexing at most %d lines %.2f us (bound %.0f us)\n",
+           worst * 1e6, RELEX_LOCAL_LINES + 1, worstLocal * 1e6, RELEX_LOCAL_BOUND * 1e6);
+
+    // The incremental stream must match a full re-lex of the edited text
+    LexedSource* fresh = lexSource(lexed->source->text, lexed->source->length);
+    int ok = sameTokens(lexed, fresh);
+    printf("  verification against full re-lex: %s\n", ok ? "OK" : "MISMATCH");
+    if (worstLocal > RELEX_LOCAL_BOUND) {
+        printf("  local edits exceeded the %.0f us bound (SLOWER)\n", RELEX_LOCAL_BOUND * 1e6);
+        ok = 0;
+    }
+
+    freeLexedSource(fresh);
+    freeLexedSource(lexed);
+    free(program.text);
+    return ok ? 0 : 1;
+}
+
+// Function to compare two parse trees, including the recorded token spans
+static int sameParseTree(const ParseTreeNode* a, const ParseTreeNode* b) {
+    if (!a || !b) return a == b;
+    if (strcmp(a->label, b->label) != 0 || strcmp(a->value, b->value) != 0 ||
+        a->childCount != b->childCount || a->tokenOffset != b->tokenOffset || a->tokenSpan != b->tokenSpan) {
+        printf("  node differs: %s '%s' [%d+%d] vs %s '%s' [%d+%d]\n",
+               a->label, a->value, a->tokenOffset, a->tokenSpan,
+               b->label, b->value, b->tokenOffset, b->tokenSpan);
+        return 0;
+    }
+    for (int i = 0; i < a->childCount; i++) {
+        if (!sameParseTree(a->children[i], b->children[i])) return 0;
+    }
+    return 1;
+}
+
+// Function to check whether a line starts with a statement the generator can precede
+static int startsStatement(const LexedSource* lexed, int line) {
+    int first = lexed->lineFirstToken[line - 1];
+    if (first == lexed->lineFirstToken[line] || lexed->lineEntryState[line - 1]) return 0;
+    Token token = lexedTokenAt(lexed, first);
+    return strcmp(token.type, "IDENTIFIER") == 0 ||
+           (strcmp(token.type, "Keyword") == 0 &&
+            (strcmp(token.value, "int") == 0 || strcmp(token.value, "for") == 0 ||
+             strcmp(token.value, "if") == 0 || strcmp(token.value, "printf") == 0));
+}
+
+// One-line edits (literal changes, inserted and removed statements) in a 100K-line program
+static int benchmarkReparse(void) {
+    const int lines = 100000;
+    const int edits = 4000;
+    static const char statement[] = "total = total + 1;\n";
+
+    parserDebug = 0;
+    TextBuilder program = generateProgram(lines);
+    LexedSource* lexed = lexSource(program.text, program.length);
+
+    double start = benchmarkNow();
+    ParsedProgram* parsed = parseTokenStream(lexedTokens(lexed), lexed->tokenCount);
+    double fullParse = benchmarkNow() - start;
+    printf("reparse: %d lines, %d tokens, %d top-level statements, full parse %.2f ms\n",
+           lexed->source->lineCount, lexed->tokenCount, parsed->root->childCount, fullParse * 1e3);
+    if (parsed->errorCount) {
+        printf("  generated program has %d syntax errors\n", parsed->errorCount);
+        return 1;
+    }
+
+    srand(4242);
+    double relexTime = 0.0, flattenTime = 0.0, reparseTime = 0.0, worst = 0.0;
+    long rebuilt = 0;
+    size_t pendingOffset = 0;
+    int pendingInsert = 0;
+    for (int i = 0; i < edits; i++) {
+        size_t offset, deleted;
+        char text[32];
+
+        if (pendingInsert) {
+            // Remove the statement inserted by the previous edit
+            offset = pendingOffset;
+            deleted = sizeof(statement) - 1;
+            text[0] = '\0';
+            pendingInsert = 0;
+        } else if (i % 3 == 0) {
+            int line;
+            do {
+                line = 1 + rand() % lexed->source->lineCount;
+            } while (!startsStatement(lexed, line));
+            offset = sourceLineStart(lexed->source, line);
+            deleted = 0;
+            strcpy(text, statement);
+            pendingOffset = offset;
+            pendingInsert = 1;
+        } else {
+            // Retype an integer literal
+            Token token;
+            do {
+                token = lexedTokenAt(lexed, rand() % lexed->tokenCount);
+            } while (strcmp(token.type, "INT_LITERAL") != 0);
+            offset = sourceOffsetOf(lexed->source, token.lineNumber, token.column);
+            deleted = strlen(token.value);
+            snprintf(text, sizeof(text), "%d", rand() % 1000);
+        }
+
+        TokenEdit edit;
+        double t0 = benchmarkNow();
+        relexEdit(lexed, offset, deleted, text, strlen(text), &edit);
+        double t1 = benchmarkNow();
+        Token* tokens = lexedTokens(lexed); // The parser reads one contiguous array
+        double tf = benchmarkNow();
+        reparseEdit(parsed, tokens, lexed->tokenCount, &edit);
+        double t2 = benchmarkNow();
+
+        relexTime += t1 - t0;
+        flattenTime += tf - t1;
+        reparseTime += t2 - tf;
+        if (t2 - tf > worst) worst = t2 - tf;
+        rebuilt += parsed->reparsedStatements;
+    }
+
+    printf("  %d edits, %.2f statements rebuilt per edit, %d full reparses\n",
+           edits, (double)rebuilt / edits, parsed->fullReparses);
+    printf("  relex mean %.2f us, token array refresh mean %.2f us, reparse mean %.2f us, worst reparse %.2f us\n",
+           relexTime / edits * 1e6, flattenTime / edits * 1e6, reparseTime / edits * 1e6, worst * 1e6);
+
+    // The incrementally maintained tree must match a fresh parse
+    ParsedProgram* fresh = parseTokenStream(lexedTokens(lexed), lexed->tokenCount);
+    int ok = fresh->errorCount == parsed->errorCount && sameParseTree(parsed->root, fresh->root);
+    printf("  verification against full parse: %s\n", ok ? "OK" : "MISMATCH");
+
+    freeParsedProgram(fresh);
+    freeParsedProgram(parsed);
+    freeLexedSource(lexed);
+    free(program.text);
+    return ok ? 0 : 1;
+}
+
+// Function to expand every deferred block reachable from `node`, as a full walk would
+static void expandAll(ParseTreeNode* node) {
+    ensureChildren(node);
+    for (int i = 0; i < node->childCount; i++) {
+        if (node->children[i]) expandAll(node->children[i]);
+    }
+}
+
+// Outline-style parse of a 100K-line program with block bodies deferred
+static int benchmarkLazy(void) {
+    const int lines = 100000;
+
+    parserDebug = 0;
+    TextBuilder program = generateNestedProgram(lines);
+    LexedSource* lexed = lexSource(program.text, program.length);
+
+    double start = benchmarkNow();
+    ParsedProgram* eager = parseTokenStream(lexedTokens(lexed), lexed->tokenCount);
+    double eagerTime = benchmarkNow() - start;
+
+    lazyBlocks = 1;
+    setDeferredExpander(expandBlock);
+    deferredBlockCount = expandedBlockCount = 0;
+    start = benchmarkNow();
+    ParsedProgram* lazy = parseTokenStream(lexedTokens(lexed), lexed->tokenCount);
+    double lazyTime = benchmarkNow() - start;
+
+    printf("lazy: %d tokens, eager parse %.2f ms, lazy parse %.2f ms (%.1fx)\n",
+           lexed->tokenCount, eagerTime * 1e3, lazyTime * 1e3, eagerTime / lazyTime);
+
+    // A consumer that only looks inside roughly every 100th top-level statement
+    ParseTreeNode* root = lazy->root;
+    for (int i = 1; i < root->childCount; i += 101) {
+        expandAll(root->children[i]);
+    }
+    printf("  %d blocks deferred, %d expanded on demand, %d never expanded\n",
+           deferredBlockCount, expandedBlockCount, deferredBlockCount - expandedBlockCount);
+
+    // Expanding everything must give the eager tree
+    start = benchmarkNow();
+    expandAll(root);
+    double expandTime = benchmarkNow() - start;
+    int ok = sameParseTree(eager->root, root);
+    printf("  expanding the rest took %.2f ms; verification against eager parse: %s\n",
+           expandTime * 1e3, ok ? "OK" : "MISMATCH");
+
+    lazyBlocks = 0;
+    setDeferredExpander(NULL);
+    freeParsedProgram(lazy);
+    freeParsedProgram(eager);
+    freeLexedSource(lexed);
+    free(program.text);
+    return ok ? 0 : 1;
+}
+
+// ---------------------------------------
+// Concurrent interning
+// ---------------------------------------
+
+#define INTERN_THREADS 4
+#define INTERN_NAMES 200000
+
+// One thread interning every name, starting at its own offset, and reading
+// back names other threads may still be inserting around it
+typedef struct {
+    InternTable* table;
+    int offset;
+    SymbolId* ids;    // Per name, the id this thread got
+    int errors;
+} InternWorker;
+
+static void runInternWorker(InternWorker* worker) {
+    char name[32], expected[32];
+    for (int i = 0; i < INTERN_NAMES; i++) {
+        int k = (worker->offset + i) % INTERN_NAMES;
+        int length = snprintf(name, sizeof(name), "name%d", k);
+        worker->ids[k] = internStringIn(worker->table, name, (size_t)length);
+
+        // An earlier name of this thread, read without the lock
+        int earlier = (worker->offset + i / 2) % INTERN_NAMES;
+        snprintf(expected, sizeof(expected), "name%d", earlier);
+        const char* text = internedStringIn(worker->table, worker->ids[earlier]);
+        if (!text || strcmp(text, expected) != 0) worker->errors++;
+    }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI internThread(LPVOID argument) {
+    runInternWorker((InternWorker*)argument);
+    return 0;
+}
+#else
+static void* internThread(void* argument) {
+    runInternWorker((InternWorker*)argument);
+    return NULL;
+}
+#endif
+
+// Threads interning the same names into one concurrent table must agree on
+// every id, and lock-free reads must never see a half-published entry
+static int benchmarkIntern(void) {
+    printf("intern: %d threads interning the same %d names into one concurrent table\n", INTERN_THREADS,
+           INTERN_NAMES);
+    InternWorker workers[INTERN_THREADS];
+
+    // The single-threaded baseline: one worker on a plain table
+    InternTable* plain = createInternTable(0);
+    workers[0].table = plain;
+    workers[0].offset = 0;
+    workers[0].ids = (SymbolId*)calloc(INTERN_NAMES, sizeof(SymbolId));
+    workers[0].errors = 0;
+    double start = benchmarkNow();
+    runInternWorker(&workers[0]);
+    double plainTime = benchmarkNow() - start;
+    int ok = workers[0].errors == 0 && internedCountIn(plain) == INTERN_NAMES;
+    freeInternTable(plain);
+    free(workers[0].ids);
+
+    InternTable* table = createInternTable(1);
+    for (int t = 0; t < INTERN_THREADS; t++) {
+        workers[t].table = table;
+        workers[t].offset = t * (INTERN_NAMES / INTERN_THREADS);
+        workers[t].ids = (SymbolId*)calloc(INTERN_NAMES, sizeof(SymbolId));
+        workers[t].errors = 0;
+    }
+    start = benchmarkNow();
+#ifdef _WIN32
+    HANDLE threads[INTERN_THREADS];
+    for (int t = 0; t < INTERN_THREADS; t++) threads[t] = CreateThread(NULL, 0, internThread, &workers[t], 0, NULL);
+    for (int t = 0; t < INTERN_THREADS; t++) {
+        WaitForSingleObject(threads[t], INFINITE);
+        CloseHandle(threads[t]);
+    }
+#else
+    pthread_t threads[INTERN_THREADS];
+    for (int t = 0; t < INTERN_THREADS; t++) pthread_create(&threads[t], NULL, internThread, &workers[t]);
+    for (int t = 0; t < INTERN_THREADS; t++) pthread_join(threads[t], NULL);
+#endif
+    double concurrentTime = benchmarkNow() - start;
+
+    int errors = 0, disagreements = 0;
+    char expected[32];
+    for (int t = 0; t < INTERN_THREADS; t++) errors += workers[t].errors;
+    for (int k = 0; k < INTERN_NAMES; k++) {
+        for (int t = 1; t < INTERN_THREADS; t++) disagreements += workers[t].ids[k] != workers[0].ids[k];
+        snprintf(expected, sizeof(expected), "name%d", k);
+        const char* text = internedStringIn(table, workers[0].ids[k]);
+        errors += !text || strcmp(text, expected) != 0;
+    }
+    uint32_t count = internedCountIn(table);
+    ok = ok && errors == 0 && disagreements == 0 && count == INTERN_NAMES;
+    printf("  1 thread, plain table:      %8.2f ms\n", plainTime * 1e3);
+    printf("  %d threads, concurrent table: %8.2f ms for %d inserts; %u strings, %d ids disagreeing, "
+           "%d bad reads, %s\n", INTERN_THREADS, concurrentTime * 1e3, INTERN_THREADS * INTERN_NAMES, count,
+           disagreements, errors, ok ? "OK" : "MISMATCH");
+    for (int t = 0; t < INTERN_THREADS; t++) free(workers[t].ids);
+    freeInternTable(table);
+    return ok ? 0 : 1;
+}
+
+// Lookup cost of the scoped symbol table as the number of declarations grows
+static int benchmarkSymbols(void) {
+    static const int sizes[] = {1000, 10000, 100000};
+    const int lookups = 4000000;
+    int ok = 1;
+
+    printf("symbols: %d random lookups per table size\n", lookups);
+    for (int s = 0; s < (int)(sizeof(sizes) / sizeof(sizes[0])); s++) {
+        int count = sizes[s];
+        SymbolId* names = (SymbolId*)malloc(count * sizeof(SymbolId));
+        char name[32];
+        for (int i = 0; i < count; i++) {
+            snprintf(name, sizeof(name), "var%d", i);
+            names[i] = internString(name);
+        }
+
+        // Half the names at program level, the rest spread over nested scopes that shadow them
+        SymbolTable* table = createSymbolTable();
+        double start = benchmarkNow();
+        for (int i = 0; i < count / 2; i++) {
+            declareSymbol(table, names[i], TYPE_INT, i + 1, 1);
+        }
+        for (int i = count / 2; i < count; i++) {
+            if (i % 100 == 0) pushScope(table);
+            declareSymbol(table, names[i], TYPE_FLOAT, i + 1, 1);
+            declareSymbol(table, names[i - count / 2], TYPE_FLOAT, i + 1, 5);
+        }
+        double declareTime = benchmarkNow() - start;
+
+        srand(99);
+        long found = 0;
+        start = benchmarkNow();
+        for (int i = 0; i < lookups; i++) {
+            found += useSymbol(table, names[rand() % count]) != NULL;
+        }
+        double lookupTime = benchmarkNow() - start;
+
+        // Closing every scope must expose the program-level declarations again
+        while (table->scopeDepth > 0) popScope(table);
+        for (int i = 0; i < count / 2 && ok; i++) {
+            Symbol* symbol = lookupSymbol(table, names[i]);
+            ok = symbol && symbol->type == TYPE_INT && symbol->scopeDepth == 0;
+        }
+        for (int i = count / 2; i < count && ok; i++) {
+            ok = lookupSymbol(table, names[i]) == NULL;
+        }
+
+        printf("  %6d names, %6d declarations: declare %.1f ns each, lookup %.1f ns each (%ld found)\n",
+               count, table->symbolCount, declareTime / table->symbolCount * 1e9,
+               lookupTime / lookups * 1e9, found);
+
+        freeSymbolTable(table);
+        free(names);
+    }
+
+    printf("  scope pop restores shadowed declarations: %s\n", ok ? "OK" : "MISMATCH");
+    return ok ? 0 : 1;
+}
+
+// Function to time one type-checking pass over a generated program
+static int timeTypeCheck(const char* title, TextBuilder* program, int expectedErrors) {
+    LexedSource* lexed = lexSource(program->text, program->length);
+
+    double start = benchmarkNow();
+    ParsedProgram* parsed = parseTokenStream(lexedTokens(lexed), lexed->tokenCount);
+    double parseTime = benchmarkNow() - start;
+    if (parsed->errorCount) {
+        printf("  %s: generated program has %d syntax errors\n", title, parsed->errorCount);
+        return 0;
+    }
+
+    start = benchmarkNow();
+    TypeCheckResult* result = typeCheckProgram(parsed->root, lexedTokens(lexed), lexed->tokenCount);
+    double checkTime = benchmarkNow() - start;
+
+    printf("  %-8s %7d tokens: parse %.2f ms, type check %.2f ms (%.1f ns per expression node)\n",
+           title, lexed->tokenCount, parseTime * 1e3, checkTime * 1e3,
+           checkTime / (result->typedNodes ? result->typedNodes : 1) * 1e9);
+    printf("           %d expression nodes typed, %d conversions inserted, %d type errors (expected %d)\n",
+           result->typedNodes, result->conversions, result->errorCount, expectedErrors);
+
+    // A second pass over the annotated tree must agree and insert nothing new
+    TypeCheckResult* again = typeCheckProgram(parsed->root, lexedTokens(lexed), lexed->tokenCount);
+    int ok = result->errorCount == expectedErrors && again->errorCount == expectedErrors &&
+             again->conversions == 0;
+
+    if (result->errorCount == 0) {
+        start = benchmarkNow();
+        FoldResult folded = foldConstants(parsed->root, result->bindingCount);
+        double foldTime = benchmarkNow() - start;
+        printf("           constant folding %.2f ms: %d nodes folded, %d uses propagated\n",
+               foldTime * 1e3, folded.foldedNodes, folded.propagatedUses);
+    }
+
+    freeTypeCheckResult(again);
+    freeTypeCheckResult(result);
+    freeParsedProgram(parsed);
+    freeLexedSource(lexed);
+    return ok;
+}
+
+// Type checking cost on large generated programs
+static int benchmarkTypeCheck(void) {
+    const int lines = 100000;
+    int expectedErrors = 0;
+
+    parserDebug = 0;
+    printf("typecheck: %d-line programs\n", lines);
+
+    TextBuilder mixed = generateProgram(lines);
+    int ok = timeTypeCheck("mixed", &mixed, 0);
+    free(mixed.text);
+
+    TextBuilder nested = generateNestedProgram(lines);
+    ok = timeTypeCheck("nested", &nested, 0) && ok;
+    free(nested.text);
+
+    TextBuilder typed = generateTypedProgram(lines, 50, &expectedErrors);
+    ok = timeTypeCheck("typed", &typed, expectedErrors) && ok;
+    free(typed.text);
+
+    printf("  errors reported in bulk and second pass idempotent: %s\n", ok ? "OK" : "MISMATCH");
+    return ok ? 0 : 1;
+}
+
+// Function to check computeDominators() against the textbook set equations
+// Dom(b) = {b} + intersection of Dom(p) over predecessors p, solved with bitsets
+static int dominatorsMatchSets(const Cfg* cfg) {
+    int n = cfg->blockCount;
+    int words = (n + 63) / 64;
+    uint64_t* sets = (uint64_t*)malloc((size_t)n * words * sizeof(uint64_t));
+    uint64_t* scratch = (uint64_t*)malloc(words * sizeof(uint64_t));
+    if (!sets || !scratch) {
+        fprintf(stderr, "Error: Memory allocation failed for dominator check.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    memset(sets, 0xFF, (size_t)n * words * sizeof(uint64_t));
+    memset(sets, 0, words * sizeof(uint64_t));
+    sets[0] = 1;
+    int changed = 1;
+    while (changed) {
+        changed = 0;
+        for (int b = 1; b < n; b++) {
+            const BasicBlock* block = &cfg->blocks[b];
+            memset(scratch, 0xFF, words * sizeof(uint64_t));
+            for (int p = 0; p < block->predecessorCount; p++) {
+                const uint64_t* dom = &sets[(size_t)cfg->predecessors[block->firstPredecessor + p] * words];
+                for (int w = 0; w < words; w++) scratch[w] &= dom[w];
+            }
+            scratch[b / 64] |= 1ull << (b % 64);
+            if (memcmp(scratch, &sets[(size_t)b * words], words * sizeof(uint64_t)) != 0) {
+                memcpy(&sets[(size_t)b * words], scratch, words * sizeof(uint64_t));
+                changed = 1;
+            }
+        }
+    }
+
+    int ok = 1;
+    for (int b = 0; b < n && ok; b++) {
+        for (int a = 0; a < n; a++) {
+            int inSet = (sets[(size_t)b * words + a / 64] >> (a % 64)) & 1;
+            if (inSet != (dominates(cfg, a, b) != 0)) {
+                printf("  B%d dominates B%d: sets say %d, dominator tree says %d\n", a, b, inSet, !inSet);
+                ok = 0;
+                break;
+            }
+        }
+    }
+    free(sets);
+    free(scratch);
+    return ok;
+}
+
+// Function to parse, check and fold a generated program, then time CFG construction.
+// With `verify`, the dominators are also compared against the bitset solution.
+static int timeCfg(const char* title, TextBuilder* program, int verify) {
+    LexedSource* lexed = lexSource(program->text, program->length);
+    ParsedProgram* parsed = parseTokenStream(lexedTokens(lexed), lexed->tokenCount);
+    TypeCheckResult* checked = typeCheckProgram(parsed->root, lexedTokens(lexed), lexed->tokenCount);
+    if (parsed->errorCount || checked->errorCount) {
+        printf("  %s: generated program has %d syntax and %d type errors\n", title,
+               parsed->errorCount, checked->errorCount);
+        return 0;
+    }
+    foldConstants(parsed->root, checked->bindingCount);
+
+    double start = benchmarkNow();
+    Cfg* cfg = buildCfg(parsed->root, checked->bindingCount);
+    double buildTime = benchmarkNow() - start;
+    start = benchmarkNow();
+    computeDominators(cfg);
+    double dominatorTime = benchmarkNow() - start;
+
+    int ok = 1;
+    if (verify) {
+        ok = dominatorsMatchSets(cfg);
+        printf("  %-8s %6d blocks: dominators match the set equations: %s\n", title, cfg->blockCount,
+               ok ? "OK" : "MISMATCH");
+    } else {
+        printf("  %-8s %7d instructions in %6d blocks, %6d edges, %5d loops\n", title,
+               cfg->instructionCount, cfg->blockCount, cfg->edgeCount, cfg->loopCount);
+        printf("           build %.2f ms (%.1f ns per instruction), dominators %.2f ms (%.1f ns per block)\n",
+               buildTime * 1e3, buildTime / (cfg->instructionCount ? cfg->instructionCount : 1) * 1e9,
+               dominatorTime * 1e3, dominatorTime / (cfg->blockCount ? cfg->blockCount : 1) * 1e9);
+    }
+
+    freeCfg(cfg);
+    freeTypeCheckResult(checked);
+    freeParsedProgram(parsed);
+    freeLexedSource(lexed);
+    return ok;
+}
+
+// CFG construction and dominator cost on large generated programs
+static int benchmarkCfg(void) {
+    const int lines = 100000;
+    const int checkedLines = 3000;
+    int expectedErrors = 0;
+    int ok = 1;
+
+    parserDebug = 0;
+    printf("cfg: %d-line programs\n", lines);
+    for (int pass = 0; pass < 2; pass++) {
+        int size = pass == 0 ? lines : checkedLines;
+        if (pass == 1) printf("cfg: %d-line programs checked against bitset dominators\n", size);
+
+        TextBuilder mixed = generateProgram(size);
+        ok = timeCfg("mixed", &mixed, pass) && ok;
+        free(mixed.text);
+
+        TextBuilder nested = generateNestedProgram(size);
+        ok = timeCfg("nested", &nested, pass) && ok;
+        free(nested.text);
+
+        TextBuilder typed = generateTypedProgram(size, 0, &expectedErrors);
+        ok = timeCfg("typed", &typed, pass) && ok;
+        free(typed.text);
+    }
+    return ok ? 0 : 1;
+}
+
+// ---------------------------------------
+// Bytecode VM
+// ---------------------------------------
+
+// Loop-heavy programs: each is timed in the VM and checked against the same
+// computation written in C, which also gives a native baseline
+typedef struct {
+    const char* title;
+    const char* source;  // printf-style template taking `size`
+    int size;
+    void (*reference)(int size, char* expected, size_t expectedSize);
+} VmProgram;
+
+static void nestedForReference(int size, char* expected, size_t expectedSize) {
+    int32_t total = 0;
+    for (int32_t i = 0; i < size; i++) {
+        for (int32_t j = 0; j < i; j++) {
+            total = intAdd(total, intMod(intMul(i, j), 7));
+        }
+    }
+    snprintf(expected, expectedSize, "%d\n", total);
+}
+
+static void collatzReference(int size, char* expected, size_t expectedSize) {
+    int32_t steps = 0;
+    for (int32_t n = 1; n < size; n++) {
+        int32_t x = n;
+        while (x != 1) {
+            x = intMod(x, 2) == 0 ? intFloorDiv(x, 2) : intAdd(intMul(3, x), 1);
+            steps = intAdd(steps, 1);
+        }
+    }
+    snprintf(expected, expectedSize, "%d\n", steps);
+}
+
+static void seriesReference(int size, char* expected, size_t expectedSize) {
+    double sum = 0.0;
+    int32_t k = 1;
+    do {
+        double kf = (double)k;
+        sum = sum + 1.0 / floatPow(kf, 2);
+        k = intAdd(k, 1);
+    } while (k <= size);
+    snprintf(expected, expectedSize, "%f\n", sum);
+}
+
+static void primesReference(int size, char* expected, size_t expectedSize) {
+    int32_t count = 0;
+    for (int32_t n = 2; n < size; n++) {
+        if (intMod(n, 2) == 0 && n != 2) continue;
+        int32_t d = 3;
+        int32_t prime = 1;
+        while (intMul(d, d) <= n) {
+            if (intMod(n, d) == 0) {
+                prime = 0;
+                break;
+            }
+            d = intAdd(d, 2);
+        }
+        if (prime == 1) count = intAdd(count, 1);
+    }
+    snprintf(expected, expectedSize, "%d\n", count);
+}
+
+static void runtimeFormatReference(int size, char* expected, size_t expectedSize) {
+    int32_t total = 0;
+    for (int32_t i = 0; i < size; i++) {
+        total = intAdd(total, intMod(i, 7));
+    }
+    double mean = (double)total / size;
+    snprintf(expected, expectedSize, "total=%d mean=%.3f [%6d] %d %c\n", total, mean, size, total, 'x');
+}
+
+static const VmProgram vmPrograms[] = {
+    {"nested", "int total = 0;\n"
+               "for (int i = 0; i < %d; i++) {\n"
+               "    for (int j = 0; j < i; j++) {\n"
+               "        total = total + (i * j) %% 7;\n"
+               "    }\n"
+               "}\n"
+               "printf(\"%%d\\n\", total);\n",
+     3000, nestedForReference},
+    {"while", "int steps = 0;\n"
+              "int n = 1;\n"
+              "while (n < %d) {\n"
+              "    int x = n;\n"
+              "    while (x != 1) {\n"
+              "        if (x %% 2 == 0) {\n"
+              "            x = x // 2;\n"
+              "        } else {\n"
+              "            x = 3 * x + 1;\n"
+              "        }\n"
+              "        steps += 1;\n"
+              "    }\n"
+              "    n += 1;\n"
+              "}\n"
+              "printf(\"%%d\\n\", steps);\n",
+     100000, collatzReference},
+    {"do", "float sum = 0.0;\n"
+           "int k = 1;\n"
+           "do {\n"
+           "    float kf = k;\n"
+           "    sum = sum + 1.0 / (kf ^ 2);\n"
+           "    k += 1;\n"
+           "} while (k <= %d);\n"
+           "printf(\"%%f\\n\", sum);\n",
+     5000000, seriesReference},
+    {"primes", "int count = 0;\n"
+               "for (int n = 2; n < %d; n++) {\n"
+               "    if (n %% 2 == 0 && n != 2) {\n"
+               "        continue;\n"
+               "    }\n"
+               "    int d = 3;\n"
+               "    int prime = 1;\n"
+               "    while (d * d <= n) {\n"
+               "        if (n %% d == 0) {\n"
+               "            prime = 0;\n"
+               "            break;\n"
+               "        }\n"
+               "        d += 2;\n"
+               "    }\n"
+               "    if (prime == 1) {\n"
+               "        count += 1;\n"
+               "    }\n"
+               "}\n"
+               "printf(\"%%d\\n\", count);\n",
+     300000, primesReference},
+    {"format", "int n = %d;\n"
+               "int total = 0;\n"
+               "string fmt = \"no rows\\n\";\n"
+               "for (int i = 0; i < n; i++) {\n"
+               "    total = total + i %% 7;\n"
+               "    if (i == 1) {\n"
+               "        fmt = \"total=%%d mean=%%.3f [%%6d] %%s %%c\\n\";\n"
+               "    }\n"
+               "}\n"
+               "float mean = total / n;\n"
+               "char mark = 'x';\n"
+               "printf(fmt, total, mean, n, total, mark);\n",
+     1000000, runtimeFormatReference},
+};
+
+// Function to take a program's source through every phase down to bytecode (NULL on errors).
+// With `cOutput`, the folded tree is also translated to C there.
+static BytecodeProgram* compileSource(const char* title, const char* source, FILE* cOutput) {
+    LexedSource* lexed = lexSource(source, strlen(source));
+    ParsedProgram* parsed = parseTokenStream(lexedTokens(lexed), lexed->tokenCount);
+    TypeCheckResult* checked = typeCheckProgram(parsed->root, lexedTokens(lexed), lexed->tokenCount);
+    BytecodeProgram* program = NULL;
+    if (parsed->errorCount || checked->errorCount) {
+        printf("  %s: program has %d syntax and %d type errors\n", title, parsed->errorCount, checked->errorCount);
+    } else {
+        foldConstants(parsed->root, checked->bindingCount);
+        if (cOutput) emitCProgram(parsed->root, cOutput);
+        Cfg* cfg = buildCfg(parsed->root, checked->bindingCount);
+        computeDominators(cfg);
+        eliminateBoundsChecks(cfg);
+        vectorizeLoops(cfg);
+        optimizeLoops(cfg);
+        numberValues(cfg);
+        eliminateDeadCode(cfg);
+        assignRegisterSlots(cfg, JIT_INT_REGISTERS, JIT_FLOAT_REGISTERS);
+        program = compileBytecode(cfg);
+        freeCfg(cfg);
+    }
+    freeTypeCheckResult(checked);
+    freeParsedProgram(parsed);
+    freeLexedSource(lexed);
+    return program;
+}
+
+// Function to run `program` once, returning the seconds taken and what it printed (truncated to fit)
+static double runCaptured(const BytecodeProgram* program, char* printed, size_t printedSize, int* status) {
+    printed[0] = '\0';
+    FILE* output = tmpfile();
+    if (!output) {
+        *status = 1;
+        return 0.0;
+    }
+    double start = benchmarkNow();
+    *status = runBytecode(program, stdin, output);
+    double elapsed = benchmarkNow() - start;
+    rewind(output);
+    size_t length = fread(printed, 1, printedSize - 1, output);
+    printed[length] = '\0';
+    fclose(output);
+    return elapsed;
+}
+
+// Function to run one program in the VM, with and without superinstructions, and
+// compare its output with the C reference
+static int timeVmProgram(const VmProgram* entry) {
+    char source[2048];
+    char expected[128];
+    char plain[128];
+    char fused[128];
+    int plainStatus, fusedStatus;
+    snprintf(source, sizeof(source), entry->source, entry->size);
+
+    bytecodeSuperinstructions = 0;
+    BytecodeProgram* plainProgram = compileSource(entry->title, source, NULL);
+    bytecodeSuperinstructions = 1;
+    BytecodeProgram* program = compileSource(entry->title, source, NULL);
+    if (!plainProgram || !program) {
+        freeBytecode(plainProgram);
+        freeBytecode(program);
+        return 0;
+    }
+
+    double plainTime = runCaptured(plainProgram, plain, sizeof(plain), &plainStatus);
+#ifdef VM_PROFILE
+    printf("  %s without superinstructions: ", entry->title);
+    writeVmProfile(stdout);
+#endif
+    double vmTime = runCaptured(program, fused, sizeof(fused), &fusedStatus);
+
+    double start = benchmarkNow();
+    entry->reference(entry->size, expected, sizeof(expected));
+    double nativeTime = benchmarkNow() - start;
+
+    int ok = plainStatus == 0 && fusedStatus == 0 && strcmp(plain, expected) == 0 && strcmp(fused, expected) == 0;
+    fused[strcspn(fused, "\n")] = '\0';
+    expected[strcspn(expected, "\n")] = '\0';
+    printf("  %-7s n=%-8d VM %8.2f ms (%2d instructions), without superinstructions %8.2f ms (%2d)\n",
+           entry->title, entry->size, vmTime * 1e3, program->codeCount, plainTime * 1e3, plainProgram->codeCount);
+    printf("          native C %7.2f ms (VM %.1fx), printed %s %s\n", nativeTime * 1e3,
+           nativeTime > 0 ? vmTime / nativeTime : 0.0, fused, ok ? "OK" : "MISMATCH");
+    if (!ok) printf("           expected %s\n", expected);
+#ifdef VM_PROFILE
+    printf("  %s: ", entry->title);
+    writeVmProfile(stdout);
+#endif
+
+    freeBytecode(plainProgram);
+    freeBytecode(program);
+    return ok;
+}
+
+// Bytecode VM on loop-heavy programs (nested for, while, do-while, break/continue)
+static int benchmarkVm(void) {
+    parserDebug = 0;
+    printf("vm: loop-heavy programs, output checked against C\n");
+    int ok = 1;
+    for (size_t i = 0; i < sizeof(vmPrograms) / sizeof(vmPrograms[0]); i++) {
+        ok = timeVmProgram(&vmPrograms[i]) && ok;
+    }
+    return ok ? 0 : 1;
+}
+
+// ---------------------------------------
+// C backend
+// ---------------------------------------
+
+#ifdef _WIN32
+#define EMITTED_PROGRAM "emit_bench.exe"
+#define RUN_EMITTED "emit_bench.exe > emit_bench.out"
+#define QUIET " > nul 2>&1"
+#else
+#define EMITTED_PROGRAM "emit_bench"
+#define RUN_EMITTED "./emit_bench > emit_bench.out"
+#define QUIET " > /dev/null 2>&1"
+#endif
+
+// Function to translate one VM program to C, build it with gcc -O2 and compare its
+// run (process start included) with the VM's
+static int timeEmittedProgram(const VmProgram* entry) {
+    char source[2048];
+    char expected[128];
+    char printed[128] = "";
+    char interpreted[128];
+    int vmStatus;
+    snprintf(source, sizeof(source), entry->source, entry->size);
+
+    FILE* cFile = fopen("emit_bench.c", "w");
+    if (!cFile) {
+        printf("  %s: unable to create emit_bench.c\n", entry->title);
+        return 0;
+    }
+    BytecodeProgram* program = compileSource(entry->title, source, cFile);
+    fclose(cFile);
+    if (!program) return 0;
+
+    double start = benchmarkNow();
+    int built = system("gcc -O2 -o " EMITTED_PROGRAM " emit_bench.c" QUIET) == 0;
+    double compileTime = benchmarkNow() - start;
+
+    double nativeTime = 0.0;
+    if (built) {
+        start = benchmarkNow();
+        built = system(RUN_EMITTED) == 0;
+        nativeTime = benchmarkNow() - start;
+        FILE* output = fopen("emit_bench.out", "r");
+        if (output) {
+            if (!fgets(printed, sizeof(printed), output)) printed[0] = '\0';
+            fclose(output);
+        }
+    }
+    double vmTime = runCaptured(program, interpreted, sizeof(interpreted), &vmStatus);
+    entry->reference(entry->size, expected, sizeof(expected));
+
+    int ok = built && vmStatus == 0 && strcmp(printed, expected) == 0 && strcmp(interpreted, expected) == 0;
+    printed[strcspn(printed, "\n")] = '\0';
+    expected[strcspn(expected, "\n")] = '\0';
+    printf("  %-7s n=%-8d gcc -O2 %7.2f ms, emitted C %8.2f ms, VM %8.2f ms (%.1fx), printed %s %s\n",
+           entry->title, entry->size, compileTime * 1e3, nativeTime * 1e3, vmTime * 1e3,
+           nativeTime > 0 ? vmTime / nativeTime : 0.0, printed, ok ? "OK" : "MISMATCH");
+    if (!ok) printf("           expected %s\n", expected);
+
+    freeBytecode(program);
+    remove("emit_bench.c");
+    remove("emit_bench.out");
+    remove(EMITTED_PROGRAM);
+    return ok;
+}
+
+// --emit-c output built by the system compiler, against the VM on the same programs
+static int benchmarkEmitC(void) {
+    parserDebug = 0;
+    printf("emit-c: VM programs translated to C and built with gcc -O2\n");
+    if (system("gcc --version" QUIET) != 0) {
+        printf("  gcc not found; skipped\n");
+        return 0;
+    }
+    int ok = 1;
+    for (size_t i = 0; i < sizeof(vmPrograms) / sizeof(vmPrograms[0]); i++) {
+        ok = timeEmittedProgram(&vmPrograms[i]) && ok;
+    }
+    return ok ? 0 : 1;
+}
+
+// ---------------------------------------
+// JIT
+// ---------------------------------------
+
+// Function to time one VM program interpreted and with the JIT, both checked against C
+static int timeJitProgram(const VmProgram* entry) {
+    char source[2048];
+    char expected[128];
+    char interpreted[128];
+    char native[128];
+    int interpretedStatus, nativeStatus;
+    snprintf(source, sizeof(source), entry->source, entry->size);
+
+    BytecodeProgram* program = compileSource(entry->title, source, NULL);
+    if (!program) return 0;
+
+    double start = benchmarkNow();
+    JitCode* jit = compileJit(program);
+    double compileTime = benchmarkNow() - start;
+    int codeSize = jitCodeSize(jit);
+    int pinned = jitPinnedRegisters(jit);
+    freeJit(jit);
+
+    vmJit = 0;
+    double vmTime = runCaptured(program, interpreted, sizeof(interpreted), &interpretedStatus);
+    vmJit = 1;
+    double jitTime = runCaptured(program, native, sizeof(native), &nativeStatus);
+    vmJit = 0;
+
+    start = benchmarkNow();
+    entry->reference(entry->size, expected, sizeof(expected));
+    double nativeTime = benchmarkNow() - start;
+
+    int ok = interpretedStatus == 0 && nativeStatus == 0 &&
+             strcmp(interpreted, expected) == 0 && strcmp(native, expected) == 0;
+    native[strcspn(native, "\n")] = '\0';
+    expected[strcspn(expected, "\n")] = '\0';
+    printf("  %-7s n=%-8d JIT %8.2f ms, VM %8.2f ms (%.1fx), C %7.2f ms; %5d bytes in %.3f ms, %d pinned, printed %s %s\n",
+           entry->title, entry->size, jitTime * 1e3, vmTime * 1e3, jitTime > 0 ? vmTime / jitTime : 0.0,
+           nativeTime * 1e3, codeSize, compileTime * 1e3, pinned, native, ok ? "OK" : "MISMATCH");
+    if (!ok) printf("           expected %s\n", expected);
+
+    freeBytecode(program);
+    return ok;
+}
+
+static uint32_t nextRandom(uint32_t* state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+static void appendIntExpression(TextBuilder* builder, uint32_t* seed, int depth);
+static void appendFloatExpression(TextBuilder* builder, uint32_t* seed, int depth);
+
+static void appendIntExpression(TextBuilder* builder, uint32_t* seed, int depth) {
+    static const char* const divisors[] = {"1", "2", "3", "8", "(0 - 1)", "(0 - 4)", "7", "(i1 %% 7 + 8)"};
+    char text[64];
+    uint32_t choice = nextRandom(seed) % 8;
+    if (depth == 0 || choice < 2) {
+        uint32_t leaf = nextRandom(seed) % 6;
+        if (leaf < 4) snprintf(text, sizeof(text), "i%u", leaf);
+        else if (leaf == 4) snprintf(text, sizeof(text), "n");
+        else snprintf(text, sizeof(text), "%u", nextRandom(seed) % 100);
+        appendText(builder, text);
+        return;
+    }
+
+    appendText(builder, "(");
+    appendIntExpression(builder, seed, depth - 1);
+    if (choice <= 4) {
+        appendText(builder, choice == 2 ? " + " : choice == 3 ? " - " : " * ");
+        appendIntExpression(builder, seed, depth - 1);
+    } else if (choice <= 6) {
+        snprintf(text, sizeof(text), choice == 5 ? " // %s" : " %% %s", divisors[nextRandom(seed) % 8]);
+        char divisor[64];
+        snprintf(divisor, sizeof(divisor), text, 0); // Turns %% into %
+        appendText(builder, divisor);
+    } else {
+        snprintf(text, sizeof(text), " ^ %u", nextRandom(seed) % 4);
+        appendText(builder, text);
+    }
+    appendText(builder, ")");
+}
+
+static void appendFloatExpression(TextBuilder* builder, uint32_t* seed, int depth) {
+    char text[64];
+    uint32_t choice = nextRandom(seed) % 8;
+    if (depth == 0 || choice < 2) {
+        uint32_t leaf = nextRandom(seed) % 5;
+        if (leaf < 3) snprintf(text, sizeof(text), "f%u", leaf);
+        else if (leaf == 3) snprintf(text, sizeof(text), "i%u", nextRandom(seed) % 4);
+        else snprintf(text, sizeof(text), "%u.%u", nextRandom(seed) % 10, nextRandom(seed) % 100);
+        appendText(builder, text);
+        return;
+    }
+
+    appendText(builder, "(");
+    appendFloatExpression(builder, seed, depth - 1);
+    if (choice <= 5) {
+        appendText(builder, choice == 2 ? " + " : choice == 3 ? " - " : choice == 4 ? " * " : " / ");
+        appendFloatExpression(builder, seed, depth - 1);
+    } else {
+        snprintf(text, sizeof(text), choice == 6 ? " ^ %u" : " ^ (0 - %u)", nextRandom(seed) % 3);
+        appendText(builder, text);
+    }
+    appendText(builder, ")");
+}
+
+static void appendCondition(TextBuilder* builder, uint32_t* seed, int depth) {
+    static const char* const comparisons[] = {" == ", " != ", " < ", " <= ", " > ", " >= "};
+    uint32_t choice = nextRandom(seed) % 8;
+    if (depth > 0 && choice >= 6) {
+        appendText(builder, "(");
+        appendCondition(builder, seed, depth - 1);
+        appendText(builder, choice == 6 ? " && " : " || ");
+        appendCondition(builder, seed, depth - 1);
+        appendText(builder, ")");
+    } else if (depth > 0 && choice == 5) {
+        appendText(builder, "!");
+        appendCondition(builder, seed, depth - 1);
+    } else if (choice == 4) {
+        appendText(builder, "b0");
+    } else {
+        int useFloat = choice & 1;
+        appendText(builder, "(");
+        if (useFloat) appendFloatExpression(builder, seed, 1);
+        else appendIntExpression(builder, seed, 1);
+        appendText(builder, comparisons[nextRandom(seed) % 6]);
+        if (useFloat) appendFloatExpression(builder, seed, 1);
+        else appendIntExpression(builder, seed, 1);
+        appendText(builder, ")");
+    }
+}
+
+static void appendStatements(TextBuilder* builder, uint32_t* seed, int count, const char* indent) {
+    char text[32];
+    for (int i = 0; i < count; i++) {
+        appendText(builder, indent);
+        switch (nextRandom(seed) % 5) {
+            case 0:
+            case 1:
+                snprintf(text, sizeof(text), "i%u = ", nextRandom(seed) % 4);
+                appendText(builder, text);
+                appendIntExpression(builder, seed, 3);
+                break;
+            case 2:
+                snprintf(text, sizeof(text), "f%u = ", nextRandom(seed) % 3);
+                appendText(builder, text);
+                appendFloatExpression(builder, seed, 2);
+                break;
+            case 3:
+                appendText(builder, "b0 = ");
+                appendCondition(builder, seed, 2);
+                break;
+            default:
+                appendText(builder, "if (");
+                appendCondition(builder, seed, 2);
+                snprintf(text, sizeof(text), ") {\n%s    i%u += ", indent, nextRandom(seed) % 4);
+                appendText(builder, text);
+                appendIntExpression(builder, seed, 2);
+                snprintf(text, sizeof(text), ";\n%s} else {\n%s    f%u -= ", indent, indent, nextRandom(seed) % 3);
+                appendText(builder, text);
+                appendFloatExpression(builder, seed, 1);
+                appendText(builder, ";\n");
+                appendText(builder, indent);
+                appendText(builder, "}\n");
+                continue;
+        }
+        appendText(builder, ";\n");
+    }
+}
+
+// Function to build a random loop over int, float and bool arithmetic that prints its state
+static TextBuilder generateArithmeticProgram(uint32_t seed) {
+    TextBuilder builder = {NULL, 0, 0};
+    appendText(&builder, "int i0 = 3;\nint i1 = 7;\nint i2 = 0 - 4;\nint i3 = 11;\n"
+                         "float f0 = 1.5;\nfloat f1 = 0.25;\nfloat f2 = 2.0;\nbool b0 = 1 < 2;\n"
+                         "int n = 0;\nwhile (n < 40) {\n");
+    appendStatements(&builder, &seed, 6, "    ");
+    appendText(&builder, "    n += 1;\n}\nfor (int k = 0; k < 3; k++) {\n");
+    appendStatements(&builder, &seed, 3, "    ");
+    appendText(&builder, "    printf(\"%d %d %d %d %f %f %f %s\\n\", i0, i1, i2, i3, f0, f1, f2, b0);\n}\n");
+    return builder;
+}
+
+// Function to run random programs interpreted and with the JIT; returns how many differed
+static int differentialJitPrograms(int count) {
+    char interpreted[4096];
+    char native[4096];
+    int mismatches = 0, skipped = 0;
+    for (int i = 0; i < count; i++) {
+        TextBuilder source = generateArithmeticProgram(0x9E3779B9u + (uint32_t)i * 7919u);
+        BytecodeProgram* program = compileSource("random", source.text, NULL);
+        if (!program) {
+            skipped++;
+            free(source.text);
+            continue;
+        }
+        int interpretedStatus, nativeStatus;
+        vmJit = 0;
+        runCaptured(program, interpreted, sizeof(interpreted), &interpretedStatus);
+        vmJit = 1;
+        runCaptured(program, native, sizeof(native), &nativeStatus);
+        vmJit = 0;
+        if (interpretedStatus != nativeStatus || strcmp(interpreted, native) != 0) {
+            if (mismatches++ == 0) {
+                printf("  first mismatch, program %d:\n%s\n  interpreter:\n%s  JIT:\n%s", i, source.text, interpreted, native);
+            }
+        }
+        freeBytecode(program);
+        free(source.text);
+    }
+    printf("  differential: %d random programs, %d mismatches, %d skipped\n", count, mismatches, skipped);
+    return mismatches + skipped;
+}
+
+// Baseline JIT against the interpreter: timed loops, then random differential programs
+static int benchmarkJit(void) {
+    parserDebug = 0;
+    printf("jit: x86-64 native code against the bytecode interpreter\n");
+    BytecodeProgram* probe = compileSource("probe", "int x = 1;\n", NULL);
+    JitCode* jit = probe ? compileJit(probe) : NULL;
+    freeBytecode(probe);
+    if (!jit) {
+        printf("  JIT unavailable on this platform; skipped\n");
+        return 0;
+    }
+    freeJit(jit);
+
+    int ok = 1;
+    for (size_t i = 0; i < sizeof(vmPrograms) / sizeof(vmPrograms[0]); i++) {
+        ok = timeJitProgram(&vmPrograms[i]) && ok;
+    }
+    ok = differentialJitPrograms(300) == 0 && ok;
+    return ok ? 0 : 1;
+}
+
+// ---------------------------------------
+// Tiered execution
+// ---------------------------------------
+
+// Function to run one VM program at `size` interpreted, tiered and with the JIT
+// compiled up front, all checked against C
+static int timeTieredProgram(const VmProgram* entry, int size) {
+    char source[2048];
+    char expected[128];
+    char interpreted[128];
+    char tiered[128];
+    char eager[128];
+    int interpretedStatus, tieredStatus, eagerStatus;
+    snprintf(source, sizeof(source), entry->source, size);
+
+    BytecodeProgram* program = compileSource(entry->title, source, NULL);
+    if (!program) return 0;
+
+    double vmTime = runCaptured(program, interpreted, sizeof(interpreted), &interpretedStatus);
+    vmTiered = 1;
+    double tieredTime = runCaptured(program, tiered, sizeof(tiered), &tieredStatus);
+    vmTiered = 0;
+    vmJit = 1;
+    double eagerTime = runCaptured(program, eager, sizeof(eager), &eagerStatus);
+    vmJit = 0;
+    entry->reference(size, expected, sizeof(expected));
+
+    int ok = interpretedStatus == 0 && tieredStatus == 0 && eagerStatus == 0 && strcmp(interpreted, expected) == 0 &&
+             strcmp(tiered, expected) == 0 && strcmp(eager, expected) == 0;
+    tiered[strcspn(tiered, "\n")] = '\0';
+    expected[strcspn(expected, "\n")] = '\0';
+    printf("  %-7s n=%-8d tiered %8.3f ms, VM %8.3f ms, eager JIT %8.3f ms, printed %s %s\n",
+           entry->title, size, tieredTime * 1e3, vmTime * 1e3, eagerTime * 1e3, tiered, ok ? "OK" : "MISMATCH");
+    if (!ok) printf("           expected %s\n", expected);
+
+    freeBytecode(program);
+    return ok;
+}
+
+// Tiered execution against the interpreter and the eager JIT, on short runs
+// (where compiling would not pay off) and on the full loop-heavy runs
+static int benchmarkTiered(void) {
+    parserDebug = 0;
+    printf("tiered: interpreter first, loops promoted to native code after %d back-edges\n", vmHotLoopThreshold);
+    int ok = 1;
+    for (size_t i = 0; i < sizeof(vmPrograms) / sizeof(vmPrograms[0]); i++) {
+        ok = timeTieredProgram(&vmPrograms[i], 20) && ok;
+    }
+    for (size_t i = 0; i < sizeof(vmPrograms) / sizeof(vmPrograms[0]); i++) {
+        ok = timeTieredProgram(&vmPrograms[i], vmPrograms[i].size) && ok;
+    }
+
+    // Random programs with a threshold low enough that their loops tier up mid-run
+    char interpreted[4096];
+    char promoted[4096];
+    int mismatches = 0, skipped = 0;
+    int threshold = vmHotLoopThreshold;
+    vmHotLoopThreshold = 2;
+    for (int i = 0; i < 200; i++) {
+        TextBuilder source = generateArithmeticProgram(0x2545F491u + (uint32_t)i * 7919u);
+        BytecodeProgram* program = compileSource("random", source.text, NULL);
+        if (!program) {
+            skipped++;
+            free(source.text);
+            continue;
+        }
+        int interpretedStatus, promotedStatus;
+        runCaptured(program, interpreted, sizeof(interpreted), &interpretedStatus);
+        vmTiered = 1;
+        runCaptured(program, promoted, sizeof(promoted), &promotedStatus);
+        vmTiered = 0;
+        if (interpretedStatus != promotedStatus || strcmp(interpreted, promoted) != 0) {
+            if (mismatches++ == 0) {
+                printf("  first mismatch, program %d:\n%s\n  interpreter:\n%s  tiered:\n%s", i, source.text, interpreted, promoted);
+            }
+        }
+        freeBytecode(program);
+        free(source.text);
+    }
+    vmHotLoopThreshold = threshold;
+    printf("  differential: 200 random programs tiering up after 2 back-edges, %d mismatches, %d skipped\n",
+           mismatches, skipped);
+    return ok && mismatches + skipped == 0 ? 0 : 1;
+}
+
+// ---------------------------------------
+// printf
+// ---------------------------------------
+
+// Function to compare formatInt and formatFloat with snprintf on `count` random values
+// of every magnitude, plus the edge cases; returns the number of differences
+static int formatMismatches(int count) {
+    static const double edges[] = {0.0, -0.0, 0.5, -0.5, 0.0000005, 0.0000015, 0.0000025, 2.5e-7, -1e-9,
+                                   1.0 / 3.0, 9999999.9999995, 1e7, 1e15, 1e300, -1e300, 1e-300, 0.1, 0.7};
+    char fast[FORMAT_FLOAT_MAX + 1];
+    char reference[FORMAT_FLOAT_MAX + 1];
+    int mismatches = 0;
+    uint32_t seed = 99991;
+    double zero = 0.0;
+    for (int i = -3; i < count; i++) {
+        int32_t n = i == -3 ? INT32_MIN : i == -2 ? INT32_MAX : i == -1 ? 0 : (int32_t)nextRandom(&seed);
+        int length = formatInt(fast, n);
+        fast[length] = '\0';
+        snprintf(reference, sizeof(reference), "%d", n);
+        if (strcmp(fast, reference) != 0) mismatches++;
+
+        double f;
+        if (i < 0) {
+            f = i == -3 ? zero / zero : i == -2 ? 1.0 / zero : -1.0 / zero;
+        } else if (i < (int)(sizeof(edges) / sizeof(edges[0]))) {
+            f = edges[i];
+        } else {
+            // Random mantissa and decimal scale, and every few values an exact tie
+            double scale = 1.0;
+            for (uint32_t e = nextRandom(&seed) % 16; e > 0; e--) scale *= 10.0;
+            f = (double)(int32_t)nextRandom(&seed) / scale;
+            if (i % 7 == 0) f = (double)((int32_t)nextRandom(&seed) % 100000) + 0.5 / 1e6 * (nextRandom(&seed) % 3);
+        }
+        length = formatFloat(fast, f);
+        fast[length] = '\0';
+        snprintf(reference, sizeof(reference), "%f", f);
+        if (strcmp(fast, reference) != 0) {
+            if (mismatches++ == 0) printf("  first mismatch: %.17g -> %s, printf %s\n", f, fast, reference);
+        }
+    }
+    return mismatches;
+}
+
+// Precompiled formats and buffered output against calling fprintf per statement:
+// an output-heavy loop, with the VM's output compared byte for byte
+static int benchmarkPrint(void) {
+    enum { LINES = 200000 };
+    parserDebug = 0;
+    printf("print: precompiled printf formats into a buffer, against fprintf per statement\n");
+    int mismatches = formatMismatches(1000000);
+    printf("  formatInt/formatFloat against snprintf on 1000000 values each: %d mismatches\n", mismatches);
+
+    char source[512];
+    snprintf(source, sizeof(source),
+             "float f = 0.5;\n"
+             "string word = \"row\";\n"
+             "char mark = 'x';\n"
+             "for (int i = 0; i < %d; i++) {\n"
+             "    printf(\"%%s %%d: f=%%f c=%%c\\n\", word, i, f, mark);\n"
+             "    f = f * 1.25 + 0.1;\n"
+             "    if (f > 1000.0) {\n"
+             "        f = f / 1000.0;\n"
+             "    }\n"
+             "}\n",
+             LINES);
+    BytecodeProgram* program = compileSource("print", source, NULL);
+    FILE* vmOutput = tmpfile();
+    FILE* cOutput = tmpfile();
+    if (!program || !vmOutput || !cOutput) {
+        freeBytecode(program);
+        if (vmOutput) fclose(vmOutput);
+        if (cOutput) fclose(cOutput);
+        return 1;
+    }
+
+    // Fastest of three runs each; every run rewrites the same bytes
+    int status = 0;
+    double vmTime = 0.0;
+    double cTime = 0.0;
+    for (int run = 0; run < 3; run++) {
+        rewind(vmOutput);
+        double start = benchmarkNow();
+        status |= runBytecode(program, stdin, vmOutput);
+        double elapsed = benchmarkNow() - start;
+        if (run == 0 || elapsed < vmTime) vmTime = elapsed;
+
+        rewind(cOutput);
+        start = benchmarkNow();
+        double f = 0.5;
+        const char* word = "row";
+        for (int i = 0; i < LINES; i++) {
+            fprintf(cOutput, "%s %d: f=%f c=%c\n", word, i, f, 'x');
+            f = f * 1.25 + 0.1;
+            if (f > 1000.0) f = f / 1000.0;
+        }
+        fflush(cOutput);
+        elapsed = benchmarkNow() - start;
+        if (run == 0 || elapsed < cTime) cTime = elapsed;
+    }
+
+    // Same bytes?
+    rewind(vmOutput);
+    rewind(cOutput);
+    int same = status == 0;
+    long bytes = 0;
+    for (int a, b; same;) {
+        a = fgetc(vmOutput);
+        b = fgetc(cOutput);
+        same = a == b;
+        if (a == EOF || b == EOF) break;
+        bytes++;
+    }
+    printf("  %d lines (%ld bytes): VM %7.2f ms, C fprintf per statement %7.2f ms (%.1fx), output %s\n",
+           LINES, bytes, vmTime * 1e3, cTime * 1e3, vmTime > 0 ? cTime / vmTime : 0.0, same ? "OK" : "MISMATCH");
+
+    fclose(vmOutput);
+    fclose(cOutput);
+    freeBytecode(program);
+    return same && mismatches == 0 ? 0 : 1;
+}
+
+// ---------------------------------------
+// input
+// ---------------------------------------
+
+// Function to run the reading program over `input`; returns the seconds taken and what it printed
+static double timeInputRun(const BytecodeProgram* program, FILE* input, char* printed, size_t printedSize,
+                           int* status) {
+    FILE* output = tmpfile();
+    printed[0] = '\0';
+    if (!output) {
+        *status = 1;
+        return 0.0;
+    }
+    double start = benchmarkNow();
+    *status = runBytecode(program, input, output);
+    double elapsed = benchmarkNow() - start;
+    rewind(output);
+    size_t length = fread(printed, 1, printedSize - 1, output);
+    printed[length] = '\0';
+    fclose(output);
+    return elapsed;
+}
+
+// input() over a million ints and a million floats: from a redirected file (mapped),
+// through a pipe (block reads), and the same loop in C calling fscanf per value
+static int benchmarkInput(void) {
+    enum { VALUES = 1000000 };
+    parserDebug = 0;
+    printf("input: %d ints and %d floats read with input(), against fscanf per value\n", VALUES, VALUES);
+
+    FILE* data = fopen("input_bench.txt", "w");
+    if (!data) {
+        printf("  unable to create input_bench.txt\n");
+        return 1;
+    }
+    uint32_t seed = 4242;
+    for (int i = 0; i < VALUES; i++) {
+        int32_t n = (int32_t)(nextRandom(&seed) % 2000001) - 1000000;
+        int32_t f = (int32_t)(nextRandom(&seed) % 2000001) - 1000000;
+        if (i % 100 == 0) {
+            fprintf(data, "%d %.6e\n", n, f / 1000.0); // Exponent form now and then
+        } else {
+            fprintf(data, "%d\t%.3f\n", n, f / 1000.0);
+        }
+    }
+    fclose(data);
+
+    char source[512];
+    snprintf(source, sizeof(source),
+             "int n;\n"
+             "float x;\n"
+             "int total = 0;\n"
+             "float sum = 0.0;\n"
+             "for (int i = 0; i < %d; i++) {\n"
+             "    input(\"%%d\", &n);\n"
+             "    input(\"%%f\", &x);\n"
+             "    total = total + n;\n"
+             "    sum = sum + x;\n"
+             "}\n"
+             "printf(\"%%d %%f\\n\", total, sum);\n",
+             VALUES);
+    BytecodeProgram* program = compileSource("input", source, NULL);
+    if (!program) {
+        remove("input_bench.txt");
+        return 1;
+    }
+
+    // The reference: fscanf per value, summed the same way
+    char expected[128];
+    data = fopen("input_bench.txt", "r");
+    double start = benchmarkNow();
+    int32_t total = 0;
+    double sum = 0.0;
+    for (int i = 0; i < VALUES; i++) {
+        int n;
+        double x;
+        if (fscanf(data, "%d", &n) != 1 || fscanf(data, "%lf", &x) != 1) break;
+        total = intAdd(total, n);
+        sum = sum + x;
+    }
+    double scanfTime = benchmarkNow() - start;
+    fclose(data);
+    snprintf(expected, sizeof(expected), "%d %f\n", total, sum);
+
+    char printed[128];
+    int status;
+    data = fopen("input_bench.txt", "r");
+    double mappedTime = timeInputRun(program, data, printed, sizeof(printed), &status);
+    fclose(data);
+    int ok = status == 0 && strcmp(printed, expected) == 0;
+    printf("  redirected file: VM %7.2f ms, C fscanf per value %7.2f ms (%.1fx), %s\n", mappedTime * 1e3,
+           scanfTime * 1e3, mappedTime > 0 ? scanfTime / mappedTime : 0.0, ok ? "OK" : "MISMATCH");
+
+#ifndef _WIN32
+    FILE* pipe = popen("cat input_bench.txt", "r");
+    if (pipe) {
+        double pipeTime = timeInputRun(program, pipe, printed, sizeof(printed), &status);
+        pclose(pipe);
+        int pipeOk = status == 0 && strcmp(printed, expected) == 0;
+        ok = ok && pipeOk;
+        printf("  pipe:            VM %7.2f ms (%.1fx), %s\n", pipeTime * 1e3,
+               pipeTime > 0 ? scanfTime / pipeTime : 0.0, pipeOk ? "OK" : "MISMATCH");
+    }
+#endif
+    expected[strcspn(expected, "\n")] = '\0';
+    printf("  printed %s\n", expected);
+
+    freeBytecode(program);
+    remove("input_bench.txt");
+    return ok ? 0 : 1;
+}
+
+// ---------------------------------------
+// Value representation
+// ---------------------------------------
+
+// The straightforward alternative to NaN boxing: a kind next to a union (16 bytes)
+typedef struct {
+    ValueKind kind;
+    union {
+        int32_t i;
+        double f;
+        const char* s;
+        ValueArray* a;
+    } as;
+} UnionValue;
+
+// Function to check that every kind survives boxing, including the edge cases
+static int valueRoundTrips(void) {
+    static const char* text = "text";
+    ValueArray* array = newValueArray(3);
+    array->items[0] = boxInt(1);
+    array->items[1] = boxFloat(2.5);
+    array->items[2] = boxString(text);
+    double zero = 0.0;
+    double nan = zero / zero;
+    double negativeZero = -zero;
+    char buffer[64];
+
+    int ok = valueKind(boxInt(INT32_MIN)) == VALUE_INT && unboxInt(boxInt(INT32_MIN)) == INT32_MIN &&
+             unboxInt(boxInt(INT32_MAX)) == INT32_MAX && unboxInt(boxInt(-1)) == -1 &&
+             valueKind(boxChar('z')) == VALUE_CHAR && unboxInt(boxChar('z')) == 'z' &&
+             valueKind(boxBool(7)) == VALUE_BOOL && unboxInt(boxBool(7)) == 1 &&
+             valueKind(boxNull()) == VALUE_NULL &&
+             valueKind(boxString(text)) == VALUE_STRING && unboxString(boxString(text)) == text &&
+             valueKind(boxArray(array)) == VALUE_ARRAY && unboxArray(boxArray(array)) == array &&
+             valueKind(boxFloat(nan)) == VALUE_FLOAT && unboxFloat(boxFloat(nan)) != unboxFloat(boxFloat(nan)) &&
+             valueKind(boxFloat(-nan)) == VALUE_FLOAT &&
+             valueKind(boxFloat(negativeZero)) == VALUE_FLOAT && boxFloat(negativeZero) != boxFloat(zero) &&
+             valueKind(boxFloat(-1.0 / zero)) == VALUE_FLOAT && unboxFloat(boxFloat(-1.0 / zero)) < -1e308 &&
+             unboxFloat(boxFloat(1e308)) == 1e308 &&
+             strcmp(valueText(boxArray(array), buffer, sizeof(buffer)), "[1, 2.500000, text]") == 0;
+    freeValueArray(array);
+    return ok;
+}
+
+// NaN-boxed values against the kind-plus-union layout: bytes per value, and a pass
+// that reads a million mixed values in each (ints, floats, bools, chars, null, strings)
+static int benchmarkValues(void) {
+    enum { COUNT = 1000000, PASSES = 20 };
+    static const char* words[] = {"alpha", "be", "gamma", "delta"};
+    printf("values: NaN-boxed %d-byte values against a %d-byte kind-plus-union\n",
+           (int)sizeof(TaggedValue), (int)sizeof(UnionValue));
+    int ok = valueRoundTrips();
+    printf("  round trips (int limits, NaN, -0.0, infinities, pointers, arrays) %s\n", ok ? "OK" : "MISMATCH");
+
+    TaggedValue* boxed = (TaggedValue*)malloc(COUNT * sizeof(TaggedValue));
+    UnionValue* unions = (UnionValue*)malloc(COUNT * sizeof(UnionValue));
+    if (!boxed || !unions) {
+        printf("  out of memory\n");
+        free(boxed);
+        free(unions);
+        return 1;
+    }
+    uint32_t seed = 12345;
+    for (int i = 0; i < COUNT; i++) {
+        uint32_t r = nextRandom(&seed);
+        int32_t n = (int32_t)(r >> 8) - (1 << 22);
+        UnionValue* u = &unions[i];
+        switch (r % 6) {
+            case 0: boxed[i] = boxInt(n); u->kind = VALUE_INT; u->as.i = n; break;
+            case 1: boxed[i] = boxFloat(n * 0.5); u->kind = VALUE_FLOAT; u->as.f = n * 0.5; break;
+            case 2: boxed[i] = boxBool(n & 1); u->kind = VALUE_BOOL; u->as.i = n & 1; break;
+            case 3: boxed[i] = boxChar('a' + (n & 15)); u->kind = VALUE_CHAR; u->as.i = 'a' + (n & 15); break;
+            case 4: boxed[i] = boxNull(); u->kind = VALUE_NULL; u->as.i = 0; break;
+            default: boxed[i] = boxString(words[n & 3]); u->kind = VALUE_STRING; u->as.s = words[n & 3]; break;
+        }
+    }
+
+    // Sum what each kind contributes; both layouts must agree
+    double boxedSum = 0.0, unionSum = 0.0;
+    double start = benchmarkNow();
+    for (int pass = 0; pass < PASSES; pass++) {
+        for (int i = 0; i < COUNT; i++) {
+            TaggedValue v = boxed[i];
+            switch (valueKind(v)) {
+                case VALUE_FLOAT: boxedSum += unboxFloat(v); break;
+                case VALUE_STRING: boxedSum += (double)strlen(unboxString(v)); break;
+                case VALUE_NULL: case VALUE_ARRAY: break;
+                default: boxedSum += unboxInt(v); break;
+            }
+        }
+    }
+    double boxedTime = benchmarkNow() - start;
+    start = benchmarkNow();
+    for (int pass = 0; pass < PASSES; pass++) {
+        for (int i = 0; i < COUNT; i++) {
+            const UnionValue* u = &unions[i];
+            switch (u->kind) {
+                case VALUE_FLOAT: unionSum += u->as.f; break;
+                case VALUE_STRING: unionSum += (double)strlen(u->as.s); break;
+                case VALUE_NULL: case VALUE_ARRAY: break;
+                default: unionSum += u->as.i; break;
+            }
+        }
+    }
+    double unionTime = benchmarkNow() - start;
+
+    int sumsMatch = boxedSum == unionSum;
+    ok = ok && sumsMatch;
+    printf("  %d mixed values: NaN-boxed %5.1f MB, %6.2f ms per pass\n", COUNT,
+           COUNT * sizeof(TaggedValue) / 1e6, boxedTime * 1e3 / PASSES);
+    printf("  %*s kind+union %5.1f MB, %6.2f ms per pass, sums %s\n", 21, "",
+           COUNT * sizeof(UnionValue) / 1e6, unionTime * 1e3 / PASSES, sumsMatch ? "OK" : "MISMATCH");
+    free(boxed);
+    free(unions);
+    return ok ? 0 : 1;
+}
+
+// ---------------------------------------
+// arrays
+// ---------------------------------------
+
+// Array loops that bounds-check elimination applies to: a sum over an int array
+// and a threshold scan over a float array, each swept repeatedly
+static const char* const arraySources[][2] = {
+    {"sum",
+     "int n = %d;\n"
+     "array int a[n];\n"
+     "for (int i = 0; i < n; i++) {\n"
+     "    a[i] = i %% 1000;\n"
+     "}\n"
+     "int total = 0;\n"
+     "for (int pass = 0; pass < 50; pass++) {\n"
+     "    for (int i = 0; i < n; i++) {\n"
+     "        total += a[i];\n"
+     "    }\n"
+     "}\n"
+     "printf(\"sum=%%d\\n\", total);\n"},
+    {"scan",
+     "int n = %d;\n"
+     "array float v[n];\n"
+     "for (int i = 0; i < n; i++) {\n"
+     "    v[i] = (i %% 977) * 0.5;\n"
+     "}\n"
+     "int above = 0;\n"
+     "for (int pass = 0; pass < 50; pass++) {\n"
+     "    float limit = pass * 8.0;\n"
+     "    for (int i = 0; i < n; i++) {\n"
+     "        if (v[i] > limit) {\n"
+     "            above += 1;\n"
+     "        }\n"
+     "    }\n"
+     "}\n"
+     "printf(\"above=%%d\\n\", above);\n"},
+};
+
+static int countOpcode(const BytecodeProgram* program, int opcode) {
+    int count = 0;
+    for (int pc = 0; pc < program->codeCount; pc++) count += program->code[pc].opcode == opcode;
+    return count;
+}
+
+// Each program compiled with and without bounds-check elimination: checks left, time, same output
+static int benchmarkArrays(void) {
+    enum { LENGTH = 100000 };
+    parserDebug = 0;
+    printf("arrays: typed array loops with bounds checks proven by the loop test, against checking every access\n");
+    int ok = 1;
+    for (size_t p = 0; p < sizeof(arraySources) / sizeof(arraySources[0]); p++) {
+        char source[1024];
+        char checked[128], proven[128];
+        int checkedStatus, provenStatus;
+        snprintf(source, sizeof(source), arraySources[p][1], LENGTH);
+
+        cfgVectorizeLoops = 0; // Time the loops the checks are in, not a kernel that replaces them
+        cfgBoundsCheckElimination = 0;
+        BytecodeProgram* checkedProgram = compileSource(arraySources[p][0], source, NULL);
+        cfgBoundsCheckElimination = 1;
+        BytecodeProgram* program = compileSource(arraySources[p][0], source, NULL);
+        cfgVectorizeLoops = 1;
+        if (!checkedProgram || !program) {
+            freeBytecode(checkedProgram);
+            freeBytecode(program);
+            return 1;
+        }
+
+        double checkedTime = runCaptured(checkedProgram, checked, sizeof(checked), &checkedStatus);
+        double provenTime = runCaptured(program, proven, sizeof(proven), &provenStatus);
+        int same = checkedStatus == 0 && provenStatus == 0 && strcmp(checked, proven) == 0;
+        ok = ok && same;
+        printf("  %-5s %d elements x 50: every access checked %7.2f ms (%d checks), proven %7.2f ms (%d checks, %.2fx), output %s\n",
+               arraySources[p][0], LENGTH, checkedTime * 1e3, countOpcode(checkedProgram, BC_CHECK_INDEX),
+               provenTime * 1e3, countOpcode(program, BC_CHECK_INDEX),
+               provenTime > 0 ? checkedTime / provenTime : 0.0, same ? "OK" : "MISMATCH");
+        freeBytecode(checkedProgram);
+        freeBytecode(program);
+    }
+    return ok ? 0 : 1;
+}
+
+// Loops vectorizeLoops() replaces, run 200 times over the same arrays: an int and
+// a float element-wise map, an int sum and a float dot product
+static const char* const vectorSources[][2] = {
+    {"map-i",
+     "int n = %d;\n"
+     "array int a[n];\n"
+     "array int b[n];\n"
+     "array int c[n];\n"
+     "for (int i = 0; i < n; i++) {\n"
+     "    a[i] = i %% 1000;\n"
+     "    b[i] = 7 - i %% 13;\n"
+     "}\n"
+     "for (int pass = 0; pass < 200; pass++) {\n"
+     "    for (int i = 0; i < n; i++) {\n"
+     "        c[i] = a[i] * b[i];\n"
+     "    }\n"
+     "    for (int i = 0; i < n; i++) {\n"
+     "        a[i] = c[i] + a[i];\n"
+     "    }\n"
+     "}\n"
+     "int total = 0;\n"
+     "for (int i = 0; i < n; i++) {\n"
+     "    total += a[i];\n"
+     "}\n"
+     "printf(\"total=%%d\\n\", total);\n"},
+    {"map-f",
+     "int n = %d;\n"
+     "array float x[n];\n"
+     "array float y[n];\n"
+     "for (int i = 0; i < n; i++) {\n"
+     "    x[i] = (i %% 977) * 0.5;\n"
+     "}\n"
+     "for (int pass = 0; pass < 200; pass++) {\n"
+     "    for (int i = 0; i < n; i++) {\n"
+     "        y[i] = x[i] * 0.5;\n"
+     "    }\n"
+     "    for (int i = 0; i < n; i++) {\n"
+     "        x[i] = y[i] + 1.5;\n"
+     "    }\n"
+     "}\n"
+     "float first = x[1];\n"
+     "float last = x[n - 1];\n"
+     "printf(\"x1=%%.17g last=%%.17g\\n\", first, last);\n"},
+    {"sum-i",
+     "int n = %d;\n"
+     "array int a[n];\n"
+     "for (int i = 0; i < n; i++) {\n"
+     "    a[i] = i %% 1000 - 300;\n"
+     "}\n"
+     "int total = 0;\n"
+     "for (int pass = 0; pass < 200; pass++) {\n"
+     "    for (int i = 0; i < n; i++) {\n"
+     "        total += a[i];\n"
+     "    }\n"
+     "}\n"
+     "printf(\"sum=%%d\\n\", total);\n"},
+    {"dot-f",
+     "int n = %d;\n"
+     "array float x[n];\n"
+     "array float y[n];\n"
+     "for (int i = 0; i < n; i++) {\n"
+     "    x[i] = (i %% 977) * 0.25;\n"
+     "    y[i] = (i %% 131) * 0.125;\n"
+     "}\n"
+     "float d = 0.0;\n"
+     "for (int pass = 0; pass < 200; pass++) {\n"
+     "    for (int i = 0; i < n; i++) {\n"
+     "        d += x[i] * y[i];\n"
+     "    }\n"
+     "}\n"
+     "printf(\"dot=%%.17g\\n\", d);\n"},
+};
+
+// Function to compare printed results: exactly, or for float sums (reassociated) each
+// number within a relative 1e-9 of the scalar loop's
+static int sameVectorOutput(const char* expected, const char* actual, int tolerant) {
+    if (!tolerant) return strcmp(expected, actual) == 0;
+    const char* value = strchr(expected, '=');
+    const char* other = strchr(actual, '=');
+    if (!value || !other) return 0;
+    double a = strtod(value + 1, NULL), b = strtod(other + 1, NULL);
+    double scale = a < 0 ? -a : a;
+    double difference = a > b ? a - b : b - a;
+    return difference <= 1e-9 * (scale > 1.0 ? scale : 1.0);
+}
+
+// Each program run as scalar bytecode loops, then as kernels on every instruction set
+// the CPU has: time per form and the same output
+static int benchmarkVectorize(void) {
+    enum { LENGTH = 100000 };
+    static const VectorIsa isas[] = {VECTOR_ISA_SCALAR, VECTOR_ISA_SSE2, VECTOR_ISA_AVX2};
+    parserDebug = 0;
+    printf("vectorize: array loops as whole-loop kernels against the interpreter's loop (best here: %s)\n",
+           vectorIsaName(vectorIsa()));
+    int ok = 1;
+    for (size_t p = 0; p < sizeof(vectorSources) / sizeof(vectorSources[0]); p++) {
+        char source[2048];
+        char expected[128], actual[128];
+        int status;
+        snprintf(source, sizeof(source), vectorSources[p][1], LENGTH);
+
+        cfgVectorizeLoops = 0;
+        BytecodeProgram* scalarProgram = compileSource(vectorSources[p][0], source, NULL);
+        cfgVectorizeLoops = 1;
+        BytecodeProgram* program = compileSource(vectorSources[p][0], source, NULL);
+        if (!scalarProgram || !program) {
+            freeBytecode(scalarProgram);
+            freeBytecode(program);
+            return 1;
+        }
+        int kernels = countOpcode(program, BC_VECTOR_MAP_I) + countOpcode(program, BC_VECTOR_MAP_F) +
+                      countOpcode(program, BC_VECTOR_SUM_I) + countOpcode(program, BC_VECTOR_SUM_F);
+        double scalarTime = runCaptured(scalarProgram, expected, sizeof(expected), &status);
+        ok = ok && status == 0 && kernels > 0;
+        printf("  %-5s %d elements x 200: loop %8.2f ms", vectorSources[p][0], LENGTH, scalarTime * 1e3);
+
+        int tolerant = strcmp(vectorSources[p][0], "dot-f") == 0;
+        int supported = vectorIsa();
+        for (size_t k = 0; k < sizeof(isas) / sizeof(isas[0]); k++) {
+            if ((int)isas[k] > supported) continue;
+            vectorIsaLimit = isas[k];
+            double time = runCaptured(program, actual, sizeof(actual), &status);
+            int same = status == 0 && sameVectorOutput(expected, actual, tolerant);
+            ok = ok && same;
+            printf(", %s %7.2f ms (%.1fx%s)", vectorIsaName(isas[k]), time * 1e3,
+                   time > 0 ? scalarTime / time : 0.0, same ? "" : ", MISMATCH");
+        }
+        vectorIsaLimit = VECTOR_ISA_AVX2;
+        printf(", %d kernel%s\n", kernels, kernels == 1 ? "" : "s");
+        freeBytecode(scalarProgram);
+        freeBytecode(program);
+    }
+    return ok ? 0 : 1;
+}
+
+// ---------------------------------------
+// switch
+// ---------------------------------------
+
+// The same dispatch written as a switch and as an if/else-if chain: 16 dense int
+// labels (a jump table), 12 sparse ones (a binary search) and 8 strings (hashed)
+static const char* const switchSources[][3] = {
+    {"dense",
+     "int total = 0;\n"
+     "for (int i = 0; i < %d; i++) {\n"
+     "    int k = i %% 17;\n"
+     "    switch (k) {\n"
+     "        case 0: total += 3; break;\n"
+     "        case 1: total += 5; break;\n"
+     "        case 2: total += 7; break;\n"
+     "        case 3: total += 11; break;\n"
+     "        case 4: total += 13; break;\n"
+     "        case 5: total += 17; break;\n"
+     "        case 6: total += 19; break;\n"
+     "        case 7: total += 23; break;\n"
+     "        case 8: total += 29; break;\n"
+     "        case 9: total += 31; break;\n"
+     "        case 10: total += 37; break;\n"
+     "        case 11: total += 41; break;\n"
+     "        case 12: total += 43; break;\n"
+     "        case 13: total += 47; break;\n"
+     "        case 14: total += 53; break;\n"
+     "        case 15: total += 59; break;\n"
+     "        default: total += 1;\n"
+     "    }\n"
+     "}\n"
+     "printf(\"total=%%d\\n\", total);\n",
+     "int total = 0;\n"
+     "for (int i = 0; i < %d; i++) {\n"
+     "    int k = i %% 17;\n"
+     "    if (k == 0) { total += 3; }\n"
+     "    else if (k == 1) { total += 5; }\n"
+     "    else if (k == 2) { total += 7; }\n"
+     "    else if (k == 3) { total += 11; }\n"
+     "    else if (k == 4) { total += 13; }\n"
+     "    else if (k == 5) { total += 17; }\n"
+     "    else if (k == 6) { total += 19; }\n"
+     "    else if (k == 7) { total += 23; }\n"
+     "    else if (k == 8) { total += 29; }\n"
+     "    else if (k == 9) { total += 31; }\n"
+     "    else if (k == 10) { total += 37; }\n"
+     "    else if (k == 11) { total += 41; }\n"
+     "    else if (k == 12) { total += 43; }\n"
+     "    else if (k == 13) { total += 47; }\n"
+     "    else if (k == 14) { total += 53; }\n"
+     "    else if (k == 15) { total += 59; }\n"
+     "    else { total += 1; }\n"
+     "}\n"
+     "printf(\"total=%%d\\n\", total);\n"},
+    {"sparse",
+     "int total = 0;\n"
+     "for (int i = 0; i < %d; i++) {\n"
+     "    int k = (i %% 13) * 97 + 3;\n"
+     "    switch (k) {\n"
+     "        case 3: total += 3; break;\n"
+     "        case 100: total += 5; break;\n"
+     "        case 197: total += 7; break;\n"
+     "        case 294: total += 11; break;\n"
+     "        case 391: total += 13; break;\n"
+     "        case 488: total += 17; break;\n"
+     "        case 585: total += 19; break;\n"
+     "        case 682: total += 23; break;\n"
+     "        case 779: total += 29; break;\n"
+     "        case 876: total += 31; break;\n"
+     "        case 973: total += 37; break;\n"
+     "        case 1070: total += 41; break;\n"
+     "        default: total += 1;\n"
+     "    }\n"
+     "}\n"
+     "printf(\"total=%%d\\n\", total);\n",
+     "int total = 0;\n"
+     "for (int i = 0; i < %d; i++) {\n"
+     "    int k = (i %% 13) * 97 + 3;\n"
+     "    if (k == 3) { total += 3; }\n"
+     "    else if (k == 100) { total += 5; }\n"
+     "    else if (k == 197) { total += 7; }\n"
+     "    else if (k == 294) { total += 11; }\n"
+     "    else if (k == 391) { total += 13; }\n"
+     "    else if (k == 488) { total += 17; }\n"
+     "    else if (k == 585) { total += 19; }\n"
+     "    else if (k == 682) { total += 23; }\n"
+     "    else if (k == 779) { total += 29; }\n"
+     "    else if (k == 876) { total += 31; }\n"
+     "    else if (k == 973) { total += 37; }\n"
+     "    else if (k == 1070) { total += 41; }\n"
+     "    else { total += 1; }\n"
+     "}\n"
+     "printf(\"total=%%d\\n\", total);\n"},
+    {"string",
+     "int total = 0;\n"
+     "string w = \"\";\n"
+     "for (int i = 0; i < %d; i++) {\n"
+     "    int k = i %% 9;\n"
+     "    w = \"walnut\";\n"
+     "    if (k < 8) { w = \"plum\"; }\n"
+     "    if (k < 7) { w = \"pear\"; }\n"
+     "    if (k < 6) { w = \"mango\"; }\n"
+     "    if (k < 5) { w = \"lemon\"; }\n"
+     "    if (k < 4) { w = \"fig\"; }\n"
+     "    if (k < 3) { w = \"cherry\"; }\n"
+     "    if (k < 2) { w = \"banana\"; }\n"
+     "    if (k < 1) { w = \"apple\"; }\n"
+     "    switch (w) {\n"
+     "        case \"apple\": total += 3; break;\n"
+     "        case \"banana\": total += 5; break;\n"
+     "        case \"cherry\": total += 7; break;\n"
+     "        case \"fig\": total += 11; break;\n"
+     "        case \"lemon\": total += 13; break;\n"
+     "        case \"mango\": total += 17; break;\n"
+     "        case \"pear\": total += 19; break;\n"
+     "        case \"plum\": total += 23; break;\n"
+     "        default: total += 1;\n"
+     "    }\n"
+     "}\n"
+     "printf(\"total=%%d\\n\", total);\n",
+     "int total = 0;\n"
+     "string w = \"\";\n"
+     "for (int i = 0; i < %d; i++) {\n"
+     "    int k = i %% 9;\n"
+     "    w = \"walnut\";\n"
+     "    if (k < 8) { w = \"plum\"; }\n"
+     "    if (k < 7) { w = \"pear\"; }\n"
+     "    if (k < 6) { w = \"mango\"; }\n"
+     "    if (k < 5) { w = \"lemon\"; }\n"
+     "    if (k < 4) { w = \"fig\"; }\n"
+     "    if (k < 3) { w = \"cherry\"; }\n"
+     "    if (k < 2) { w = \"banana\"; }\n"
+     "    if (k < 1) { w = \"apple\"; }\n"
+     "    if (w == \"apple\") { total += 3; }\n"
+     "    else if (w == \"banana\") { total += 5; }\n"
+     "    else if (w == \"cherry\") { total += 7; }\n"
+     "    else if (w == \"fig\") { total += 11; }\n"
+     "    else if (w == \"lemon\") { total += 13; }\n"
+     "    else if (w == \"mango\") { total += 17; }\n"
+     "    else if (w == \"pear\") { total += 19; }\n"
+     "    else if (w == \"plum\") { total += 23; }\n"
+     "    else { total += 1; }\n"
+     "}\n"
+     "printf(\"total=%%d\\n\", total);\n"},
+};
+
+// Each dispatch run as a switch and as its if/else-if chain: time, compares left, same output
+static int benchmarkSwitch(void) {
+    enum { ITERATIONS = 1000000 };
+    parserDebug = 0;
+    printf("switch: switch statements as jump tables, search trees and string hashes against if/else-if chains\n");
+    int ok = 1;
+    for (size_t p = 0; p < sizeof(switchSources) / sizeof(switchSources[0]); p++) {
+        char switchSource[4096], chainSource[4096];
+        char expected[128], actual[128];
+        int chainStatus, switchStatus;
+        snprintf(switchSource, sizeof(switchSource), switchSources[p][1], ITERATIONS);
+        snprintf(chainSource, sizeof(chainSource), switchSources[p][2], ITERATIONS);
+
+        BytecodeProgram* chainProgram = compileSource(switchSources[p][0], chainSource, NULL);
+        BytecodeProgram* program = compileSource(switchSources[p][0], switchSource, NULL);
+        if (!chainProgram || !program) {
+            freeBytecode(chainProgram);
+            freeBytecode(program);
+            return 1;
+        }
+
+        double chainTime = runCaptured(chainProgram, expected, sizeof(expected), &chainStatus);
+        double switchTime = runCaptured(program, actual, sizeof(actual), &switchStatus);
+        int same = chainStatus == 0 && switchStatus == 0 && strcmp(expected, actual) == 0;
+        ok = ok && same;
+        printf("  %-6s %d dispatches: if/else-if %7.2f ms, switch %7.2f ms (%.2fx; %d table%s, %d hash%s), output %s\n",
+               switchSources[p][0], ITERATIONS, chainTime * 1e3, switchTime * 1e3,
+               switchTime > 0 ? chainTime / switchTime : 0.0, countOpcode(program, BC_SWITCH),
+               countOpcode(program, BC_SWITCH) == 1 ? "" : "s", countOpcode(program, BC_HASH_S),
+               countOpcode(program, BC_HASH_S) == 1 ? "" : "es", same ? "OK" : "MISMATCH");
+        freeBytecode(chainProgram);
+        freeBytecode(program);
+    }
+    return ok ? 0 : 1;
+}
+
+// ---------------------------------------
+// loops
+// ---------------------------------------
+
+// Loops optimizeLoops() improves: an invariant float and int expression recomputed
+// every iteration next to i * k, and a matrix fill whose row offset r * columns
+// the inner loop recomputes
+static const char* const loopSources[][2] = {
+    {"invariant",
+     "int n = %d;\n"
+     "int scale = 3;\n"
+     "float rate = 1.5;\n"
+     "scale = scale + n %% 7;\n"
+     "rate = rate * 2.0;\n"
+     "float acc = 0.0;\n"
+     "int total = 0;\n"
+     "for (int i = 0; i < n; i++) {\n"
+     "    acc += scale * rate + 0.5;\n"
+     "    total += i * scale + (scale * scale - 1);\n"
+     "}\n"
+     "printf(\"acc=%%.17g total=%%d\\n\", acc, total);\n"},
+    {"matrix",
+     "int rows = %d // 500;\n"
+     "int columns = 500;\n"
+     "array int m[rows][columns];\n"
+     "for (int pass = 0; pass < 4; pass++) {\n"
+     "    for (int r = 0; r < rows; r++) {\n"
+     "        for (int c = 0; c < columns; c++) {\n"
+     "            m[r][c] = r * c + pass;\n"
+     "        }\n"
+     "    }\n"
+     "}\n"
+     "int total = 0;\n"
+     "for (int r = 0; r < rows; r++) {\n"
+     "    for (int c = 0; c < columns; c++) {\n"
+     "        total += m[r][c];\n"
+     "    }\n"
+     "}\n"
+     "printf(\"total=%%d\\n\", total);\n"},
+};
+
+// Function to run random programs compiled with and without optimizeLoops(); returns how many differed
+static int differentialLoopPrograms(int count) {
+    char plain[4096];
+    char optimized[4096];
+    int mismatches = 0, skipped = 0;
+    for (int i = 0; i < count; i++) {
+        TextBuilder source = generateArithmeticProgram(0x6C8E9CF5u + (uint32_t)i * 7919u);
+        cfgLoopOptimization = 0;
+        BytecodeProgram* plainProgram = compileSource("random", source.text, NULL);
+        cfgLoopOptimization = 1;
+        BytecodeProgram* program = compileSource("random", source.text, NULL);
+        if (!plainProgram || !program) {
+            skipped++;
+        } else {
+            int plainStatus, optimizedStatus;
+            runCaptured(plainProgram, plain, sizeof(plain), &plainStatus);
+            runCaptured(program, optimized, sizeof(optimized), &optimizedStatus);
+            if ((plainStatus != optimizedStatus || strcmp(plain, optimized) != 0) && mismatches++ == 0) {
+                printf("  first mismatch, program %d:\n%s\n  as written:\n%s  optimized:\n%s", i, source.text, plain,
+                       optimized);
+            }
+        }
+        freeBytecode(plainProgram);
+        freeBytecode(program);
+        free(source.text);
+    }
+    printf("  differential: %d random programs, %d mismatches, %d skipped\n", count, mismatches, skipped);
+    return mismatches + skipped;
+}
+
+// Each program compiled with and without loop optimization: bytecode size, time, same output
+static int benchmarkLoops(void) {
+    enum { ITERATIONS = 1000000 };
+    parserDebug = 0;
+    printf("loops: invariant code hoisted to preheaders and counter products strength-reduced, against loops as written\n");
+    int ok = 1;
+    for (size_t p = 0; p < sizeof(loopSources) / sizeof(loopSources[0]); p++) {
+        char source[1024];
+        char expected[128], actual[128];
+        int plainStatus, optimizedStatus;
+        snprintf(source, sizeof(source), loopSources[p][1], ITERATIONS);
+
+        cfgLoopOptimization = 0;
+        BytecodeProgram* plainProgram = compileSource(loopSources[p][0], source, NULL);
+        cfgLoopOptimization = 1;
+        BytecodeProgram* program = compileSource(loopSources[p][0], source, NULL);
+        if (!plainProgram || !program) {
+            freeBytecode(plainProgram);
+            freeBytecode(program);
+            return 1;
+        }
+
+        double plainTime = runCaptured(plainProgram, expected, sizeof(expected), &plainStatus);
+        double optimizedTime = runCaptured(program, actual, sizeof(actual), &optimizedStatus);
+        int same = plainStatus == 0 && optimizedStatus == 0 && strcmp(expected, actual) == 0;
+        ok = ok && same;
+        printf("  %-9s %d iterations: as written %7.2f ms (%d instructions), optimized %7.2f ms (%d instructions, "
+               "%.2fx), output %s\n",
+               loopSources[p][0], ITERATIONS, plainTime * 1e3, plainProgram->codeCount, optimizedTime * 1e3,
+               program->codeCount, optimizedTime > 0 ? plainTime / optimizedTime : 0.0, same ? "OK" : "MISMATCH");
+        freeBytecode(plainProgram);
+        freeBytecode(program);
+    }
+    ok = differentialLoopPrograms(300) == 0 && ok;
+    return ok ? 0 : 1;
+}
+
+// ---------------------------------------
+// value numbering
+// ---------------------------------------
+
+// Subexpressions the generated statements share; b and d stay positive, so
+// division never fails
+static const char* const sharedExpressions[] = {
+    "a + b", "c - d", "a * c", "b + d", "a // b", "c % d", "(a + b) * 2", "a * c - b",
+};
+
+// Function to build straight-line code that keeps recomputing a few subexpressions:
+// assignments, an occasional write to an input (so old values stop matching), and
+// blocks under a test that always holds, which recompute what dominates them
+static TextBuilder generateRedundantProgram(uint32_t seed, int statements) {
+    static const char* const operators[] = {" + ", " - ", " * "};
+    const int expressionCount = (int)(sizeof(sharedExpressions) / sizeof(sharedExpressions[0]));
+    TextBuilder builder = {NULL, 0, 0};
+    char line[160];
+    appendText(&builder, "int a = 7;\nint b = 3;\nint c = 11;\nint d = 5;\n"
+                         "a = a + 1;\nb = b + 1;\nc = c + 1;\nd = d + 1;\n"
+                         "float h = 1.5;\nh = h * 2.0;\nfloat g = 0.0;\n"
+                         "int x0 = 0;\nint x1 = 0;\nint x2 = 0;\nint x3 = 0;\n");
+    for (int i = 0; i < statements; i++) {
+        uint32_t choice = nextRandom(&seed) % 12;
+        const char* left = sharedExpressions[nextRandom(&seed) % expressionCount];
+        const char* right = sharedExpressions[nextRandom(&seed) % expressionCount];
+        int target = (int)(nextRandom(&seed) % 4);
+        if (choice < 8) {
+            snprintf(line, sizeof(line), "x%d = x%d + (%s)%s(%s);\n", target, target, left,
+                     operators[nextRandom(&seed) % 3], right);
+        } else if (choice == 8) {
+            snprintf(line, sizeof(line), "%s = %s + 1;\n", target & 1 ? "a" : "c", target & 1 ? "a" : "c");
+        } else if (choice == 9) {
+            snprintf(line, sizeof(line), "g = g + h * 0.5 + (h * 0.5 - %d.25);\n", target);
+        } else {
+            snprintf(line, sizeof(line), "if ((%s) >= (%s) || (%s) < (%s)) {\n    x%d = x%d - (%s);\n}\n",
+                     left, right, left, right, target, target, left);
+        }
+        appendText(&builder, line);
+    }
+    appendText(&builder, "printf(\"%d %d %d %d %d %f\\n\", x0, x1, x2, x3, a, g);\n");
+    return builder;
+}
+
+// Function to compile `source` with value numbering off, within blocks and dominator-scoped
+static int compileValueModes(const char* title, const char* source, BytecodeProgram* programs[3]) {
+    for (int mode = 0; mode < 3; mode++) {
+        cfgValueNumbering = mode;
+        programs[mode] = compileSource(title, source, NULL);
+    }
+    cfgValueNumbering = 2;
+    return programs[0] && programs[1] && programs[2];
+}
+
+// Generated straight-line programs, every statement run once (so instructions are
+// operations executed), at each level of value numbering; then random programs
+// with loops and branches, checked against no numbering
+static int benchmarkValueNumbering(void) {
+    enum { RUNS = 50 };
+    static const int sizes[] = {1000, 10000};
+    static const char* const modes[] = {"off", "in blocks", "dominators"};
+    parserDebug = 0;
+    printf("gvn: value numbering within blocks and down the dominator tree on generated straight-line code\n");
+    int ok = 1;
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        TextBuilder source = generateRedundantProgram(0x1B873593u + (uint32_t)s, sizes[s]);
+        BytecodeProgram* programs[3];
+        if (!compileValueModes("redundant", source.text, programs)) {
+            for (int mode = 0; mode < 3; mode++) freeBytecode(programs[mode]);
+            free(source.text);
+            return 1;
+        }
+        char expected[256], actual[256];
+        printf("  %5d statements:", sizes[s]);
+        for (int mode = 0; mode < 3; mode++) {
+            double time = 0.0;
+            int status = 0;
+            for (int run = 0; run < RUNS; run++) {
+                time += runCaptured(programs[mode], mode == 0 ? expected : actual, sizeof(expected), &status);
+            }
+            int same = status == 0 && (mode == 0 || strcmp(expected, actual) == 0);
+            ok = ok && same;
+            printf("%s %s %d instructions %.3f ms%s", mode ? "," : "", modes[mode], programs[mode]->codeCount,
+                   time * 1e3 / RUNS, same ? "" : " MISMATCH");
+        }
+        printf("\n");
+        for (int mode = 0; mode < 3; mode++) freeBytecode(programs[mode]);
+        free(source.text);
+    }
+
+    char plain[4096], numbered[4096];
+    int mismatches = 0, skipped = 0;
+    for (int i = 0; i < 300; i++) {
+        TextBuilder source = i % 2 ? generateArithmeticProgram(0x85EBCA6Bu + (uint32_t)i * 7919u)
+                                   : generateRedundantProgram(0xC2B2AE35u + (uint32_t)i, 40);
+        BytecodeProgram* programs[3];
+        if (!compileValueModes("random", source.text, programs)) {
+            skipped++;
+        } else {
+            int plainStatus, status;
+            runCaptured(programs[0], plain, sizeof(plain), &plainStatus);
+            for (int mode = 1; mode < 3; mode++) {
+                runCaptured(programs[mode], numbered, sizeof(numbered), &status);
+                if ((plainStatus != status || strcmp(plain, numbered) != 0) && mismatches++ == 0) {
+                    printf("  first mismatch, program %d (%s):\n%s\n  off:\n%s  numbered:\n%s", i, modes[mode],
+                           source.text, plain, numbered);
+                }
+            }
+        }
+        for (int mode = 0; mode < 3; mode++) freeBytecode(programs[mode]);
+        free(source.text);
+    }
+    printf("  differential: 300 random programs, %d mismatches, %d skipped\n", mismatches, skipped);
+    return ok && mismatches + skipped == 0 ? 0 : 1;
+}
+
+// ---------------------------------------
+// dataflow
+// ---------------------------------------
+
+// Function to build a program with `variables` variables, a third declared
+// without a value, read and written by `groups` if/else statements and
+// while loops, so blocks pass sets of every size around a loop nest
+static TextBuilder generateDataflowProgram(uint32_t seed, int variables, int groups) {
+    TextBuilder builder = {NULL, 0, 0};
+    char line[200];
+    for (int v = 0; v < variables; v++) {
+        if (v % 3 == 0) {
+            snprintf(line, sizeof(line), "int v%d;\n", v);
+        } else {
+            snprintf(line, sizeof(line), "int v%d = %d;\n", v, v % 97);
+        }
+        appendText(&builder, line);
+    }
+    appendText(&builder, "int n = 0;\ninput(\"%d\", &n);\n");
+    for (int g = 0; g < groups; g++) {
+        int a = (int)(nextRandom(&seed) % (uint32_t)variables);
+        int b = (int)(nextRandom(&seed) % (uint32_t)variables);
+        int c = (int)(nextRandom(&seed) % (uint32_t)variables);
+        int d = (int)(nextRandom(&seed) % (uint32_t)variables);
+        if (g % 4 == 3) {
+            snprintf(line, sizeof(line), "int k%d = 0;\nwhile (k%d < n) {\n    v%d = v%d + v%d;\n"
+                                         "    int t%d;\n    if (v%d > k%d) {\n        t%d = v%d;\n    }\n"
+                                         "    v%d = t%d;\n    k%d = k%d + 1;\n}\n",
+                     g, g, a, b, c, g, d, g, g, a, c, g, g, g);
+        } else {
+            snprintf(line, sizeof(line), "if (v%d > n) {\n    v%d = v%d + v%d;\n} else {\n    v%d = v%d;\n}\n",
+                     a, b, c, d, c, a);
+        }
+        appendText(&builder, line);
+    }
+    appendText(&builder, "printf(\"%d\\n\", n);\n");
+    return builder;
+}
+
+// Function to lower a program to its CFG as the compiler does before optimizing (NULL on errors)
+static Cfg* lowerSource(const char* title, const char* source) {
+    LexedSource* lexed = lexSource(source, strlen(source));
+    ParsedProgram* parsed = parseTokenStream(lexedTokens(lexed), lexed->tokenCount);
+    TypeCheckResult* checked = typeCheckProgram(parsed->root, lexedTokens(lexed), lexed->tokenCount);
+    Cfg* cfg = NULL;
+    if (parsed->errorCount || checked->errorCount) {
+        printf("  %s: program has %d syntax and %d type errors\n", title, parsed->errorCount, checked->errorCount);
+    } else {
+        foldConstants(parsed->root, checked->bindingCount);
+        cfg = buildCfg(parsed->root, checked->bindingCount);
+        computeDominators(cfg);
+    }
+    freeTypeCheckResult(checked);
+    freeParsedProgram(parsed);
+    freeLexedSource(lexed);
+    return cfg;
+}
+
+// What an instruction does to bit `bit` of a problem: 1 generates it, -1 kills it
+typedef int (*FactEffect)(const Cfg* cfg, const ReachingDefinitions* reaching, const IrInstruction* in,
+                          int definition, int bit);
+
+static int livenessEffect(const Cfg* cfg, const ReachingDefinitions* reaching, const IrInstruction* in,
+                          int definition, int bit) {
+    (void)cfg;
+    (void)reaching;
+    (void)definition;
+    if (in->a == bit || in->b == bit || in->c == bit) return 1;
+    return in->dst == bit ? -1 : 0;
+}
+
+static int reachingEffect(const Cfg* cfg, const ReachingDefinitions* reaching, const IrInstruction* in,
+                          int definition, int bit) {
+    (void)cfg;
+    if (definition == bit) return 1;
+    return in->dst >= 0 && in->dst == reaching->definedRegister[bit] ? -1 : 0;
+}
+
+static int assignmentEffect(const Cfg* cfg, const ReachingDefinitions* reaching, const IrInstruction* in,
+                            int definition, int bit) {
+    (void)cfg;
+    (void)reaching;
+    (void)definition;
+    if (in->dst != bit) return 0;
+    return in->implicit ? -1 : 1;
+}
+
+// Function to solve a problem one fact at a time the textbook way -- every
+// block, in order, until a whole pass changes nothing -- and compare with `flow`
+static int dataflowMatchesReference(const char* name, const Cfg* cfg, const Dataflow* flow,
+                                    const ReachingDefinitions* reaching, FactEffect effect) {
+    int n = cfg->blockCount;
+    unsigned char* in = (unsigned char*)malloc((size_t)n);
+    unsigned char* out = (unsigned char*)malloc((size_t)n);
+    if (!in || !out) {
+        fprintf(stderr, "Error: Memory allocation failed for dataflow check.\n");
+        exit(EXIT_FAILURE);
+    }
+    int ok = 1;
+    for (int bit = 0; bit < flow->bitCount && ok; bit++) {
+        memset(in, flow->intersect, (size_t)n);
+        memset(out, flow->intersect, (size_t)n);
+        int changed = 1;
+        while (changed) {
+            changed = 0;
+            for (int k = 0; k < n; k++) {
+                int b = flow->forward ? k : n - 1 - k;
+                const BasicBlock* block = &cfg->blocks[b];
+                int boundary = flow->forward ? b == 0 : block->successorCount == 0;
+                int count = flow->forward ? block->predecessorCount : block->successorCount;
+                int met = flow->intersect && count > 0 && !boundary;
+                for (int e = 0; e < count; e++) {
+                    int neighbour = flow->forward ? cfg->predecessors[block->firstPredecessor + e]
+                                                  : block->successors[e];
+                    int value = flow->forward ? out[neighbour] : in[neighbour];
+                    met = flow->intersect ? met && value : met || value;
+                }
+
+                int value = met;
+                int definition = reaching ? reaching->firstDefinition[b] : 0;
+                for (int i = 0; i < block->codeCount; i++) {
+                    int position = flow->forward ? i : block->codeCount - 1 - i;
+                    const IrInstruction* instruction = &block->code[position];
+                    int numbered = -1;
+                    if (reaching && instruction->dst >= 0) numbered = definition++;
+                    int result = effect(cfg, reaching, instruction, numbered, bit);
+                    if (result) value = result > 0;
+                }
+                unsigned char* before = flow->forward ? &in[b] : &out[b];
+                unsigned char* after = flow->forward ? &out[b] : &in[b];
+                *before = (unsigned char)met;
+                if (*after != value) {
+                    *after = (unsigned char)value;
+                    changed = 1;
+                }
+            }
+        }
+        for (int b = 0; b < n && ok; b++) {
+            if (in[b] != testBit(dataflowSet(flow, flow->in, b), bit) ||
+                out[b] != testBit(dataflowSet(flow, flow->out, b), bit)) {
+                printf("  %s: fact %d at B%d is in=%d out=%d, the reference says in=%d out=%d\n", name, bit, b,
+                       testBit(dataflowSet(flow, flow->in, b), bit), testBit(dataflowSet(flow, flow->out, b), bit),
+                       in[b], out[b]);
+                ok = 0;
+            }
+        }
+    }
+    free(in);
+    free(out);
+    return ok;
+}
+
+// Function to check all three analyses on one small program
+static int checkDataflow(const char* title, const char* source, int* checked) {
+    Cfg* cfg = lowerSource(title, source);
+    if (!cfg) return 0;
+    Dataflow* liveness = computeLiveness(cfg);
+    ReachingDefinitions* reaching = computeReachingDefinitions(cfg);
+    Dataflow* assignment = computeDefiniteAssignment(cfg);
+    int ok = dataflowMatchesReference("liveness", cfg, liveness, NULL, livenessEffect) &&
+             dataflowMatchesReference("reaching definitions", cfg, reaching->flow, reaching, reachingEffect) &&
+             dataflowMatchesReference("definite assignment", cfg, assignment, NULL, assignmentEffect);
+    if (!ok) printf("  in program %s:\n%s\n", title, source);
+    *checked += liveness->bitCount + reaching->flow->bitCount + assignment->bitCount;
+    freeDataflow(liveness);
+    freeReachingDefinitions(reaching);
+    freeDataflow(assignment);
+    freeCfg(cfg);
+    return ok;
+}
+
+// Liveness, reaching definitions and definite assignment on programs with
+// 10K to 200K variables, after checking every fact of small programs against a
+// one-bit-at-a-time reference solver
+static int benchmarkDataflow(void) {
+    static const int sizes[] = {10000, 100000, 200000};
+    parserDebug = 0;
+    int ok = 1, checked = 0;
+    for (int i = 0; i < 120 && ok; i++) {
+        TextBuilder source = i % 2 ? generateArithmeticProgram(0x27D4EB2Fu + (uint32_t)i * 7919u)
+                                   : generateDataflowProgram(0x165667B1u + (uint32_t)i, 40, 24);
+        ok = checkDataflow("random", source.text, &checked);
+        free(source.text);
+    }
+    printf("dataflow: 120 random programs, %d facts checked against the reference solver: %s\n", checked,
+           ok ? "OK" : "MISMATCH");
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]) && ok; s++) {
+        TextBuilder source = generateDataflowProgram(0x9E3779B9u, sizes[s], 400);
+        Cfg* cfg = lowerSource("variables", source.text);
+        free(source.text);
+        if (!cfg) return 1;
+        printf("  %6d variables: %d registers, %d blocks, %d instructions\n", sizes[s], cfg->registerCount,
+               cfg->blockCount, cfg->instructionCount);
+
+        double start = benchmarkNow();
+        Dataflow* liveness = computeLiveness(cfg);
+        double livenessTime = benchmarkNow() - start;
+        start = benchmarkNow();
+        ReachingDefinitions* reaching = computeReachingDefinitions(cfg);
+        double reachingTime = benchmarkNow() - start;
+        start = benchmarkNow();
+        Dataflow* assignment = computeDefiniteAssignment(cfg);
+        double assignmentTime = benchmarkNow() - start;
+        start = benchmarkNow();
+        int unassigned = findUninitializedReads(cfg, NULL, 0);
+        double warningTime = benchmarkNow() - start;
+
+        printf("    liveness             %7.2f ms (%d bits, %d block visits)\n", livenessTime * 1e3,
+               liveness->bitCount, liveness->visits);
+        printf("    reaching definitions %7.2f ms (%d bits, %d block visits)\n", reachingTime * 1e3,
+               reaching->flow->bitCount, reaching->flow->visits);
+        printf("    definite assignment  %7.2f ms (%d bits, %d block visits)\n", assignmentTime * 1e3,
+               assignment->bitCount, assignment->visits);
+        printf("    uninitialized reads  %7.2f ms (%d variables)\n", warningTime * 1e3, unassigned);
+        freeDataflow(liveness);
+        freeReachingDefinitions(reaching);
+        freeDataflow(assignment);
+        freeCfg(cfg);
+    }
+    return ok ? 0 : 1;
+}
+
+// ---------------------------------------
+// dead code
+// ---------------------------------------
+
+// Programs written with dead code in them: a debug flag and a mode that are
+// constant but assigned on more than one path (so folding the tree keeps
+// them), and scratch values nothing prints
+static const char* const deadCodeSources[][2] = {
+    {"flags",
+     "int n = %d;\n"
+     "bool debug = 1 > 2;\n"
+     "int mode = 2;\n"
+     "if (n < 0) {\n"
+     "    debug = 2 < 1;\n"
+     "    mode = 2;\n"
+     "}\n"
+     "int total = 0;\n"
+     "for (int i = 0; i < n; i++) {\n"
+     "    if (debug) {\n"
+     "        printf(\"i=%%d total=%%d\\n\", i, total);\n"
+     "    }\n"
+     "    switch (mode) {\n"
+     "        case 1: total = total + 1; break;\n"
+     "        case 2: total = total + i %% 5; break;\n"
+     "        default: total = 0;\n"
+     "    }\n"
+     "    if (mode == 2 && !debug) {\n"
+     "        total = total + 1;\n"
+     "    }\n"
+     "}\n"
+     "printf(\"%%d\\n\", total);\n"},
+    {"scratch",
+     "int n = %d;\n"
+     "int total = 0;\n"
+     "float average = 0.0;\n"
+     "int last = 0;\n"
+     "for (int i = 0; i < n; i++) {\n"
+     "    int square = i * i;\n"
+     "    int cube = square * i;\n"
+     "    float ratio = i * 0.5;\n"
+     "    bool even = i %% 2 == 0;\n"
+     "    last = cube;\n"
+     "    average = ratio + 1.0;\n"
+     "    if (even) {\n"
+     "        total = total + 3;\n"
+     "    } else {\n"
+     "        total = total + 1;\n"
+     "    }\n"
+     "}\n"
+     "printf(\"%%d\\n\", total);\n"},
+};
+
+// Function to compile one corpus program with and without eliminateDeadCode()
+// and add its bytecode size and run time to the totals
+static int timeDeadCode(const char* title, const char* source, int* bytes, double* times) {
+    BytecodeProgram* programs[2];
+    for (int pass = 0; pass < 2; pass++) {
+        cfgDeadCodeElimination = pass;
+        programs[pass] = compileSource(title, source, NULL);
+    }
+    cfgDeadCodeElimination = 1;
+    int ok = programs[0] && programs[1];
+    if (ok) {
+        // Fastest of three alternating runs each, so one noisy run cannot pass for a regression
+        char expected[256], actual[256];
+        int plainStatus = 0, status = 0;
+        double plainTime = 0.0, time = 0.0;
+        for (int run = 0; run < 3; run++) {
+            int runStatus;
+            double elapsed = runCaptured(programs[0], expected, sizeof(expected), &runStatus);
+            plainStatus |= runStatus;
+            if (run == 0 || elapsed < plainTime) plainTime = elapsed;
+            elapsed = runCaptured(programs[1], actual, sizeof(actual), &runStatus);
+            status |= runStatus;
+            if (run == 0 || elapsed < time) time = elapsed;
+        }
+        int same = plainStatus == 0 && status == 0 && strcmp(expected, actual) == 0;
+        // Removing code must not cost time: more than 15% (and 0.5 ms) slower fails.
+        // Identical bytecode cannot be slower, so a gap there is only noise; a gap
+        // on changed code is re-measured over three more runs before it counts.
+        int unchanged = programs[0]->codeCount == programs[1]->codeCount &&
+                        memcmp(programs[0]->code, programs[1]->code,
+                               programs[0]->codeCount * sizeof(BytecodeInstruction)) == 0;
+        for (int run = 0; !unchanged && run < 3 && time > plainTime * 1.15 && time - plainTime > 0.5e-3; run++) {
+            double elapsed = runCaptured(programs[0], expected, sizeof(expected), &plainStatus);
+            if (elapsed < plainTime) plainTime = elapsed;
+            elapsed = runCaptured(programs[1], actual, sizeof(actual), &status);
+            if (elapsed < time) time = elapsed;
+        }
+        int slower = !unchanged && time > plainTime * 1.15 && time - plainTime > 0.5e-3;
+        ok = same && !slower;
+        int plainBytes = programs[0]->codeCount * (int)sizeof(BytecodeInstruction);
+        int prunedBytes = programs[1]->codeCount * (int)sizeof(BytecodeInstruction);
+        printf("  %-10s %6d -> %6d bytes of bytecode, %8.2f -> %8.2f ms%s, output %s\n", title, plainBytes,
+               prunedBytes, plainTime * 1e3, time * 1e3, slower ? " (SLOWER)" : "", same ? "OK" : "MISMATCH");
+        bytes[0] += plainBytes;
+        bytes[1] += prunedBytes;
+        times[0] += plainTime;
+        times[1] += time;
+    }
+    freeBytecode(programs[0]);
+    freeBytecode(programs[1]);
+    return ok;
+}
+
+// The benchmark corpus (VM, switch and loop programs plus two with dead code
+// written in) compiled with and without dead code elimination, then random
+// programs checked against no elimination
+static int benchmarkDeadCode(void) {
+    enum { ITERATIONS = 1000000 };
+    parserDebug = 0;
+    printf("dce: constant branches folded and dead stores removed, against code generated from every instruction\n");
+    int ok = 1, bytes[2] = {0, 0};
+    double times[2] = {0.0, 0.0};
+    char source[4096];
+    for (size_t i = 0; i < sizeof(vmPrograms) / sizeof(vmPrograms[0]); i++) {
+        snprintf(source, sizeof(source), vmPrograms[i].source, vmPrograms[i].size);
+        ok = timeDeadCode(vmPrograms[i].title, source, bytes, times) && ok;
+    }
+    for (size_t i = 0; i < sizeof(switchSources) / sizeof(switchSources[0]); i++) {
+        snprintf(source, sizeof(source), switchSources[i][1], ITERATIONS);
+        ok = timeDeadCode(switchSources[i][0], source, bytes, times) && ok;
+    }
+    for (size_t i = 0; i < sizeof(loopSources) / sizeof(loopSources[0]); i++) {
+        snprintf(source, sizeof(source), loopSources[i][1], ITERATIONS);
+        ok = timeDeadCode(loopSources[i][0], source, bytes, times) && ok;
+    }
+    for (size_t i = 0; i < sizeof(deadCodeSources) / sizeof(deadCodeSources[0]); i++) {
+        snprintf(source, sizeof(source), deadCodeSources[i][1], ITERATIONS);
+        ok = timeDeadCode(deadCodeSources[i][0], source, bytes, times) && ok;
+    }
+    printf("  corpus     %6d -> %6d bytes (%d saved), %8.2f -> %8.2f ms (%.2fx)\n", bytes[0], bytes[1],
+           bytes[0] - bytes[1], times[0] * 1e3, times[1] * 1e3, times[1] > 0 ? times[0] / times[1] : 0.0);
+
+    char plain[4096], pruned[4096];
+    int mismatches = 0, skipped = 0;
+    for (int i = 0; i < 300; i++) {
+        TextBuilder random = i % 2 ? generateArithmeticProgram(0x4CF5AD43u + (uint32_t)i * 7919u)
+                                   : generateRedundantProgram(0x2127599Bu + (uint32_t)i, 40);
+        cfgDeadCodeElimination = 0;
+        BytecodeProgram* plainProgram = compileSource("random", random.text, NULL);
+        cfgDeadCodeElimination = 1;
+        BytecodeProgram* program = compileSource("random", random.text, NULL);
+        if (!plainProgram || !program) {
+            skipped++;
+        } else {
+            int plainStatus, status;
+            runCaptured(plainProgram, plain, sizeof(plain), &plainStatus);
+            runCaptured(program, pruned, sizeof(pruned), &status);
+            if ((plainStatus != status || strcmp(plain, pruned) != 0) && mismatches++ == 0) {
+                printf("  first mismatch, program %d:\n%s\n  as generated:\n%s  pruned:\n%s", i, random.text, plain,
+                       pruned);
+            }
+        }
+        freeBytecode(plainProgram);
+        freeBytecode(program);
+        free(random.text);
+    }
+    printf("  differential: 300 random programs, %d mismatches, %d skipped\n", mismatches, skipped);
+    return ok && mismatches + skipped == 0 ? 0 : 1;
+}
+
+// ---------------------------------------
+// Register allocation
+// ---------------------------------------
+
+// Locals of one loop dead by the next (slots to share), and more live int
+// accumulators than the JIT has machine registers (ranges to spill)
+static const char* const registerSources[][2] = {
+    {"phases",
+     "int n = %d;\n"
+     "int total = 0;\n"
+     "float mean = 0.0;\n"
+     "for (int i = 0; i < n; i++) {\n"
+     "    int a = i * 3;\n"
+     "    int b = a + 7;\n"
+     "    int c = b %% 11;\n"
+     "    total = total + c;\n"
+     "}\n"
+     "for (int j = 0; j < n; j++) {\n"
+     "    int d = j * 5;\n"
+     "    int e = d - 2;\n"
+     "    int f = e %% 13;\n"
+     "    float g = f * 0.25;\n"
+     "    mean = mean + g;\n"
+     "    total = total + f;\n"
+     "}\n"
+     "for (int k = 0; k < n; k++) {\n"
+     "    int h = k + total;\n"
+     "    int m = h %% 17;\n"
+     "    int q = m * m;\n"
+     "    total = total + q %% 3;\n"
+     "}\n"
+     "printf(\"%%d %%f\\n\", total, mean);\n"},
+    {"pressure",
+     "int n = %d;\n"
+     "int s0 = 0; int s1 = 1; int s2 = 2; int s3 = 3; int s4 = 4; int s5 = 5;\n"
+     "int s6 = 6; int s7 = 7; int s8 = 8; int s9 = 9; int s10 = 10; int s11 = 11;\n"
+     "for (int i = 0; i < n; i++) {\n"
+     "    s0 = s0 + i %% 3;\n"
+     "    s1 = s1 + s0 %% 5;\n"
+     "    s2 = s2 + s1 %% 7;\n"
+     "    s3 = s3 + s2 %% 11;\n"
+     "    s4 = s4 + s3 %% 13;\n"
+     "    s5 = s5 + s4 %% 17;\n"
+     "    s6 = s6 + s5 %% 19;\n"
+     "    s7 = s7 + s6 %% 23;\n"
+     "    s8 = s8 + s7 %% 29;\n"
+     "    s9 = s9 + s8 %% 31;\n"
+     "    s10 = s10 + s9 %% 37;\n"
+     "    s11 = s11 + s10 %% 41;\n"
+     "}\n"
+     "printf(\"%%d %%d %%d %%d %%d %%d\\n\", s0, s2, s4, s6, s8, s11);\n"},
+};
+
+// Function to compile one corpus program with one register per virtual
+// register and with allocated slots, and add its frame size and interpreted
+// and native run times to the totals
+static int timeRegisterAllocation(const char* title, const char* source, int* frames, double* vmTimes,
+                                  double* jitTimes) {
+    BytecodeProgram* programs[2];
+    for (int pass = 0; pass < 2; pass++) {
+        cfgRegisterAllocation = pass;
+        programs[pass] = compileSource(title, source, NULL);
+    }
+    cfgRegisterAllocation = 1;
+    int ok = programs[0] && programs[1];
+    if (ok) {
+        char expected[256], actual[256];
+        int status[4];
+        double vmTime[2], jitTime[2];
+        vmTime[0] = runCaptured(programs[0], expected, sizeof(expected), &status[0]);
+        vmTime[1] = runCaptured(programs[1], actual, sizeof(actual), &status[1]);
+        ok = strcmp(expected, actual) == 0;
+        vmJit = 1;
+        for (int pass = 0; pass < 2; pass++) {
+            jitTime[pass] = runCaptured(programs[pass], actual, sizeof(actual), &status[2 + pass]);
+            ok = ok && strcmp(expected, actual) == 0;
+        }
+        vmJit = 0;
+        ok = ok && status[0] == 0 && status[1] == 0 && status[2] == 0 && status[3] == 0;
+        int frame[2];
+        for (int pass = 0; pass < 2; pass++) {
+            frame[pass] = programs[pass]->registerCount * (int)sizeof(Value);
+            frames[pass] += frame[pass];
+            vmTimes[pass] += vmTime[pass];
+            jitTimes[pass] += jitTime[pass];
+        }
+        printf("  %-10s frame %5d -> %5d bytes, VM %8.2f -> %8.2f ms, JIT %8.2f -> %8.2f ms, output %s\n", title,
+               frame[0], frame[1], vmTime[0] * 1e3, vmTime[1] * 1e3, jitTime[0] * 1e3, jitTime[1] * 1e3,
+               ok ? "OK" : "MISMATCH");
+    }
+    freeBytecode(programs[0]);
+    freeBytecode(programs[1]);
+    return ok;
+}
+
+// The benchmark corpus (VM, switch, loop and dead code programs plus two
+// written for register pressure) compiled with and without register
+// allocation, then random programs checked against no allocation, interpreted
+// and native
+static int benchmarkRegisterAllocation(void) {
+    enum { ITERATIONS = 1000000 };
+    parserDebug = 0;
+    printf("regalloc: linear-scan slots and machine registers, against one slot per virtual register\n");
+    int ok = 1, frames[2] = {0, 0};
+    double vmTimes[2] = {0.0, 0.0}, jitTimes[2] = {0.0, 0.0};
+    char source[4096];
+    for (size_t i = 0; i < sizeof(vmPrograms) / sizeof(vmPrograms[0]); i++) {
+        snprintf(source, sizeof(source), vmPrograms[i].source, vmPrograms[i].size);
+        ok = timeRegisterAllocation(vmPrograms[i].title, source, frames, vmTimes, jitTimes) && ok;
+    }
+    for (size_t i = 0; i < sizeof(switchSources) / sizeof(switchSources[0]); i++) {
+        snprintf(source, sizeof(source), switchSources[i][1], ITERATIONS);
+        ok = timeRegisterAllocation(switchSources[i][0], source, frames, vmTimes, jitTimes) && ok;
+    }
+    for (size_t i = 0; i < sizeof(loopSources) / sizeof(loopSources[0]); i++) {
+        snprintf(source, sizeof(source), loopSources[i][1], ITERATIONS);
+        ok = timeRegisterAllocation(loopSources[i][0], source, frames, vmTimes, jitTimes) && ok;
+    }
+    for (size_t i = 0; i < sizeof(deadCodeSources) / sizeof(deadCodeSources[0]); i++) {
+        snprintf(source, sizeof(source), deadCodeSources[i][1], ITERATIONS);
+        ok = timeRegisterAllocation(deadCodeSources[i][0], source, frames, vmTimes, jitTimes) && ok;
+    }
+    for (size_t i = 0; i < sizeof(registerSources) / sizeof(registerSources[0]); i++) {
+        snprintf(source, sizeof(source), registerSources[i][1], ITERATIONS);
+        ok = timeRegisterAllocation(registerSources[i][0], source, frames, vmTimes, jitTimes) && ok;
+    }
+    printf("  corpus     frame %5d -> %5d bytes, VM %8.2f -> %8.2f ms (%.2fx), JIT %8.2f -> %8.2f ms (%.2fx)\n",
+           frames[0], frames[1], vmTimes[0] * 1e3, vmTimes[1] * 1e3, vmTimes[1] > 0 ? vmTimes[0] / vmTimes[1] : 0.0,
+           jitTimes[0] * 1e3, jitTimes[1] * 1e3, jitTimes[1] > 0 ? jitTimes[0] / jitTimes[1] : 0.0);
+
+    char plain[4096], allocated[4096];
+    int mismatches = 0, skipped = 0;
+    for (int i = 0; i < 300; i++) {
+        TextBuilder random = i % 2 ? generateArithmeticProgram(0x3C6EF372u + (uint32_t)i * 7919u)
+                                   : generateRedundantProgram(0x510E527Fu + (uint32_t)i, 40);
+        cfgRegisterAllocation = 0;
+        BytecodeProgram* plainProgram = compileSource("random", random.text, NULL);
+        cfgRegisterAllocation = 1;
+        BytecodeProgram* program = compileSource("random", random.text, NULL);
+        if (!plainProgram || !program) {
+            skipped++;
+        } else {
+            int plainStatus, status;
+            runCaptured(plainProgram, plain, sizeof(plain), &plainStatus);
+            for (int native = 0; native < 2; native++) {
+                vmJit = native;
+                runCaptured(program, allocated, sizeof(allocated), &status);
+                if ((plainStatus != status || strcmp(plain, allocated) != 0) && mismatches++ == 0) {
+                    printf("  first mismatch, program %d (%s):\n%s\n  one slot per register:\n%s  allocated:\n%s", i,
+                           native ? "JIT" : "VM", random.text, plain, allocated);
+                }
+            }
+            vmJit = 0;
+        }
+        freeBytecode(plainProgram);
+        freeBytecode(program);
+        free(random.text);
+    }
+    printf("  differential: 300 random programs, %d mismatches, %d skipped\n", mismatches, skipped);
+    return ok && mismatches + skipped == 0 ? 0 : 1;
+}
+
+// Function to dispatch a benchmark by name
+int runBenchmark(const char* name) {
+    if (strcmp(name, "relex") == 0) {
+        return benchmarkRelex();
+    }
+    if (strcmp(name, "reparse") == 0) {
+        return benchmarkReparse();
+    }
+    if (strcmp(name, "lazy") == 0) {
+        return benchmarkLazy();
+    }
+    if (strcmp(name, "symbols") == 0) {
+        return benchmarkSymbols();
+    }
+    if (strcmp(name, "intern") == 0) {
+        return benchmarkIntern();
+    }
+    if (strcmp(name, "typecheck") == 0) {
+        return benchmarkTypeCheck();
+    }
+    if (strcmp(name, "cfg") == 0) {
+        return benchmarkCfg();
+    }
+    if (strcmp(name, "vm") == 0) {
+        return benchmarkVm();
+    }
+    if (strcmp(name, "jit") == 0) {
+        return benchmarkJit();
+    }
+    if (strcmp(name, "tiered") == 0) {
+        return benchmarkTiered();
+    }
+    if (strcmp(name, "emit-c") == 0) {
+        return benchmarkEmitC();
+    }
+    if (strcmp(name, "values") == 0) {
+        return benchmarkValues();
+    }
+    if (strcmp(name, "print") == 0) {
+        return benchmarkPrint();
+    }
+    if (strcmp(name, "input") == 0) {
+        return benchmarkInput();
+    }
+    if (strcmp(name, "arrays") == 0) {
+        return benchmarkArrays();
+    }
+    if (strcmp(name, "vectorize") == 0) {
+        return benchmarkVectorize();
+    }
+    if (strcmp(name, "switch") == 0) {
+        return benchmarkSwitch();
+    }
+    if (strcmp(name, "loops") == 0) {
+        return benchmarkLoops();
+    }
+    if (strcmp(name, "gvn") == 0) {
+        return benchmarkValueNumbering();
+    }
+    if (strcmp(name, "dataflow") == 0) {
+        return benchmarkDataflow();
+    }
+    if (strcmp(name, "dce") == 0) {
+        return benchmarkDeadCode();
+    }
+    if (strcmp(name, "regalloc") == 0) {
+        return benchmarkRegisterAllocation();
+    }
+    printf("Unknown benchmark '%s'. Available: relex, reparse, lazy, symbols, intern, typecheck, cfg, vm, jit, tiered, emit-c, values, print, input, arrays, vectorize, switch, loops, gvn, dataflow, dce, regalloc\n", name);
+    return 1;
+}
@@ -0,0 +1,10 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+// Wall-clock timer in seconds (high resolution, monotonic)
+double benchmarkNow(void);
+
+// Run a named benchmark; returns 0 on success, non-zero on failure or unknown name
+int runBenchmark(const char* name);
+
+#endif // BENCHMARK_H
@@ -0,0 +1,224 @@
+#include "bounds_check.h"
+#include <stdlib.h>
+#include "symbol_table.h"
+
+static void* allocateArray(int count, size_t size) {
+    void* array = calloc(count > 0 ? (size_t)count : 1, size);
+    if (!array) {
+        fprintf(stderr, "Error: Memory allocation failed for control-flow graph.\n");
+        exit(EXIT_FAILURE);
+    }
+    return array;
+}
+
+// ---------------------------------------
+// Bounds-check elimination
+// ---------------------------------------
+
+int cfgBoundsCheckElimination = 1;
+
+#define MAX_LOOP_STEP (1 << 30) // i < n <= an array length (< 2^28), so i + step cannot overflow
+
+void collectDefSites(const Cfg* cfg, DefSites* defs) {
+    defs->count = (int*)allocateArray(cfg->registerCount, sizeof(int));
+    defs->block = (int*)allocateArray(cfg->registerCount, sizeof(int));
+    defs->position = (int*)allocateArray(cfg->registerCount, sizeof(int));
+    for (int b = 0; b < cfg->blockCount; b++) {
+        const BasicBlock* block = &cfg->blocks[b];
+        for (int i = 0; i < block->codeCount; i++) {
+            int dst = block->code[i].dst;
+            if (dst < 0) continue;
+            defs->count[dst]++;
+            defs->block[dst] = b;
+            defs->position[dst] = i;
+        }
+    }
+}
+
+void freeDefSites(DefSites* defs) {
+    free(defs->count);
+    free(defs->block);
+    free(defs->position);
+}
+
+const IrInstruction* onlyDef(const Cfg* cfg, const DefSites* defs, int reg) {
+    if (reg < 0 || defs->count[reg] != 1) return NULL;
+    return &cfg->blocks[defs->block[reg]].code[defs->position[reg]];
+}
+
+int constantInt(const Cfg* cfg, const DefSites* defs, int reg, int32_t* value) {
+    const IrInstruction* def = onlyDef(cfg, defs, reg);
+    if (!def || def->opcode != IR_CONST || def->type != TYPE_INT) return 0;
+    *value = def->imm.i;
+    return 1;
+}
+
+// Non-zero if instruction (a, i) runs before (b, j) on every path to the latter
+static int runsBefore(const Cfg* cfg, int a, int i, int b, int j) {
+    return a == b ? i < j : dominates(cfg, a, b);
+}
+
+// Function to recognize `i = add i, k` (1 <= k <= MAX_LOOP_STEP) in a block that only jumps back to `header`
+static int isLoopStep(const Cfg* cfg, const DefSites* defs, int header, int b, const IrInstruction* in) {
+    const BasicBlock* block = &cfg->blocks[b];
+    int32_t step;
+    return block->successorCount == 1 && block->successors[0] == header && in->opcode == IR_ADD &&
+           in->type == TYPE_INT && in->a == in->dst && constantInt(cfg, defs, in->b, &step) &&
+           step >= 1 && step <= MAX_LOOP_STEP;
+}
+
+// Function to match a header that ends in `t = lt i, n; branch t ? body : exit` where
+// the body is only entered from the header, i is a non-negative constant on entry and
+// only steps up at the end of an iteration, and neither i nor n changes in between
+void findCountedLoop(const Cfg* cfg, const DefSites* defs, int header, CountedLoop* loop) {
+    const BasicBlock* block = &cfg->blocks[header];
+    loop->counter = -1;
+    if (!block->loopHeader || block->successorCount != 2 || block->codeCount < 2) return;
+    const IrInstruction* branch = &block->code[block->codeCount - 1];
+    const IrInstruction* compare = &block->code[block->codeCount - 2];
+    if (branch->opcode != IR_BRANCH || compare->opcode != IR_LT || compare->type != TYPE_INT ||
+        compare->dst != branch->a) {
+        return;
+    }
+    int counter = compare->a;
+    int limit = compare->b;
+    int body = block->successors[0];
+    if (counter == limit || cfg->blocks[body].predecessorCount != 1) return;
+
+    int32_t fixedLimit;
+    int constantLimit = constantInt(cfg, defs, limit, &fixedLimit);
+    for (int b = 0; b < cfg->blockCount; b++) {
+        if (b != header && !dominates(cfg, body, b)) continue;
+        const BasicBlock* current = &cfg->blocks[b];
+        for (int i = 0; i < current->codeCount; i++) {
+            const IrInstruction* in = &current->code[i];
+            if (in->dst == limit && !constantLimit) return;
+            if (in->dst == counter && (b == header || !isLoopStep(cfg, defs, header, b, in))) return;
+        }
+    }
+
+    // The one way in from outside the loop leaves a non-negative constant in the counter
+    int entry = -1;
+    for (int p = 0; p < block->predecessorCount; p++) {
+        int predecessor = cfg->predecessors[block->firstPredecessor + p];
+        if (dominates(cfg, header, predecessor)) continue;
+        if (entry >= 0) return;
+        entry = predecessor;
+    }
+    if (entry < 0) return;
+    const BasicBlock* entryBlock = &cfg->blocks[entry];
+    for (int i = entryBlock->codeCount - 1; i >= 0; i--) {
+        const IrInstruction* in = &entryBlock->code[i];
+        if (in->dst != counter) continue;
+        if (in->opcode != IR_CONST || in->type != TYPE_INT || in->imm.i < 0) return;
+        loop->counter = counter;
+        loop->limit = limit;
+        return;
+    }
+}
+
+// Function to decide whether `limit` is at most the length of `dimension` of the array
+// in register `array` wherever the check at (b, position) runs
+static int limitFitsArray(const Cfg* cfg, const DefSites* defs, int array, int dimension, int limit,
+                          int b, int position) {
+    const IrInstruction* creation = onlyDef(cfg, defs, array);
+    if (!creation || creation->opcode != IR_NEW_ARRAY) return 0;
+    int site = defs->block[array], sitePosition = defs->position[array];
+    if (!runsBefore(cfg, site, sitePosition, b, position)) return 0;
+    int length = dimension == 0 ? creation->a : creation->b;
+    if (length < 0) return 0;
+
+    int32_t limitValue, lengthValue;
+    if (constantInt(cfg, defs, limit, &limitValue) && constantInt(cfg, defs, length, &lengthValue)) {
+        return limitValue <= lengthValue;
+    }
+    if (limit != length) return 0;
+
+    // The same variable: every write to it comes before the creation that the
+    // check comes after, so the array was created with the value the loop tests
+    for (int d = 0; d < cfg->blockCount; d++) {
+        const BasicBlock* block = &cfg->blocks[d];
+        for (int i = 0; i < block->codeCount; i++) {
+            if (block->code[i].dst == length && !runsBefore(cfg, d, i, site, sitePosition)) return 0;
+        }
+    }
+    return 1;
+}
+
+// Function to tell whether the check at (b, position) repeats an earlier one in its block
+// with no write to the array or the index in between
+static int repeatsCheck(const BasicBlock* block, int position) {
+    const IrInstruction* check = &block->code[position];
+    for (int i = position - 1; i >= 0; i--) {
+        const IrInstruction* in = &block->code[i];
+        if (in->dst == check->a || in->dst == check->b) return 0;
+        if (in->opcode == IR_CHECK_INDEX && in->a == check->a && in->b == check->b && in->imm.i == check->imm.i) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Function to tell whether a counted loop proves 0 <= index < length for the check at (b, position)
+static int checkedByLoop(const Cfg* cfg, const DefSites* defs, const CountedLoop* loops,
+                         const IrInstruction* check, int b, int position) {
+    for (int h = 0; h < cfg->blockCount; h++) {
+        const CountedLoop* loop = &loops[h];
+        if (loop->counter != check->b || !dominates(cfg, cfg->blocks[h].successors[0], b)) continue;
+
+        // In the block that steps the counter, only a check before the step sees i < n
+        const BasicBlock* block = &cfg->blocks[b];
+        int stepped = 0;
+        for (int i = 0; i < position; i++) {
+            if (block->code[i].dst == check->b) stepped = 1;
+        }
+        if (stepped) continue;
+        if (limitFitsArray(cfg, defs, check->a, check->imm.i, loop->limit, b, position)) return 1;
+    }
+    return 0;
+}
+
+// Checks are dropped, never hoisted: a check moved ahead of a loop would report
+// the error before output the loop prints on its way to the bad index.
+int eliminateBoundsChecks(Cfg* cfg) {
+    cfg->removedBoundsChecks = 0;
+    if (!cfgBoundsCheckElimination || cfg->boundsChecks == 0 || !cfg->idom) return 0;
+
+    DefSites defs;
+    collectDefSites(cfg, &defs);
+
+    CountedLoop* loops = (CountedLoop*)allocateArray(cfg->blockCount, sizeof(CountedLoop));
+    for (int h = 0; h < cfg->blockCount; h++) {
+        findCountedLoop(cfg, &defs, h, &loops[h]);
+    }
+
+    // Decide on the code as lowered, then compact each block (removing changes positions)
+    unsigned char** removed = (unsigned char**)allocateArray(cfg->blockCount, sizeof(unsigned char*));
+    for (int b = 0; b < cfg->blockCount; b++) {
+        const BasicBlock* block = &cfg->blocks[b];
+        removed[b] = (unsigned char*)allocateArray(block->codeCount, 1);
+        for (int i = 0; i < block->codeCount; i++) {
+            const IrInstruction* in = &block->code[i];
+            if (in->opcode != IR_CHECK_INDEX) continue;
+            if (repeatsCheck(block, i) || checkedByLoop(cfg, &defs, loops, in, b, i)) {
+                removed[b][i] = 1;
+                cfg->removedBoundsChecks++;
+            }
+        }
+    }
+    for (int b = 0; b < cfg->blockCount; b++) {
+        BasicBlock* block = &cfg->blocks[b];
+        int kept = 0;
+        for (int i = 0; i < block->codeCount; i++) {
+            if (!removed[b][i]) block->code[kept++] = block->code[i];
+        }
+        block->codeCount = kept;
+        free(removed[b]);
+    }
+    cfg->instructionCount -= cfg->removedBoundsChecks;
+
+    free(removed);
+    free(loops);
+    freeDefSites(&defs);
+    return cfg->removedBoundsChecks;
+}
@@ -0,0 +1,38 @@
+#ifndef BOUNDS_CHECK_H
+#define BOUNDS_CHECK_H
+
+#include <stdint.h>
+#include "cfg.h"
+
+extern int cfgBoundsCheckElimination; // Non-zero (default): eliminateBoundsChecks() removes what it proves
+
+// Drop array bounds checks that cannot fail (needs computeDominators): those on
+// the counter of a loop whose header tests `i < n`, where i starts at a
+// non-negative constant, only steps up at the end of an iteration and n is no
+// more than the array's length; and a repeat of a check earlier in the same
+// block. Returns the number removed.
+int eliminateBoundsChecks(Cfg* cfg);
+
+// Counted loops, also matched by vectorizeLoops()
+// Writes per register, and where the only one is
+typedef struct {
+    int* count;
+    int* block;
+    int* position;
+} DefSites;
+
+// What a loop header's exit test proves on entry to its body: counter < limit
+typedef struct {
+    int counter;          // -1 when the header does not have that shape
+    int limit;
+} CountedLoop;
+
+void collectDefSites(const Cfg* cfg, DefSites* defs);
+void freeDefSites(DefSites* defs);
+const IrInstruction* onlyDef(const Cfg* cfg, const DefSites* defs, int reg); // NULL unless written exactly once
+int constantInt(const Cfg* cfg, const DefSites* defs, int reg, int32_t* value); // Non-zero if that write is an int constant
+
+// Fill `loop` for the block `header` (counter -1 when it is not a counted loop)
+void findCountedLoop(const Cfg* cfg, const DefSites* defs, int header, CountedLoop* loop);
+
+#endif // BOUNDS_CHECK_H
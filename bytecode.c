@@ -0,0 +1,850 @@
+#include "bytecode.h"
+#include <stdlib.h>
+#include <string.h>
+#include "arithmetic.h"
+#include "symbol_table.h"
+#include "vector_kernels.h"
+#include "format.h"
+
+static void* growArray(void* array, int* capacity, int needed, size_t size) {
+    if (needed <= *capacity) return array;
+    int newCapacity = *capacity ? *capacity : 16;
+    while (newCapacity < needed) newCapacity *= 2;
+    array = realloc(array, (size_t)newCapacity * size);
+    if (!array) {
+        fprintf(stderr, "Error: Memory allocation failed for bytecode.\n");
+        exit(EXIT_FAILURE);
+    }
+    *capacity = newCapacity;
+    return array;
+}
+
+static void* allocateArray(int count, size_t size) {
+    void* array = calloc(count > 0 ? (size_t)count : 1, size);
+    if (!array) {
+        fprintf(stderr, "Error: Memory allocation failed for bytecode.\n");
+        exit(EXIT_FAILURE);
+    }
+    return array;
+}
+
+static BytecodeInstruction* emitCode(BytecodeProgram* program, int opcode, int a, int b, int c) {
+    program->code = (BytecodeInstruction*)growArray(program->code, &program->codeCapacity,
+                                                    program->codeCount + 1, sizeof(BytecodeInstruction));
+    BytecodeInstruction* instruction = &program->code[program->codeCount++];
+    instruction->opcode = opcode;
+    instruction->a = a;
+    instruction->b = b;
+    instruction->c = c;
+    return instruction;
+}
+
+static int addFloat(BytecodeProgram* program, double value) {
+    program->floats = (double*)growArray(program->floats, &program->floatCapacity,
+                                         program->floatCount + 1, sizeof(double));
+    program->floats[program->floatCount] = value;
+    return program->floatCount++;
+}
+
+int bytecodeSuperinstructions = 1;
+
+typedef struct {
+    BytecodeProgram* program;
+    const Cfg* cfg;
+    int* uses;               // Reads per register
+    int* defs;               // Writes per register
+    int* defBlock;           // Block of the last write; -1 once a read is seen in another block
+    unsigned char* pending;  // Constant whose load waits for the register's only use
+    int32_t* pendingValue;
+    int* literal;            // String index + 1 of a temporary holding a string literal, else 0
+} BytecodeCompiler;
+
+static void countUse(BytecodeCompiler* compiler, int reg, int b) {
+    if (reg < 0) return;
+    compiler->uses[reg]++;
+    if (compiler->defBlock[reg] != b) compiler->defBlock[reg] = -1;
+}
+
+// Function to count reads and writes of every register in the CFG
+static void countUses(BytecodeCompiler* compiler) {
+    const Cfg* cfg = compiler->cfg;
+    for (int b = 0; b < cfg->blockCount; b++) {
+        const BasicBlock* block = &cfg->blocks[b];
+        for (int i = 0; i < block->codeCount; i++) {
+            const IrInstruction* in = &block->code[i];
+            if (in->dst >= 0) {
+                compiler->defs[in->dst]++;
+                compiler->defBlock[in->dst] = b;
+            }
+        }
+    }
+    for (int b = 0; b < cfg->blockCount; b++) {
+        const BasicBlock* block = &cfg->blocks[b];
+        for (int i = 0; i < block->codeCount; i++) {
+            countUse(compiler, block->code[i].a, b);
+            countUse(compiler, block->code[i].b, b);
+            countUse(compiler, block->code[i].c, b);
+        }
+    }
+}
+
+// A temporary written once and read once, in the same block, can live in its reader as an immediate
+static int isSingleUseTemporary(const BytecodeCompiler* compiler, int reg) {
+    return reg >= compiler->cfg->bindingCount && compiler->uses[reg] == 1 && compiler->defs[reg] == 1 &&
+           compiler->defBlock[reg] >= 0;
+}
+
+// Function to take a deferred constant as an immediate operand
+static int takeConstant(BytecodeCompiler* compiler, int reg, int32_t* value) {
+    if (reg < 0 || !compiler->pending[reg]) return 0;
+    compiler->pending[reg] = 0;
+    *value = compiler->pendingValue[reg];
+    return 1;
+}
+
+// Function to make `reg` hold its value before it is read as a register
+static int operand(BytecodeCompiler* compiler, int reg) {
+    int32_t value;
+    if (takeConstant(compiler, reg, &value)) {
+        emitCode(compiler->program, BC_LOAD_INT, reg, value, 0);
+    }
+    return reg;
+}
+
+// ---------------------------------------
+// Instruction selection
+// ---------------------------------------
+
+// ---------------------------------------
+// printf formats
+// ---------------------------------------
+
+static int addFormatText(BytecodeProgram* program, const char* text, int length) {
+    program->formatText = (char*)growArray(program->formatText, &program->formatTextCapacity,
+                                           program->formatTextLength + length + 1 + FORMAT_TEXT_PADDING, 1);
+    int offset = program->formatTextLength;
+    memcpy(program->formatText + offset, text, (size_t)length);
+    memset(program->formatText + offset + length, 0, 1 + FORMAT_TEXT_PADDING);
+    program->formatTextLength += length + 1;
+    return offset;
+}
+
+static void addFormatOp(BytecodeProgram* program, int kind, int reg, int text, int length) {
+    program->formatOps = (FormatOp*)growArray(program->formatOps, &program->formatOpCapacity,
+                                              program->formatOpCount + 1, sizeof(FormatOp));
+    FormatOp* op = &program->formatOps[program->formatOpCount++];
+    op->kind = kind;
+    op->reg = reg;
+    op->text = text;
+    op->length = length;
+}
+
+// Function to add literal text, merged into the text run before it when there is one
+static void addFormatLiteral(BytecodeProgram* program, const char* text, int length) {
+    if (length == 0) return;
+    FormatOp* last = program->formatOpCount ? &program->formatOps[program->formatOpCount - 1] : NULL;
+    if (last && last->kind == FORMAT_TEXT && last->text + last->length + 1 == program->formatTextLength) {
+        // Extend the last run in place (drop its terminator)
+        program->formatTextLength--;
+        addFormatText(program, text, length);
+        last->length += length;
+        return;
+    }
+    addFormatOp(program, FORMAT_TEXT, -1, addFormatText(program, text, length), length);
+}
+
+// Function to print a value of `type` the way it reads in source
+static void addNaturalFormat(BytecodeProgram* program, int reg, int type) {
+    switch (type) {
+        case TYPE_FLOAT: addFormatOp(program, FORMAT_FLOAT, reg, 0, 0); break;
+        case TYPE_CHAR: addFormatOp(program, FORMAT_CHAR, reg, 0, 0); break;
+        case TYPE_BOOL: addFormatOp(program, FORMAT_BOOL, reg, 0, 0); break;
+        case TYPE_STRING: addFormatOp(program, FORMAT_STRING, reg, 0, 0); break;
+        default: addFormatOp(program, FORMAT_INT, reg, 0, 0); break;
+    }
+}
+
+// Function to add one conversion `spec` (e.g. "%5.2f") of register `reg`
+static void addConversion(BytecodeProgram* program, const char* spec, char conversion, int reg, int type) {
+    int plain = spec[2] == '\0'; // No flags, width or precision
+    int isString = type == TYPE_STRING;
+    if (conversion != 's' && isString) {
+        program->formatMismatches++;
+        addNaturalFormat(program, reg, type); // A string has no number to convert: print it as it is
+    } else if (plain && conversion == 's') {
+        addNaturalFormat(program, reg, type);
+    } else if (plain && (conversion == 'd' || conversion == 'i') && type != TYPE_FLOAT && !isString) {
+        addFormatOp(program, FORMAT_INT, reg, 0, 0);
+    } else if (plain && conversion == 'f' && type == TYPE_FLOAT) {
+        addFormatOp(program, FORMAT_FLOAT, reg, 0, 0);
+    } else if (plain && conversion == 'c' && type != TYPE_FLOAT && !isString) {
+        addFormatOp(program, FORMAT_CHAR, reg, 0, 0);
+    } else {
+        addFormatOp(program, FORMAT_SPEC, reg, addFormatText(program, spec, (int)strlen(spec)), conversion);
+    }
+}
+
+// Function to split printf(format, arguments...) into format ops, the way the VM's
+// run-time formatter reads it: a conversion with no argument left, or that is not
+// one, prints as text, and arguments the format does not consume follow it in
+// their natural form. `format` is NULL when the first argument is not a string.
+// Returns the index of the first op.
+static int compileFormat(BytecodeProgram* program, const unsigned char* types, const char* format,
+                         const int* arguments, int count) {
+    int first = program->formatOpCount;
+    int next = 0;
+    if (format) {
+        next = 1;
+        const char* run = format;
+        for (const char* p = format; *p; p++) {
+            if (*p != '%') continue;
+            addFormatLiteral(program, run, (int)(p - run));
+            run = p;
+            if (p[1] == '%') {
+                addFormatLiteral(program, "%", 1);
+                run = ++p + 1;
+                continue;
+            }
+
+            FormatSpec spec;
+            int isConversion = scanFormatSpec(p, &spec);
+            if (!isConversion || next >= count) {
+                if (isConversion) program->formatMismatches++;
+                addFormatLiteral(program, "%", 1); // Printed as text; what follows is read again
+                run = p + 1;
+                continue;
+            }
+            int reg = arguments[next++];
+            addConversion(program, spec.spec, spec.conversion, reg, types[reg]);
+            p += spec.length - 1;
+            run = p + 1;
+        }
+        addFormatLiteral(program, run, (int)strlen(run));
+    }
+    for (; next < count; next++) {
+        addNaturalFormat(program, arguments[next], types[arguments[next]]);
+    }
+    addFormatOp(program, FORMAT_END, -1, 0, 0);
+    return first;
+}
+
+static const unsigned char intCompare[] = {BC_EQ_I, BC_NE_I, BC_LT_I, BC_LE_I, BC_GT_I, BC_GE_I};
+static const unsigned char floatCompare[] = {BC_EQ_F, BC_NE_F, BC_LT_F, BC_LE_F, BC_GT_F, BC_GE_F};
+
+// Comparison index (IR_EQ order) with the operands swapped, and with the result negated
+static const unsigned char swappedCompare[] = {0, 1, 4, 5, 2, 3};
+static const unsigned char negatedCompare[] = {1, 0, 5, 4, 3, 2};
+
+// Function to pick the typed opcode for an IR arithmetic or comparison instruction
+static int selectBinary(const IrInstruction* in) {
+    int isFloat = in->type == TYPE_FLOAT;
+    switch (in->opcode) {
+        case IR_ADD: return isFloat ? BC_ADD_F : BC_ADD_I;
+        case IR_SUB: return isFloat ? BC_SUB_F : BC_SUB_I;
+        case IR_MUL: return isFloat ? BC_MUL_F : BC_MUL_I;
+        case IR_DIV: return BC_DIV_F; // The type checker converts '/' operands to float
+        case IR_FLOOR_DIV: return BC_FLOOR_DIV_I;
+        case IR_MOD: return BC_MOD_I;
+        case IR_POW: return isFloat ? BC_POW_F : BC_POW_I;
+        default: break;
+    }
+
+    int index = in->opcode - IR_EQ;
+    if (in->type == TYPE_STRING) return index == 0 ? BC_EQ_S : BC_NE_S;
+    return isFloat ? floatCompare[index] : intCompare[index];
+}
+
+// Offset of an element type's array opcode from the int one (I, F, B)
+static int elementKind(int type) {
+    return type == TYPE_FLOAT ? 1 : type == TYPE_INT ? 0 : 2;
+}
+
+// Kernel operation for an IR_VECTOR_MAP's IR opcode
+static int vectorOp(int opcode) {
+    switch (opcode) {
+        case IR_ADD: return VECTOR_ADD;
+        case IR_SUB: return VECTOR_SUB;
+        case IR_MUL: return VECTOR_MUL;
+        case IR_DIV: return VECTOR_DIV;
+        default: return VECTOR_COPY;
+    }
+}
+
+static int isIntComparison(const IrInstruction* in) {
+    return in->opcode >= IR_EQ && in->opcode <= IR_GE && in->type != TYPE_FLOAT && in->type != TYPE_STRING;
+}
+
+// Function to compile int arithmetic with a deferred constant operand as r[a] = r[b] op k
+static int compileConstantArithmetic(BytecodeCompiler* compiler, const IrInstruction* in) {
+    if (in->type == TYPE_FLOAT) return 0;
+    int commutative = in->opcode == IR_ADD || in->opcode == IR_MUL;
+    int32_t value;
+
+    if (in->opcode == IR_ADD || in->opcode == IR_SUB || in->opcode == IR_MUL) {
+        int opcode = in->opcode == IR_MUL ? BC_MUL_IK : BC_ADD_IK;
+        if (takeConstant(compiler, in->b, &value)) {
+            if (in->opcode == IR_SUB) value = intNeg(value); // x - k wraps exactly like x + (-k)
+            emitCode(compiler->program, opcode, in->dst, operand(compiler, in->a), value);
+            return 1;
+        }
+        if (commutative && takeConstant(compiler, in->a, &value)) {
+            emitCode(compiler->program, opcode, in->dst, operand(compiler, in->b), value);
+            return 1;
+        }
+        return 0;
+    }
+
+    // // and % only take a non-zero divisor, so the fused forms never check
+    if ((in->opcode == IR_FLOOR_DIV || in->opcode == IR_MOD) && in->b >= 0 &&
+        compiler->pending[in->b] && compiler->pendingValue[in->b] != 0) {
+        takeConstant(compiler, in->b, &value);
+        emitCode(compiler->program, in->opcode == IR_MOD ? BC_MOD_IK : BC_FLOOR_DIV_IK,
+                 in->dst, operand(compiler, in->a), value);
+        return 1;
+    }
+    return 0;
+}
+
+static void compileInstruction(BytecodeCompiler* compiler, const IrInstruction* in) {
+    BytecodeProgram* program = compiler->program;
+    switch (in->opcode) {
+        case IR_CONST:
+            if (in->type == TYPE_FLOAT) {
+                emitCode(program, BC_LOAD_FLOAT, in->dst, addFloat(program, in->imm.f), 0);
+            } else if (in->type == TYPE_STRING) {
+                emitCode(program, BC_LOAD_STRING, in->dst, in->imm.i, 0);
+                if (isSingleUseTemporary(compiler, in->dst)) compiler->literal[in->dst] = in->imm.i + 1;
+            } else if (bytecodeSuperinstructions && isSingleUseTemporary(compiler, in->dst)) {
+                compiler->pending[in->dst] = 1;
+                compiler->pendingValue[in->dst] = in->imm.i;
+            } else {
+                emitCode(program, BC_LOAD_INT, in->dst, in->imm.i, 0);
+            }
+            break;
+        case IR_COPY:
+            emitCode(program, BC_MOVE, in->dst, operand(compiler, in->a), 0);
+            break;
+        case IR_INT_TO_FLOAT:
+            emitCode(program, BC_INT_TO_FLOAT, in->dst, operand(compiler, in->a), 0);
+            break;
+        case IR_NOT:
+            emitCode(program, BC_NOT, in->dst, operand(compiler, in->a), 0);
+            break;
+        case IR_INPUT:
+            emitCode(program, BC_INPUT, in->dst, in->imm.i, compiler->cfg->registerTypes[in->dst]);
+            break;
+        case IR_ARG:
+            program->arguments = (int*)growArray(program->arguments, &program->argumentCapacity,
+                                                 program->argumentCount + 1, sizeof(int));
+            program->arguments[program->argumentCount++] = operand(compiler, in->a);
+            break;
+        case IR_PRINT: {
+            // The IR_ARGs just before this one were appended to the pool in order. A format
+            // held in a variable can change, so only a literal one is split now.
+            int first = program->argumentCount - in->imm.i;
+            const int* arguments = program->arguments + first;
+            const unsigned char* types = compiler->cfg->registerTypes;
+            int ops = -1;
+            if (in->imm.i == 0 || types[arguments[0]] != TYPE_STRING) {
+                ops = compileFormat(program, types, NULL, arguments, in->imm.i);
+            } else if (compiler->literal[arguments[0]]) {
+                const char* format = compiler->cfg->strings[compiler->literal[arguments[0]] - 1];
+                ops = compileFormat(program, types, format, arguments, in->imm.i);
+            }
+            emitCode(program, BC_PRINT, first, in->imm.i, ops);
+            break;
+        }
+        case IR_NEW_ARRAY:
+            emitCode(program, BC_NEW_ARRAY_I + elementKind(in->type), in->dst, operand(compiler, in->a),
+                     in->b >= 0 ? operand(compiler, in->b) : -1);
+            break;
+        case IR_ARRAY_LENGTH:
+            emitCode(program, BC_ARRAY_LENGTH, in->dst, in->a, in->imm.i);
+            break;
+        case IR_CHECK_INDEX:
+            emitCode(program, BC_CHECK_INDEX, in->a, operand(compiler, in->b), in->imm.i);
+            break;
+        case IR_LOAD_ELEMENT:
+            emitCode(program, BC_LOAD_ELEMENT_I + elementKind(in->type), in->dst, in->a, operand(compiler, in->b));
+            break;
+        case IR_STORE_ELEMENT: {
+            int index = operand(compiler, in->b);
+            emitCode(program, BC_STORE_ELEMENT_I + elementKind(in->type), in->a, index, operand(compiler, in->c));
+            break;
+        }
+        case IR_MAX:
+            emitCode(program, BC_MAX_I, in->dst, operand(compiler, in->a), operand(compiler, in->b));
+            break;
+        case IR_HASH:
+            emitCode(program, BC_HASH_S, in->dst, operand(compiler, in->a), in->imm.i);
+            break;
+        case IR_VECTOR_MAP:
+        case IR_VECTOR_SUM: {
+            // The arrays are already in the pool from the IR_ARGs; the range follows them
+            int count = in->opcode == IR_VECTOR_MAP ? 3 : in->imm.i;
+            int first = program->argumentCount - count;
+            int range[2] = {operand(compiler, in->a), operand(compiler, in->b)};
+            program->arguments = (int*)growArray(program->arguments, &program->argumentCapacity,
+                                                 program->argumentCount + 2, sizeof(int));
+            program->arguments[program->argumentCount++] = range[0];
+            program->arguments[program->argumentCount++] = range[1];
+            int isFloat = in->type == TYPE_FLOAT;
+            if (in->opcode == IR_VECTOR_MAP) {
+                emitCode(program, isFloat ? BC_VECTOR_MAP_F : BC_VECTOR_MAP_I, first, vectorOp(in->imm.i), 0);
+            } else {
+                emitCode(program, isFloat ? BC_VECTOR_SUM_F : BC_VECTOR_SUM_I, in->dst, first, count);
+            }
+            break;
+        }
+        default:
+            if (bytecodeSuperinstructions && compileConstantArithmetic(compiler, in)) break;
+            emitCode(program, selectBinary(in), in->dst, operand(compiler, in->a), operand(compiler, in->b));
+            break;
+    }
+}
+
+// Function to emit "if (cond) goto target", where `cond` is an int comparison
+// (IR_EQ order index) of `left` against `right` or against the constant `value`
+static void emitCompareBranch(BytecodeProgram* program, int index, int left, int right,
+                              int hasConstant, int32_t value, int target) {
+    if (hasConstant) {
+        emitCode(program, BC_BRANCH_EQ_IK + index, left, value, target);
+    } else {
+        emitCode(program, BC_BRANCH_EQ_I + index, left, right, target);
+    }
+}
+
+// Function to lower "t = a cmp b; branch t" as one compare-and-branch (plus a jump
+// when neither side falls through). Targets are block numbers until patched.
+static void compileCompareBranch(BytecodeCompiler* compiler, const IrInstruction* compare,
+                                 const BasicBlock* block, int b) {
+    int index = compare->opcode - IR_EQ;
+    int left = compare->a;
+    int right = compare->b;
+    int32_t value = 0;
+    int hasConstant = takeConstant(compiler, right, &value);
+    if (!hasConstant && takeConstant(compiler, left, &value)) {
+        hasConstant = 1;
+        left = right;
+        index = swappedCompare[index]; // k < x is x > k
+    }
+    left = operand(compiler, left);
+    if (!hasConstant) right = operand(compiler, right);
+
+    int taken = block->successors[0];
+    int notTaken = block->successors[1];
+    if (taken == b + 1) {
+        emitCompareBranch(compiler->program, negatedCompare[index], left, right, hasConstant, value, notTaken);
+    } else {
+        emitCompareBranch(compiler->program, index, left, right, hasConstant, value, taken);
+        if (notTaken != b + 1) emitCode(compiler->program, BC_JUMP, notTaken, 0, 0);
+    }
+}
+
+// Function to lower a block's terminator. Jumps to the next block in layout order
+// become fallthroughs; targets are block numbers until the caller patches them.
+static void compileTerminator(BytecodeCompiler* compiler, const BasicBlock* block, int b, const IrInstruction* in) {
+    BytecodeProgram* program = compiler->program;
+    int next = b + 1;
+    switch (in->opcode) {
+        case IR_JUMP:
+            if (block->successors[0] != next) emitCode(program, BC_JUMP, block->successors[0], 0, 0);
+            break;
+        case IR_BRANCH: {
+            int taken = block->successors[0];
+            int notTaken = block->successors[1];
+            int condition = operand(compiler, in->a);
+            if (notTaken == next) {
+                emitCode(program, BC_JUMP_IF_TRUE, condition, taken, 0);
+            } else if (taken == next) {
+                emitCode(program, BC_JUMP_IF_FALSE, condition, notTaken, 0);
+            } else {
+                emitCode(program, BC_JUMP_IF_TRUE, condition, taken, 0);
+                emitCode(program, BC_JUMP, notTaken, 0, 0);
+            }
+            break;
+        }
+        case IR_SWITCH: {
+            // The table holds block numbers until the caller patches them with the jumps
+            int entries = block->successorCount - 1;
+            int table = program->jumpTableCount;
+            program->jumpTables = (int*)growArray(program->jumpTables, &program->jumpTableCapacity,
+                                                  table + entries + 2, sizeof(int));
+            program->jumpTables[table] = entries;
+            memcpy(&program->jumpTables[table + 1], block->successors, (size_t)(entries + 1) * sizeof(int));
+            program->jumpTableCount += entries + 2;
+            emitCode(program, BC_SWITCH, operand(compiler, in->a), in->imm.i, table);
+            break;
+        }
+        default:
+            emitCode(program, BC_RETURN, in->a >= 0 ? operand(compiler, in->a) : -1, 0, 0);
+            break;
+    }
+}
+
+static void compileBlock(BytecodeCompiler* compiler, int b) {
+    const BasicBlock* block = &compiler->cfg->blocks[b];
+    for (int i = 0; i < block->codeCount; i++) {
+        const IrInstruction* in = &block->code[i];
+        if (IR_IS_TERMINATOR(in->opcode)) {
+            compileTerminator(compiler, block, b, in);
+            continue;
+        }
+
+        // A comparison whose only reader is the branch right after it
+        const IrInstruction* next = i + 1 < block->codeCount ? &block->code[i + 1] : NULL;
+        if (bytecodeSuperinstructions && next && next->opcode == IR_BRANCH && next->a == in->dst &&
+            isIntComparison(in) && isSingleUseTemporary(compiler, in->dst)) {
+            compileCompareBranch(compiler, in, block, b);
+            i++;
+            continue;
+        }
+        compileInstruction(compiler, in);
+    }
+}
+
+// Function to give every input() the text before its conversion as its own string,
+// so the VM shows it without scanning the format, and check the conversion
+// against the variable's type
+static void splitInputPrompts(BytecodeProgram* program) {
+    int inputs = 0;
+    for (int pc = 0; pc < program->codeCount; pc++) {
+        if (program->code[pc].opcode == BC_INPUT) inputs++;
+    }
+    if (!inputs) return;
+    program->strings = (char**)realloc(program->strings, (size_t)(program->stringCount + inputs) * sizeof(char*));
+    if (!program->strings) {
+        fprintf(stderr, "Error: Memory allocation failed for bytecode.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (int pc = 0; pc < program->codeCount; pc++) {
+        BytecodeInstruction* in = &program->code[pc];
+        if (in->opcode != BC_INPUT) continue;
+        const char* format = program->strings[in->b];
+        const char* conversion = strchr(format, '%');
+        int length = conversion ? (int)(conversion - format) : (int)strlen(format);
+        if (conversion) {
+            const char* c = conversion + 1;
+            while (*c && strchr("0123456789lh", *c)) c++;
+            const char* expected = in->c == TYPE_FLOAT ? "fFeEgG" : in->c == TYPE_CHAR ? "c"
+                                 : in->c == TYPE_STRING ? "s" : in->c == TYPE_BOOL ? "sd" : "di";
+            if (!*c || !strchr(expected, *c)) program->formatMismatches++;
+        }
+
+        char* prompt = (char*)allocateArray(length + 1, 1);
+        memcpy(prompt, format, (size_t)length);
+        in->b = program->stringCount;
+        program->strings[program->stringCount++] = prompt;
+    }
+}
+
+// Function to rename every register the program mentions to its slot
+static void renameToSlots(BytecodeProgram* program, const Cfg* cfg) {
+    for (int pc = 0; pc < program->codeCount; pc++) {
+        int32_t* operands[3];
+        int count = bytecodeRegisterOperands(&program->code[pc], operands);
+        for (int i = 0; i < count; i++) {
+            if (*operands[i] >= 0) *operands[i] = cfg->registerSlots[*operands[i]];
+        }
+    }
+    for (int i = 0; i < program->argumentCount; i++) {
+        program->arguments[i] = cfg->registerSlots[program->arguments[i]];
+    }
+    for (int i = 0; i < program->formatOpCount; i++) {
+        if (program->formatOps[i].kind >= FORMAT_INT) {
+            program->formatOps[i].reg = cfg->registerSlots[program->formatOps[i].reg];
+        }
+    }
+}
+
+BytecodeProgram* compileBytecode(const Cfg* cfg) {
+    BytecodeCompiler compiler;
+    compiler.program = (BytecodeProgram*)allocateArray(1, sizeof(BytecodeProgram));
+    compiler.cfg = cfg;
+    compiler.uses = (int*)allocateArray(cfg->registerCount, sizeof(int));
+    compiler.defs = (int*)allocateArray(cfg->registerCount, sizeof(int));
+    compiler.defBlock = (int*)allocateArray(cfg->registerCount, sizeof(int));
+    compiler.pending = (unsigned char*)allocateArray(cfg->registerCount, 1);
+    compiler.pendingValue = (int32_t*)allocateArray(cfg->registerCount, sizeof(int32_t));
+    compiler.literal = (int*)allocateArray(cfg->registerCount, sizeof(int));
+    countUses(&compiler);
+
+    BytecodeProgram* program = compiler.program;
+    int* blockStart = (int*)allocateArray(cfg->blockCount, sizeof(int));
+    for (int b = 0; b < cfg->blockCount; b++) {
+        blockStart[b] = program->codeCount;
+        compileBlock(&compiler, b);
+    }
+
+    // Patch block numbers into instruction indices
+    for (int pc = 0; pc < program->codeCount; pc++) {
+        int32_t* target = bytecodeJumpTarget(&program->code[pc]);
+        if (target) *target = blockStart[*target];
+    }
+    for (int table = 0; table < program->jumpTableCount; table += program->jumpTables[table] + 2) {
+        for (int k = 1; k <= program->jumpTables[table] + 1; k++) {
+            program->jumpTables[table + k] = blockStart[program->jumpTables[table + k]];
+        }
+    }
+    free(blockStart);
+    free(compiler.uses);
+    free(compiler.defs);
+    free(compiler.defBlock);
+    free(compiler.pending);
+    free(compiler.pendingValue);
+    free(compiler.literal);
+
+    // The program outlives the CFG, so it keeps its own copies of the strings and types
+    program->stringCount = cfg->stringCount;
+    program->strings = (char**)allocateArray(cfg->stringCount, sizeof(char*));
+    for (int i = 0; i < cfg->stringCount; i++) {
+        size_t length = strlen(cfg->strings[i]) + 1;
+        program->strings[i] = (char*)allocateArray((int)length, 1);
+        memcpy(program->strings[i], cfg->strings[i], length);
+    }
+    if (cfg->registerSlots) {
+        renameToSlots(program, cfg);
+        program->registerCount = cfg->slotCount;
+        program->registerTypes = (unsigned char*)allocateArray(cfg->slotCount, 1);
+        program->registerPins = (unsigned char*)allocateArray(cfg->slotCount, 1);
+        if (cfg->slotCount) {
+            memcpy(program->registerTypes, cfg->slotTypes, (size_t)cfg->slotCount);
+            memcpy(program->registerPins, cfg->slotPins, (size_t)cfg->slotCount);
+        }
+    } else {
+        program->registerCount = cfg->registerCount;
+        program->registerTypes = (unsigned char*)allocateArray(cfg->registerCount, 1);
+        if (cfg->registerCount) memcpy(program->registerTypes, cfg->registerTypes, (size_t)cfg->registerCount);
+    }
+    splitInputPrompts(program);
+    return program;
+}
+
+// ---------------------------------------
+// Output
+// ---------------------------------------
+
+static const char* const opcodeNames[BC_OPCODE_COUNT] = {
+    "load_int", "load_float", "load_string", "move", "int_to_float",
+    "add_i", "sub_i", "mul_i", "floor_div_i", "mod_i", "pow_i",
+    "add_f", "sub_f", "mul_f", "div_f", "pow_f",
+    "eq_i", "ne_i", "lt_i", "le_i", "gt_i", "ge_i",
+    "eq_f", "ne_f", "lt_f", "le_f", "gt_f", "ge_f",
+    "eq_s", "ne_s", "hash_s", "not",
+    "jump", "jump_if_true", "jump_if_false", "switch",
+    "input", "print", "return",
+    "new_array_i", "new_array_f", "new_array_b", "array_length", "check_index",
+    "load_elem_i", "load_elem_f", "load_elem_b", "store_elem_i", "store_elem_f", "store_elem_b",
+    "max_i", "vector_map_i", "vector_map_f", "vector_sum_i", "vector_sum_f",
+    "add_ik", "mul_ik", "floor_div_ik", "mod_ik",
+    "branch_eq_i", "branch_ne_i", "branch_lt_i", "branch_le_i", "branch_gt_i", "branch_ge_i",
+    "branch_eq_ik", "branch_ne_ik", "branch_lt_ik", "branch_le_ik", "branch_gt_ik", "branch_ge_ik",
+};
+
+const char* bytecodeOpcodeName(int opcode) {
+    return (opcode >= 0 && opcode < BC_OPCODE_COUNT) ? opcodeNames[opcode] : "?";
+}
+
+int32_t* bytecodeJumpTarget(BytecodeInstruction* instruction) {
+    switch (instruction->opcode) {
+        case BC_JUMP:
+            return &instruction->a;
+        case BC_JUMP_IF_TRUE:
+        case BC_JUMP_IF_FALSE:
+            return &instruction->b;
+        default:
+            if (instruction->opcode >= BC_BRANCH_EQ_I && instruction->opcode <= BC_BRANCH_GE_IK) {
+                return &instruction->c;
+            }
+            return NULL;
+    }
+}
+
+int bytecodeRegisterOperands(BytecodeInstruction* in, int32_t* operands[3]) {
+    switch (in->opcode) {
+        case BC_LOAD_INT:
+        case BC_LOAD_FLOAT:
+        case BC_LOAD_STRING:
+        case BC_INPUT:
+        case BC_VECTOR_SUM_I:
+        case BC_VECTOR_SUM_F:
+        case BC_JUMP_IF_TRUE:
+        case BC_JUMP_IF_FALSE:
+        case BC_SWITCH:
+            operands[0] = &in->a;
+            return 1;
+        case BC_RETURN:
+            operands[0] = &in->a;
+            return in->a >= 0;
+        case BC_MOVE:
+        case BC_INT_TO_FLOAT:
+        case BC_NOT:
+        case BC_HASH_S:
+        case BC_ARRAY_LENGTH:
+        case BC_CHECK_INDEX:
+        case BC_ADD_IK:
+        case BC_MUL_IK:
+        case BC_FLOOR_DIV_IK:
+        case BC_MOD_IK:
+            operands[0] = &in->a;
+            operands[1] = &in->b;
+            return 2;
+        case BC_JUMP:
+        case BC_PRINT:
+        case BC_VECTOR_MAP_I:
+        case BC_VECTOR_MAP_F:
+            return 0;
+        default:
+            if (in->opcode >= BC_BRANCH_EQ_IK && in->opcode <= BC_BRANCH_GE_IK) {
+                operands[0] = &in->a;
+                return 1;
+            }
+            if (in->opcode >= BC_BRANCH_EQ_I && in->opcode <= BC_BRANCH_GE_I) {
+                operands[0] = &in->a;
+                operands[1] = &in->b;
+                return 2;
+            }
+            operands[0] = &in->a;
+            operands[1] = &in->b;
+            operands[2] = &in->c;
+            return 3;
+    }
+}
+
+// Function to show a precompiled format, e.g. `  ; "x=" int(r1) "\n"`
+static void writeFormatOps(const BytecodeProgram* program, const FormatOp* op, FILE* file) {
+    static const char* const kindNames[] = {"", "", "int", "float", "char", "bool", "string", "spec"};
+    fputs("  ;", file);
+    for (; op->kind != FORMAT_END; op++) {
+        if (op->kind != FORMAT_TEXT) {
+            if (op->kind == FORMAT_SPEC) {
+                fprintf(file, " \"%s\"(r%d)", program->formatText + op->text, op->reg);
+            } else {
+                fprintf(file, " %s(r%d)", kindNames[op->kind], op->reg);
+            }
+            continue;
+        }
+        fputs(" \"", file);
+        for (int i = 0; i < op->length; i++) {
+            char c = program->formatText[op->text + i];
+            if (c == '\n') fputs("\\n", file);
+            else if (c == '\t') fputs("\\t", file);
+            else if (c == '"' || c == '\\') fprintf(file, "\\%c", c);
+            else fputc(c, file);
+        }
+        fputc('"', file);
+    }
+}
+
+// Output: one instruction per line, prefixed with its index (the jump target numbering)
+void writeBytecodeToFile(const BytecodeProgram* program, FILE* file) {
+    fprintf(file, "; %d instructions, %d registers, %d float constants, %d strings\n",
+            program->codeCount, program->registerCount, program->floatCount, program->stringCount);
+
+    for (int pc = 0; pc < program->codeCount; pc++) {
+        const BytecodeInstruction* in = &program->code[pc];
+        fprintf(file, "%5d  %-13s ", pc, bytecodeOpcodeName(in->opcode));
+        switch (in->opcode) {
+            case BC_LOAD_INT:
+                fprintf(file, "r%d, %d", in->a, in->b);
+                break;
+            case BC_LOAD_FLOAT:
+                fprintf(file, "r%d, %.17g", in->a, program->floats[in->b]);
+                break;
+            case BC_LOAD_STRING:
+            case BC_INPUT:
+                fprintf(file, "r%d, s%d", in->a, in->b);
+                break;
+            case BC_MOVE:
+            case BC_INT_TO_FLOAT:
+            case BC_NOT:
+                fprintf(file, "r%d, r%d", in->a, in->b);
+                break;
+            case BC_JUMP:
+                fprintf(file, "%d", in->a);
+                break;
+            case BC_JUMP_IF_TRUE:
+            case BC_JUMP_IF_FALSE:
+                fprintf(file, "r%d, %d", in->a, in->b);
+                break;
+            case BC_SWITCH: {
+                const int* table = &program->jumpTables[in->c];
+                fprintf(file, "r%d from %d [", in->a, in->b);
+                for (int k = 0; k < table[0]; k++) {
+                    fprintf(file, "%s%d", k ? " " : "", table[2 + k]);
+                }
+                fprintf(file, "] else %d", table[1]);
+                break;
+            }
+            case BC_HASH_S:
+                fprintf(file, "r%d, r%d & %d", in->a, in->b, in->c);
+                break;
+            case BC_PRINT:
+                for (int i = 0; i < in->b; i++) {
+                    fprintf(file, "%sr%d", i ? ", " : "", program->arguments[in->a + i]);
+                }
+                if (in->c >= 0) writeFormatOps(program, &program->formatOps[in->c], file);
+                break;
+            case BC_RETURN:
+                if (in->a >= 0) fprintf(file, "r%d", in->a);
+                break;
+            case BC_NEW_ARRAY_I:
+            case BC_NEW_ARRAY_F:
+            case BC_NEW_ARRAY_B:
+                fprintf(file, "r%d, r%d", in->a, in->b);
+                if (in->c >= 0) fprintf(file, ", r%d", in->c);
+                break;
+            case BC_ARRAY_LENGTH:
+            case BC_CHECK_INDEX:
+                fprintf(file, "r%d, r%d, %d", in->a, in->b, in->c);
+                break;
+            case BC_VECTOR_MAP_I:
+            case BC_VECTOR_MAP_F: {
+                static const char* const ops[] = {"+", "-", "*", "/", "copy"};
+                const int* run = &program->arguments[in->a];
+                fprintf(file, "r%d = r%d %s r%d for r%d <= k < r%d", run[0], run[1], ops[in->b], run[2], run[3], run[4]);
+                break;
+            }
+            case BC_VECTOR_SUM_I:
+            case BC_VECTOR_SUM_F: {
+                const int* run = &program->arguments[in->b];
+                fprintf(file, "r%d, r%d", in->a, run[0]);
+                if (in->c == 2) fprintf(file, " * r%d", run[1]);
+                fprintf(file, " for r%d <= k < r%d", run[in->c], run[in->c + 1]);
+                break;
+            }
+            case BC_ADD_IK:
+            case BC_MUL_IK:
+            case BC_FLOOR_DIV_IK:
+            case BC_MOD_IK:
+                fprintf(file, "r%d, r%d, %d", in->a, in->b, in->c);
+                break;
+            default:
+                if (in->opcode >= BC_BRANCH_EQ_IK && in->opcode <= BC_BRANCH_GE_IK) {
+                    fprintf(file, "r%d, %d, %d", in->a, in->b, in->c);
+                    break;
+                }
+                fprintf(file, "r%d, r%d, r%d", in->a, in->b, in->c);
+                break;
+        }
+        fputc('\n', file);
+    }
+}
+
+void freeBytecode(BytecodeProgram* program) {
+    if (!program) return;
+    for (int i = 0; i < program->stringCount; i++) {
+        free(program->strings[i]);
+    }
+    free(program->strings);
+    free(program->code);
+    free(program->floats);
+    free(program->arguments);
+    free(program->jumpTables);
+    free(program->formatOps);
+    free(program->formatText);
+    free(program->registerTypes);
+    free(program->registerPins);
+    free(program);
+}
@@ -0,0 +1,138 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "cfg.h"
+
+// Register-based bytecode. Every instruction is four ints: the opcode and up
+// to three operands. Registers are the CFG's (variables first, then
+// temporaries); operand types are resolved at compile time, so each opcode
+// works on one representation.
+typedef enum {
+    BC_LOAD_INT,       // r[a] = b (int, char and bool)
+    BC_LOAD_FLOAT,     // r[a] = floats[b]
+    BC_LOAD_STRING,    // r[a] = strings[b]
+    BC_MOVE,           // r[a] = r[b]
+    BC_INT_TO_FLOAT,   // r[a] = (float)r[b]
+
+    BC_ADD_I, BC_SUB_I, BC_MUL_I, BC_FLOOR_DIV_I, BC_MOD_I, BC_POW_I, // r[a] = r[b] op r[c]
+    BC_ADD_F, BC_SUB_F, BC_MUL_F, BC_DIV_F, BC_POW_F,                 // POW_F: float base, int exponent
+
+    BC_EQ_I, BC_NE_I, BC_LT_I, BC_LE_I, BC_GT_I, BC_GE_I,             // r[a] = r[b] op r[c] (bool)
+    BC_EQ_F, BC_NE_F, BC_LT_F, BC_LE_F, BC_GT_F, BC_GE_F,
+    BC_EQ_S, BC_NE_S,
+    BC_HASH_S,         // r[a] = stringHash(r[b]) & c
+    BC_NOT,            // r[a] = !r[b]
+
+    BC_JUMP,           // pc = a
+    BC_JUMP_IF_TRUE,   // if (r[a]) pc = b
+    BC_JUMP_IF_FALSE,  // if (!r[a]) pc = b
+    BC_SWITCH,         // k = r[a] - b; pc = k < jumpTables[c] (unsigned) ? jumpTables[c + 2 + k] : jumpTables[c + 1]
+
+    BC_INPUT,          // r[a] = value of type c read after showing the prompt strings[b]
+    BC_PRINT,          // printf with registers arguments[a .. a + b), run as formatOps[c ..] (-1: format at run time)
+    BC_RETURN,         // Stop (a = result register or -1)
+
+    // Typed arrays: I, F and B are int, float and one-byte (char and bool) elements
+    BC_NEW_ARRAY_I, BC_NEW_ARRAY_F, BC_NEW_ARRAY_B,                   // r[a] = new array, r[b] rows, r[c] columns (c = -1: one)
+    BC_ARRAY_LENGTH,   // r[a] = length of dimension c of array r[b]
+    BC_CHECK_INDEX,    // Runtime error unless 0 <= r[b] < length of dimension c of array r[a]
+    BC_LOAD_ELEMENT_I, BC_LOAD_ELEMENT_F, BC_LOAD_ELEMENT_B,          // r[a] = r[b][r[c]]
+    BC_STORE_ELEMENT_I, BC_STORE_ELEMENT_F, BC_STORE_ELEMENT_B,       // r[a][r[b]] = r[c]
+
+    // Whole loops replaced by vectorizeLoops(), run by the kernels in vector_kernels.h
+    BC_MAX_I,          // r[a] = max(r[b], r[c])
+    BC_VECTOR_MAP_I, BC_VECTOR_MAP_F, // d[k] = l[k] op r[k] for i <= k < n: arguments[a ..] = d, l, r, i, n; b = VectorOp
+    BC_VECTOR_SUM_I, BC_VECTOR_SUM_F, // r[a] = sum of x[k] (c = 1) or x[k] * y[k] (c = 2) for i <= k < n:
+                                      // arguments[b ..] = x, (y,) i, n
+
+    // Superinstructions, picked from the dynamic pair counts of the loop
+    // benchmarks (build with -DVM_PROFILE): a constant load feeding its only
+    // use, and an int comparison feeding the branch that ends its block.
+    BC_ADD_IK, BC_MUL_IK, BC_FLOOR_DIV_IK, BC_MOD_IK,                 // r[a] = r[b] op c (c != 0 for // and %)
+    BC_BRANCH_EQ_I, BC_BRANCH_NE_I, BC_BRANCH_LT_I,                   // if (r[a] op r[b]) pc = c
+    BC_BRANCH_LE_I, BC_BRANCH_GT_I, BC_BRANCH_GE_I,
+    BC_BRANCH_EQ_IK, BC_BRANCH_NE_IK, BC_BRANCH_LT_IK,                // if (r[a] op b) pc = c
+    BC_BRANCH_LE_IK, BC_BRANCH_GT_IK, BC_BRANCH_GE_IK,
+    BC_OPCODE_COUNT
+} BytecodeOpcode;
+
+typedef struct {
+    int32_t opcode;    // BytecodeOpcode
+    int32_t a, b, c;
+} BytecodeInstruction;
+
+// printf with a literal format is split at compile time into text runs and one
+// conversion per argument, each picked for the argument's static type. Plain
+// conversions get their own kinds; anything with flags, width or precision (or
+// a value the conversion has to convert) keeps its spec for the C library.
+typedef enum {
+    FORMAT_END,
+    FORMAT_TEXT,       // formatText[text .. text + length)
+    FORMAT_INT,        // r[reg].i in decimal (%d, %i, %s and natural int)
+    FORMAT_FLOAT,      // r[reg].f as %f (%f, %s and natural float)
+    FORMAT_CHAR,       // r[reg].i as a character (%c, %s and natural char)
+    FORMAT_BOOL,       // true/false (%s and natural bool)
+    FORMAT_STRING,     // r[reg].s (%s and natural string)
+    FORMAT_SPEC,       // r[reg] through the C spec at formatText + text; `length` is the conversion
+} FormatOpKind;
+
+// formatText is followed by this many readable bytes, so short runs copy in one fixed-size move
+#define FORMAT_TEXT_PADDING 16
+
+typedef struct {
+    int32_t kind;      // FormatOpKind
+    int32_t reg;
+    int32_t text;
+    int32_t length;
+} FormatOp;
+
+typedef struct {
+    BytecodeInstruction* code;
+    int codeCount;
+    int codeCapacity;
+
+    double* floats;           // Float constant pool
+    int floatCount;
+    int floatCapacity;
+
+    int* arguments;           // printf argument registers, one run per BC_PRINT or vector kernel
+    int argumentCount;
+    int argumentCapacity;
+
+    int* jumpTables;          // One run per BC_SWITCH: [entries, default target, target per entry...]
+    int jumpTableCount;
+    int jumpTableCapacity;
+
+    FormatOp* formatOps;      // Precompiled printf formats, each run ended by FORMAT_END
+    int formatOpCount;
+    int formatOpCapacity;
+    char* formatText;         // Their text runs and specs
+    int formatTextLength;
+    int formatTextCapacity;
+    int formatMismatches;     // Conversions without an argument or with one of the wrong type
+
+    char** strings;           // Decoded string literals and format strings (owned)
+    int stringCount;
+
+    int registerCount;
+    unsigned char* registerTypes; // SymbolType per register (owned)
+    unsigned char* registerPins;  // Machine register per register as in Cfg.slotPins (owned), or NULL
+} BytecodeProgram;
+
+extern int bytecodeSuperinstructions; // Non-zero (default): fuse the pairs above while compiling
+
+// Compile a CFG into one instruction stream. Blocks are laid out in the CFG's
+// reverse postorder, so most jumps become fallthroughs. With slots assigned,
+// every register is renamed to its slot.
+BytecodeProgram* compileBytecode(const Cfg* cfg);
+
+const char* bytecodeOpcodeName(int opcode);
+int32_t* bytecodeJumpTarget(BytecodeInstruction* instruction); // Operand holding the target, or NULL
+// Operands naming registers the instruction reads or writes (some may be -1 for none); returns how many
+int bytecodeRegisterOperands(BytecodeInstruction* instruction, int32_t* operands[3]);
+void writeBytecodeToFile(const BytecodeProgram* program, FILE* file);
+void freeBytecode(BytecodeProgram* program);
+
+#endif // BYTECODE_H
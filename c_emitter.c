@@ -0,0 +1,1117 @@
+#include "c_emitter.h"
+#include <stdlib.h>
+#include <string.h>
+#include "arithmetic.h"
+#include "symbol_table.h"
+#include "format.h"
+
+// Helpers every translated program starts with. They mirror arithmetic.h and
+// the VM's runtime errors and input(); gcc inlines them away at -O2.
+static const char* const runtimePrelude =
+    "#include <stdint.h>\n"
+    "#include <stdio.h>\n"
+    "#include <stdlib.h>\n"
+    "#include <string.h>\n"
+    "\n"
+    "#ifdef __GNUC__\n"
+    "#pragma GCC diagnostic ignored \"-Wunused-variable\" // Folded variables may never be read\n"
+    "#endif\n"
+    "\n"
+    "static inline int32_t prism_add(int32_t a, int32_t b) { return (int32_t)((uint32_t)a + (uint32_t)b); }\n"
+    "static inline int32_t prism_sub(int32_t a, int32_t b) { return (int32_t)((uint32_t)a - (uint32_t)b); }\n"
+    "static inline int32_t prism_mul(int32_t a, int32_t b) { return (int32_t)((uint32_t)a * (uint32_t)b); }\n"
+    "static inline int32_t prism_neg(int32_t a) { return (int32_t)(0u - (uint32_t)a); }\n"
+    "\n"
+    "static void prism_division_by_zero(const char* what) {\n"
+    "    printf(\"Runtime Error: Integer %s by zero.\\n\", what);\n"
+    "    exit(1);\n"
+    "}\n"
+    "\n"
+    "static inline int32_t prism_floor_div(int32_t a, int32_t b) {\n"
+    "    if (b == 0) prism_division_by_zero(\"division\");\n"
+    "    if (b == -1) return prism_neg(a);\n"
+    "    int32_t quotient = a / b;\n"
+    "    if (a % b != 0 && ((a < 0) != (b < 0))) quotient--;\n"
+    "    return quotient;\n"
+    "}\n"
+    "\n"
+    "static inline int32_t prism_mod(int32_t a, int32_t b) {\n"
+    "    if (b == 0) prism_division_by_zero(\"modulo\");\n"
+    "    if (b == -1) return 0;\n"
+    "    int32_t remainder = a % b;\n"
+    "    if (remainder != 0 && ((remainder < 0) != (b < 0))) remainder += b;\n"
+    "    return remainder;\n"
+    "}\n"
+    "\n"
+    "static inline int32_t prism_pow_i(int32_t base, int32_t exponent) {\n"
+    "    if (exponent < 0) {\n"
+    "        if (base == 1) return 1;\n"
+    "        if (base == -1) return (exponent & 1) ? -1 : 1;\n"
+    "        return 0;\n"
+    "    }\n"
+    "    uint32_t result = 1, factor = (uint32_t)base;\n"
+    "    for (uint32_t n = (uint32_t)exponent; n; n >>= 1) {\n"
+    "        if (n & 1) result *= factor;\n"
+    "        factor *= factor;\n"
+    "    }\n"
+    "    return (int32_t)result;\n"
+    "}\n"
+    "\n"
+    "static inline double prism_pow_f(double base, int32_t exponent) {\n"
+    "    double result = 1.0, factor = base;\n"
+    "    uint32_t n = exponent < 0 ? 0u - (uint32_t)exponent : (uint32_t)exponent;\n"
+    "    for (; n; n >>= 1) {\n"
+    "        if (n & 1) result *= factor;\n"
+    "        factor *= factor;\n"
+    "    }\n"
+    "    return exponent < 0 ? 1.0 / result : result;\n"
+    "}\n"
+    "\n"
+    "// Typed arrays: zeroed, 64-byte aligned, row-major; a one-dimensional array has one column\n"
+    "typedef struct { void* data; void* block; int32_t dims[2]; } prism_array;\n"
+    "\n"
+    "static void prism_new_array(prism_array* array, int32_t rows, int32_t columns, size_t size) {\n"
+    "    int64_t length = (int64_t)rows * columns;\n"
+    "    if (rows < 0 || columns < 0 || length > (1 << 28)) {\n"
+    "        printf(\"Runtime Error: Array length %lld is invalid.\\n\", (long long)(rows < 0 ? rows : columns < 0 ? columns : length));\n"
+    "        exit(1);\n"
+    "    }\n"
+    "    free(array->block); // A declaration run again (in a loop) replaces its array\n"
+    "    array->block = calloc(1, (size_t)length * size + 64);\n"
+    "    if (!array->block) exit(1);\n"
+    "    array->data = (void*)(((uintptr_t)array->block + 63) & ~(uintptr_t)63);\n"
+    "    array->dims[0] = rows;\n"
+    "    array->dims[1] = columns;\n"
+    "}\n"
+    "\n"
+    "static inline int32_t prism_check_index(const prism_array* array, int32_t index, int dimension) {\n"
+    "    if ((uint32_t)index >= (uint32_t)array->dims[dimension]) {\n"
+    "        printf(\"Runtime Error: Array index %d is out of bounds for length %d.\\n\", index, array->dims[dimension]);\n"
+    "        exit(1);\n"
+    "    }\n"
+    "    return index;\n"
+    "}\n"
+    "\n"
+    "static inline int32_t prism_index2(const prism_array* array, int32_t row, int32_t column) {\n"
+    "    prism_check_index(array, row, 0);\n"
+    "    prism_check_index(array, column, 1);\n"
+    "    return row * array->dims[1] + column;\n"
+    "}\n"
+    "\n"
+    "static inline const char* prism_int_text(char* text, int32_t value) { sprintf(text, \"%d\", value); return text; }\n"
+    "static inline const char* prism_char_text(char* text, int32_t value) { text[0] = (char)value; return text; }\n"
+    "static inline const char* prism_float_text(char* text, double value) { snprintf(text, 64, \"%f\", value); return text; }\n"
+    "\n"
+    "// printf with a format only known at run time, read by the VM's rules: an argument\n"
+    "// per conversion, converted to what it expects; %s, a string given to a numeric\n"
+    "// conversion and unconsumed arguments print the natural form; a '%' with no\n"
+    "// conversion or no argument left prints as text\n"
+    "typedef struct { char type; int32_t i; double f; const char* s; } prism_arg; // type: i, f, c, b or s\n"
+    "\n"
+    "static const char* prism_arg_text(char* text, prism_arg arg) {\n"
+    "    switch (arg.type) {\n"
+    "        case 'f': snprintf(text, 256, \"%f\", arg.f); return text;\n"
+    "        case 'c': text[0] = (char)arg.i; text[1] = '\\0'; return text;\n"
+    "        case 'b': return arg.i ? \"true\" : \"false\";\n"
+    "        case 's': return arg.s ? arg.s : \"\";\n"
+    "        default: sprintf(text, \"%d\", arg.i); return text;\n"
+    "    }\n"
+    "}\n"
+    "\n"
+    "static void prism_printf(const char* format, int count, const prism_arg* args) {\n"
+    "    char text[256];\n"
+    "    int next = 0;\n"
+    "    for (const char* p = format ? format : \"\"; *p; p++) {\n"
+    "        if (*p != '%') {\n"
+    "            putchar(*p);\n"
+    "            continue;\n"
+    "        }\n"
+    "        if (p[1] == '%') {\n"
+    "            putchar('%');\n"
+    "            p++;\n"
+    "            continue;\n"
+    "        }\n"
+    "        char spec[32] = \"%\";\n"
+    "        int length = 1;\n"
+    "        const char* q = p + 1;\n"
+    "        while (*q && strchr(\"-+ #0123456789.\", *q) && length < 30) spec[length++] = *q++;\n"
+    "        while (*q == 'l' || *q == 'h') q++;\n"
+    "        if (!*q || !strchr(\"diuxXocfFeEgGs\", *q) || next >= count) {\n"
+    "            putchar('%');\n"
+    "            continue;\n"
+    "        }\n"
+    "        spec[length++] = *q;\n"
+    "        spec[length] = '\\0';\n"
+    "        prism_arg arg = args[next++];\n"
+    "        if (arg.type == 's' && *q != 's') fputs(prism_arg_text(text, arg), stdout); // No number to convert\n"
+    "        else if (strchr(\"diuxXoc\", *q)) printf(spec, arg.type == 'f' ? (int)arg.f : arg.i);\n"
+    "        else if (*q != 's') printf(spec, arg.type == 'f' ? arg.f : (double)arg.i);\n"
+    "        else printf(spec, prism_arg_text(text, arg));\n"
+    "        p = q;\n"
+    "    }\n"
+    "    for (; next < count; next++) {\n"
+    "        if (args[next].type == 'f') printf(\"%f\", args[next].f);\n"
+    "        else if (args[next].type == 'c') putchar(args[next].i);\n"
+    "        else fputs(prism_arg_text(text, args[next]), stdout);\n"
+    "    }\n"
+    "}\n"
+    "\n"
+    "static void prism_prompt(const char* prompt) {\n"
+    "    fputs(prompt, stdout);\n"
+    "    fflush(stdout);\n"
+    "}\n"
+    "\n"
+    "static void prism_input_error(const char* type) {\n"
+    "    printf(\"Runtime Error: Expected a %s value for input.\\n\", type);\n"
+    "    exit(1);\n"
+    "}\n"
+    "\n"
+    "static inline int32_t prism_read_int(const char* prompt) {\n"
+    "    int value;\n"
+    "    prism_prompt(prompt);\n"
+    "    if (scanf(\"%d\", &value) != 1) prism_input_error(\"int\");\n"
+    "    return value;\n"
+    "}\n"
+    "\n"
+    "static inline double prism_read_float(const char* prompt) {\n"
+    "    double value;\n"
+    "    prism_prompt(prompt);\n"
+    "    if (scanf(\"%lf\", &value) != 1) prism_input_error(\"float\");\n"
+    "    return value;\n"
+    "}\n"
+    "\n"
+    "static inline int32_t prism_read_char(const char* prompt) {\n"
+    "    char value;\n"
+    "    prism_prompt(prompt);\n"
+    "    if (scanf(\" %c\", &value) != 1) prism_input_error(\"char\");\n"
+    "    return (unsigned char)value;\n"
+    "}\n"
+    "\n"
+    "static inline int32_t prism_read_bool(const char* prompt) {\n"
+    "    char word[256];\n"
+    "    prism_prompt(prompt);\n"
+    "    if (scanf(\"%255s\", word) != 1) prism_input_error(\"bool\");\n"
+    "    return strcmp(word, \"true\") == 0 || strcmp(word, \"1\") == 0;\n"
+    "}\n"
+    "\n"
+    "static inline const char* prism_read_string(const char* prompt) {\n"
+    "    char word[256];\n"
+    "    prism_prompt(prompt);\n"
+    "    if (scanf(\"%255s\", word) != 1) prism_input_error(\"string\");\n"
+    "    char* copy = (char*)malloc(strlen(word) + 1);\n"
+    "    if (!copy) exit(1);\n"
+    "    return strcpy(copy, word);\n"
+    "}\n"
+    "\n";
+
+typedef struct {
+    FILE* file;
+    int indent;
+    int loopDepth;  // break/continue outside a loop are dropped, as the CFG does
+    int switchDepth; // ... except a break inside a switch
+} CEmitter;
+
+static void emitStatement(CEmitter* emitter, ParseTreeNode* node);
+static void emitExpression(CEmitter* emitter, ParseTreeNode* node);
+
+// ---------------------------------------
+// Names, types and literals
+// ---------------------------------------
+
+static void emitIndent(CEmitter* emitter) {
+    fprintf(emitter->file, "%*s", emitter->indent * 4, "");
+}
+
+// Variables become name_binding, so shadowed names stay distinct and never meet a C keyword.
+// Only trees without syntax, semantic or type errors are translated, so every name is resolved.
+static void emitName(CEmitter* emitter, const ParseTreeNode* identifier) {
+    if (identifier->binding < 0) {
+        fprintf(stderr, "Error: Internal error: '%s' reached C translation unresolved.\n", identifier->value);
+        exit(EXIT_FAILURE);
+    }
+    fprintf(emitter->file, "%s_%d", identifier->value, identifier->binding);
+}
+
+static const char* cTypeName(int type) {
+    switch (type) {
+        case TYPE_FLOAT: return "double";
+        case TYPE_STRING: return "const char*";
+        default: return "int32_t"; // int, char (its code) and bool (0 or 1), as in the VM
+    }
+}
+
+// Element storage in typed arrays, matching the VM's
+static const char* cElementType(int type) {
+    switch (type) {
+        case TYPE_FLOAT: return "double";
+        case TYPE_INT: return "int32_t";
+        default: return "uint8_t"; // char and bool
+    }
+}
+
+// Chars compute as ints
+static int arithmeticType(int type) {
+    return type == TYPE_CHAR ? TYPE_INT : type;
+}
+
+// Function to write decoded text as a C string literal (without the quotes)
+static void emitEscaped(FILE* file, const char* text, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        unsigned char c = (unsigned char)text[i];
+        switch (c) {
+            case '\n': fputs("\\n", file); break;
+            case '\t': fputs("\\t", file); break;
+            case '\r': fputs("\\r", file); break;
+            case '"': fputs("\\\"", file); break;
+            case '\\': fputs("\\\\", file); break;
+            case '?': fputs("\\?", file); break; // Never a trigraph
+            default:
+                if (c < 32 || c >= 127) fprintf(file, "\\%03o", c);
+                else fputc(c, file);
+                break;
+        }
+    }
+}
+
+static void emitIntConstant(FILE* file, int32_t value) {
+    if (value == INT32_MIN) fputs("(-2147483647 - 1)", file);
+    else if (value < 0) fprintf(file, "(%d)", (int)value);
+    else fprintf(file, "%d", (int)value);
+}
+
+static void emitFloatConstant(FILE* file, double value) {
+    char text[40];
+    snprintf(text, sizeof(text), "%.17g", value);
+    if (!strpbrk(text, ".e")) strcat(text, ".0");
+    fprintf(file, value < 0 ? "(%s)" : "%s", text);
+}
+
+static void emitLiteral(CEmitter* emitter, const ParseTreeNode* node) {
+    FILE* file = emitter->file;
+    switch (node->type) {
+        case TYPE_FLOAT:
+            emitFloatConstant(file, strtod(node->value, NULL));
+            break;
+        case TYPE_CHAR: {
+            char* decoded = decodeLiteral(node->value);
+            fprintf(file, "%d", (unsigned char)decoded[0]);
+            free(decoded);
+            break;
+        }
+        case TYPE_BOOL:
+            fputs(node->value[0] == 't' ? "1" : "0", file);
+            break;
+        case TYPE_STRING: {
+            char* decoded = decodeLiteral(node->value);
+            fputc('"', file);
+            emitEscaped(file, decoded, strlen(decoded));
+            fputc('"', file);
+            free(decoded);
+            break;
+        }
+        default:
+            emitIntConstant(file, intFromText(node->value));
+            break;
+    }
+}
+
+static void emitZero(FILE* file, int type) {
+    fputs(type == TYPE_FLOAT ? "0.0" : type == TYPE_STRING ? "\"\"" : "0", file);
+}
+
+// ---------------------------------------
+// Expressions
+// ---------------------------------------
+
+// Function to write `left op right` computed in `type`; compound operators use their base operator
+static void emitBinary(CEmitter* emitter, int op, int type, ParseTreeNode* left, ParseTreeNode* right) {
+    FILE* file = emitter->file;
+    const char* helper = NULL;
+    const char* symbol = NULL;
+    switch (op) {
+        case OP_ADD: case OP_ADD_ASSIGN: helper = "prism_add"; symbol = " + "; break;
+        case OP_SUB: case OP_SUB_ASSIGN: helper = "prism_sub"; symbol = " - "; break;
+        case OP_MUL: case OP_MUL_ASSIGN: helper = "prism_mul"; symbol = " * "; break;
+        case OP_DIV: case OP_DIV_ASSIGN: symbol = " / "; break; // Operands were converted to float
+        case OP_FLOOR_DIV: case OP_FLOOR_DIV_ASSIGN: helper = "prism_floor_div"; break;
+        case OP_MOD: case OP_MOD_ASSIGN: helper = "prism_mod"; break;
+        case OP_POW: helper = type == TYPE_FLOAT ? "prism_pow_f" : "prism_pow_i"; break;
+        case OP_EQ: symbol = " == "; break;
+        case OP_NE: symbol = " != "; break;
+        case OP_LT: symbol = " < "; break;
+        case OP_LE: symbol = " <= "; break;
+        case OP_GT: symbol = " > "; break;
+        case OP_GE: symbol = " >= "; break;
+        case OP_AND: symbol = " && "; break;
+        case OP_OR: symbol = " || "; break;
+        default: symbol = " , "; break;
+    }
+
+    if ((op == OP_EQ || op == OP_NE) && type == TYPE_STRING) {
+        fputs("(strcmp(", file);
+        emitExpression(emitter, left);
+        fputs(", ", file);
+        emitExpression(emitter, right);
+        fprintf(file, ")%s0)", symbol);
+        return;
+    }
+
+    // Float arithmetic and every comparison are plain C; int arithmetic wraps through the helpers
+    if (helper && (type != TYPE_FLOAT || !symbol)) {
+        fprintf(file, "%s(", helper);
+        emitExpression(emitter, left);
+        fputs(", ", file);
+        emitExpression(emitter, right);
+        fputc(')', file);
+        return;
+    }
+    fputc('(', file);
+    emitExpression(emitter, left);
+    fputs(symbol, file);
+    emitExpression(emitter, right);
+    fputc(')', file);
+}
+
+// Function to write [IDENTIFIER, '[', index, ']', ('[', index, ']')?] as an lvalue
+// whose indices are checked, first dimension first, after both are computed
+static void emitElement(CEmitter* emitter, ParseTreeNode* node) {
+    FILE* file = emitter->file;
+    ParseTreeNode* array = node->children[0];
+    ParseTreeNode* indices[2] = {NULL, NULL};
+    int rank = 0;
+    for (int i = 1; i < node->childCount && rank < 2; i++) {
+        if (NODE_IS_EXPRESSION(node->children[i]->kind)) indices[rank++] = node->children[i];
+    }
+
+    fprintf(file, "((%s*)", cElementType(node->type));
+    emitName(emitter, array);
+    fputs(".data)[", file);
+    fputs(rank == 2 ? "prism_index2(&" : "prism_check_index(&", file);
+    emitName(emitter, array);
+    fputs(", ", file);
+    emitExpression(emitter, indices[0]);
+    fputs(", ", file);
+    if (rank == 2) emitExpression(emitter, indices[1]);
+    else fputc('0', file);
+    fputs(")]", file);
+}
+
+// Function to write an assignment [target, operator, value, ';'?] as a C expression
+static void emitAssignment(CEmitter* emitter, ParseTreeNode* node) {
+    FILE* file = emitter->file;
+    ParseTreeNode* target = node->childCount >= 3 ? unwrap(node->children[0]) : NULL;
+    if (!target || (target->kind != NODE_IDENTIFIER && target->kind != NODE_ARRAY_ACCESS)) {
+        fputs("(void)0", file);
+        return;
+    }
+
+    int op = node->children[1]->op;
+    if (target->kind == NODE_ARRAY_ACCESS) emitElement(emitter, target);
+    else emitName(emitter, target);
+    fputs(" = ", file);
+    if (op == OP_ASSIGN || op == OP_NONE) {
+        emitExpression(emitter, node->children[2]);
+    } else {
+        emitBinary(emitter, op, arithmeticType(target->type), target, node->children[2]);
+    }
+}
+
+// Function to write ++x / x-- as x = x +/- 1
+static void emitIncrement(CEmitter* emitter, ParseTreeNode* node) {
+    ParseTreeNode* variable = NULL;
+    int op = OP_NONE;
+    for (int i = 0; i < node->childCount; i++) {
+        ParseTreeNode* child = node->children[i];
+        if (child->kind == NODE_IDENTIFIER) variable = child;
+        else if (child->kind == NODE_OPERATOR) op = child->op;
+    }
+    if (!variable) {
+        fputs("(void)0", emitter->file);
+        return;
+    }
+
+    emitName(emitter, variable);
+    fputs(" = ", emitter->file);
+    if (variable->type == TYPE_FLOAT) {
+        emitName(emitter, variable);
+        fputs(op == OP_DECREMENT ? " - 1.0" : " + 1.0", emitter->file);
+    } else {
+        fputs(op == OP_DECREMENT ? "prism_sub(" : "prism_add(", emitter->file);
+        emitName(emitter, variable);
+        fputs(", 1)", emitter->file);
+    }
+}
+
+static void emitExpression(CEmitter* emitter, ParseTreeNode* node) {
+    FILE* file = emitter->file;
+    node = unwrap(node);
+    if (!node) {
+        fputc('0', file);
+        return;
+    }
+
+    switch (node->kind) {
+        case NODE_INT_LITERAL:
+        case NODE_FLOAT_LITERAL:
+        case NODE_CHAR_LITERAL:
+        case NODE_STRING_LITERAL:
+        case NODE_BOOL_LITERAL:
+        case NODE_LITERAL:
+            emitLiteral(emitter, node);
+            return;
+
+        case NODE_IDENTIFIER:
+            emitName(emitter, node);
+            return;
+
+        case NODE_ARRAY_ACCESS:
+            emitElement(emitter, node);
+            return;
+
+        case NODE_INT_TO_FLOAT:
+            fputs("((double)", file);
+            emitExpression(emitter, node->childCount ? node->children[0] : NULL);
+            fputc(')', file);
+            return;
+
+        case NODE_LOGICAL_OR_EXPR:
+        case NODE_LOGICAL_AND_EXPR:
+        case NODE_RELATIONAL_EXPR:
+        case NODE_ARITHMETIC_EXPR:
+        case NODE_TERM:
+        case NODE_FACTOR: {
+            if (node->childCount != 3 || node->children[1]->kind != NODE_OPERATOR) break;
+            ParseTreeNode* left = node->children[0];
+            ParseTreeNode* right = node->children[2];
+            int op = node->children[1]->op;
+            int type = (op == OP_POW) ? arithmeticType(left->type)
+                     : (left->type == TYPE_FLOAT || right->type == TYPE_FLOAT) ? TYPE_FLOAT
+                     : arithmeticType(left->type);
+            emitBinary(emitter, op, type, left, right);
+            return;
+        }
+
+        case NODE_EXPONENTIAL_EXPR:
+            // [base, exponent]: the '^' token has no node
+            if (node->childCount != 2) break;
+            emitBinary(emitter, OP_POW, arithmeticType(node->children[0]->type),
+                       node->children[0], node->children[1]);
+            return;
+
+        case NODE_LOGICAL_NOT_EXPR:
+            if (node->childCount != 2) break;
+            fputs("(!", file);
+            emitExpression(emitter, node->children[1]);
+            fputc(')', file);
+            return;
+
+        case NODE_ASSIGNMENT_STATEMENT: // Chained assignment
+            fputc('(', file);
+            emitAssignment(emitter, node);
+            fputc(')', file);
+            return;
+
+        case NODE_UNARY_EXPR:
+            fputc('(', file);
+            emitIncrement(emitter, node);
+            fputc(')', file);
+            return;
+
+        default:
+            break;
+    }
+    fputc('0', file);
+}
+
+// ---------------------------------------
+// printf and input
+// ---------------------------------------
+
+// Function to write one printf argument for `conversion`, converted the way the VM does.
+// %s takes any value and prints its natural text, so non-strings are formatted first.
+static void emitFormatArgument(CEmitter* emitter, char conversion, ParseTreeNode* value) {
+    FILE* file = emitter->file;
+    int type = unwrap(value)->type;
+    if (strchr("diuxXoc", conversion)) {
+        fputs("(int)", file);
+    } else if (strchr("fFeEgG", conversion)) {
+        fputs("(double)", file);
+    } else if (type == TYPE_BOOL) {
+        fputc('(', file);
+        emitExpression(emitter, value);
+        fputs(" ? \"true\" : \"false\")", file);
+        return;
+    } else if (type == TYPE_FLOAT) {
+        fputs("prism_float_text((char[64]){0}, ", file);
+    } else if (type == TYPE_CHAR) {
+        fputs("prism_char_text((char[2]){0}, ", file);
+    } else if (type != TYPE_STRING) {
+        fputs("prism_int_text((char[16]){0}, ", file);
+    } else {
+        emitExpression(emitter, value);
+        return;
+    }
+    emitExpression(emitter, value);
+    if (conversion == 's') fputc(')', file);
+}
+
+// Conversion that prints a value of `type` the way it reads in source
+static char naturalConversion(int type) {
+    switch (type) {
+        case TYPE_FLOAT: return 'f';
+        case TYPE_CHAR: return 'c';
+        case TYPE_BOOL: case TYPE_STRING: return 's';
+        default: return 'd';
+    }
+}
+
+// Function to write printf(format, item, ...) with a format computed at run time as a
+// prism_printf call, each item tagged with its type
+static void emitRuntimeFormat(CEmitter* emitter, ParseTreeNode** values, int count) {
+    FILE* file = emitter->file;
+    emitIndent(emitter);
+    fputs("prism_printf(", file);
+    emitExpression(emitter, values[0]);
+    fprintf(file, ", %d, ", count - 1);
+    if (count == 1) {
+        fputs("NULL);\n", file);
+        return;
+    }
+    fputs("(prism_arg[]){", file);
+    for (int i = 1; i < count; i++) {
+        switch (unwrap(values[i])->type) {
+            case TYPE_FLOAT: fputs("{'f', .f = ", file); break;
+            case TYPE_CHAR: fputs("{'c', .i = ", file); break;
+            case TYPE_BOOL: fputs("{'b', .i = ", file); break;
+            case TYPE_STRING: fputs("{'s', .s = ", file); break;
+            default: fputs("{'i', .i = ", file); break;
+        }
+        emitExpression(emitter, values[i]);
+        fputs(i + 1 < count ? "}, " : "}", file);
+    }
+    fputs("});\n", file);
+}
+
+// Function to lower printf(item, ...) into one C printf. A string literal first item is the
+// format, interpreted now exactly as the VM does at run time; items it does not consume follow
+// in natural form. Any other string first item is a format read at run time by prism_printf.
+static void emitOutput(CEmitter* emitter, ParseTreeNode* node) {
+    FILE* file = emitter->file;
+    ParseTreeNode* list = NULL;
+    for (int i = 0; i < node->childCount; i++) {
+        if (node->children[i]->kind == NODE_OUTPUT_LIST) list = node->children[i];
+    }
+    if (!list) return;
+
+    int capacity = list->childCount ? list->childCount : 1;
+    ParseTreeNode** values = (ParseTreeNode**)malloc(capacity * sizeof(ParseTreeNode*));
+    char* conversions = (char*)malloc(capacity);
+    if (!values || !conversions) {
+        fprintf(stderr, "Error: Memory allocation failed for C output.\n");
+        exit(EXIT_FAILURE);
+    }
+    int count = 0;
+    for (int i = 0; i < list->childCount; i++) {
+        ParseTreeNode* item = list->children[i];
+        if (item->kind == NODE_ADDRESS_VARIABLE) {
+            ParseTreeNode* variable = item->children[item->childCount - 1];
+            if (variable->kind == NODE_IDENTIFIER) values[count++] = variable;
+        } else if (NODE_IS_EXPRESSION(item->kind)) {
+            values[count++] = item;
+        }
+    }
+
+    ParseTreeNode* format = count ? unwrap(values[0]) : NULL;
+    if (format && format->type == TYPE_STRING &&
+        format->kind != NODE_STRING_LITERAL && format->kind != NODE_LITERAL) {
+        emitRuntimeFormat(emitter, values, count);
+        free(values);
+        free(conversions);
+        return;
+    }
+
+    int first = 0;
+    int next = 0;
+    emitIndent(emitter);
+    fputs("printf(\"", file);
+    if (format && format->type == TYPE_STRING) {
+        char* text = decodeLiteral(format->value);
+        first = next = 1;
+        for (const char* p = text; *p; p++) {
+            if (*p != '%') {
+                emitEscaped(file, p, 1);
+                continue;
+            }
+            if (p[1] == '%') {
+                fputs("%%", file);
+                p++;
+                continue;
+            }
+
+            FormatSpec spec;
+            if (!scanFormatSpec(p, &spec) || next >= count) {
+                fputs("%%", file); // Not a conversion, or no argument left: print it as text
+                continue;
+            }
+            if (spec.conversion != 's' && unwrap(values[next])->type == TYPE_STRING) {
+                fputs("%s", file); // A string has no number to convert: printed as it is, as in the VM
+                conversions[next++] = 's';
+            } else {
+                fputs(spec.spec, file); // Flags, width and precision need no escaping
+                conversions[next++] = spec.conversion;
+            }
+            p += spec.length - 1;
+        }
+        free(text);
+    }
+    for (int i = next; i < count; i++) {
+        conversions[i] = naturalConversion(unwrap(values[i])->type);
+        fprintf(file, "%%%c", conversions[i]);
+    }
+    fputc('"', file);
+
+    for (int i = first; i < count; i++) {
+        fputs(", ", file);
+        if (i < next) {
+            emitFormatArgument(emitter, conversions[i], values[i]);
+        } else if (unwrap(values[i])->type == TYPE_BOOL) {
+            emitFormatArgument(emitter, 's', values[i]);
+        } else {
+            emitExpression(emitter, values[i]);
+        }
+    }
+    fputs(");\n", file);
+    free(values);
+    free(conversions);
+}
+
+// Function to lower input("prompt %d", &x, ...): one read per variable
+static void emitInput(CEmitter* emitter, ParseTreeNode* node) {
+    FILE* file = emitter->file;
+    for (int i = 0; i < node->childCount; i++) {
+        ParseTreeNode* list = node->children[i];
+        if (strcmp(list->label, "InputList") != 0) continue;
+
+        for (int j = 0; j < list->childCount; j++) {
+            ParseTreeNode* pair = list->children[j];
+            if (pair->childCount < 3 || pair->children[2]->kind != NODE_ADDRESS_VARIABLE) continue;
+            ParseTreeNode* address = pair->children[2];
+            ParseTreeNode* variable = address->children[address->childCount - 1];
+            if (variable->kind != NODE_IDENTIFIER) continue;
+
+            // The prompt is the format's text before its conversion
+            char* format = decodeLiteral(pair->children[0]->value);
+            char* conversion = strchr(format, '%');
+            size_t promptLength = conversion ? (size_t)(conversion - format) : strlen(format);
+
+            emitIndent(emitter);
+            emitName(emitter, variable);
+            fprintf(file, " = prism_read_%s(\"", symbolTypeName((SymbolType)variable->type));
+            emitEscaped(file, format, promptLength);
+            fputs("\");\n", file);
+            free(format);
+        }
+    }
+}
+
+// ---------------------------------------
+// Statements
+// ---------------------------------------
+
+// Function to write the declarators of [type, name, (=, value)?, (',' | ';'), name, ...]
+// after "type "; uninitialized variables start at zero, as in the CFG
+static void emitDeclarators(CEmitter* emitter, ParseTreeNode* node) {
+    FILE* file = emitter->file;
+    int declared = node->children[0]->type;
+    int first = 1;
+    fprintf(file, "%s ", cTypeName(declared));
+    for (int i = 1; i < node->childCount; i++) {
+        ParseTreeNode* name = node->children[i];
+        if (name->kind != NODE_IDENTIFIER) continue;
+
+        if (!first) fputs(", ", file);
+        first = 0;
+        emitName(emitter, name);
+        fputs(" = ", file);
+        if (i + 2 < node->childCount && node->children[i + 1]->kind == NODE_OPERATOR &&
+            NODE_IS_EXPRESSION(node->children[i + 2]->kind)) {
+            emitExpression(emitter, node->children[i + 2]);
+            i += 2;
+        } else {
+            emitZero(file, declared);
+        }
+    }
+}
+
+// Function to store the values of an ArrayInitializer in order (row >= 0: one row of a 2D array)
+static void emitArrayInitializer(CEmitter* emitter, ParseTreeNode* node, ParseTreeNode* name, int type, int row) {
+    FILE* file = emitter->file;
+    int next = 0;
+    for (int i = 0; i < node->childCount; i++) {
+        ParseTreeNode* child = node->children[i];
+        if (child->kind == NODE_ARRAY_INITIALIZER) {
+            emitArrayInitializer(emitter, child, name, type, next++);
+            continue;
+        }
+        if (!NODE_IS_EXPRESSION(child->kind)) continue;
+
+        emitIndent(emitter);
+        fprintf(file, "((%s*)", cElementType(type));
+        emitName(emitter, name);
+        fputs(".data)[", file);
+        if (row >= 0) {
+            fputs("prism_index2(&", file);
+            emitName(emitter, name);
+            fprintf(file, ", %d, %d)] = ", row, next++);
+        } else {
+            fputs("prism_check_index(&", file);
+            emitName(emitter, name);
+            fprintf(file, ", %d, 0)] = ", next++);
+        }
+        emitExpression(emitter, child);
+        fputs(";\n", file);
+    }
+}
+
+// Function to write [array, type, name, '[', length, ']', ('[', length, ']')?, ('=', initializer)?, ';'].
+// The variable is static so that a declaration run again can free the array it made before.
+static void emitArrayDeclaration(CEmitter* emitter, ParseTreeNode* node) {
+    if (node->childCount < 3) return;
+    FILE* file = emitter->file;
+    int type = node->children[1]->type;
+    ParseTreeNode* name = node->children[2];
+    ParseTreeNode* lengths[2] = {NULL, NULL};
+    ParseTreeNode* initializer = NULL;
+    int rank = 0;
+    for (int i = 3; i < node->childCount; i++) {
+        ParseTreeNode* child = node->children[i];
+        if (child->kind == NODE_ARRAY_INITIALIZER) initializer = child;
+        else if (NODE_IS_EXPRESSION(child->kind) && rank < 2) lengths[rank++] = child;
+    }
+
+    emitIndent(emitter);
+    fputs("static prism_array ", file);
+    emitName(emitter, name);
+    fputs(";\n", file);
+    emitIndent(emitter);
+    fputs("prism_new_array(&", file);
+    emitName(emitter, name);
+    fputs(", ", file);
+    emitExpression(emitter, lengths[0]);
+    fputs(", ", file);
+    if (lengths[1]) emitExpression(emitter, lengths[1]);
+    else fputc('1', file);
+    fprintf(file, ", sizeof(%s));\n", cElementType(type));
+    if (initializer) emitArrayInitializer(emitter, initializer, name, type, -1);
+}
+
+// Function to write a block's braces and statements; the caller ends the line
+static void emitBlock(CEmitter* emitter, ParseTreeNode* node) {
+    fputs("{\n", emitter->file);
+    emitter->indent++;
+    if (node) {
+        ensureChildren(node);
+        for (int i = 0; i < node->childCount; i++) {
+            emitStatement(emitter, node->children[i]);
+        }
+    }
+    emitter->indent--;
+    emitIndent(emitter);
+    fputc('}', emitter->file);
+}
+
+static void emitConditional(CEmitter* emitter, ParseTreeNode* node) {
+    FILE* file = emitter->file;
+    ParseTreeNode* condition = NULL;
+    int branches = 0;
+
+    emitIndent(emitter);
+    for (int i = 0; i < node->childCount; i++) {
+        ParseTreeNode* child = node->children[i];
+        if (NODE_IS_EXPRESSION(child->kind)) {
+            condition = child;
+        } else if (child->kind == NODE_BLOCK) {
+            if (branches++) fputs(" else ", file);
+            if (condition) {
+                fputs("if (", file);
+                emitExpression(emitter, condition);
+                fputs(") ", file);
+                condition = NULL;
+            }
+            emitBlock(emitter, child);
+        }
+    }
+    fputc('\n', file);
+}
+
+// Function to write for (init; condition [until stop]; update) body as one C for loop
+static void emitForLoop(CEmitter* emitter, ParseTreeNode* node) {
+    FILE* file = emitter->file;
+    ParseTreeNode* init = NULL;
+    ParseTreeNode* condition = NULL;
+    ParseTreeNode* stop = NULL;
+    ParseTreeNode* update = NULL;
+    ParseTreeNode* body = NULL;
+    int afterUntil = 0;
+
+    for (int i = 0; i < node->childCount; i++) {
+        ParseTreeNode* child = node->children[i];
+        switch (child->kind) {
+            case NODE_FOR_INIT: init = child; break;
+            case NODE_FOR_UPDATE: update = child; break;
+            case NODE_BLOCK: body = child; break;
+            case NODE_NOISE_WORD:
+                if (strcmp(child->value, "until") == 0) afterUntil = 1;
+                break;
+            default:
+                if (!NODE_IS_EXPRESSION(child->kind)) break;
+                if (afterUntil) stop = child;
+                else condition = child;
+                break;
+        }
+    }
+
+    emitIndent(emitter);
+    fputs("for (", file);
+    if (init && init->childCount > 0) {
+        if (init->children[0]->kind == NODE_TYPE_SPECIFIER) emitDeclarators(emitter, init);
+        else emitAssignment(emitter, init);
+    }
+    fputs("; ", file);
+    if (condition) {
+        fputc('(', file);
+        emitExpression(emitter, condition);
+        fputc(')', file);
+    }
+    if (stop) {
+        fputs(condition ? " && !(" : "!(", file);
+        emitExpression(emitter, stop);
+        fputc(')', file);
+    }
+    fputs("; ", file);
+    if (update) {
+        int first = 1;
+        for (int i = 0; i < update->childCount; i++) {
+            ParseTreeNode* step = update->children[i];
+            if (step->kind != NODE_UNARY_EXPR && step->kind != NODE_ASSIGNMENT_STATEMENT) continue;
+            if (!first) fputs(", ", file);
+            first = 0;
+            if (step->kind == NODE_UNARY_EXPR) emitIncrement(emitter, step);
+            else emitAssignment(emitter, step);
+        }
+    }
+    fputs(") ", file);
+
+    emitter->loopDepth++;
+    emitBlock(emitter, body);
+    emitter->loopDepth--;
+    fputc('\n', file);
+}
+
+// Function to write while and do-while loops: [while, condition, body] / [do, body, while, condition]
+static void emitWhileLoop(CEmitter* emitter, ParseTreeNode* node) {
+    FILE* file = emitter->file;
+    ParseTreeNode* condition = NULL;
+    ParseTreeNode* body = NULL;
+    for (int i = 0; i < node->childCount; i++) {
+        ParseTreeNode* child = node->children[i];
+        if (NODE_IS_EXPRESSION(child->kind)) condition = child;
+        else if (child->kind == NODE_BLOCK) body = child;
+    }
+
+    emitIndent(emitter);
+    emitter->loopDepth++;
+    if (node->kind == NODE_WHILE_LOOP) {
+        fputs("while (", file);
+        emitExpression(emitter, condition);
+        fputs(") ", file);
+        emitBlock(emitter, body);
+        fputc('\n', file);
+    } else {
+        fputs("do ", file);
+        emitBlock(emitter, body);
+        fputs(" while (", file);
+        emitExpression(emitter, condition);
+        fputs(");\n", file);
+    }
+    emitter->loopDepth--;
+}
+
+// Function to write a switch as a C switch, which gcc lowers as it sees fit. A
+// string switch first finds the number of the matching case (-1: none) with strcmp.
+// Labels are followed by an empty statement so a declaration may come next.
+static void emitSwitch(CEmitter* emitter, ParseTreeNode* node) {
+    FILE* file = emitter->file;
+    ParseTreeNode* subject = node->children[1];
+    int isString = subject->type == TYPE_STRING;
+
+    emitIndent(emitter);
+    if (isString) {
+        fputs("{\n", file);
+        emitter->indent++;
+        emitIndent(emitter);
+        fputs("const char* prism_subject = ", file);
+        emitExpression(emitter, subject);
+        fputs(";\n", file);
+        emitIndent(emitter);
+        fputs("int32_t prism_case = -1;\n", file);
+        int index = 0;
+        for (int i = 2; i < node->childCount; i++) {
+            if (node->children[i]->kind != NODE_CASE_CLAUSE) continue;
+            emitIndent(emitter);
+            fprintf(file, "%sif (strcmp(prism_subject, ", index ? "else " : "");
+            emitLiteral(emitter, node->children[i]->children[1]);
+            fprintf(file, ") == 0) prism_case = %d;\n", index++);
+        }
+        emitIndent(emitter);
+        fputs("switch (prism_case) {\n", file);
+    } else {
+        fputs("switch (", file);
+        emitExpression(emitter, subject);
+        fputs(") {\n", file);
+    }
+
+    emitter->switchDepth++;
+    int index = 0;
+    for (int i = 2; i < node->childCount; i++) {
+        ParseTreeNode* clause = node->children[i];
+        emitIndent(emitter);
+        int first = 1;
+        if (clause->kind == NODE_DEFAULT_CLAUSE) {
+            fputs("default:;\n", file);
+        } else if (isString) {
+            fprintf(file, "case %d:;\n", index++);
+            first = 2;
+        } else {
+            fputs("case ", file);
+            emitLiteral(emitter, clause->children[1]);
+            fputs(":;\n", file);
+            first = 2;
+        }
+        emitter->indent++;
+        for (int j = first; j < clause->childCount; j++) {
+            emitStatement(emitter, clause->children[j]);
+        }
+        emitter->indent--;
+    }
+    emitter->switchDepth--;
+
+    emitIndent(emitter);
+    fputs("}\n", file);
+    if (isString) {
+        emitter->indent--;
+        emitIndent(emitter);
+        fputs("}\n", file);
+    }
+}
+
+static void emitJump(CEmitter* emitter, ParseTreeNode* node) {
+    if (node->childCount == 0) return;
+    const char* keyword = node->children[0]->value;
+    FILE* file = emitter->file;
+
+    if (strcmp(keyword, "return") == 0) {
+        // The program stops; its value is computed (it may fail) but not used, as in the VM
+        emitIndent(emitter);
+        if (node->childCount > 1 && NODE_IS_EXPRESSION(node->children[1]->kind)) {
+            fputs("{ (void)(", file);
+            emitExpression(emitter, node->children[1]);
+            fputs("); return 0; }\n", file);
+        } else {
+            fputs("return 0;\n", file);
+        }
+        return;
+    }
+
+    int isBreak = strcmp(keyword, "break") == 0;
+    if (emitter->loopDepth == 0 && !(isBreak && emitter->switchDepth > 0)) return;
+    emitIndent(emitter);
+    fprintf(file, "%s;\n", isBreak ? "break" : "continue");
+}
+
+static void emitStatement(CEmitter* emitter, ParseTreeNode* node) {
+    if (!node) return;
+    FILE* file = emitter->file;
+
+    switch (node->kind) {
+        case NODE_PROGRAM:
+        case NODE_DECLARATION_STATEMENT:
+            ensureChildren(node);
+            for (int i = 0; i < node->childCount; i++) {
+                emitStatement(emitter, node->children[i]);
+            }
+            break;
+
+        case NODE_BLOCK:
+            emitIndent(emitter);
+            emitBlock(emitter, node);
+            fputc('\n', file);
+            break;
+
+        case NODE_VARIABLE_DECLARATION:
+            if (node->childCount == 0 || node->children[0]->kind != NODE_TYPE_SPECIFIER) break;
+            emitIndent(emitter);
+            emitDeclarators(emitter, node);
+            fputs(";\n", file);
+            break;
+
+        case NODE_ARRAY_DECLARATION:
+            emitArrayDeclaration(emitter, node);
+            break;
+
+        case NODE_ASSIGNMENT_STATEMENT:
+            emitIndent(emitter);
+            emitAssignment(emitter, node);
+            fputs(";\n", file);
+            break;
+
+        case NODE_UNARY_EXPR:
+            emitIndent(emitter);
+            emitIncrement(emitter, node);
+            fputs(";\n", file);
+            break;
+
+        case NODE_CONDITIONAL_STATEMENT:
+            emitConditional(emitter, node);
+            break;
+
+        case NODE_FOR_LOOP:
+            emitForLoop(emitter, node);
+            break;
+
+        case NODE_WHILE_LOOP:
+        case NODE_DO_WHILE_LOOP:
+            emitWhileLoop(emitter, node);
+            break;
+
+        case NODE_SWITCH_STATEMENT:
+            emitSwitch(emitter, node);
+            break;
+
+        case NODE_JUMP_STATEMENT:
+            emitJump(emitter, node);
+            break;
+
+        case NODE_INPUT_STATEMENT:
+            emitInput(emitter, node);
+            break;
+
+        case NODE_OUTPUT_STATEMENT:
+            emitOutput(emitter, node);
+            break;
+
+        default:
+            break; // Comments, delimiters and keywords produce no code
+    }
+}
+
+void emitCProgram(ParseTreeNode* root, FILE* file) {
+    CEmitter emitter = {file, 1, 0, 0};
+    fputs("// Translated from Prismatic by syntax_analyzer --emit-c\n", file);
+    fputs(runtimePrelude, file);
+    fputs("int main(void) {\n", file);
+    fputs("    static char prism_output[1 << 16];\n", file);
+    fputs("    setvbuf(stdout, prism_output, _IOFBF, sizeof(prism_output));\n\n", file);
+    emitStatement(&emitter, root);
+    fputs("    return 0;\n}\n", file);
+}
@@ -0,0 +1,13 @@
+#ifndef C_EMITTER_H
+#define C_EMITTER_H
+
+#include <stdio.h>
+#include "parse_tree.h"
+
+// Translate a type-checked program into a standalone C translation unit that
+// behaves like the bytecode VM: 32-bit wrapping ints, floor `//` and `%`,
+// integer `^`, the same printf conversions and the same runtime errors.
+// Needs a tree the type checker accepted (node->type and node->binding).
+void emitCProgram(ParseTreeNode* root, FILE* file);
+
+#endif // C_EMITTER_H
@@ -0,0 +1,1536 @@
+#include "cfg.h"
+#include <stdlib.h>
+#include <string.h>
+#include "arithmetic.h"
+#include "symbol_table.h"
+
+typedef struct {
+    Cfg* cfg;
+    int current;         // Block receiving instructions
+    int breakTarget;     // Innermost loop's or switch's exit (-1 outside both)
+    int continueTarget;  // Innermost loop's update block (-1 outside loops)
+} CfgBuilder;
+
+static void* growArray(void* array, int* capacity, int needed, size_t size) {
+    if (needed <= *capacity) return array;
+    int newCapacity = *capacity ? *capacity : 8;
+    while (newCapacity < needed) newCapacity *= 2;
+    array = realloc(array, (size_t)newCapacity * size);
+    if (!array) {
+        fprintf(stderr, "Error: Memory allocation failed for control-flow graph.\n");
+        exit(EXIT_FAILURE);
+    }
+    *capacity = newCapacity;
+    return array;
+}
+
+static void* allocateArray(int count, size_t size) {
+    void* array = calloc(count > 0 ? (size_t)count : 1, size);
+    if (!array) {
+        fprintf(stderr, "Error: Memory allocation failed for control-flow graph.\n");
+        exit(EXIT_FAILURE);
+    }
+    return array;
+}
+
+// ---------------------------------------
+// Blocks, registers and instructions
+// ---------------------------------------
+
+int newBlock(Cfg* cfg) {
+    cfg->blocks = (BasicBlock*)growArray(cfg->blocks, &cfg->blockCapacity, cfg->blockCount + 1, sizeof(BasicBlock));
+    BasicBlock* block = &cfg->blocks[cfg->blockCount];
+    memset(block, 0, sizeof(*block));
+    block->successors = (int*)growArray(NULL, &block->successorCapacity, 2, sizeof(int));
+    block->successors[0] = block->successors[1] = -1;
+    return cfg->blockCount++;
+}
+
+int newRegister(Cfg* cfg, int type) {
+    if (cfg->registerCount == cfg->registerCapacity) {
+        int capacity = cfg->registerCapacity;
+        cfg->registerTypes = (unsigned char*)growArray(cfg->registerTypes, &capacity, cfg->registerCount + 1,
+                                                       sizeof(unsigned char));
+        capacity = cfg->registerCapacity;
+        cfg->registerNames = (SymbolId*)growArray(cfg->registerNames, &capacity, cfg->registerCount + 1,
+                                                  sizeof(SymbolId));
+        cfg->registerCapacity = capacity;
+    }
+    cfg->registerTypes[cfg->registerCount] = (unsigned char)type;
+    cfg->registerNames[cfg->registerCount] = SYMBOL_NONE;
+    return cfg->registerCount++;
+}
+
+// Function to add an instruction to the end of a block, before its terminator
+IrInstruction* insertBeforeJump(BasicBlock* block, int opcode, int type, int dst, int a, int b) {
+    block->code = (IrInstruction*)growArray(block->code, &block->codeCapacity, block->codeCount + 1,
+                                            sizeof(IrInstruction));
+    IrInstruction* in = &block->code[block->codeCount - 1];
+    block->code[block->codeCount++] = *in;
+    in->opcode = (unsigned char)opcode;
+    in->type = (unsigned char)type;
+    in->dst = dst;
+    in->a = a;
+    in->b = b;
+    in->c = -1;
+    in->imm.i = 0;
+    return in;
+}
+
+static int addString(Cfg* cfg, const char* literal) {
+    cfg->strings = (char**)growArray(cfg->strings, &cfg->stringCapacity, cfg->stringCount + 1, sizeof(char*));
+    cfg->strings[cfg->stringCount] = decodeLiteral(literal);
+    return cfg->stringCount++;
+}
+
+// Function to append an instruction to the current block.
+// Code after a terminator (return/break/continue) goes to a fresh block nothing jumps to.
+static IrInstruction* emit(CfgBuilder* builder, int opcode, int type, int dst, int a, int b) {
+    Cfg* cfg = builder->cfg;
+    BasicBlock* block = &cfg->blocks[builder->current];
+    if (block->codeCount > 0 && IR_IS_TERMINATOR(block->code[block->codeCount - 1].opcode)) {
+        builder->current = newBlock(cfg);
+        block = &cfg->blocks[builder->current];
+    }
+
+    block->code = (IrInstruction*)growArray(block->code, &block->codeCapacity, block->codeCount + 1,
+                                            sizeof(IrInstruction));
+    IrInstruction* instruction = &block->code[block->codeCount++];
+    memset(instruction, 0, sizeof(*instruction));
+    instruction->opcode = (unsigned char)opcode;
+    instruction->type = (unsigned char)type;
+    instruction->dst = dst;
+    instruction->a = a;
+    instruction->b = b;
+    instruction->c = -1;
+    return instruction;
+}
+
+static void jumpTo(CfgBuilder* builder, int target) {
+    emit(builder, IR_JUMP, TYPE_UNKNOWN, -1, -1, -1);
+    BasicBlock* block = &builder->cfg->blocks[builder->current];
+    block->successors[0] = target;
+    block->successorCount = 1;
+}
+
+// Function to end `block` with a jump to `target`
+void endBlockWithJump(Cfg* cfg, int block, int target) {
+    CfgBuilder builder;
+    builder.cfg = cfg;
+    builder.current = block;
+    jumpTo(&builder, target);
+}
+
+static void branchOn(CfgBuilder* builder, int condition, int whenTrue, int whenFalse) {
+    emit(builder, IR_BRANCH, TYPE_BOOL, -1, condition, -1);
+    BasicBlock* block = &builder->cfg->blocks[builder->current];
+    block->successors[0] = whenTrue;
+    block->successors[1] = whenFalse;
+    block->successorCount = 2;
+}
+
+// Function to load an int, char or bool constant into `dst`
+static IrInstruction* emitIntInto(CfgBuilder* builder, int dst, int type, int32_t value) {
+    IrInstruction* in = emit(builder, IR_CONST, type, dst, -1, -1);
+    in->imm.i = value;
+    return in;
+}
+
+static int emitInt(CfgBuilder* builder, int type, int32_t value) {
+    int dst = newRegister(builder->cfg, type);
+    emitIntInto(builder, dst, type, value);
+    return dst;
+}
+
+static IrInstruction* emitZeroInto(CfgBuilder* builder, int dst, int type) {
+    if (type == TYPE_FLOAT) {
+        IrInstruction* in = emit(builder, IR_CONST, TYPE_FLOAT, dst, -1, -1);
+        in->imm.f = 0.0;
+        return in;
+    }
+    if (type == TYPE_STRING) {
+        int string = addString(builder->cfg, "\"\"");
+        IrInstruction* in = emit(builder, IR_CONST, TYPE_STRING, dst, -1, -1);
+        in->imm.i = string;
+        return in;
+    }
+    return emitIntInto(builder, dst, type, 0);
+}
+
+// ---------------------------------------
+// Expressions
+// ---------------------------------------
+
+static int lowerValue(CfgBuilder* builder, ParseTreeNode* node);
+static void lowerBranch(CfgBuilder* builder, ParseTreeNode* node, int whenTrue, int whenFalse);
+static void lowerStatement(CfgBuilder* builder, ParseTreeNode* node);
+
+// Chars compute as ints
+static int arithmeticType(int type) {
+    return type == TYPE_CHAR ? TYPE_INT : type;
+}
+
+static int binaryOpcode(int op) {
+    switch (op) {
+        case OP_ADD: case OP_ADD_ASSIGN: return IR_ADD;
+        case OP_SUB: case OP_SUB_ASSIGN: return IR_SUB;
+        case OP_MUL: case OP_MUL_ASSIGN: return IR_MUL;
+        case OP_DIV: case OP_DIV_ASSIGN: return IR_DIV;
+        case OP_FLOOR_DIV: case OP_FLOOR_DIV_ASSIGN: return IR_FLOOR_DIV;
+        case OP_MOD: case OP_MOD_ASSIGN: return IR_MOD;
+        case OP_POW: return IR_POW;
+        case OP_EQ: return IR_EQ;
+        case OP_NE: return IR_NE;
+        case OP_LT: return IR_LT;
+        case OP_LE: return IR_LE;
+        case OP_GT: return IR_GT;
+        case OP_GE: return IR_GE;
+        default: return -1;
+    }
+}
+
+static int lowerLiteral(CfgBuilder* builder, ParseTreeNode* node) {
+    const char* text = node->value;
+    switch (node->type) {
+        case TYPE_FLOAT: {
+            int dst = newRegister(builder->cfg, TYPE_FLOAT);
+            emit(builder, IR_CONST, TYPE_FLOAT, dst, -1, -1)->imm.f = strtod(text, NULL);
+            return dst;
+        }
+        case TYPE_CHAR: {
+            char* decoded = decodeLiteral(text);
+            int dst = emitInt(builder, TYPE_CHAR, (unsigned char)decoded[0]);
+            free(decoded);
+            return dst;
+        }
+        case TYPE_BOOL:
+            return emitInt(builder, TYPE_BOOL, text[0] == 't');
+        case TYPE_STRING: {
+            int dst = newRegister(builder->cfg, TYPE_STRING);
+            emit(builder, IR_CONST, TYPE_STRING, dst, -1, -1)->imm.i = addString(builder->cfg, text);
+            return dst;
+        }
+        default:
+            return emitInt(builder, TYPE_INT, intFromText(text));
+    }
+}
+
+// Function to evaluate && / || for their value: branch, then merge true/false into one register
+static int lowerLogicalValue(CfgBuilder* builder, ParseTreeNode* node) {
+    Cfg* cfg = builder->cfg;
+    int dst = newRegister(cfg, TYPE_BOOL);
+    int whenTrue = newBlock(cfg);
+    int whenFalse = newBlock(cfg);
+    int join = newBlock(cfg);
+
+    lowerBranch(builder, node, whenTrue, whenFalse);
+    builder->current = whenTrue;
+    emitIntInto(builder, dst, TYPE_BOOL, 1);
+    jumpTo(builder, join);
+    builder->current = whenFalse;
+    emitIntInto(builder, dst, TYPE_BOOL, 0);
+    jumpTo(builder, join);
+    builder->current = join;
+    return dst;
+}
+
+// Function to read the variable register an identifier resolved to. Only trees without
+// syntax, semantic or type errors are lowered, so an unresolved one is a compiler bug.
+static int bindingOf(const ParseTreeNode* identifier) {
+    if (identifier->binding < 0) {
+        fprintf(stderr, "Error: Internal error: '%s' reached control-flow lowering unresolved.\n",
+                identifier->value);
+        exit(EXIT_FAILURE);
+    }
+    return identifier->binding;
+}
+
+// Function to store `valueNode` into variable register `variable` with `op` (=, +=, ...)
+static void lowerStore(CfgBuilder* builder, int variable, int op, ParseTreeNode* valueNode) {
+    Cfg* cfg = builder->cfg;
+    int value = lowerValue(builder, valueNode);
+
+    if (op == OP_ASSIGN || binaryOpcode(op) < 0) {
+        if (value == variable) return;
+
+        // A temporary computed by the last instruction is written straight into the variable
+        BasicBlock* block = &cfg->blocks[builder->current];
+        IrInstruction* last = block->codeCount ? &block->code[block->codeCount - 1] : NULL;
+        if (value >= cfg->bindingCount && last && last->dst == value) {
+            last->dst = variable;
+            return;
+        }
+        emit(builder, IR_COPY, cfg->registerTypes[variable], variable, value, -1);
+        return;
+    }
+
+    emit(builder, binaryOpcode(op), arithmeticType(cfg->registerTypes[variable]), variable, variable, value);
+}
+
+// Function to check the indices of [IDENTIFIER, '[', index, ']', ...] against the array's
+// lengths and return the register holding the flat index (row * columns + column)
+static int lowerElementIndex(CfgBuilder* builder, ParseTreeNode* node) {
+    Cfg* cfg = builder->cfg;
+    int array = bindingOf(node->children[0]);
+    int indices[2];
+    int rank = 0;
+    for (int i = 1; i < node->childCount && rank < 2; i++) {
+        if (NODE_IS_EXPRESSION(node->children[i]->kind)) indices[rank++] = lowerValue(builder, node->children[i]);
+    }
+    for (int d = 0; d < rank; d++) {
+        emit(builder, IR_CHECK_INDEX, TYPE_INT, -1, array, indices[d])->imm.i = d;
+        cfg->boundsChecks++;
+    }
+    if (rank < 2) return indices[0];
+
+    int columns = newRegister(cfg, TYPE_INT);
+    emit(builder, IR_ARRAY_LENGTH, TYPE_INT, columns, array, -1)->imm.i = 1;
+    int rowStart = newRegister(cfg, TYPE_INT);
+    emit(builder, IR_MUL, TYPE_INT, rowStart, indices[0], columns);
+    int flat = newRegister(cfg, TYPE_INT);
+    emit(builder, IR_ADD, TYPE_INT, flat, rowStart, indices[1]);
+    return flat;
+}
+
+// Function to lower a store to an array element: [ArrayAccess, operator, value].
+// A compound operator loads the element once, after the one check of its index.
+static int lowerElementStore(CfgBuilder* builder, ParseTreeNode* target, int op, ParseTreeNode* valueNode) {
+    Cfg* cfg = builder->cfg;
+    int array = bindingOf(target->children[0]);
+    int type = target->type;
+    int index = lowerElementIndex(builder, target);
+    int value = lowerValue(builder, valueNode);
+
+    if (op != OP_ASSIGN && binaryOpcode(op) >= 0) {
+        int element = newRegister(cfg, type);
+        emit(builder, IR_LOAD_ELEMENT, type, element, array, index);
+        int result = newRegister(cfg, type);
+        emit(builder, binaryOpcode(op), arithmeticType(type), result, element, value);
+        value = result;
+    }
+    emit(builder, IR_STORE_ELEMENT, type, -1, array, index)->c = value;
+    return value;
+}
+
+// Function to lower [target, operator, value, ';'?]; returns the target's register
+static int lowerAssignment(CfgBuilder* builder, ParseTreeNode* node) {
+    if (node->childCount < 3) return emitInt(builder, TYPE_INT, 0);
+
+    ParseTreeNode* target = unwrap(node->children[0]);
+    if (target && target->kind == NODE_ARRAY_ACCESS) {
+        return lowerElementStore(builder, target, node->children[1]->op, node->children[2]);
+    }
+    if (!target || target->kind != NODE_IDENTIFIER) {
+        return lowerValue(builder, node->children[2]);
+    }
+    int variable = bindingOf(target);
+    lowerStore(builder, variable, node->children[1]->op, node->children[2]);
+    return variable;
+}
+
+// Function to lower ++x / x-- as x = x +/- 1
+static int lowerIncrement(CfgBuilder* builder, ParseTreeNode* node) {
+    ParseTreeNode* variable = NULL;
+    int op = OP_NONE;
+    for (int i = 0; i < node->childCount; i++) {
+        ParseTreeNode* child = node->children[i];
+        if (child->kind == NODE_IDENTIFIER) variable = child;
+        else if (child->kind == NODE_OPERATOR) op = child->op;
+    }
+    if (!variable) return emitInt(builder, TYPE_INT, 0);
+
+    Cfg* cfg = builder->cfg;
+    int target = bindingOf(variable);
+    int type = arithmeticType(cfg->registerTypes[target]);
+    int one;
+    if (type == TYPE_FLOAT) {
+        one = newRegister(cfg, TYPE_FLOAT);
+        emit(builder, IR_CONST, TYPE_FLOAT, one, -1, -1)->imm.f = 1.0;
+    } else {
+        one = emitInt(builder, TYPE_INT, 1);
+    }
+    emit(builder, op == OP_DECREMENT ? IR_SUB : IR_ADD, type, target, target, one);
+    return target;
+}
+
+// Function to lower an expression and return the register holding its value
+static int lowerValue(CfgBuilder* builder, ParseTreeNode* node) {
+    Cfg* cfg = builder->cfg;
+    node = unwrap(node);
+    if (!node) return emitInt(builder, TYPE_INT, 0);
+
+    switch (node->kind) {
+        case NODE_INT_LITERAL:
+        case NODE_FLOAT_LITERAL:
+        case NODE_CHAR_LITERAL:
+        case NODE_STRING_LITERAL:
+        case NODE_BOOL_LITERAL:
+        case NODE_LITERAL:
+            return lowerLiteral(builder, node);
+
+        case NODE_IDENTIFIER:
+            return bindingOf(node);
+
+        case NODE_ARRAY_ACCESS: {
+            int array = bindingOf(node->children[0]);
+            int index = lowerElementIndex(builder, node);
+            int dst = newRegister(cfg, node->type);
+            emit(builder, IR_LOAD_ELEMENT, node->type, dst, array, index);
+            return dst;
+        }
+
+        case NODE_INT_TO_FLOAT: {
+            int value = lowerValue(builder, node->childCount ? node->children[0] : NULL);
+            int dst = newRegister(cfg, TYPE_FLOAT);
+            emit(builder, IR_INT_TO_FLOAT, TYPE_FLOAT, dst, value, -1);
+            return dst;
+        }
+
+        case NODE_LOGICAL_OR_EXPR:
+        case NODE_LOGICAL_AND_EXPR:
+        case NODE_RELATIONAL_EXPR:
+        case NODE_ARITHMETIC_EXPR:
+        case NODE_TERM:
+        case NODE_FACTOR: {
+            if (node->childCount != 3 || node->children[1]->kind != NODE_OPERATOR) break;
+            int op = node->children[1]->op;
+            if (op == OP_AND || op == OP_OR) {
+                return lowerLogicalValue(builder, node);
+            }
+
+            ParseTreeNode* left = node->children[0];
+            ParseTreeNode* right = node->children[2];
+            int a = lowerValue(builder, left);
+            int b = lowerValue(builder, right);
+            int type = (op == OP_POW) ? arithmeticType(left->type)
+                     : (left->type == TYPE_FLOAT || right->type == TYPE_FLOAT) ? TYPE_FLOAT
+                     : arithmeticType(left->type);
+            int dst = newRegister(cfg, node->type);
+            emit(builder, binaryOpcode(op), type, dst, a, b);
+            return dst;
+        }
+
+        case NODE_EXPONENTIAL_EXPR: {
+            // [base, exponent]: the '^' token has no node
+            if (node->childCount != 2) break;
+            int a = lowerValue(builder, node->children[0]);
+            int b = lowerValue(builder, node->children[1]);
+            int dst = newRegister(cfg, node->type);
+            emit(builder, IR_POW, arithmeticType(node->children[0]->type), dst, a, b);
+            return dst;
+        }
+
+        case NODE_LOGICAL_NOT_EXPR: {
+            if (node->childCount != 2) break;
+            int value = lowerValue(builder, node->children[1]);
+            int dst = newRegister(cfg, TYPE_BOOL);
+            emit(builder, IR_NOT, TYPE_BOOL, dst, value, -1);
+            return dst;
+        }
+
+        case NODE_ASSIGNMENT_STATEMENT:
+            return lowerAssignment(builder, node); // Chained assignment
+
+        case NODE_UNARY_EXPR:
+            return lowerIncrement(builder, node);
+
+        default:
+            break;
+    }
+    return emitInt(builder, TYPE_INT, 0);
+}
+
+// Function to lower a condition as jumps: control reaches `whenTrue` or `whenFalse`.
+// && and || short-circuit without materializing a bool.
+static void lowerBranch(CfgBuilder* builder, ParseTreeNode* node, int whenTrue, int whenFalse) {
+    node = unwrap(node);
+    if (!node) {
+        jumpTo(builder, whenFalse);
+        return;
+    }
+
+    if ((node->kind == NODE_LOGICAL_OR_EXPR || node->kind == NODE_LOGICAL_AND_EXPR) &&
+        node->childCount == 3 && node->children[1]->kind == NODE_OPERATOR &&
+        (node->children[1]->op == OP_OR || node->children[1]->op == OP_AND)) {
+        int next = newBlock(builder->cfg); // Where the right operand is tested
+        if (node->children[1]->op == OP_OR) {
+            lowerBranch(builder, node->children[0], whenTrue, next);
+        } else {
+            lowerBranch(builder, node->children[0], next, whenFalse);
+        }
+        builder->current = next;
+        lowerBranch(builder, node->children[2], whenTrue, whenFalse);
+        return;
+    }
+
+    if (node->kind == NODE_LOGICAL_NOT_EXPR && node->childCount == 2) {
+        lowerBranch(builder, node->children[1], whenFalse, whenTrue);
+        return;
+    }
+
+    // Folded conditions jump straight to the side they select
+    if (node->kind == NODE_BOOL_LITERAL) {
+        jumpTo(builder, node->value[0] == 't' ? whenTrue : whenFalse);
+        return;
+    }
+
+    branchOn(builder, lowerValue(builder, node), whenTrue, whenFalse);
+}
+
+// ---------------------------------------
+// Statements
+// ---------------------------------------
+
+// Function to lower [type, name, (=, value)?, (',' | ';'), name, ...].
+// Uninitialized variables start at zero (0, 0.0, '\0', false or "").
+static void lowerDeclaration(CfgBuilder* builder, ParseTreeNode* node) {
+    if (node->childCount == 0 || node->children[0]->kind != NODE_TYPE_SPECIFIER) return;
+    Cfg* cfg = builder->cfg;
+    int declared = node->children[0]->type;
+
+    for (int i = 1; i < node->childCount; i++) {
+        ParseTreeNode* name = node->children[i];
+        if (name->kind != NODE_IDENTIFIER) continue;
+
+        int variable = bindingOf(name);
+        cfg->registerTypes[variable] = (unsigned char)declared;
+        cfg->registerNames[variable] = name->symbolId;
+
+        if (i + 2 < node->childCount && node->children[i + 1]->kind == NODE_OPERATOR &&
+            NODE_IS_EXPRESSION(node->children[i + 2]->kind)) {
+            lowerStore(builder, variable, OP_ASSIGN, node->children[i + 2]);
+            i += 2;
+        } else {
+            emitZeroInto(builder, variable, declared)->implicit = 1;
+        }
+    }
+}
+
+// Function to store an initializer's elements at constant indices. Rows of a
+// two-dimensional array are nested initializers, lowered with their `row`.
+static void lowerArrayInitializer(CfgBuilder* builder, ParseTreeNode* node, int array, int type, int row) {
+    Cfg* cfg = builder->cfg;
+    int rowStart = -1;
+    if (row >= 0) {
+        int rowIndex = emitInt(builder, TYPE_INT, row);
+        emit(builder, IR_CHECK_INDEX, TYPE_INT, -1, array, rowIndex)->imm.i = 0;
+        cfg->boundsChecks++;
+        int columns = newRegister(cfg, TYPE_INT);
+        emit(builder, IR_ARRAY_LENGTH, TYPE_INT, columns, array, -1)->imm.i = 1;
+        rowStart = newRegister(cfg, TYPE_INT);
+        emit(builder, IR_MUL, TYPE_INT, rowStart, rowIndex, columns);
+    }
+
+    int next = 0;
+    for (int i = 0; i < node->childCount; i++) {
+        ParseTreeNode* child = node->children[i];
+        if (child->kind == NODE_ARRAY_INITIALIZER) {
+            lowerArrayInitializer(builder, child, array, type, next++);
+            continue;
+        }
+        if (!NODE_IS_EXPRESSION(child->kind)) continue;
+
+        int index = emitInt(builder, TYPE_INT, next++);
+        emit(builder, IR_CHECK_INDEX, TYPE_INT, -1, array, index)->imm.i = row >= 0;
+        cfg->boundsChecks++;
+        if (row >= 0) {
+            int flat = newRegister(cfg, TYPE_INT);
+            emit(builder, IR_ADD, TYPE_INT, flat, rowStart, index);
+            index = flat;
+        }
+        int value = lowerValue(builder, child);
+        emit(builder, IR_STORE_ELEMENT, type, -1, array, index)->c = value;
+    }
+}
+
+// Function to lower [array, type, name, '[', length, ']', ('[', length, ']')?, ('=', initializer)?, ';'].
+// Elements start at zero; the initializer stores its values in order.
+static void lowerArrayDeclaration(CfgBuilder* builder, ParseTreeNode* node) {
+    if (node->childCount < 3) return;
+    Cfg* cfg = builder->cfg;
+    int type = node->children[1]->type;
+    ParseTreeNode* name = node->children[2];
+    int array = bindingOf(name);
+    cfg->registerTypes[array] = TYPE_ARRAY;
+    cfg->registerNames[array] = name->symbolId;
+
+    int lengths[2] = {-1, -1};
+    int rank = 0;
+    ParseTreeNode* initializer = NULL;
+    for (int i = 3; i < node->childCount; i++) {
+        ParseTreeNode* child = node->children[i];
+        if (child->kind == NODE_ARRAY_INITIALIZER) initializer = child;
+        else if (NODE_IS_EXPRESSION(child->kind) && rank < 2) lengths[rank++] = lowerValue(builder, child);
+    }
+    emit(builder, IR_NEW_ARRAY, type, array, lengths[0], lengths[1]);
+    if (initializer) lowerArrayInitializer(builder, initializer, array, type, -1);
+}
+
+// Function to lower if / else if / else: each condition falls through to the next test
+static void lowerConditional(CfgBuilder* builder, ParseTreeNode* node) {
+    Cfg* cfg = builder->cfg;
+    int join = newBlock(cfg);
+    ParseTreeNode* condition = NULL;
+
+    for (int i = 0; i < node->childCount; i++) {
+        ParseTreeNode* child = node->children[i];
+        if (NODE_IS_EXPRESSION(child->kind)) {
+            condition = child;
+        } else if (child->kind == NODE_BLOCK) {
+            if (condition) {
+                int thenBlock = newBlock(cfg);
+                int next = newBlock(cfg);
+                lowerBranch(builder, condition, thenBlock, next);
+                builder->current = thenBlock;
+                lowerStatement(builder, child);
+                jumpTo(builder, join);
+                builder->current = next;
+                condition = NULL;
+            } else {
+                lowerStatement(builder, child); // else
+            }
+        }
+    }
+
+    jumpTo(builder, join);
+    builder->current = join;
+}
+
+// Function to lower for (init; condition [until stop]; update) body:
+//   init -> header -> body -> update -> header, header -> exit
+static void lowerForLoop(CfgBuilder* builder, ParseTreeNode* node) {
+    Cfg* cfg = builder->cfg;
+    ParseTreeNode* init = NULL;
+    ParseTreeNode* condition = NULL;
+    ParseTreeNode* stop = NULL;
+    ParseTreeNode* update = NULL;
+    ParseTreeNode* body = NULL;
+    int afterUntil = 0;
+
+    for (int i = 0; i < node->childCount; i++) {
+        ParseTreeNode* child = node->children[i];
+        switch (child->kind) {
+            case NODE_FOR_INIT: init = child; break;
+            case NODE_FOR_UPDATE: update = child; break;
+            case NODE_BLOCK: body = child; break;
+            case NODE_NOISE_WORD:
+                if (strcmp(child->value, "until") == 0) afterUntil = 1;
+                break;
+            default:
+                if (!NODE_IS_EXPRESSION(child->kind)) break;
+                if (afterUntil) stop = child;
+                else condition = child;
+                break;
+        }
+    }
+
+    if (init) lowerStatement(builder, init);
+
+    int header = newBlock(cfg);
+    int bodyBlock = newBlock(cfg);
+    int latch = newBlock(cfg);
+    int exit = newBlock(cfg);
+
+    jumpTo(builder, header);
+    builder->current = header;
+    if (condition && stop) {
+        int check = newBlock(cfg);
+        lowerBranch(builder, condition, check, exit);
+        builder->current = check;
+        lowerBranch(builder, stop, exit, bodyBlock);
+    } else if (condition) {
+        lowerBranch(builder, condition, bodyBlock, exit);
+    } else if (stop) {
+        lowerBranch(builder, stop, exit, bodyBlock);
+    } else {
+        jumpTo(builder, bodyBlock);
+    }
+
+    int savedBreak = builder->breakTarget;
+    int savedContinue = builder->continueTarget;
+    builder->breakTarget = exit;
+    builder->continueTarget = latch;
+    builder->current = bodyBlock;
+    lowerStatement(builder, body);
+    jumpTo(builder, latch);
+    builder->breakTarget = savedBreak;
+    builder->continueTarget = savedContinue;
+
+    builder->current = latch;
+    if (update) lowerStatement(builder, update);
+    jumpTo(builder, header);
+
+    builder->current = exit;
+}
+
+// Function to lower while (condition) body: header -> body -> header, header -> exit
+static void lowerWhileLoop(CfgBuilder* builder, ParseTreeNode* node) {
+    Cfg* cfg = builder->cfg;
+    ParseTreeNode* condition = NULL;
+    ParseTreeNode* body = NULL;
+    for (int i = 0; i < node->childCount; i++) {
+        ParseTreeNode* child = node->children[i];
+        if (NODE_IS_EXPRESSION(child->kind)) condition = child;
+        else if (child->kind == NODE_BLOCK) body = child;
+    }
+
+    int header = newBlock(cfg);
+    int bodyBlock = newBlock(cfg);
+    int exit = newBlock(cfg);
+
+    jumpTo(builder, header);
+    builder->current = header;
+    lowerBranch(builder, condition, bodyBlock, exit);
+
+    int savedBreak = builder->breakTarget;
+    int savedContinue = builder->continueTarget;
+    builder->breakTarget = exit;
+    builder->continueTarget = header;
+    builder->current = bodyBlock;
+    lowerStatement(builder, body);
+    jumpTo(builder, header);
+    builder->breakTarget = savedBreak;
+    builder->continueTarget = savedContinue;
+
+    builder->current = exit;
+}
+
+// Function to lower do body while (condition);: body -> test -> body, test -> exit
+static void lowerDoWhileLoop(CfgBuilder* builder, ParseTreeNode* node) {
+    Cfg* cfg = builder->cfg;
+    ParseTreeNode* condition = NULL;
+    ParseTreeNode* body = NULL;
+    for (int i = 0; i < node->childCount; i++) {
+        ParseTreeNode* child = node->children[i];
+        if (NODE_IS_EXPRESSION(child->kind)) condition = child;
+        else if (child->kind == NODE_BLOCK) body = child;
+    }
+
+    int bodyBlock = newBlock(cfg);
+    int test = newBlock(cfg);
+    int exit = newBlock(cfg);
+
+    jumpTo(builder, bodyBlock);
+
+    int savedBreak = builder->breakTarget;
+    int savedContinue = builder->continueTarget;
+    builder->breakTarget = exit;
+    builder->continueTarget = test;
+    builder->current = bodyBlock;
+    lowerStatement(builder, body);
+    jumpTo(builder, test);
+    builder->breakTarget = savedBreak;
+    builder->continueTarget = savedContinue;
+
+    builder->current = test;
+    lowerBranch(builder, condition, bodyBlock, exit);
+
+    builder->current = exit;
+}
+
+// ---------------------------------------
+// switch
+// ---------------------------------------
+
+#define SWITCH_TABLE_MIN 4     // Fewest labels worth a jump table
+#define SWITCH_TABLE_SPREAD 3  // ... whose range may be up to this many times the label count
+#define SWITCH_LINEAR_MAX 3    // Labels a search tests one by one instead of splitting further
+#define SWITCH_HASH_MIN 4      // Fewest string labels worth hashing
+
+typedef struct {
+    int32_t value;   // Int or char label; for strings, its index in cfg->strings
+    uint32_t bucket; // String label's hash bucket
+    int target;      // Block of its clause
+    int order;       // Position in the source, so the first of equal labels wins
+} SwitchLabel;
+
+static int compareLabelValues(const void* left, const void* right) {
+    const SwitchLabel* a = (const SwitchLabel*)left;
+    const SwitchLabel* b = (const SwitchLabel*)right;
+    if (a->value != b->value) return a->value < b->value ? -1 : 1;
+    return a->order - b->order;
+}
+
+static int compareLabelBuckets(const void* left, const void* right) {
+    const SwitchLabel* a = (const SwitchLabel*)left;
+    const SwitchLabel* b = (const SwitchLabel*)right;
+    if (a->bucket != b->bucket) return a->bucket < b->bucket ? -1 : 1;
+    return a->order - b->order;
+}
+
+// Function to end the current block with an IR_SWITCH on `value` over [low, low + range)
+// that leaves every entry at `otherwise`; returns the block so the caller fills the table
+static int emitSwitchTable(CfgBuilder* builder, int value, int type, int32_t low, int range, int otherwise) {
+    emit(builder, IR_SWITCH, type, -1, value, -1)->imm.i = low;
+    BasicBlock* block = &builder->cfg->blocks[builder->current];
+    block->successors = (int*)growArray(block->successors, &block->successorCapacity, range + 1, sizeof(int));
+    for (int k = 0; k <= range; k++) {
+        block->successors[k] = otherwise;
+    }
+    block->successorCount = range + 1;
+    return builder->current;
+}
+
+// Function to test `value` against each label in turn (strings with string equality)
+static void lowerCaseChain(CfgBuilder* builder, int value, int type, const SwitchLabel* labels, int count,
+                           int otherwise) {
+    Cfg* cfg = builder->cfg;
+    for (int i = 0; i < count; i++) {
+        int label;
+        if (type == TYPE_STRING) {
+            label = newRegister(cfg, TYPE_STRING);
+            emit(builder, IR_CONST, TYPE_STRING, label, -1, -1)->imm.i = labels[i].value;
+        } else {
+            label = emitInt(builder, type, labels[i].value);
+        }
+        int equal = newRegister(cfg, TYPE_BOOL);
+        emit(builder, IR_EQ, type, equal, value, label);
+        int next = i + 1 < count ? newBlock(cfg) : otherwise;
+        branchOn(builder, equal, labels[i].target, next);
+        if (i + 1 < count) builder->current = next;
+    }
+    if (count == 0) jumpTo(builder, otherwise);
+}
+
+// Function to dispatch an int or char on sorted, distinct labels: one jump table when
+// they are dense enough, else a binary search whose halves are dispatched the same way
+static void lowerCaseSearch(CfgBuilder* builder, int value, int type, const SwitchLabel* labels, int count,
+                            int otherwise) {
+    Cfg* cfg = builder->cfg;
+    int64_t range = count ? (int64_t)labels[count - 1].value - labels[0].value + 1 : 0;
+    if (count >= SWITCH_TABLE_MIN && range <= (int64_t)count * SWITCH_TABLE_SPREAD) {
+        int table = emitSwitchTable(builder, value, type, labels[0].value, (int)range, otherwise);
+        for (int i = 0; i < count; i++) {
+            cfg->blocks[table].successors[1 + (int)((int64_t)labels[i].value - labels[0].value)] = labels[i].target;
+        }
+        cfg->switchTables++;
+        return;
+    }
+    if (count <= SWITCH_LINEAR_MAX) {
+        lowerCaseChain(builder, value, type, labels, count, otherwise);
+        return;
+    }
+
+    int middle = count / 2;
+    int below = newBlock(cfg);
+    int above = newBlock(cfg);
+    int bound = emitInt(builder, type, labels[middle].value);
+    int less = newRegister(cfg, TYPE_BOOL);
+    emit(builder, IR_LT, type, less, value, bound);
+    branchOn(builder, less, below, above);
+    cfg->switchSearches++;
+    builder->current = below;
+    lowerCaseSearch(builder, value, type, labels, middle, otherwise);
+    builder->current = above;
+    lowerCaseSearch(builder, value, type, labels + middle, count - middle, otherwise);
+}
+
+// Function to dispatch a string: hash it into a table of buckets (about one label
+// each) and compare only against the labels in its bucket
+static void lowerStringDispatch(CfgBuilder* builder, int value, SwitchLabel* labels, int count, int otherwise) {
+    Cfg* cfg = builder->cfg;
+    if (count < SWITCH_HASH_MIN) {
+        lowerCaseChain(builder, value, TYPE_STRING, labels, count, otherwise);
+        return;
+    }
+
+    int buckets = 2;
+    while (buckets < count) buckets *= 2;
+    for (int i = 0; i < count; i++) {
+        labels[i].bucket = stringHash(cfg->strings[labels[i].value]) & (uint32_t)(buckets - 1);
+    }
+    qsort(labels, (size_t)count, sizeof(SwitchLabel), compareLabelBuckets);
+
+    int hash = newRegister(cfg, TYPE_INT);
+    emit(builder, IR_HASH, TYPE_STRING, hash, value, -1)->imm.i = buckets - 1;
+    int table = emitSwitchTable(builder, hash, TYPE_INT, 0, buckets, otherwise);
+    cfg->switchHashes++;
+    for (int first = 0; first < count;) {
+        int last = first;
+        while (last < count && labels[last].bucket == labels[first].bucket) last++;
+        int chain = newBlock(cfg);
+        cfg->blocks[table].successors[1 + labels[first].bucket] = chain;
+        builder->current = chain;
+        lowerCaseChain(builder, value, TYPE_STRING, labels + first, last - first, otherwise);
+        first = last;
+    }
+}
+
+// Function to lower switch (subject) { clauses }: dispatch once to the clause blocks,
+// which run on into the next one; break leaves the switch
+static void lowerSwitch(CfgBuilder* builder, ParseTreeNode* node) {
+    Cfg* cfg = builder->cfg;
+    int value = lowerValue(builder, node->children[1]);
+    int type = cfg->registerTypes[value];
+    int clauseCount = node->childCount - 2;
+    int exit = newBlock(cfg);
+    int otherwise = exit;
+
+    int* clauses = (int*)allocateArray(clauseCount, sizeof(int));
+    SwitchLabel* labels = (SwitchLabel*)allocateArray(clauseCount, sizeof(SwitchLabel));
+    int labelCount = 0;
+    for (int i = 0; i < clauseCount; i++) {
+        ParseTreeNode* clause = node->children[2 + i];
+        clauses[i] = newBlock(cfg);
+        if (clause->kind == NODE_DEFAULT_CLAUSE) {
+            otherwise = clauses[i];
+            continue;
+        }
+
+        const ParseTreeNode* literal = clause->children[1];
+        SwitchLabel* label = &labels[labelCount];
+        label->target = clauses[i];
+        label->order = labelCount++;
+        if (type == TYPE_STRING) {
+            label->value = addString(cfg, literal->value);
+        } else if (literal->type == TYPE_CHAR) {
+            char* decoded = decodeLiteral(literal->value);
+            label->value = (unsigned char)decoded[0];
+            free(decoded);
+        } else {
+            label->value = intFromText(literal->value);
+        }
+    }
+
+    if (type == TYPE_STRING) {
+        lowerStringDispatch(builder, value, labels, labelCount, otherwise);
+    } else {
+        qsort(labels, (size_t)labelCount, sizeof(SwitchLabel), compareLabelValues);
+        int distinct = 0;
+        for (int i = 0; i < labelCount; i++) {
+            if (distinct == 0 || labels[i].value != labels[distinct - 1].value) labels[distinct++] = labels[i];
+        }
+        lowerCaseSearch(builder, value, type, labels, distinct, otherwise);
+    }
+
+    int savedBreak = builder->breakTarget;
+    builder->breakTarget = exit;
+    for (int i = 0; i < clauseCount; i++) {
+        ParseTreeNode* clause = node->children[2 + i];
+        builder->current = clauses[i];
+        for (int j = clause->kind == NODE_CASE_CLAUSE ? 2 : 1; j < clause->childCount; j++) {
+            lowerStatement(builder, clause->children[j]);
+        }
+        jumpTo(builder, i + 1 < clauseCount ? clauses[i + 1] : exit);
+    }
+    builder->breakTarget = savedBreak;
+    builder->current = exit;
+
+    free(clauses);
+    free(labels);
+}
+
+// Function to lower return [value]; / break; / continue;
+static void lowerJump(CfgBuilder* builder, ParseTreeNode* node) {
+    if (node->childCount == 0) return;
+    const char* keyword = node->children[0]->value;
+
+    if (strcmp(keyword, "return") == 0) {
+        int value = -1;
+        if (node->childCount > 1 && NODE_IS_EXPRESSION(node->children[1]->kind)) {
+            value = lowerValue(builder, node->children[1]);
+        }
+        emit(builder, IR_RETURN, value >= 0 ? builder->cfg->registerTypes[value] : TYPE_UNKNOWN, -1, value, -1);
+        return;
+    }
+
+    int target = strcmp(keyword, "break") == 0 ? builder->breakTarget : builder->continueTarget;
+    if (target < 0) {
+        builder->cfg->strayJumps++;
+        return;
+    }
+    jumpTo(builder, target);
+}
+
+// Function to lower input("fmt", &x, "fmt", &y): one IR_INPUT per variable
+static void lowerInput(CfgBuilder* builder, ParseTreeNode* node) {
+    Cfg* cfg = builder->cfg;
+    for (int i = 0; i < node->childCount; i++) {
+        ParseTreeNode* list = node->children[i];
+        if (strcmp(list->label, "InputList") != 0) continue;
+
+        for (int j = 0; j < list->childCount; j++) {
+            ParseTreeNode* pair = list->children[j];
+            if (pair->childCount < 3 || pair->children[2]->kind != NODE_ADDRESS_VARIABLE) continue;
+
+            ParseTreeNode* address = pair->children[2];
+            ParseTreeNode* variable = address->children[address->childCount - 1];
+            if (variable->kind != NODE_IDENTIFIER) continue;
+
+            int target = bindingOf(variable);
+            emit(builder, IR_INPUT, cfg->registerTypes[target], target, -1, -1)->imm.i =
+                addString(cfg, pair->children[0]->value);
+        }
+    }
+}
+
+// Function to lower printf(item, ...): evaluate every item, then pass them together
+static void lowerOutput(CfgBuilder* builder, ParseTreeNode* node) {
+    Cfg* cfg = builder->cfg;
+    ParseTreeNode* list = NULL;
+    for (int i = 0; i < node->childCount; i++) {
+        if (node->children[i]->kind == NODE_OUTPUT_LIST) list = node->children[i];
+    }
+    if (!list) return;
+
+    int* values = (int*)allocateArray(list->childCount, sizeof(int));
+    int count = 0;
+    for (int i = 0; i < list->childCount; i++) {
+        ParseTreeNode* item = list->children[i];
+        if (item->kind == NODE_ADDRESS_VARIABLE) {
+            ParseTreeNode* variable = item->children[item->childCount - 1];
+            if (variable->kind == NODE_IDENTIFIER) values[count++] = bindingOf(variable);
+        } else if (NODE_IS_EXPRESSION(item->kind)) {
+            values[count++] = lowerValue(builder, item);
+        }
+    }
+
+    for (int i = 0; i < count; i++) {
+        emit(builder, IR_ARG, cfg->registerTypes[values[i]], -1, values[i], -1);
+    }
+    emit(builder, IR_PRINT, TYPE_UNKNOWN, -1, -1, -1)->imm.i = count;
+    free(values);
+}
+
+static void lowerStatement(CfgBuilder* builder, ParseTreeNode* node) {
+    if (!node) return;
+
+    switch (node->kind) {
+        case NODE_PROGRAM:
+        case NODE_BLOCK:
+        case NODE_DECLARATION_STATEMENT:
+        case NODE_FOR_UPDATE:
+            ensureChildren(node);
+            for (int i = 0; i < node->childCount; i++) {
+                lowerStatement(builder, node->children[i]);
+            }
+            break;
+
+        case NODE_VARIABLE_DECLARATION:
+            lowerDeclaration(builder, node);
+            break;
+
+        case NODE_ARRAY_DECLARATION:
+            lowerArrayDeclaration(builder, node);
+            break;
+
+        case NODE_FOR_INIT:
+            if (node->childCount > 0 && node->children[0]->kind == NODE_TYPE_SPECIFIER) {
+                lowerDeclaration(builder, node);
+            } else {
+                lowerAssignment(builder, node);
+            }
+            break;
+
+        case NODE_ASSIGNMENT_STATEMENT:
+            lowerAssignment(builder, node);
+            break;
+
+        case NODE_UNARY_EXPR:
+            lowerIncrement(builder, node);
+            break;
+
+        case NODE_CONDITIONAL_STATEMENT:
+            lowerConditional(builder, node);
+            break;
+
+        case NODE_FOR_LOOP:
+            lowerForLoop(builder, node);
+            break;
+
+        case NODE_WHILE_LOOP:
+            lowerWhileLoop(builder, node);
+            break;
+
+        case NODE_DO_WHILE_LOOP:
+            lowerDoWhileLoop(builder, node);
+            break;
+
+        case NODE_SWITCH_STATEMENT:
+            lowerSwitch(builder, node);
+            break;
+
+        case NODE_JUMP_STATEMENT:
+            lowerJump(builder, node);
+            break;
+
+        case NODE_INPUT_STATEMENT:
+            lowerInput(builder, node);
+            break;
+
+        case NODE_OUTPUT_STATEMENT:
+            lowerOutput(builder, node);
+            break;
+
+        default:
+            break; // Comments, delimiters and keywords produce no code
+    }
+}
+
+// ---------------------------------------
+// Block order and edges
+// ---------------------------------------
+
+// Function to follow a chain of blocks that hold nothing but a jump
+static int skipEmptyBlocks(const Cfg* cfg, int block) {
+    for (int steps = 0; steps < cfg->blockCount; steps++) {
+        const BasicBlock* current = &cfg->blocks[block];
+        if (current->codeCount != 1 || current->code[0].opcode != IR_JUMP) break;
+        block = current->successors[0];
+    }
+    return block;
+}
+
+// Function to point every edge past jump-only blocks (join points of if/else, empty
+// else-if tests and switch cases); a branch or switch whose targets then all agree
+// becomes a jump
+void threadJumps(Cfg* cfg) {
+    for (int b = 0; b < cfg->blockCount; b++) {
+        BasicBlock* block = &cfg->blocks[b];
+        int agree = block->successorCount > 1;
+        for (int s = 0; s < block->successorCount; s++) {
+            block->successors[s] = skipEmptyBlocks(cfg, block->successors[s]);
+            if (block->successors[s] != block->successors[0]) agree = 0;
+        }
+        if (agree) {
+            IrInstruction* branch = &block->code[block->codeCount - 1];
+            branch->opcode = IR_JUMP;
+            branch->a = -1;
+            block->successorCount = 1;
+        }
+    }
+}
+
+// Function to renumber blocks in reverse postorder from the entry and drop unreachable ones.
+// Successors are visited not-taken first, so a branch's taken side is laid out right after it.
+static void orderBlocks(Cfg* cfg) {
+    int n = cfg->blockCount;
+    int* postorder = (int*)allocateArray(n, sizeof(int));
+    int* stack = (int*)allocateArray(n, sizeof(int));
+    int* nextSuccessor = (int*)allocateArray(n, sizeof(int));
+    int* newIndex = (int*)allocateArray(n, sizeof(int));
+    for (int i = 0; i < n; i++) newIndex[i] = -1;
+
+    int visited = 0, depth = 0;
+    stack[depth++] = 0;
+    newIndex[0] = 0; // Marks "seen" until the real numbers are assigned
+    while (depth > 0) {
+        int block = stack[depth - 1];
+        BasicBlock* current = &cfg->blocks[block];
+        if (nextSuccessor[block] < current->successorCount) {
+            int successor = current->successors[current->successorCount - 1 - nextSuccessor[block]++];
+            if (newIndex[successor] < 0) {
+                newIndex[successor] = 0;
+                stack[depth++] = successor;
+            }
+        } else {
+            postorder[visited++] = block;
+            depth--;
+        }
+    }
+
+    BasicBlock* ordered = (BasicBlock*)allocateArray(visited, sizeof(BasicBlock));
+    for (int i = 0; i < n; i++) newIndex[i] = -1;
+    for (int i = 0; i < visited; i++) {
+        int old = postorder[visited - 1 - i];
+        newIndex[old] = i;
+        ordered[i] = cfg->blocks[old];
+    }
+    for (int i = 0; i < visited; i++) {
+        for (int s = 0; s < ordered[i].successorCount; s++) {
+            ordered[i].successors[s] = newIndex[ordered[i].successors[s]];
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        if (newIndex[i] >= 0) continue;
+        free(cfg->blocks[i].code);
+        free(cfg->blocks[i].successors);
+    }
+
+    cfg->unreachableBlocks = n - visited;
+    free(cfg->blocks);
+    cfg->blocks = ordered;
+    cfg->blockCount = visited;
+    cfg->blockCapacity = visited;
+
+    free(postorder);
+    free(stack);
+    free(nextSuccessor);
+    free(newIndex);
+}
+
+// Function to build the flat predecessor lists (sorted by block number). A block
+// that appears more than once in a switch table is one edge.
+static void linkPredecessors(Cfg* cfg) {
+    int n = cfg->blockCount;
+    int edges = 0;
+    int* lastSource = (int*)allocateArray(n, sizeof(int));
+    for (int b = 0; b < n; b++) {
+        cfg->blocks[b].predecessorCount = 0;
+        lastSource[b] = -1;
+    }
+    for (int b = 0; b < n; b++) {
+        for (int s = 0; s < cfg->blocks[b].successorCount; s++) {
+            int successor = cfg->blocks[b].successors[s];
+            if (lastSource[successor] == b) continue;
+            lastSource[successor] = b;
+            cfg->blocks[successor].predecessorCount++;
+            edges++;
+        }
+    }
+
+    int start = 0;
+    for (int b = 0; b < n; b++) {
+        cfg->blocks[b].firstPredecessor = start;
+        start += cfg->blocks[b].predecessorCount;
+        cfg->blocks[b].predecessorCount = 0;
+    }
+
+    free(cfg->predecessors);
+    cfg->predecessors = (int*)allocateArray(edges, sizeof(int));
+    for (int b = 0; b < n; b++) lastSource[b] = -1;
+    for (int b = 0; b < n; b++) {
+        for (int s = 0; s < cfg->blocks[b].successorCount; s++) {
+            int target = cfg->blocks[b].successors[s];
+            if (lastSource[target] == b) continue;
+            lastSource[target] = b;
+            BasicBlock* successor = &cfg->blocks[target];
+            cfg->predecessors[successor->firstPredecessor + successor->predecessorCount++] = b;
+        }
+    }
+    cfg->edgeCount = edges;
+    free(lastSource);
+}
+
+// Function to renumber blocks in reverse postorder after a pass added or cut edges
+void renumberBlocks(Cfg* cfg) {
+    orderBlocks(cfg);
+    linkPredecessors(cfg);
+}
+
+// Function to lower a whole program: one CFG, entry block 0, every path ending in IR_RETURN
+Cfg* buildCfg(ParseTreeNode* root, int bindingCount) {
+    Cfg* cfg = (Cfg*)allocateArray(1, sizeof(Cfg));
+    cfg->bindingCount = bindingCount;
+    for (int i = 0; i < bindingCount; i++) {
+        newRegister(cfg, TYPE_UNKNOWN);
+    }
+
+    CfgBuilder builder;
+    builder.cfg = cfg;
+    builder.current = newBlock(cfg);
+    builder.breakTarget = -1;
+    builder.continueTarget = -1;
+
+    lowerStatement(&builder, root);
+    emit(&builder, IR_RETURN, TYPE_UNKNOWN, -1, -1, -1);
+
+    // Blocks left open (only possible in code nothing reaches) end the program too
+    for (int b = 0; b < cfg->blockCount; b++) {
+        BasicBlock* block = &cfg->blocks[b];
+        if (block->codeCount == 0 || !IR_IS_TERMINATOR(block->code[block->codeCount - 1].opcode)) {
+            builder.current = b;
+            emit(&builder, IR_RETURN, TYPE_UNKNOWN, -1, -1, -1);
+        }
+    }
+
+    threadJumps(cfg);
+    renumberBlocks(cfg);
+
+    cfg->instructionCount = 0;
+    for (int b = 0; b < cfg->blockCount; b++) {
+        cfg->instructionCount += cfg->blocks[b].codeCount;
+    }
+    return cfg;
+}
+
+// ---------------------------------------
+// Dominators
+// ---------------------------------------
+
+// Walk both fingers up the tree until they meet; block numbers are reverse postorder,
+// so a dominator always has a smaller number than the blocks it dominates
+static int intersect(const int* idom, int a, int b) {
+    while (a != b) {
+        while (a > b) a = idom[a];
+        while (b > a) b = idom[b];
+    }
+    return a;
+}
+
+void computeDominators(Cfg* cfg) {
+    int n = cfg->blockCount;
+    free(cfg->idom);
+    free(cfg->domChildStart);
+    free(cfg->domChildren);
+    free(cfg->domPre);
+    free(cfg->domPost);
+
+    int* idom = (int*)allocateArray(n, sizeof(int));
+    for (int b = 0; b < n; b++) idom[b] = -1;
+    idom[0] = 0;
+
+    // Blocks are already in reverse postorder, so this usually settles in two sweeps
+    int changed = 1;
+    while (changed) {
+        changed = 0;
+        for (int b = 1; b < n; b++) {
+            const BasicBlock* block = &cfg->blocks[b];
+            int newIdom = -1;
+            for (int p = 0; p < block->predecessorCount; p++) {
+                int predecessor = cfg->predecessors[block->firstPredecessor + p];
+                if (idom[predecessor] < 0) continue;
+                newIdom = newIdom < 0 ? predecessor : intersect(idom, predecessor, newIdom);
+            }
+            if (idom[b] != newIdom) {
+                idom[b] = newIdom;
+                changed = 1;
+            }
+        }
+    }
+    idom[0] = -1;
+
+    // Tree children, flat
+    int* childStart = (int*)allocateArray(n + 1, sizeof(int));
+    int* children = (int*)allocateArray(n, sizeof(int));
+    for (int b = 1; b < n; b++) childStart[idom[b] + 1]++;
+    for (int b = 0; b < n; b++) childStart[b + 1] += childStart[b];
+    int* fill = (int*)allocateArray(n, sizeof(int));
+    for (int b = 1; b < n; b++) {
+        children[childStart[idom[b]] + fill[idom[b]]++] = b;
+    }
+
+    // Pre/post numbering of the tree: a dominates b iff b's interval nests in a's
+    int* pre = (int*)allocateArray(n, sizeof(int));
+    int* post = (int*)allocateArray(n, sizeof(int));
+    int* stack = (int*)allocateArray(n, sizeof(int));
+    int depth = 0, preCounter = 0, postCounter = 0;
+    memset(fill, 0, (size_t)n * sizeof(int));
+    stack[depth++] = 0;
+    pre[0] = preCounter++;
+    while (depth > 0) {
+        int block = stack[depth - 1];
+        if (fill[block] < childStart[block + 1] - childStart[block]) {
+            int child = children[childStart[block] + fill[block]++];
+            pre[child] = preCounter++;
+            stack[depth++] = child;
+        } else {
+            post[block] = postCounter++;
+            depth--;
+        }
+    }
+    free(stack);
+    free(fill);
+
+    cfg->idom = idom;
+    cfg->domChildStart = childStart;
+    cfg->domChildren = children;
+    cfg->domPre = pre;
+    cfg->domPost = post;
+
+    // An edge into a block that dominates its source closes a loop; a header
+    // reached by several such edges (breaks threaded to it) is still one loop
+    cfg->loopCount = 0;
+    for (int b = 0; b < n; b++) {
+        cfg->blocks[b].loopHeader = 0;
+    }
+    for (int b = 0; b < n; b++) {
+        const BasicBlock* block = &cfg->blocks[b];
+        for (int s = 0; s < block->successorCount; s++) {
+            BasicBlock* header = &cfg->blocks[block->successors[s]];
+            if (dominates(cfg, block->successors[s], b) && !header->loopHeader) {
+                header->loopHeader = 1;
+                cfg->loopCount++;
+            }
+        }
+    }
+}
+
+int dominates(const Cfg* cfg, int a, int b) {
+    return cfg->domPre[a] <= cfg->domPre[b] && cfg->domPost[b] <= cfg->domPost[a];
+}
+
+// ---------------------------------------
+// Output
+// ---------------------------------------
+
+static const char* const opcodeNames[IR_OPCODE_COUNT] = {
+    "const", "copy", "itof",
+    "add", "sub", "mul", "div", "floordiv", "mod", "pow",
+    "eq", "ne", "lt", "le", "gt", "ge",
+    "not", "max", "hash", "input", "arg", "print",
+    "newarray", "length", "check", "load", "store", "vmap", "vsum",
+    "jump", "branch", "switch", "return",
+};
+
+const char* irOpcodeName(int opcode) {
+    return (opcode >= 0 && opcode < IR_OPCODE_COUNT) ? opcodeNames[opcode] : "?";
+}
+
+// Function to name a register: variables as name.N, temporaries as tN
+static const char* registerName(const Cfg* cfg, int reg, char* text, size_t size) {
+    if (reg >= 0 && reg < cfg->bindingCount && cfg->registerNames[reg] != SYMBOL_NONE) {
+        snprintf(text, size, "%s.%d", internedString(cfg->registerNames[reg]), reg);
+    } else {
+        snprintf(text, size, "t%d", reg);
+    }
+    return text;
+}
+
+static void writeQuoted(FILE* file, const char* text) {
+    fputc('"', file);
+    for (; *text; text++) {
+        switch (*text) {
+            case '\n': fputs("\\n", file); break;
+            case '\t': fputs("\\t", file); break;
+            case '"': fputs("\\\"", file); break;
+            case '\\': fputs("\\\\", file); break;
+            default: fputc(*text, file); break;
+        }
+    }
+    fputc('"', file);
+}
+
+static void writeInstruction(const Cfg* cfg, const BasicBlock* block, const IrInstruction* in, FILE* file) {
+    char dst[80], a[80], b[80];
+    const char* type = symbolTypeName((SymbolType)in->type);
+    registerName(cfg, in->dst, dst, sizeof(dst));
+    registerName(cfg, in->a, a, sizeof(a));
+    registerName(cfg, in->b, b, sizeof(b));
+
+    fputs("    ", file);
+    switch (in->opcode) {
+        case IR_CONST:
+            fprintf(file, "%s = const %s ", dst, type);
+            if (in->type == TYPE_FLOAT) fprintf(file, "%.17g", in->imm.f);
+            else if (in->type == TYPE_STRING) writeQuoted(file, cfg->strings[in->imm.i]);
+            else fprintf(file, "%d", (int)in->imm.i);
+            break;
+        case IR_COPY:
+        case IR_INT_TO_FLOAT:
+        case IR_NOT:
+            fprintf(file, "%s = %s %s", dst, irOpcodeName(in->opcode), a);
+            break;
+        case IR_INPUT:
+            fprintf(file, "%s = input %s ", dst, type);
+            writeQuoted(file, cfg->strings[in->imm.i]);
+            break;
+        case IR_ARG:
+            fprintf(file, "arg %s", a);
+            break;
+        case IR_PRINT:
+            fprintf(file, "print %d", (int)in->imm.i);
+            break;
+        case IR_NEW_ARRAY:
+            fprintf(file, "%s = newarray %s[%s]", dst, type, a);
+            if (in->b >= 0) fprintf(file, "[%s]", b);
+            break;
+        case IR_ARRAY_LENGTH:
+            fprintf(file, "%s = length %s, %d", dst, a, (int)in->imm.i);
+            break;
+        case IR_CHECK_INDEX:
+            fprintf(file, "check %s, %s < length %d", a, b, (int)in->imm.i);
+            break;
+        case IR_LOAD_ELEMENT:
+            fprintf(file, "%s = load %s %s[%s]", dst, type, a, b);
+            break;
+        case IR_STORE_ELEMENT: {
+            char c[80];
+            fprintf(file, "store %s %s[%s] = %s", type, a, b, registerName(cfg, in->c, c, sizeof(c)));
+            break;
+        }
+        case IR_VECTOR_MAP:
+            fprintf(file, "vmap %s %s for %s < %s", type, irOpcodeName(in->imm.i), a, b);
+            break;
+        case IR_HASH:
+            fprintf(file, "%s = hash %s & %d", dst, a, (int)in->imm.i);
+            break;
+        case IR_VECTOR_SUM:
+            fprintf(file, "%s = vsum %s %s for %s < %s", dst, type, in->imm.i == 2 ? "dot" : "sum", a, b);
+            break;
+        case IR_JUMP:
+            fprintf(file, "jump B%d", block->successors[0]);
+            break;
+        case IR_BRANCH:
+            fprintf(file, "branch %s ? B%d : B%d", a, block->successors[0], block->successors[1]);
+            break;
+        case IR_SWITCH:
+            fprintf(file, "switch %s from %d [", a, (int)in->imm.i);
+            for (int s = 1; s < block->successorCount; s++) {
+                fprintf(file, "%sB%d", s > 1 ? " " : "", block->successors[s]);
+            }
+            fprintf(file, "] else B%d", block->successors[0]);
+            break;
+        case IR_RETURN:
+            if (in->a >= 0) fprintf(file, "return %s", a);
+            else fputs("return", file);
+            break;
+        default:
+            fprintf(file, "%s = %s %s %s, %s", dst, irOpcodeName(in->opcode), type, a, b);
+            break;
+    }
+    fputc('\n', file);
+}
+
+// Output: one paragraph per block with its predecessors, dominator and code
+void writeCfgToFile(const Cfg* cfg, FILE* file) {
+    fprintf(file, "; %d blocks, %d instructions, %d edges, %d registers (%d variables), %d loops\n",
+            cfg->blockCount, cfg->instructionCount, cfg->edgeCount, cfg->registerCount,
+            cfg->bindingCount, cfg->loopCount);
+
+    for (int b = 0; b < cfg->blockCount; b++) {
+        const BasicBlock* block = &cfg->blocks[b];
+        fprintf(file, "\nB%d:", b);
+        if (block->predecessorCount) {
+            fputs("  preds", file);
+            for (int p = 0; p < block->predecessorCount; p++) {
+                fprintf(file, " B%d", cfg->predecessors[block->firstPredecessor + p]);
+            }
+        }
+        if (cfg->idom && cfg->idom[b] >= 0) fprintf(file, "  idom B%d", cfg->idom[b]);
+        if (block->loopHeader) fputs("  loop header", file);
+        fputc('\n', file);
+
+        for (int i = 0; i < block->codeCount; i++) {
+            writeInstruction(cfg, block, &block->code[i], file);
+        }
+    }
+
+    // The slots assignRegisterSlots() gave the registers, if it ran
+    if (cfg->registerSlots) fprintf(file, "\nslots: %d\n", cfg->slotCount);
+    for (int slot = 0; cfg->registerSlots && slot < cfg->slotCount; slot++) {
+        fprintf(file, "  s%d %s", slot, symbolTypeName((SymbolType)cfg->slotTypes[slot]));
+        if (cfg->slotPins[slot]) fprintf(file, " (machine register %d)", cfg->slotPins[slot]);
+        fputc(':', file);
+        for (int r = 0; r < cfg->registerCount; r++) {
+            char name[64];
+            if (cfg->registerSlots[r] == slot) fprintf(file, " %s", registerName(cfg, r, name, sizeof(name)));
+        }
+        fputc('\n', file);
+    }
+}
+
+void freeCfg(Cfg* cfg) {
+    if (!cfg) return;
+    for (int b = 0; b < cfg->blockCount; b++) {
+        free(cfg->blocks[b].code);
+        free(cfg->blocks[b].successors);
+    }
+    for (int i = 0; i < cfg->stringCount; i++) {
+        free(cfg->strings[i]);
+    }
+    free(cfg->blocks);
+    free(cfg->predecessors);
+    free(cfg->registerTypes);
+    free(cfg->registerNames);
+    free(cfg->strings);
+    free(cfg->idom);
+    free(cfg->domChildStart);
+    free(cfg->domChildren);
+    free(cfg->domPre);
+    free(cfg->domPost);
+    free(cfg->registerSlots);
+    free(cfg->slotTypes);
+    free(cfg->slotPins);
+    free(cfg);
+}
@@ -0,0 +1,142 @@
+#ifndef CFG_H
+#define CFG_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "parse_tree.h"
+
+// Three-address instructions over virtual registers. Registers
+// 0..bindingCount-1 are the program's variables (numbered like the type
+// checker's bindings); temporaries follow them.
+typedef enum {
+    IR_CONST,        // dst = imm (strings: imm.i indexes cfg->strings)
+    IR_COPY,         // dst = a
+    IR_INT_TO_FLOAT, // dst = (float)a
+    IR_ADD, IR_SUB, IR_MUL, IR_DIV, IR_FLOOR_DIV, IR_MOD, IR_POW, // dst = a op b
+    IR_EQ, IR_NE, IR_LT, IR_LE, IR_GT, IR_GE,                     // dst = a op b (bool)
+    IR_NOT,          // dst = !a
+    IR_MAX,          // dst = max(a, b) (int)
+    IR_HASH,         // dst = stringHash(a) & imm.i (imm.i + 1 buckets, a power of two)
+    IR_INPUT,        // dst = value read with format cfg->strings[imm.i]
+    IR_ARG,          // Pass a to the IR_PRINT that follows
+    IR_PRINT,        // Print the imm.i preceding IR_ARG values
+    IR_NEW_ARRAY,    // dst = zeroed array of `type` elements: a rows, b columns (-1 for one dimension)
+    IR_ARRAY_LENGTH, // dst = length of dimension imm.i of array a
+    IR_CHECK_INDEX,  // Stop with a runtime error unless 0 <= b < length of dimension imm.i of array a
+    IR_LOAD_ELEMENT, // dst = a[b], b the flat index (row * columns + column)
+    IR_STORE_ELEMENT,// a[b] = c
+    IR_VECTOR_MAP,   // For a <= k < b: d[k] = l[k] op r[k] (op = imm.i, IR_ADD .. IR_DIV or IR_COPY); the
+                     // 3 preceding IR_ARGs are d, l, r, each l or r an array or a scalar used in every lane
+    IR_VECTOR_SUM,   // dst = sum over a <= k < b of x[k] (imm.i = 1) or x[k] * y[k] (imm.i = 2);
+                     // the imm.i preceding IR_ARGs are the arrays
+    IR_JUMP,         // Terminator: go to successors[0]
+    IR_BRANCH,       // Terminator: a ? successors[0] : successors[1]
+    IR_SWITCH,       // Terminator: go to successors[1 + a - imm.i] when that is one of them, else successors[0]
+    IR_RETURN,       // Terminator: leave the program (a = value or -1)
+    IR_OPCODE_COUNT
+} IrOpcode;
+
+#define IR_IS_TERMINATOR(opcode) ((opcode) >= IR_JUMP)
+
+typedef struct {
+    unsigned char opcode; // IrOpcode
+    unsigned char type;   // SymbolType the operation works on (operands for comparisons)
+    unsigned char implicit; // IR_CONST: the zero an uninitialized declaration starts its variable at
+    int dst;              // Register written (-1 = none)
+    int a, b, c;          // Operand registers (-1 = unused; only IR_STORE_ELEMENT reads c)
+    union {
+        int32_t i;        // int, char and bool constants; string index; argument count
+        double f;         // float constants
+    } imm;
+} IrInstruction;
+
+typedef struct {
+    IrInstruction* code;  // Instructions in order, the terminator last
+    int codeCount;
+    int codeCapacity;
+    int* successors;      // IR_BRANCH: [taken, not taken]; IR_JUMP: [target]; IR_SWITCH: [default, table...]
+    int successorCount;   // Targets may repeat in a switch table; edges and predecessors count them once
+    int successorCapacity;
+    int firstPredecessor; // Start of this block's run in cfg->predecessors
+    int predecessorCount;
+    int loopHeader;       // Non-zero if some back edge targets this block
+} BasicBlock;
+
+// Control-flow graph of the whole program (Prismatic has no functions, so this is main).
+// Blocks are numbered in reverse postorder from the entry, block 0; unreachable blocks are dropped.
+typedef struct {
+    BasicBlock* blocks;
+    int blockCount;
+    int blockCapacity;
+    int* predecessors;    // Flat predecessor lists, one run per block
+
+    int registerCount;
+    int registerCapacity;
+    unsigned char* registerTypes; // SymbolType per register
+    SymbolId* registerNames;      // Variable name per register (SYMBOL_NONE for temporaries)
+    int bindingCount;             // Registers below this are variables
+
+    char** strings;       // Decoded string literals and format strings
+    int stringCount;
+    int stringCapacity;
+
+    // Dominator tree, filled by computeDominators()
+    int* idom;            // Immediate dominator per block (-1 for the entry)
+    int* domChildStart;   // Children of block b are domChildren[domChildStart[b] .. domChildStart[b + 1])
+    int* domChildren;
+    int* domPre;          // Preorder/postorder numbers in the tree, for O(1) dominance queries
+    int* domPost;
+
+    // Storage for the registers, filled by assignRegisterSlots() (NULL before)
+    int* registerSlots;   // Slot per register (-1 for registers no instruction mentions)
+    int slotCount;
+    unsigned char* slotTypes; // SymbolType per slot
+    unsigned char* slotPins;  // Per slot: k > 0 for the k-th machine register of its class, 0 for memory
+
+    // Statistics
+    int instructionCount;
+    int edgeCount;
+    int loopCount;        // Loop headers found by computeDominators()
+    int unreachableBlocks; // Blocks dropped after return/break/continue
+    int strayJumps;       // break/continue outside a loop (lowered as no-ops)
+    int boundsChecks;     // IR_CHECK_INDEX instructions lowered
+    int removedBoundsChecks; // ... and dropped by eliminateBoundsChecks()
+    int vectorizedLoops;  // Loops vectorizeLoops() replaced with whole-loop kernels
+    int switchTables;     // switch statements (or parts) lowered as an IR_SWITCH jump table,
+    int switchSearches;   // ... as a binary search of comparisons,
+    int switchHashes;     // ... and string switches dispatched on an IR_HASH
+    int hoistedInstructions; // Loop-invariant instructions optimizeLoops() moved to preheaders
+    int reducedMultiplies;   // ... and multiplications of a loop counter it turned into additions
+    int redundantInBlock;    // Computations numberValues() removed for a repeat earlier in their block
+    int redundantDominated;  // ... and for one in a dominating block
+    int foldedBranches;      // Branches and switches on a known value eliminateDeadCode() made jumps,
+    int deadBlocks;          // ... the blocks that left unreachable,
+    int deadStores;          // ... the instructions it removed because nothing reads their result
+    int unusedVariables;     // ... and the variables that left with no reads or writes at all
+    int liveRanges;          // Registers assignRegisterSlots() gave a slot,
+    int pinnedRanges;        // ... those whose slot lives in a machine register
+    int spilledRanges;       // ... and int or float ones left in memory for lack of one
+} Cfg;
+
+// Lower a type-checked program into basic blocks. `bindingCount` is the type checker's.
+Cfg* buildCfg(ParseTreeNode* root, int bindingCount);
+
+// Compute immediate dominators (Cooper, Harvey and Kennedy's iterative
+// algorithm over reverse postorder), the dominator tree and loop headers.
+void computeDominators(Cfg* cfg);
+int dominates(const Cfg* cfg, int a, int b); // Non-zero if block a dominates block b
+
+// Editing helpers for the passes that rewrite the CFG
+int newBlock(Cfg* cfg);              // An empty block nothing jumps to yet
+int newRegister(Cfg* cfg, int type); // A fresh temporary of SymbolType `type`
+void endBlockWithJump(Cfg* cfg, int block, int target);
+void threadJumps(Cfg* cfg);          // Point edges past jump-only blocks; branches whose targets agree become jumps
+void renumberBlocks(Cfg* cfg);       // Reverse postorder again, unreachable blocks dropped, predecessors relinked
+// Add an instruction to the end of a block, before its terminator
+IrInstruction* insertBeforeJump(BasicBlock* block, int opcode, int type, int dst, int a, int b);
+
+const char* irOpcodeName(int opcode);
+void writeCfgToFile(const Cfg* cfg, FILE* file);
+void freeCfg(Cfg* cfg);
+
+#endif // CFG_H
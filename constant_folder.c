@@ -0,0 +1,427 @@
+#include "constant_folder.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "arithmetic.h"
+#include "symbol_table.h"
+
+// Value of a literal node (bools and chars are held in `i`)
+typedef struct {
+    int type;   // TYPE_INT, TYPE_FLOAT or TYPE_BOOL
+    int32_t i;
+    double f;
+} Constant;
+
+typedef struct {
+    int* stores;             // Per binding: stores seen, the initializer included
+    ParseTreeNode** values;  // Per binding: literal initializer of a variable stored only once
+    FoldResult result;
+} Folder;
+
+static int isLiteral(const ParseTreeNode* node) {
+    switch (node->kind) {
+        case NODE_INT_LITERAL:
+        case NODE_FLOAT_LITERAL:
+        case NODE_CHAR_LITERAL:
+        case NODE_STRING_LITERAL:
+        case NODE_BOOL_LITERAL:
+        case NODE_LITERAL:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+// Function to read the value of a literal node; returns 0 if it is not a foldable constant
+static int constantOf(ParseTreeNode* node, Constant* out) {
+    node = unwrap(node);
+    if (!node || !isLiteral(node)) return 0;
+
+    const char* text = node->value;
+    switch (node->type) {
+        case TYPE_INT:
+            out->type = TYPE_INT;
+            out->i = intFromText(text);
+            return 1;
+        case TYPE_FLOAT:
+            out->type = TYPE_FLOAT;
+            out->f = strtod(text, NULL);
+            return 1;
+        case TYPE_CHAR:
+            // Plain 'c' only; escapes are left to run time
+            if (text[0] != '\'' || text[1] == '\\' || text[1] == '\0' || text[2] != '\'') return 0;
+            out->type = TYPE_INT;
+            out->i = (unsigned char)text[1];
+            return 1;
+        case TYPE_BOOL:
+            if (strcmp(text, "true") != 0 && strcmp(text, "false") != 0) return 0;
+            out->type = TYPE_BOOL;
+            out->i = text[0] == 't';
+            return 1;
+        default:
+            return 0; // Strings are never operands of a foldable operator
+    }
+}
+
+// Function to write a folded double as literal text with the fewest digits that read back
+// exactly. This is source text, not output: printf still shows the value through %f.
+static void foldedFloatText(double value, char* text, size_t size) {
+    for (int precision = 15; precision <= 17; precision++) {
+        snprintf(text, size, "%.*g", precision, value);
+        if (strtod(text, NULL) == value) break;
+    }
+    if (!strpbrk(text, ".e")) {
+        strncat(text, ".0", size - strlen(text) - 1);
+    }
+}
+
+static ParseTreeNode* literalNode(const Constant* value) {
+    char text[48];
+    switch (value->type) {
+        case TYPE_INT:
+            snprintf(text, sizeof(text), "%d", (int)value->i);
+            return createParseTreeNode("INT_LITERAL", text);
+        case TYPE_FLOAT:
+            foldedFloatText(value->f, text, sizeof(text));
+            return createParseTreeNode("FLOAT_LITERAL", text);
+        default:
+            return createParseTreeNode("Keyword", value->i ? "true" : "false");
+    }
+}
+
+// Function to evaluate `left op right` with run-time semantics.
+// Returns 0 when the operation must be left to run time (division by zero, non-finite results).
+static int evaluateBinary(int op, const Constant* left, const Constant* right, Constant* out) {
+    if (op == OP_POW) {
+        if (right->type != TYPE_INT) return 0;
+        if (left->type == TYPE_INT) {
+            out->type = TYPE_INT;
+            out->i = intPow(left->i, right->i);
+            return 1;
+        }
+        if (left->type != TYPE_FLOAT) return 0;
+        out->type = TYPE_FLOAT;
+        out->f = floatPow(left->f, right->i);
+        return isfinite(out->f);
+    }
+
+    // The type checker made both sides the same type
+    if (left->type != right->type) return 0;
+    int type = left->type;
+
+    switch (op) {
+        case OP_ADD:
+        case OP_SUB:
+        case OP_MUL:
+            out->type = type;
+            if (type == TYPE_INT) {
+                out->i = op == OP_ADD ? intAdd(left->i, right->i)
+                       : op == OP_SUB ? intSub(left->i, right->i) : intMul(left->i, right->i);
+                return 1;
+            }
+            if (type != TYPE_FLOAT) return 0;
+            out->f = op == OP_ADD ? left->f + right->f : op == OP_SUB ? left->f - right->f : left->f * right->f;
+            return isfinite(out->f);
+
+        case OP_DIV:
+            if (type != TYPE_FLOAT || right->f == 0.0) return 0;
+            out->type = TYPE_FLOAT;
+            out->f = left->f / right->f;
+            return isfinite(out->f);
+
+        case OP_FLOOR_DIV:
+        case OP_MOD:
+            if (type != TYPE_INT || right->i == 0) return 0;
+            out->type = TYPE_INT;
+            out->i = op == OP_FLOOR_DIV ? intFloorDiv(left->i, right->i) : intMod(left->i, right->i);
+            return 1;
+
+        case OP_LT: case OP_LE: case OP_GT: case OP_GE: case OP_EQ: case OP_NE: {
+            if (type == TYPE_BOOL && op != OP_EQ && op != OP_NE) return 0;
+            int order = (type == TYPE_FLOAT) ? (left->f > right->f) - (left->f < right->f)
+                                             : (left->i > right->i) - (left->i < right->i);
+            if (type == TYPE_FLOAT && (isnan(left->f) || isnan(right->f))) return 0;
+            out->type = TYPE_BOOL;
+            out->i = op == OP_LT ? order < 0 : op == OP_LE ? order <= 0 : op == OP_GT ? order > 0
+                   : op == OP_GE ? order >= 0 : op == OP_EQ ? order == 0 : order != 0;
+            return 1;
+        }
+
+        case OP_AND:
+        case OP_OR:
+            if (type != TYPE_BOOL) return 0;
+            out->type = TYPE_BOOL;
+            out->i = op == OP_AND ? (left->i && right->i) : (left->i || right->i);
+            return 1;
+
+        default:
+            return 0;
+    }
+}
+
+// Function to swap `node` for a literal holding `value`
+static ParseTreeNode* replaceWithConstant(Folder* folder, ParseTreeNode* node, const Constant* value) {
+    ParseTreeNode* literal = literalNode(value);
+    freeParseTree(node);
+    folder->result.foldedNodes++;
+    return literal;
+}
+
+// ---------------------------------------
+// Pass 1: count stores per variable
+// ---------------------------------------
+
+static ParseTreeNode* storedIdentifier(ParseTreeNode* target) {
+    target = unwrap(target);
+    return (target && target->kind == NODE_IDENTIFIER && target->binding >= 0) ? target : NULL;
+}
+
+static void countStores(Folder* folder, ParseTreeNode* node) {
+    if (!node) return;
+    ensureChildren(node);
+
+    switch (node->kind) {
+        case NODE_VARIABLE_DECLARATION:
+        case NODE_FOR_INIT:
+            if (node->childCount > 0 && node->children[0]->kind == NODE_TYPE_SPECIFIER) {
+                // Only initialized declarations store
+                for (int i = 1; i + 1 < node->childCount; i++) {
+                    ParseTreeNode* name = node->children[i];
+                    if (name->kind == NODE_IDENTIFIER && name->binding >= 0 &&
+                        node->children[i + 1]->kind == NODE_OPERATOR) {
+                        folder->stores[name->binding]++;
+                    }
+                }
+            } else if (node->childCount > 0) {
+                // `for (i = 0; ...)` assigns
+                ParseTreeNode* target = storedIdentifier(node->children[0]);
+                if (target) folder->stores[target->binding]++;
+            }
+            break;
+
+        case NODE_ASSIGNMENT_STATEMENT:
+            if (node->childCount > 0) {
+                ParseTreeNode* target = storedIdentifier(node->children[0]);
+                if (target) folder->stores[target->binding]++;
+            }
+            break;
+
+        case NODE_UNARY_EXPR:
+        case NODE_ADDRESS_VARIABLE:
+            // ++x, x--, input(..., &x)
+            for (int i = 0; i < node->childCount; i++) {
+                ParseTreeNode* target = storedIdentifier(node->children[i]);
+                if (target) folder->stores[target->binding]++;
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    for (int i = 0; i < node->childCount; i++) {
+        countStores(folder, node->children[i]);
+    }
+}
+
+// ---------------------------------------
+// Pass 2: fold and propagate
+// ---------------------------------------
+
+static ParseTreeNode* foldExpression(Folder* folder, ParseTreeNode* node);
+static void foldStatement(Folder* folder, ParseTreeNode* node);
+
+// Function to fold the value of [target, operator, value, ...]; of the target only array indices fold
+static void foldAssignment(Folder* folder, ParseTreeNode* node) {
+    if (node->childCount > 0 && node->children[0]->kind == NODE_ARRAY_ACCESS) {
+        node->children[0] = foldExpression(folder, node->children[0]);
+    }
+    if (node->childCount > 2) {
+        node->children[2] = foldExpression(folder, node->children[2]);
+    }
+}
+
+// Function to fold a declaration and remember initializers of variables stored only once
+static void foldDeclaration(Folder* folder, ParseTreeNode* node) {
+    for (int i = 1; i + 2 < node->childCount; i++) {
+        ParseTreeNode* name = node->children[i];
+        if (name->kind != NODE_IDENTIFIER || node->children[i + 1]->kind != NODE_OPERATOR) continue;
+
+        node->children[i + 2] = foldExpression(folder, node->children[i + 2]);
+        ParseTreeNode* value = unwrap(node->children[i + 2]);
+        if (name->binding >= 0 && folder->stores[name->binding] == 1 && value && isLiteral(value)) {
+            folder->values[name->binding] = value;
+            folder->result.constantBindings++;
+        }
+        i += 2;
+    }
+}
+
+static ParseTreeNode* foldExpression(Folder* folder, ParseTreeNode* node) {
+    if (!node) return node;
+
+    Constant left, right, value;
+    switch (node->kind) {
+        case NODE_IDENTIFIER: {
+            ParseTreeNode* known = node->binding >= 0 ? folder->values[node->binding] : NULL;
+            if (!known) return node;
+            ParseTreeNode* copy = createParseTreeNode(known->label, known->value);
+            copy->type = known->type;
+            freeParseTree(node);
+            folder->result.propagatedUses++;
+            return copy;
+        }
+
+        case NODE_EXPRESSION:
+        case NODE_IDENTIFIER_EXPR:
+        case NODE_ASSIGN_EXPR:
+            if (node->childCount == 1) {
+                node->children[0] = foldExpression(folder, node->children[0]);
+            }
+            return node;
+
+        case NODE_GROUPED_EXPR:
+            if (node->childCount == 3) {
+                node->children[1] = foldExpression(folder, node->children[1]);
+                if (constantOf(node->children[1], &value)) {
+                    return replaceWithConstant(folder, node, &value);
+                }
+            }
+            return node;
+
+        case NODE_INT_TO_FLOAT:
+            if (node->childCount == 1) {
+                node->children[0] = foldExpression(folder, node->children[0]);
+                if (constantOf(node->children[0], &value) && value.type == TYPE_INT) {
+                    value.type = TYPE_FLOAT;
+                    value.f = (double)value.i;
+                    return replaceWithConstant(folder, node, &value);
+                }
+            }
+            return node;
+
+        case NODE_LOGICAL_OR_EXPR:
+        case NODE_LOGICAL_AND_EXPR:
+        case NODE_RELATIONAL_EXPR:
+        case NODE_ARITHMETIC_EXPR:
+        case NODE_TERM:
+        case NODE_FACTOR:
+            if (node->childCount == 3 && node->children[1]->kind == NODE_OPERATOR) {
+                node->children[0] = foldExpression(folder, node->children[0]);
+                node->children[2] = foldExpression(folder, node->children[2]);
+                if (constantOf(node->children[0], &left) && constantOf(node->children[2], &right) &&
+                    evaluateBinary(node->children[1]->op, &left, &right, &value)) {
+                    return replaceWithConstant(folder, node, &value);
+                }
+            }
+            return node;
+
+        case NODE_EXPONENTIAL_EXPR:
+            // [base, exponent]: the '^' token has no node
+            if (node->childCount == 2) {
+                node->children[0] = foldExpression(folder, node->children[0]);
+                node->children[1] = foldExpression(folder, node->children[1]);
+                if (constantOf(node->children[0], &left) && constantOf(node->children[1], &right) &&
+                    evaluateBinary(OP_POW, &left, &right, &value)) {
+                    return replaceWithConstant(folder, node, &value);
+                }
+            }
+            return node;
+
+        case NODE_LOGICAL_NOT_EXPR:
+            if (node->childCount == 2) {
+                node->children[1] = foldExpression(folder, node->children[1]);
+                if (constantOf(node->children[1], &value) && value.type == TYPE_BOOL) {
+                    value.i = !value.i;
+                    return replaceWithConstant(folder, node, &value);
+                }
+            }
+            return node;
+
+        case NODE_ARRAY_ACCESS:
+            // [IDENTIFIER, '[', index, ']', ...]: the array itself is never a constant
+            for (int i = 1; i < node->childCount; i++) {
+                if (NODE_IS_EXPRESSION(node->children[i]->kind)) {
+                    node->children[i] = foldExpression(folder, node->children[i]);
+                }
+            }
+            return node;
+
+        case NODE_ASSIGNMENT_STATEMENT:
+            foldAssignment(folder, node); // Chained assignment
+            return node;
+
+        case NODE_UNARY_EXPR:
+            return node; // Its operand is a store target
+        default:
+            return node;
+    }
+}
+
+static void foldStatement(Folder* folder, ParseTreeNode* node) {
+    if (!node) return;
+
+    switch (node->kind) {
+        case NODE_VARIABLE_DECLARATION:
+            foldDeclaration(folder, node);
+            return;
+
+        case NODE_FOR_INIT:
+            if (node->childCount > 0 && node->children[0]->kind == NODE_TYPE_SPECIFIER) {
+                foldDeclaration(folder, node);
+            } else {
+                foldAssignment(folder, node);
+            }
+            return;
+
+        case NODE_ASSIGNMENT_STATEMENT:
+            foldAssignment(folder, node);
+            return;
+
+        case NODE_FOR_UPDATE:
+            for (int i = 0; i < node->childCount; i++) {
+                if (node->children[i]->kind == NODE_ASSIGNMENT_STATEMENT) {
+                    foldAssignment(folder, node->children[i]);
+                }
+            }
+            return;
+
+        case NODE_ADDRESS_VARIABLE:
+            return; // input() stores through it
+
+        default:
+            break;
+    }
+
+    ensureChildren(node);
+    for (int i = 0; i < node->childCount; i++) {
+        ParseTreeNode* child = node->children[i];
+        if (!child) continue;
+        if (NODE_IS_EXPRESSION(child->kind)) {
+            node->children[i] = foldExpression(folder, child);
+        } else {
+            foldStatement(folder, child);
+        }
+    }
+}
+
+// Function to fold constants across a whole program in two walks:
+// one to find variables stored exactly once, one to fold and substitute.
+FoldResult foldConstants(ParseTreeNode* root, int bindingCount) {
+    Folder folder;
+    memset(&folder, 0, sizeof(folder));
+    folder.stores = (int*)calloc(bindingCount > 0 ? bindingCount : 1, sizeof(int));
+    folder.values = (ParseTreeNode**)calloc(bindingCount > 0 ? bindingCount : 1, sizeof(ParseTreeNode*));
+    if (!folder.stores || !folder.values) {
+        fprintf(stderr, "Error: Memory allocation failed in constant folder.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    countStores(&folder, root);
+    foldStatement(&folder, root);
+
+    free(folder.stores);
+    free(folder.values);
+    return folder.result;
+}
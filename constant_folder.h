@@ -0,0 +1,18 @@
+#ifndef CONSTANT_FOLDER_H
+#define CONSTANT_FOLDER_H
+
+#include "parse_tree.h"
+
+// What one folding pass changed
+typedef struct {
+    int foldedNodes;     // Operator, conversion and grouping nodes replaced by literals
+    int propagatedUses;  // Variable uses replaced by the variable's constant value
+    int constantBindings; // Variables found to hold one constant for their whole life
+} FoldResult;
+
+// Evaluate literal-only subexpressions and replace them with literals, and
+// substitute variables whose only store is a constant initializer. Needs a
+// tree the type checker accepted: it reads node->type and node->binding.
+FoldResult foldConstants(ParseTreeNode* root, int bindingCount);
+
+#endif // CONSTANT_FOLDER_H
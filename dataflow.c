@@ -0,0 +1,308 @@
+#include "dataflow.h"
+#include <stdlib.h>
+#include <string.h>
+
+static void* allocateArray(size_t count, size_t size) {
+    void* array = calloc(count > 0 ? count : 1, size);
+    if (!array) {
+        fprintf(stderr, "Error: Memory allocation failed for dataflow analysis.\n");
+        exit(EXIT_FAILURE);
+    }
+    return array;
+}
+
+// ---------------------------------------
+// Solver
+// ---------------------------------------
+
+Dataflow* createDataflow(const Cfg* cfg, int forward, int intersect, int bitCount) {
+    Dataflow* flow = (Dataflow*)allocateArray(1, sizeof(Dataflow));
+    flow->forward = forward;
+    flow->intersect = intersect;
+    flow->bitCount = bitCount;
+    flow->wordCount = BIT_WORDS(bitCount);
+    flow->blockCount = cfg->blockCount;
+    size_t words = (size_t)cfg->blockCount * (size_t)flow->wordCount;
+    flow->gen = (BitWord*)allocateArray(words, sizeof(BitWord));
+    flow->kill = (BitWord*)allocateArray(words, sizeof(BitWord));
+    flow->in = (BitWord*)allocateArray(words, sizeof(BitWord));
+    flow->out = (BitWord*)allocateArray(words, sizeof(BitWord));
+    return flow;
+}
+
+void freeDataflow(Dataflow* flow) {
+    if (!flow) return;
+    free(flow->gen);
+    free(flow->kill);
+    free(flow->in);
+    free(flow->out);
+    free(flow);
+}
+
+static void copySet(BitWord* restrict dst, const BitWord* restrict src, int words) {
+    for (int w = 0; w < words; w++) dst[w] = src[w];
+}
+
+static void unionInto(BitWord* restrict dst, const BitWord* restrict src, int words) {
+    for (int w = 0; w < words; w++) dst[w] |= src[w];
+}
+
+static void intersectInto(BitWord* restrict dst, const BitWord* restrict src, int words) {
+    for (int w = 0; w < words; w++) dst[w] &= src[w];
+}
+
+// Function to set result = gen | (source & ~kill), returning non-zero if that changed it
+static int transfer(BitWord* restrict result, const BitWord* restrict source, const BitWord* restrict gen,
+                    const BitWord* restrict kill, int words) {
+    BitWord changed = 0;
+    for (int w = 0; w < words; w++) {
+        BitWord value = gen[w] | (source[w] & ~kill[w]);
+        changed |= value ^ result[w];
+        result[w] = value;
+    }
+    return changed != 0;
+}
+
+// Function to combine what the block's neighbours pass on (predecessors' out
+// sets going forward, successors' in sets going backward) into `met`
+static void meetNeighbours(const Dataflow* flow, const Cfg* cfg, int b, BitWord* met, BitWord* passed) {
+    const BasicBlock* block = &cfg->blocks[b];
+    int words = flow->wordCount;
+    int boundary = flow->forward ? b == 0 : block->successorCount == 0;
+    int first = 1;
+    if (boundary) {
+        memset(met, 0, (size_t)words * sizeof(BitWord));
+        if (flow->intersect) return;
+        first = 0;
+    }
+    int count = flow->forward ? block->predecessorCount : block->successorCount;
+    for (int k = 0; k < count; k++) {
+        int neighbour = flow->forward ? cfg->predecessors[block->firstPredecessor + k] : block->successors[k];
+        const BitWord* source = dataflowSet(flow, passed, neighbour);
+        if (first) {
+            copySet(met, source, words);
+            first = 0;
+        } else if (flow->intersect) {
+            intersectInto(met, source, words);
+        } else {
+            unionInto(met, source, words);
+        }
+    }
+    if (first) memset(met, 0, (size_t)words * sizeof(BitWord));
+}
+
+void solveDataflow(Dataflow* flow, const Cfg* cfg) {
+    int n = flow->blockCount;
+    int words = flow->wordCount;
+    if (n <= 0 || words <= 0) return;
+    BitWord* passed = flow->forward ? flow->out : flow->in;
+    BitWord* met = flow->forward ? flow->in : flow->out;
+
+    // A must problem starts from "everything holds" and removes what some path breaks
+    memset(passed, 0, (size_t)n * (size_t)words * sizeof(BitWord));
+    if (flow->intersect) {
+        BitWord last = flow->bitCount % 64 ? ((BitWord)1 << (flow->bitCount % 64)) - 1 : ~(BitWord)0;
+        for (int b = 0; b < n; b++) {
+            BitWord* set = dataflowSet(flow, passed, b);
+            memset(set, 0xFF, (size_t)words * sizeof(BitWord));
+            set[words - 1] = last;
+        }
+    }
+
+    unsigned char* pending = (unsigned char*)allocateArray((size_t)n, 1);
+    memset(pending, 1, (size_t)n);
+    int remaining = n;
+    while (remaining > 0) {
+        for (int k = 0; k < n; k++) {
+            int b = flow->forward ? k : n - 1 - k;
+            if (!pending[b]) continue;
+            pending[b] = 0;
+            remaining--;
+            flow->visits++;
+
+            BitWord* into = dataflowSet(flow, met, b);
+            meetNeighbours(flow, cfg, b, into, passed);
+            if (!transfer(dataflowSet(flow, passed, b), into, dataflowSet(flow, flow->gen, b),
+                          dataflowSet(flow, flow->kill, b), words)) {
+                continue;
+            }
+
+            const BasicBlock* block = &cfg->blocks[b];
+            int count = flow->forward ? block->successorCount : block->predecessorCount;
+            for (int d = 0; d < count; d++) {
+                int dependent = flow->forward ? block->successors[d]
+                                              : cfg->predecessors[block->firstPredecessor + d];
+                if (!pending[dependent]) {
+                    pending[dependent] = 1;
+                    remaining++;
+                }
+            }
+        }
+    }
+    free(pending);
+}
+
+// ---------------------------------------
+// Analyses
+// ---------------------------------------
+
+Dataflow* computeLiveness(const Cfg* cfg) {
+    Dataflow* flow = createDataflow(cfg, 0, 0, cfg->registerCount);
+    for (int b = 0; b < cfg->blockCount; b++) {
+        const BasicBlock* block = &cfg->blocks[b];
+        BitWord* gen = dataflowSet(flow, flow->gen, b);
+        BitWord* kill = dataflowSet(flow, flow->kill, b);
+
+        // Backwards, so gen ends up with the reads no earlier write in the block covers
+        for (int i = block->codeCount - 1; i >= 0; i--) {
+            const IrInstruction* in = &block->code[i];
+            if (in->dst >= 0) {
+                setBit(kill, in->dst);
+                clearBit(gen, in->dst);
+            }
+            if (in->a >= 0) setBit(gen, in->a);
+            if (in->b >= 0) setBit(gen, in->b);
+            if (in->c >= 0) setBit(gen, in->c);
+        }
+    }
+    solveDataflow(flow, cfg);
+    return flow;
+}
+
+ReachingDefinitions* computeReachingDefinitions(const Cfg* cfg) {
+    ReachingDefinitions* reaching = (ReachingDefinitions*)allocateArray(1, sizeof(ReachingDefinitions));
+    reaching->firstDefinition = (int*)allocateArray((size_t)cfg->blockCount + 1, sizeof(int));
+    int count = 0;
+    for (int b = 0; b < cfg->blockCount; b++) {
+        reaching->firstDefinition[b] = count;
+        const BasicBlock* block = &cfg->blocks[b];
+        for (int i = 0; i < block->codeCount; i++) count += block->code[i].dst >= 0;
+    }
+    reaching->firstDefinition[cfg->blockCount] = count;
+    reaching->definitionCount = count;
+
+    // Every register's definitions, grouped by register
+    int registers = cfg->registerCount;
+    reaching->definedRegister = (int*)allocateArray((size_t)count, sizeof(int));
+    reaching->definitionPosition = (int*)allocateArray((size_t)count, sizeof(int));
+    int* start = (int*)allocateArray((size_t)registers + 1, sizeof(int));
+    int d = 0;
+    for (int b = 0; b < cfg->blockCount; b++) {
+        const BasicBlock* block = &cfg->blocks[b];
+        for (int i = 0; i < block->codeCount; i++) {
+            int dst = block->code[i].dst;
+            if (dst < 0) continue;
+            reaching->definitionPosition[d] = i;
+            reaching->definedRegister[d++] = dst;
+            start[dst + 1]++;
+        }
+    }
+    for (int r = 0; r < registers; r++) start[r + 1] += start[r];
+    int* fill = (int*)allocateArray((size_t)registers, sizeof(int));
+    int* definitions = (int*)allocateArray((size_t)count, sizeof(int));
+    for (d = 0; d < count; d++) {
+        int reg = reaching->definedRegister[d];
+        definitions[start[reg] + fill[reg]++] = d;
+    }
+
+    // gen: the last definition of each register in the block; kill: every
+    // definition of the registers it writes. lastBlock[r] - 1 is the last block seen writing r.
+    Dataflow* flow = createDataflow(cfg, 1, 0, count);
+    int* lastBlock = fill;
+    memset(lastBlock, 0, (size_t)registers * sizeof(int));
+    for (int b = 0; b < cfg->blockCount; b++) {
+        BitWord* gen = dataflowSet(flow, flow->gen, b);
+        BitWord* kill = dataflowSet(flow, flow->kill, b);
+        for (d = reaching->firstDefinition[b + 1] - 1; d >= reaching->firstDefinition[b]; d--) {
+            int reg = reaching->definedRegister[d];
+            if (lastBlock[reg] == b + 1) continue;
+            lastBlock[reg] = b + 1;
+            setBit(gen, d);
+            for (int k = start[reg]; k < start[reg + 1]; k++) {
+                if (definitions[k] != d) setBit(kill, definitions[k]);
+            }
+        }
+    }
+    free(fill);
+    reaching->registerStart = start;
+    reaching->byRegister = definitions;
+    solveDataflow(flow, cfg);
+    reaching->flow = flow;
+    return reaching;
+}
+
+void freeReachingDefinitions(ReachingDefinitions* reaching) {
+    if (!reaching) return;
+    freeDataflow(reaching->flow);
+    free(reaching->firstDefinition);
+    free(reaching->definedRegister);
+    free(reaching->definitionPosition);
+    free(reaching->registerStart);
+    free(reaching->byRegister);
+    free(reaching);
+}
+
+// Function to note one instruction's effect on which variables are assigned
+static void assignVariable(const Cfg* cfg, const IrInstruction* in, BitWord* assigned, BitWord* unassigned) {
+    if (in->dst < 0 || in->dst >= cfg->bindingCount) return;
+    if (in->implicit) {
+        clearBit(assigned, in->dst);
+        if (unassigned) setBit(unassigned, in->dst);
+    } else {
+        setBit(assigned, in->dst);
+        if (unassigned) clearBit(unassigned, in->dst);
+    }
+}
+
+Dataflow* computeDefiniteAssignment(const Cfg* cfg) {
+    Dataflow* flow = createDataflow(cfg, 1, 1, cfg->bindingCount);
+    for (int b = 0; b < cfg->blockCount; b++) {
+        const BasicBlock* block = &cfg->blocks[b];
+        BitWord* gen = dataflowSet(flow, flow->gen, b);
+        BitWord* kill = dataflowSet(flow, flow->kill, b);
+        for (int i = 0; i < block->codeCount; i++) assignVariable(cfg, &block->code[i], gen, kill);
+    }
+    solveDataflow(flow, cfg);
+    return flow;
+}
+
+int findUninitializedReads(const Cfg* cfg, int* variables, int capacity) {
+    Dataflow* flow = computeDefiniteAssignment(cfg);
+    unsigned char* reported = (unsigned char*)allocateArray((size_t)cfg->bindingCount, 1);
+    BitWord* assigned = (BitWord*)allocateArray((size_t)flow->wordCount, sizeof(BitWord));
+
+    // Only variables declared without a value can be read unassigned: scopes see to the rest
+    unsigned char* declaredEmpty = (unsigned char*)allocateArray((size_t)cfg->bindingCount, 1);
+    for (int b = 0; b < cfg->blockCount; b++) {
+        const BasicBlock* block = &cfg->blocks[b];
+        for (int i = 0; i < block->codeCount; i++) {
+            if (block->code[i].implicit && block->code[i].dst >= 0) declaredEmpty[block->code[i].dst] = 1;
+        }
+    }
+
+    int count = 0;
+    for (int b = 0; b < cfg->blockCount; b++) {
+        const BasicBlock* block = &cfg->blocks[b];
+        copySet(assigned, dataflowSet(flow, flow->in, b), flow->wordCount);
+        for (int i = 0; i < block->codeCount; i++) {
+            const IrInstruction* in = &block->code[i];
+            const int operands[3] = {in->a, in->b, in->c};
+            for (int k = 0; k < 3; k++) {
+                int reg = operands[k];
+                if (reg < 0 || reg >= cfg->bindingCount || !declaredEmpty[reg] || reported[reg] ||
+                    testBit(assigned, reg)) {
+                    continue;
+                }
+                reported[reg] = 1;
+                if (count < capacity) variables[count] = reg;
+                count++;
+            }
+            assignVariable(cfg, in, assigned, NULL);
+        }
+    }
+    free(declaredEmpty);
+    free(assigned);
+    free(reported);
+    freeDataflow(flow);
+    return count;
+}
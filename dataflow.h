@@ -0,0 +1,89 @@
+#ifndef DATAFLOW_H
+#define DATAFLOW_H
+
+#include <stdint.h>
+#include "cfg.h"
+
+// Iterative bit-vector dataflow over a Cfg. Every block has a gen and a kill
+// set of `bitCount` facts, packed 64 to a word, and solveDataflow() finds the
+// fixed point of
+//
+//   forward:  in[b]  = meet of out[p] over predecessors p, out[b] = gen[b] | (in[b] & ~kill[b])
+//   backward: out[b] = meet of in[s] over successors s,    in[b]  = gen[b] | (out[b] & ~kill[b])
+//
+// where the meet is a union (a fact holds on some path) or an intersection
+// (on every path). Nothing holds on entry to the program (forward) or after a
+// return (backward). Blocks are numbered in reverse postorder, so the solver
+// sweeps a worklist in that order (backward: its reverse): an acyclic CFG
+// settles in one sweep and a loop nest in about one more per level. Set
+// operations are plain loops over whole words that the compiler turns into
+// SIMD code.
+typedef uint64_t BitWord;
+
+#define BIT_WORDS(bits) (((bits) + 63) / 64)
+
+static inline int testBit(const BitWord* set, int bit) {
+    return (int)((set[bit >> 6] >> (bit & 63)) & 1u);
+}
+
+static inline void setBit(BitWord* set, int bit) {
+    set[bit >> 6] |= (BitWord)1 << (bit & 63);
+}
+
+static inline void clearBit(BitWord* set, int bit) {
+    set[bit >> 6] &= ~((BitWord)1 << (bit & 63));
+}
+
+typedef struct {
+    int forward;          // Non-zero: facts flow along edges; zero: against them
+    int intersect;        // Non-zero: the meet is an intersection; zero: a union
+    int bitCount;
+    int wordCount;        // BitWords per set
+    int blockCount;
+    BitWord* gen;         // blockCount sets each, block b's at b * wordCount
+    BitWord* kill;
+    BitWord* in;          // The solution: facts on entry to each block ...
+    BitWord* out;         // ... and on exit from it
+    int visits;           // Blocks solveDataflow() transferred, counting repeats
+} Dataflow;
+
+static inline BitWord* dataflowSet(const Dataflow* flow, BitWord* sets, int block) {
+    return sets + (size_t)block * (size_t)flow->wordCount;
+}
+
+// Empty gen and kill sets for each block of `cfg`, ready to fill and solve
+Dataflow* createDataflow(const Cfg* cfg, int forward, int intersect, int bitCount);
+void solveDataflow(Dataflow* flow, const Cfg* cfg);
+void freeDataflow(Dataflow* flow);
+
+// Registers live on entry to (in) and exit from (out) each block: read on some
+// path before being written again
+Dataflow* computeLiveness(const Cfg* cfg);
+
+// Definitions that reach each block: bit d is the d-th instruction with a
+// destination, counted in block and instruction order
+typedef struct {
+    Dataflow* flow;
+    int definitionCount;
+    int* firstDefinition;    // Block b's definitions are firstDefinition[b] .. firstDefinition[b + 1] - 1
+    int* definedRegister;    // Register written by each definition ...
+    int* definitionPosition; // ... and its index in the block's code
+    int* registerStart;      // Definitions of register r are byRegister[registerStart[r] .. registerStart[r + 1])
+    int* byRegister;
+} ReachingDefinitions;
+
+ReachingDefinitions* computeReachingDefinitions(const Cfg* cfg);
+void freeReachingDefinitions(ReachingDefinitions* reaching);
+
+// Variables (registers below bindingCount) assigned on every path to each
+// block. A declaration without an initializer unassigns its variable: the zero
+// it stores (an implicit IR_CONST) is not an assignment.
+Dataflow* computeDefiniteAssignment(const Cfg* cfg);
+
+// Variables some path reads before assigning them, after their declaration
+// gave them no value (needs the CFG as buildCfg() made it: later passes move
+// the implicit zeros). Fills `variables` with up to `capacity` of them in the
+// order of their first such read; returns how many there are.
+int findUninitializedReads(const Cfg* cfg, int* variables, int capacity);
+
+#endif // DATAFLOW_H
@@ -0,0 +1,225 @@
+#include "dead_code.h"
+#include <stdlib.h>
+#include <string.h>
+#include "symbol_table.h"
+#include "dataflow.h"
+
+static void* allocateArray(int count, size_t size) {
+    void* array = calloc(count > 0 ? (size_t)count : 1, size);
+    if (!array) {
+        fprintf(stderr, "Error: Memory allocation failed for control-flow graph.\n");
+        exit(EXIT_FAILURE);
+    }
+    return array;
+}
+
+// ---------------------------------------
+// Dead code and dead store elimination
+// ---------------------------------------
+
+int cfgDeadCodeElimination = 1;
+
+#define CONSTANT_DEPTH 4 // How many instructions deep a branch condition is evaluated
+
+// Instructions whose only effect is their result: removing one nothing reads
+// changes nothing. Int division stays (it can stop the program), as do input,
+// new arrays (an invalid length stops it) and the vector kernels.
+static int isRemovable(const IrInstruction* in) {
+    switch (in->opcode) {
+        case IR_CONST: case IR_COPY: case IR_INT_TO_FLOAT:
+        case IR_ADD: case IR_SUB: case IR_MUL: case IR_POW:
+        case IR_EQ: case IR_NE: case IR_LT: case IR_LE: case IR_GT: case IR_GE:
+        case IR_NOT: case IR_MAX: case IR_HASH: case IR_ARRAY_LENGTH: case IR_LOAD_ELEMENT:
+            return 1;
+        case IR_DIV: case IR_FLOOR_DIV: case IR_MOD:
+            return in->type == TYPE_FLOAT;
+        default:
+            return 0;
+    }
+}
+
+static int definitionBlock(const Cfg* cfg, const ReachingDefinitions* reaching, int d) {
+    int low = 0, high = cfg->blockCount - 1;
+    while (low < high) {
+        int middle = (low + high + 1) / 2;
+        if (reaching->firstDefinition[middle] <= d) {
+            low = middle;
+        } else {
+            high = middle - 1;
+        }
+    }
+    return low;
+}
+
+static int constantBefore(const Cfg* cfg, const ReachingDefinitions* reaching, int b, int position, int reg,
+                          int32_t* value, int depth);
+
+// Function to evaluate code[position] of block b when it computes an int,
+// char or bool constant from constants
+static int constantResult(const Cfg* cfg, const ReachingDefinitions* reaching, int b, int position,
+                          int32_t* value, int depth) {
+    const IrInstruction* in = &cfg->blocks[b].code[position];
+    if (in->type == TYPE_FLOAT || in->type == TYPE_STRING || depth > CONSTANT_DEPTH) return 0;
+    int32_t left, right;
+    switch (in->opcode) {
+        case IR_CONST:
+            *value = in->imm.i;
+            return 1;
+        case IR_COPY:
+            return constantBefore(cfg, reaching, b, position, in->a, value, depth + 1);
+        case IR_NOT:
+            if (!constantBefore(cfg, reaching, b, position, in->a, &left, depth + 1)) return 0;
+            *value = !left;
+            return 1;
+        case IR_EQ: case IR_NE: case IR_LT: case IR_LE: case IR_GT: case IR_GE:
+            if (!constantBefore(cfg, reaching, b, position, in->a, &left, depth + 1) ||
+                !constantBefore(cfg, reaching, b, position, in->b, &right, depth + 1)) {
+                return 0;
+            }
+            switch (in->opcode) {
+                case IR_EQ: *value = left == right; break;
+                case IR_NE: *value = left != right; break;
+                case IR_LT: *value = left < right; break;
+                case IR_LE: *value = left <= right; break;
+                case IR_GT: *value = left > right; break;
+                default: *value = left >= right; break;
+            }
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+// Function to find the constant `reg` holds just before code[position] of
+// block b: what its last write earlier in the block computes, or else what
+// every one of its definitions reaching the block computes
+static int constantBefore(const Cfg* cfg, const ReachingDefinitions* reaching, int b, int position, int reg,
+                          int32_t* value, int depth) {
+    if (reg < 0) return 0;
+    const BasicBlock* block = &cfg->blocks[b];
+    for (int i = position - 1; i >= 0; i--) {
+        if (block->code[i].dst == reg) return constantResult(cfg, reaching, b, i, value, depth);
+    }
+    const BitWord* in = dataflowSet(reaching->flow, reaching->flow->in, b);
+    int known = 0;
+    for (int k = reaching->registerStart[reg]; k < reaching->registerStart[reg + 1]; k++) {
+        int d = reaching->byRegister[k];
+        if (!testBit(in, d)) continue;
+        int32_t result;
+        if (!constantResult(cfg, reaching, definitionBlock(cfg, reaching, d), reaching->definitionPosition[d],
+                            &result, depth + 1) ||
+            (known && result != *value)) {
+            return 0;
+        }
+        *value = result;
+        known = 1;
+    }
+    return known;
+}
+
+// Function to turn branches and switches on a known value into jumps. Returns the number folded.
+static int foldConstantBranches(Cfg* cfg) {
+    ReachingDefinitions* reaching = computeReachingDefinitions(cfg);
+    int folded = 0;
+    for (int b = 0; b < cfg->blockCount; b++) {
+        BasicBlock* block = &cfg->blocks[b];
+        IrInstruction* terminator = &block->code[block->codeCount - 1];
+        if (terminator->opcode != IR_BRANCH && terminator->opcode != IR_SWITCH) continue;
+        int32_t value;
+        if (!constantBefore(cfg, reaching, b, block->codeCount - 1, terminator->a, &value, 0)) continue;
+
+        int target;
+        if (terminator->opcode == IR_BRANCH) {
+            target = block->successors[value ? 0 : 1];
+        } else {
+            int64_t slot = 1 + (int64_t)value - terminator->imm.i;
+            target = block->successors[slot >= 1 && slot < block->successorCount ? slot : 0];
+        }
+        terminator->opcode = IR_JUMP;
+        terminator->a = -1;
+        block->successors[0] = target;
+        block->successorCount = 1;
+        folded++;
+    }
+    freeReachingDefinitions(reaching);
+    return folded;
+}
+
+// Function to remove every removable instruction whose result is not live
+// after it, scanning each block backwards from its live-out set. Returns the
+// number removed; what they read may have died with them, so callers repeat.
+static int removeDeadStores(Cfg* cfg) {
+    Dataflow* liveness = computeLiveness(cfg);
+    BitWord* live = (BitWord*)allocateArray(liveness->wordCount, sizeof(BitWord));
+    int removed = 0;
+    for (int b = 0; b < cfg->blockCount; b++) {
+        BasicBlock* block = &cfg->blocks[b];
+        memcpy(live, dataflowSet(liveness, liveness->out, b), (size_t)liveness->wordCount * sizeof(BitWord));
+        int kept = block->codeCount;
+        for (int i = block->codeCount - 1; i >= 0; i--) {
+            IrInstruction in = block->code[i];
+            if (in.dst >= 0 && !testBit(live, in.dst) && isRemovable(&in)) {
+                removed++;
+                continue;
+            }
+            if (in.dst >= 0) clearBit(live, in.dst);
+            if (in.a >= 0) setBit(live, in.a);
+            if (in.b >= 0) setBit(live, in.b);
+            if (in.c >= 0) setBit(live, in.c);
+            block->code[--kept] = in;
+        }
+        memmove(block->code, block->code + kept, (size_t)(block->codeCount - kept) * sizeof(IrInstruction));
+        block->codeCount -= kept;
+    }
+    free(live);
+    freeDataflow(liveness);
+    cfg->instructionCount -= removed;
+    return removed;
+}
+
+int eliminateDeadCode(Cfg* cfg) {
+    if (!cfgDeadCodeElimination) return 0;
+
+    // Branches first: a side that can no longer run takes its stores and reads with it
+    for (;;) {
+        int folded = foldConstantBranches(cfg);
+        if (folded == 0) break;
+        cfg->foldedBranches += folded;
+        int unreachable = cfg->unreachableBlocks;
+        int before = cfg->blockCount;
+        threadJumps(cfg);
+        renumberBlocks(cfg);
+        computeDominators(cfg);
+        cfg->deadBlocks += before - cfg->blockCount;
+        cfg->unreachableBlocks = unreachable;
+        cfg->instructionCount = 0;
+        for (int b = 0; b < cfg->blockCount; b++) cfg->instructionCount += cfg->blocks[b].codeCount;
+    }
+
+    unsigned char* written = (unsigned char*)allocateArray(cfg->bindingCount, 1);
+    for (int b = 0; b < cfg->blockCount; b++) {
+        const BasicBlock* block = &cfg->blocks[b];
+        for (int i = 0; i < block->codeCount; i++) {
+            int dst = block->code[i].dst;
+            if (dst >= 0 && dst < cfg->bindingCount) written[dst] = 1;
+        }
+    }
+
+    int removed;
+    while ((removed = removeDeadStores(cfg)) > 0) cfg->deadStores += removed;
+
+    // Variables with writes before and no mention now were never read
+    for (int b = 0; b < cfg->blockCount; b++) {
+        const BasicBlock* block = &cfg->blocks[b];
+        for (int i = 0; i < block->codeCount; i++) {
+            const IrInstruction* in = &block->code[i];
+            const int mentioned[4] = {in->dst, in->a, in->b, in->c};
+            for (int k = 0; k < 4; k++) {
+                if (mentioned[k] >= 0 && mentioned[k] < cfg->bindingCount) written[mentioned[k]] = 0;
+            }
+        }
+    }
+    for (int v = 0; v < cfg->bindingCount; v++) cfg->unusedVariables += written[v];
+    free(written);
+    return cfg->foldedBranches + cfg->deadStores;
+}
@@ -0,0 +1,17 @@
+#ifndef DEAD_CODE_H
+#define DEAD_CODE_H
+
+#include "cfg.h"
+
+extern int cfgDeadCodeElimination; // Non-zero (default): eliminateDeadCode() folds and removes what it proves
+
+// Dead code and dead store elimination, the last pass before code generation.
+// A branch or switch whose value is a constant on every path to it (found
+// with reaching definitions, through copies, ! and comparisons) becomes a
+// jump and the blocks it no longer reaches are dropped. Then each pure
+// instruction whose result is not live (see computeLiveness() in dataflow.h)
+// is removed, repeating until nothing more dies. Returns the branches folded
+// plus the instructions removed.
+int eliminateDeadCode(Cfg* cfg);
+
+#endif // DEAD_CODE_H
@@ -0,0 +1,82 @@
+#include "format.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+// "00" .. "99", so each division by 100 produces two digits
+static const char digitPairs[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+// Function to write `value` in decimal; returns the length
+static int writeDigits(char* buffer, uint32_t value) {
+    int length = value < 10 ? 1 : value < 100 ? 2 : value < 1000 ? 3 : value < 10000 ? 4 : value < 100000 ? 5
+               : value < 1000000 ? 6 : value < 10000000 ? 7 : value < 100000000 ? 8 : value < 1000000000 ? 9 : 10;
+    char* end = buffer + length;
+    while (value >= 100) {
+        const char* pair = &digitPairs[(value % 100) * 2];
+        value /= 100;
+        *--end = pair[1];
+        *--end = pair[0];
+    }
+    if (value >= 10) {
+        *--end = digitPairs[value * 2 + 1];
+        *--end = digitPairs[value * 2];
+    } else {
+        *--end = (char)('0' + value);
+    }
+    return length;
+}
+
+int formatInt(char* buffer, int32_t value) {
+    if (value < 0) {
+        buffer[0] = '-';
+        return 1 + writeDigits(buffer + 1, 0u - (uint32_t)value);
+    }
+    return writeDigits(buffer, (uint32_t)value);
+}
+
+int formatFloat(char* buffer, double value) {
+    // Below 1e7, value * 1e6 is under 2^44 and the product is within half an ulp
+    // (at most scaled * 2^-53) of the exact one, so unless it lies within twice that of a
+    // rounding tie, its side of the tie is the side printf rounds to
+    double magnitude = fabs(value);
+    if (!(magnitude < 1e7)) return snprintf(buffer, FORMAT_FLOAT_MAX, "%f", value);
+    double scaled = magnitude * 1e6;
+    int64_t truncated = (int64_t)scaled; // floor: scaled is non-negative
+    double fraction = scaled - (double)truncated;
+    if (fabs(fraction - 0.5) <= scaled * 0x1p-52) return snprintf(buffer, FORMAT_FLOAT_MAX, "%f", value);
+
+    uint64_t units = (uint64_t)truncated + (fraction > 0.5);
+    int length = 0;
+    if (signbit(value)) buffer[length++] = '-'; // "-0.000000" too, as printf
+    length += writeDigits(buffer + length, (uint32_t)(units / 1000000));
+    uint32_t decimals = (uint32_t)(units % 1000000);
+    char* out = buffer + length;
+    out[0] = '.';
+    memcpy(out + 1, &digitPairs[(decimals / 10000) * 2], 2);
+    memcpy(out + 3, &digitPairs[(decimals / 100 % 100) * 2], 2);
+    memcpy(out + 5, &digitPairs[(decimals % 100) * 2], 2);
+    return length + 7;
+}
+
+int scanFormatSpec(const char* p, FormatSpec* spec) {
+    int length = 0;
+    const char* q = p + 1;
+    spec->spec[length++] = '%';
+    while (*q && strchr("-+ #0123456789.", *q) && length < FORMAT_SPEC_MAX - 2) {
+        spec->spec[length++] = *q++;
+    }
+    while (*q == 'l' || *q == 'h') q++;
+    if (!*q || !strchr("diuxXocfFeEgGs", *q)) {
+        spec->conversion = 0;
+        spec->length = 1;
+        return 0;
+    }
+    spec->conversion = *q;
+    spec->spec[length++] = *q;
+    spec->spec[length] = '\0';
+    spec->length = (int)(q - p) + 1;
+    return 1;
+}
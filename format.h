@@ -0,0 +1,35 @@
+#ifndef FORMAT_H
+#define FORMAT_H
+
+#include <stdint.h>
+
+// Number-to-text conversions for printf's most common cases, writing exactly
+// what the C library writes for "%d" and "%f" (no terminator; they return
+// the number of bytes written).
+
+#define FORMAT_INT_MAX 11     // "-2147483648"
+#define FORMAT_FLOAT_MAX 320  // "%f" of -DBL_MAX: 309 digits, sign and ".000000"
+
+int formatInt(char* buffer, int32_t value);
+
+// "%f": six decimals, rounded like printf. Values that are not comfortably
+// decided in double arithmetic (large magnitudes, ties within rounding error,
+// NaN and infinities) go through snprintf.
+int formatFloat(char* buffer, double value);
+
+// One printf conversion, %[flags][width][.precision][length]conversion, as the
+// VM, the bytecode compiler and the C emitter all read it. The length modifier
+// is dropped from `spec`.
+#define FORMAT_SPEC_MAX 32
+
+typedef struct {
+    char spec[FORMAT_SPEC_MAX]; // '%', flags/width/precision and the conversion, terminated
+    char conversion;            // One of diuxXocfFeEgGs, or 0 if `p` does not start one
+    int length;                 // Characters of the format it covers, from '%' to the conversion
+} FormatSpec;
+
+// Reads the conversion at `p` (a '%' that is not "%%"); returns 1 if it is one.
+// If not, the '%' stands for itself and the text after it is read again.
+int scanFormatSpec(const char* p, FormatSpec* spec);
+
+#endif // FORMAT_H
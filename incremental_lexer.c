@@ -0,0 +1,422 @@
+#include "incremental_lexer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "state_machine.h"
+
+// Growable token array filled by the token sink
+typedef struct {
+    Token *items;
+    int count;
+    int capacity;
+    const SourceMap *source; // Resolves token offsets to lines and columns
+} TokenList;
+
+// Scratch state reused across edits so a keystroke does not allocate
+static TokenList scratchTokens = {NULL, 0, 0, NULL};
+static int *scratchLineFirst = NULL;
+static unsigned char *scratchLineState = NULL;
+static int scratchLineCapacity = 0;
+static TokenList spliceTokens = {NULL, 0, 0, NULL}; // Kept prefix + new tokens + kept suffix of rewritten chunks
+
+static void* reallocOrDie(void *memory, size_t size) {
+    void *grown = realloc(memory, size);
+    if (!grown) {
+        fprintf(stderr, "Error: Memory allocation failed in incremental lexer.\n");
+        exit(EXIT_FAILURE);
+    }
+    return grown;
+}
+
+// Token sink: append one token to a TokenList
+static void appendToken(void *context, const char *type, const char *value, size_t offset) {
+    TokenList *list = (TokenList *)context;
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity ? list->capacity * 2 : 1024;
+        list->items = (Token *)reallocOrDie(list->items, list->capacity * sizeof(Token));
+    }
+
+    Token *token = &list->items[list->count++];
+    strncpy(token->type, type, sizeof(token->type) - 1);
+    token->type[sizeof(token->type) - 1] = '\0';
+    strncpy(token->value, value, sizeof(token->value) - 1);
+    token->value[sizeof(token->value) - 1] = '\0';
+    sourceLocate(list->source, offset, &token->lineNumber, &token->column);
+    token->symbolId = internTokenValue(token);
+}
+
+// Make sure the per-line arrays can hold `lines` + 1 entries
+static void reserveLines(LexedSource *lexed, int lines) {
+    if (lines + 1 <= lexed->lineCapacity) return;
+    int capacity = lexed->lineCapacity ? lexed->lineCapacity : 256;
+    while (capacity < lines + 1) capacity *= 2;
+    lexed->lineFirstToken = (int *)reallocOrDie(lexed->lineFirstToken, capacity * sizeof(int));
+    lexed->lineEntryState = (unsigned char *)reallocOrDie(lexed->lineEntryState, capacity);
+    lexed->lineCapacity = capacity;
+}
+
+static void reserveScratchLines(int lines) {
+    if (lines <= scratchLineCapacity) return;
+    int capacity = scratchLineCapacity ? scratchLineCapacity : 64;
+    while (capacity < lines) capacity *= 2;
+    scratchLineFirst = (int *)reallocOrDie(scratchLineFirst, capacity * sizeof(int));
+    scratchLineState = (unsigned char *)reallocOrDie(scratchLineState, capacity);
+    scratchLineCapacity = capacity;
+}
+
+static void reserveTokens(TokenList *list, int count) {
+    if (count <= list->capacity) return;
+    int capacity = list->capacity ? list->capacity : 1024;
+    while (capacity < count) capacity *= 2;
+    list->items = (Token *)reallocOrDie(list->items, capacity * sizeof(Token));
+    list->capacity = capacity;
+}
+
+// ---------------------------------------
+// Chunked token storage
+// ---------------------------------------
+
+// Make sure the chunk directory can hold `chunks` + 1 entries
+static void reserveChunks(LexedSource *lexed, int chunks) {
+    if (chunks + 1 <= lexed->chunkCapacity) return;
+    int capacity = lexed->chunkCapacity ? lexed->chunkCapacity : 64;
+    while (capacity < chunks + 1) capacity *= 2;
+    lexed->chunks = (TokenChunk **)reallocOrDie(lexed->chunks, capacity * sizeof(TokenChunk *));
+    lexed->chunkFirstToken = (int *)reallocOrDie(lexed->chunkFirstToken, capacity * sizeof(int));
+    lexed->chunkLineBase = (int *)reallocOrDie(lexed->chunkLineBase, capacity * sizeof(int));
+    lexed->chunkCapacity = capacity;
+}
+
+// Index of the chunk holding token `index` (the last chunk for index == tokenCount)
+static int chunkOf(const LexedSource *lexed, int index) {
+    int low = 0, high = lexed->chunkCount - 1;
+    while (low < high) {
+        int middle = (low + high + 1) / 2;
+        if (lexed->chunkFirstToken[middle] <= index) {
+            low = middle;
+        } else {
+            high = middle - 1;
+        }
+    }
+    return low;
+}
+
+// Replace directory entries [first, first + removed) with `added` unset entries
+static void spliceChunkDirectory(LexedSource *lexed, int first, int removed, int added) {
+    reserveChunks(lexed, lexed->chunkCount - removed + added);
+    int tail = lexed->chunkCount - (first + removed);
+    memmove(lexed->chunks + first + added, lexed->chunks + first + removed, tail * sizeof(TokenChunk *));
+    memmove(lexed->chunkFirstToken + first + added, lexed->chunkFirstToken + first + removed,
+            (tail + 1) * sizeof(int)); // Includes the end-of-stream entry
+    memmove(lexed->chunkLineBase + first + added, lexed->chunkLineBase + first + removed, tail * sizeof(int));
+    lexed->chunkCount += added - removed;
+}
+
+// Pack `count` tokens (absolute line numbers) into `chunks` fresh chunks at
+// directory entry `first`; the first of them becomes token `firstIndex`
+static void fillChunks(LexedSource *lexed, int first, int chunks,
+                       const Token *tokens, int count, int firstIndex) {
+    for (int c = 0; c < chunks; c++) {
+        TokenChunk *chunk = (TokenChunk *)reallocOrDie(NULL, sizeof(TokenChunk));
+        int offset = c * TOKEN_CHUNK_SIZE;
+        chunk->count = count - offset < TOKEN_CHUNK_SIZE ? count - offset : TOKEN_CHUNK_SIZE;
+        memcpy(chunk->tokens, tokens + offset, chunk->count * sizeof(Token));
+        lexed->chunks[first + c] = chunk;
+        lexed->chunkFirstToken[first + c] = firstIndex + offset;
+        lexed->chunkLineBase[first + c] = 0;
+    }
+}
+
+// Fold chunk `c + 1` into chunk `c` when both fit in one chunk, so edits do
+// not leave a trail of nearly empty chunks behind
+static void mergeChunks(LexedSource *lexed, int c) {
+    if (c < 0 || c + 1 >= lexed->chunkCount) return;
+    TokenChunk *left = lexed->chunks[c];
+    TokenChunk *right = lexed->chunks[c + 1];
+    if (left->count + right->count > TOKEN_CHUNK_SIZE) return;
+
+    int rebase = lexed->chunkLineBase[c + 1] - lexed->chunkLineBase[c];
+    memcpy(left->tokens + left->count, right->tokens, right->count * sizeof(Token));
+    for (int i = 0; i < right->count; i++) {
+        left->tokens[left->count + i].lineNumber += rebase;
+    }
+    left->count += right->count;
+    free(right);
+    spliceChunkDirectory(lexed, c + 1, 1, 0);
+}
+
+// Replace tokens [firstToken, oldEnd) with `fresh` (absolute line numbers after
+// the edit). Only the chunks holding the replaced range are rewritten; later
+// tokens move by `lineDelta` lines through their chunk's line base.
+static void spliceChunks(LexedSource *lexed, int firstToken, int oldEnd,
+                         const Token *fresh, int freshCount, int lineDelta) {
+    int tokenDelta = freshCount - (oldEnd - firstToken);
+    int first = chunkOf(lexed, firstToken);
+    int last = oldEnd > firstToken ? chunkOf(lexed, oldEnd - 1) : first;
+    TokenChunk *chunk = lexed->chunks[first];
+    int start = firstToken - lexed->chunkFirstToken[first];
+
+    if (first == last && chunk->count + tokenDelta <= TOKEN_CHUNK_SIZE) {
+        // The edit stays inside one chunk: shift the rest of that chunk only
+        int end = oldEnd - lexed->chunkFirstToken[first];
+        memmove(chunk->tokens + start + freshCount, chunk->tokens + end, (chunk->count - end) * sizeof(Token));
+        chunk->count += tokenDelta;
+        for (int i = start + freshCount; i < chunk->count; i++) {
+            chunk->tokens[i].lineNumber += lineDelta;
+        }
+        for (int i = 0; i < freshCount; i++) {
+            chunk->tokens[start + i] = fresh[i];
+            chunk->tokens[start + i].lineNumber -= lexed->chunkLineBase[first];
+        }
+    } else {
+        // Rebuild the touched chunks from the kept prefix, the new tokens and the kept suffix
+        TokenChunk *tail = lexed->chunks[last];
+        int end = oldEnd - lexed->chunkFirstToken[last];
+        int total = start + freshCount + (tail->count - end);
+        reserveTokens(&spliceTokens, total);
+
+        Token *out = spliceTokens.items;
+        for (int i = 0; i < start; i++) {
+            *out = chunk->tokens[i];
+            out++->lineNumber += lexed->chunkLineBase[first];
+        }
+        memcpy(out, fresh, freshCount * sizeof(Token));
+        out += freshCount;
+        for (int i = end; i < tail->count; i++) {
+            *out = tail->tokens[i];
+            out++->lineNumber += lexed->chunkLineBase[last] + lineDelta;
+        }
+
+        int removed = last - first + 1;
+        int added = (total + TOKEN_CHUNK_SIZE - 1) / TOKEN_CHUNK_SIZE;
+        if (added == 0 && removed == lexed->chunkCount) {
+            added = 1; // Keep one (empty) chunk
+        }
+        int firstIndex = lexed->chunkFirstToken[first];
+        for (int c = first; c <= last; c++) {
+            free(lexed->chunks[c]);
+        }
+        spliceChunkDirectory(lexed, first, removed, added);
+        fillChunks(lexed, first, added, spliceTokens.items, total, firstIndex);
+        last = first + added - 1;
+    }
+
+    // Later chunks keep their tokens and only move
+    for (int c = last + 1; c < lexed->chunkCount; c++) {
+        lexed->chunkFirstToken[c] += tokenDelta;
+        lexed->chunkLineBase[c] += lineDelta;
+    }
+    lexed->tokenCount += tokenDelta;
+    lexed->chunkFirstToken[lexed->chunkCount] = lexed->tokenCount;
+
+    mergeChunks(lexed, last);
+    mergeChunks(lexed, first - 1);
+
+    // One edit since the last lexedTokens call can be replayed on the array by
+    // shifting its tail; after more edits it is recopied from the chunks
+    int flatWasCurrent = !lexed->flatTailKept && lexed->flatValid == lexed->tokenCount - tokenDelta;
+    lexed->flatTailKept = flatWasCurrent;
+    lexed->flatTailOld = oldEnd;
+    lexed->flatTailNew = firstToken + freshCount;
+    lexed->flatTailLines = lineDelta;
+    if (lexed->flatValid > firstToken) {
+        lexed->flatValid = firstToken;
+    }
+}
+
+// Lex one line of the source map into `list`, returning the comment state after it
+static int lexSourceLine(LexedSource *lexed, int lineNumber, int inComment, TokenList *list) {
+    size_t length = sourceLineLength(lexed->source, lineNumber);
+    if (length + 1 > lexed->lineBufferCapacity) {
+        lexed->lineBufferCapacity = (length + 1) * 2;
+        lexed->lineBuffer = (char *)reallocOrDie(lexed->lineBuffer, lexed->lineBufferCapacity);
+    }
+    memcpy(lexed->lineBuffer, lexed->source->text + sourceLineStart(lexed->source, lineNumber), length);
+    lexed->lineBuffer[length] = '\0';
+
+    list->source = lexed->source;
+    setTokenSink(appendToken, list);
+    lexLine(lexed->lineBuffer, lexed->source, lineNumber, &inComment, NULL);
+    setTokenSink(NULL, NULL);
+    return inComment;
+}
+
+// Function to lex a whole buffer into a LexedSource
+LexedSource* lexSource(const char *text, size_t length) {
+    LexedSource *lexed = (LexedSource *)calloc(1, sizeof(LexedSource));
+    if (!lexed) {
+        fprintf(stderr, "Error: Memory allocation failed for lexed source.\n");
+        exit(EXIT_FAILURE);
+    }
+    lexed->source = createSourceMap(text, length, NULL);
+    reserveLines(lexed, lexed->source->lineCount);
+
+    int savedDebug = lexerDebug;
+    lexerDebug = 0;
+
+    TokenList list = {NULL, 0, 0, NULL};
+    int inComment = 0;
+    for (int line = 1; line <= lexed->source->lineCount; line++) {
+        lexed->lineFirstToken[line - 1] = list.count;
+        lexed->lineEntryState[line - 1] = (unsigned char)inComment;
+        inComment = lexSourceLine(lexed, line, inComment, &list);
+    }
+    lexed->lineFirstToken[lexed->source->lineCount] = list.count;
+    lexed->lineEntryState[lexed->source->lineCount] = (unsigned char)inComment;
+
+    lexerDebug = savedDebug;
+
+    lexed->tokenCount = list.count;
+    int chunks = (list.count + TOKEN_CHUNK_SIZE - 1) / TOKEN_CHUNK_SIZE;
+    if (chunks == 0) chunks = 1;
+    reserveChunks(lexed, chunks);
+    fillChunks(lexed, 0, chunks, list.items, list.count, 0);
+    lexed->chunkCount = chunks;
+    lexed->chunkFirstToken[chunks] = list.count;
+
+    // The lexed array doubles as the first contiguous copy
+    lexed->flatTokens = list.items;
+    lexed->flatCapacity = list.capacity;
+    lexed->flatValid = list.count;
+    return lexed;
+}
+
+// Function to apply an edit and re-lex the affected lines.
+// Lexing restarts at the first edited line and stops at the first line at or
+// after the edit whose exit comment state matches the old stream's state at
+// the same point; everything after that is reused as is, and only the chunk
+// directory and line table entries after the edit are adjusted.
+void relexEdit(LexedSource *lexed, size_t offset, size_t deletedLength,
+               const char *inserted, size_t insertedLength, TokenEdit *edit) {
+    int oldLineCount = lexed->source->lineCount;
+    int firstLine, oldLastLine, newLastLine;
+    editSourceMap(lexed->source, offset, deletedLength, inserted, insertedLength,
+                  &firstLine, &oldLastLine, &newLastLine);
+    int newLineCount = lexed->source->lineCount;
+    int lineDelta = newLineCount - oldLineCount;
+
+    int savedDebug = lexerDebug;
+    lexerDebug = 0;
+
+    // Re-lex into scratch space; the old arrays stay untouched until the splice
+    scratchTokens.count = 0;
+    int inComment = lexed->lineEntryState[firstLine - 1];
+    int line = firstLine;
+    while (1) {
+        reserveScratchLines(line - firstLine + 1);
+        scratchLineFirst[line - firstLine] = scratchTokens.count;
+        scratchLineState[line - firstLine] = (unsigned char)inComment;
+        inComment = lexSourceLine(lexed, line, inComment, &scratchTokens);
+
+        if (line >= newLineCount) break;
+        if (line >= newLastLine && inComment == lexed->lineEntryState[line - lineDelta]) break;
+        line++;
+    }
+
+    lexerDebug = savedDebug;
+
+    // Old lines firstLine..(line - lineDelta) were replaced by new lines firstLine..line
+    int oldResume = line - lineDelta;
+    int firstToken = lexed->lineFirstToken[firstLine - 1];
+    int oldEnd = lexed->lineFirstToken[oldResume];
+    int newEnd = firstToken + scratchTokens.count;
+    int tokenDelta = newEnd - oldEnd;
+
+    spliceChunks(lexed, firstToken, oldEnd, scratchTokens.items, scratchTokens.count, lineDelta);
+
+    // Splice the per-line tables the same way
+    reserveLines(lexed, newLineCount);
+    int tailLines = oldLineCount - oldResume + 1; // Includes the end-of-file entry
+    if (lineDelta != 0) {
+        memmove(lexed->lineFirstToken + line, lexed->lineFirstToken + oldResume, tailLines * sizeof(int));
+        memmove(lexed->lineEntryState + line, lexed->lineEntryState + oldResume, tailLines);
+    }
+    for (int i = firstLine; i <= line; i++) {
+        lexed->lineFirstToken[i - 1] = firstToken + scratchLineFirst[i - firstLine];
+        lexed->lineEntryState[i - 1] = scratchLineState[i - firstLine];
+    }
+    if (tokenDelta != 0) {
+        for (int i = line; i <= newLineCount; i++) {
+            lexed->lineFirstToken[i] += tokenDelta;
+        }
+    }
+    lexed->lineEntryState[line] = (unsigned char)inComment;
+
+    if (edit) {
+        edit->firstToken = firstToken;
+        edit->oldEnd = oldEnd;
+        edit->newEnd = newEnd;
+        edit->firstLine = firstLine;
+        edit->lastLine = line;
+    }
+}
+
+// Function to read one token with its absolute line number
+Token lexedTokenAt(const LexedSource *lexed, int index) {
+    int c = chunkOf(lexed, index);
+    Token token = lexed->chunks[c]->tokens[index - lexed->chunkFirstToken[c]];
+    token.lineNumber += lexed->chunkLineBase[c];
+    return token;
+}
+
+// Function to get the stream as one array. Only what changed since the last
+// call is refreshed: a single edit is replayed by shifting the array's tail,
+// anything more is recopied from the first edited token onwards.
+Token* lexedTokens(LexedSource *lexed) {
+    if (lexed->tokenCount > lexed->flatCapacity) {
+        int capacity = lexed->flatCapacity ? lexed->flatCapacity : 1024;
+        while (capacity < lexed->tokenCount) capacity *= 2;
+        lexed->flatTokens = (Token *)reallocOrDie(lexed->flatTokens, capacity * sizeof(Token));
+        lexed->flatCapacity = capacity;
+    }
+
+    int end = lexed->tokenCount;
+    if (lexed->flatTailKept) {
+        // Replay the single pending edit: move the unchanged tail, then copy the new tokens
+        Token *tail = lexed->flatTokens + lexed->flatTailNew;
+        int tailCount = lexed->tokenCount - lexed->flatTailNew;
+        memmove(tail, lexed->flatTokens + lexed->flatTailOld, tailCount * sizeof(Token));
+        if (lexed->flatTailLines != 0) {
+            for (int i = 0; i < tailCount; i++) {
+                tail[i].lineNumber += lexed->flatTailLines;
+            }
+        }
+        end = lexed->flatTailNew;
+        lexed->flatTailKept = 0;
+    }
+
+    int index = lexed->flatValid;
+    for (int c = chunkOf(lexed, index); index < end && c < lexed->chunkCount; c++) {
+        const TokenChunk *chunk = lexed->chunks[c];
+        int from = index - lexed->chunkFirstToken[c];
+        int count = chunk->count - from;
+        if (count > end - index) count = end - index;
+        Token *out = lexed->flatTokens + index;
+        memcpy(out, chunk->tokens + from, count * sizeof(Token));
+        if (lexed->chunkLineBase[c] != 0) {
+            for (int i = 0; i < count; i++) {
+                out[i].lineNumber += lexed->chunkLineBase[c];
+            }
+        }
+        index += count;
+    }
+    lexed->flatValid = lexed->tokenCount;
+    return lexed->flatTokens;
+}
+
+// Function to free a LexedSource
+void freeLexedSource(LexedSource *lexed) {
+    if (!lexed) return;
+    freeSourceMap(lexed->source);
+    for (int c = 0; c < lexed->chunkCount; c++) {
+        free(lexed->chunks[c]);
+    }
+    free(lexed->chunks);
+    free(lexed->chunkFirstToken);
+    free(lexed->chunkLineBase);
+    free(lexed->flatTokens);
+    free(lexed->lineFirstToken);
+    free(lexed->lineEntryState);
+    free(lexed->lineBuffer);
+    free(lexed);
+}
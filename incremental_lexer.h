@@ -0,0 +1,76 @@
+#ifndef INCREMENTAL_LEXER_H
+#define INCREMENTAL_LEXER_H
+
+#include <stddef.h>
+#include "token.h"
+#include "source_map.h"
+
+#define TOKEN_CHUNK_SIZE 256       // Tokens per chunk (~30 KB)
+
+// Run of consecutive tokens. Line numbers are stored relative to the chunk's
+// entry in LexedSource.chunkLineBase, so an edit that adds or removes lines
+// only moves the bases of later chunks instead of touching their tokens.
+typedef struct {
+    Token tokens[TOKEN_CHUNK_SIZE];
+    int count;
+} TokenChunk;
+
+// Tokens of an in-memory source plus the per-line bookkeeping needed to
+// re-lex only the region touched by an edit. Tokens never span lines, so
+// line starts are always token boundaries; the only state carried from one
+// line to the next is the multi-line comment flag.
+//
+// The stream is kept in chunks so an edit rewrites at most the chunks it
+// touches and then adjusts one small directory entry per later chunk; read
+// single tokens with lexedTokenAt, or call lexedTokens for a contiguous copy
+// (brought up to date lazily, only when a whole-stream consumer asks for it).
+typedef struct {
+    SourceMap *source;            // Current text and line index
+    TokenChunk **chunks;          // Token stream in source order (at least one chunk)
+    int *chunkFirstToken;         // Index of each chunk's first token; [chunkCount] = tokenCount
+    int *chunkLineBase;           // Added to the stored line number of each chunk's tokens
+    int chunkCount;
+    int chunkCapacity;
+    int tokenCount;
+    Token *flatTokens;            // Contiguous copy handed out by lexedTokens
+    int flatCapacity;
+    int flatValid;                // flatTokens[0, flatValid) match the current stream
+    int flatTailKept;             // Set when one edit is pending: flatTokens[flatTailOld, ...) hold
+    int flatTailOld;              //   tokens [flatTailNew, tokenCount), flatTailLines lines early
+    int flatTailNew;
+    int flatTailLines;
+    int *lineFirstToken;          // lineFirstToken[i] = first token of line i + 1; [lineCount] = tokenCount
+    unsigned char *lineEntryState;// Comment state entering line i + 1; [lineCount] = state at end of file
+    int lineCapacity;
+    char *lineBuffer;             // Scratch copy of the line being lexed
+    size_t lineBufferCapacity;
+} LexedSource;
+
+// Changed token range reported by relexEdit.
+// Tokens [firstToken, oldEnd) of the previous stream were replaced by
+// tokens [firstToken, newEnd) of the current one; later tokens only moved.
+typedef struct {
+    int firstToken;
+    int oldEnd;
+    int newEnd;
+    int firstLine;  // First re-lexed line (1-based, current numbering)
+    int lastLine;   // Last re-lexed line
+} TokenEdit;
+
+// Lex a whole buffer (the text is copied)
+LexedSource* lexSource(const char *text, size_t length);
+
+// Apply an edit and re-lex until the lexer state resynchronizes with the old stream
+void relexEdit(LexedSource *lexed, size_t offset, size_t deletedLength,
+               const char *inserted, size_t insertedLength, TokenEdit *edit);
+
+// Token at `index` with its absolute line number
+Token lexedTokenAt(const LexedSource *lexed, int index);
+
+// Contiguous token array for whole-stream consumers (parser, type checker);
+// valid until the next edit
+Token* lexedTokens(LexedSource *lexed);
+
+void freeLexedSource(LexedSource *lexed);
+
+#endif // INCREMENTAL_LEXER_H
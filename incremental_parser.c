@@ -0,0 +1,252 @@
+#include "incremental_parser.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "syntax_analyzer.h"
+
+// Tokens of lookahead the parser may use past the end of a statement
+#define REPARSE_LOOKAHEAD 2
+
+// Tracked Block nodes found inside one statement, with offsets relative to it
+typedef struct {
+    ParseTreeNode* block;
+    int offset;
+} NestedBlock;
+
+static ParseTreeNode** newStatements = NULL;
+static int newStatementCapacity = 0;
+
+static void collectBlocks(ParseTreeNode* node, NestedBlock* found, int* count, int capacity) {
+    for (int i = 0; i < node->childCount && *count < capacity; i++) {
+        ParseTreeNode* child = node->children[i];
+        if (!child) continue;
+        if (child->tokenSpan > 0 && strcmp(child->label, "Block") == 0) {
+            found[*count].block = child;
+            found[*count].offset = child->tokenOffset;
+            (*count)++;
+        } else {
+            collectBlocks(child, found, count, capacity);
+        }
+    }
+}
+
+static void pushStatement(int index, ParseTreeNode* node) {
+    if (index >= newStatementCapacity) {
+        newStatementCapacity = newStatementCapacity ? newStatementCapacity * 2 : 64;
+        newStatements = (ParseTreeNode**)realloc(newStatements, newStatementCapacity * sizeof(ParseTreeNode*));
+        if (!newStatements) {
+            fprintf(stderr, "Error: Memory allocation failed in incremental parser.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    newStatements[index] = node;
+}
+
+// Statement children of a container: all children of Program, everything between the braces of a Block
+static void statementRange(ParseTreeNode* container, int isBlock, int* first, int* last) {
+    *first = isBlock ? 1 : 0;
+    *last = isBlock ? container->childCount - 1 : container->childCount;
+}
+
+// Function to find the first statement in [first, last) whose span ends after `position`
+static int findStatement(ParseTreeNode* container, int first, int last, int position) {
+    int low = first, high = last;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        ParseTreeNode* child = container->children[mid];
+        if (child->tokenOffset + child->tokenSpan <= position) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+// Function to reparse the statements of `container` that overlap the edit.
+// Parsing restarts at the statement before the edit and stops at the first
+// statement boundary at or after the edit that lines up with the old tree.
+static int reparseStatements(ParseTreeNode* container, int containerStart, int isBlock,
+                             int editStart, int oldEditEnd, int delta) {
+    int first, last;
+    statementRange(container, isBlock, &first, &last);
+
+    // Relative content bounds before the edit
+    int contentStart = isBlock ? container->children[0]->tokenSpan : 0;
+    int contentEnd = isBlock ? container->children[last]->tokenOffset : container->tokenSpan;
+    int relStart = editStart - containerStart;
+    int relEnd = oldEditEnd - containerStart;
+    if (relStart < contentStart || relEnd > contentEnd) {
+        return 0; // The edit touches this container's own delimiters
+    }
+
+    int from = relStart - REPARSE_LOOKAHEAD;
+    if (from < contentStart) from = contentStart;
+    int i = findStatement(container, first, last, from);
+    int restart = (i < last) ? container->children[i]->tokenOffset : contentEnd;
+
+    int errorsBefore = syntaxErrorCount;
+    int newEnd = relEnd + delta;
+    int count = 0;
+    int j;
+    currentTokenIndex = containerStart + restart;
+
+    while (1) {
+        Token* token = peekToken();
+        int position = currentTokenIndex - containerStart;
+
+        if (position >= newEnd) {
+            // Old boundaries are statement starts and the end of the content
+            if (position - delta == contentEnd) {
+                j = last;
+                break;
+            }
+            int k = findStatement(container, i, last, position - delta);
+            if (k < last && container->children[k]->tokenOffset == position - delta) {
+                j = k;
+                break;
+            }
+        }
+
+        if (!token || (isBlock && strcmp(token->type, "Delimiter") == 0 && strcmp(token->value, "}") == 0)) {
+            if (isBlock || token) goto fail; // The block now closes somewhere else
+            j = last;
+            break;
+        }
+
+        ParseTreeNode* statementNode = parseTrackedStatement(containerStart, currentTokenIndex);
+        if (!statementNode || syntaxErrorCount != errorsBefore) {
+            freeParseTree(statementNode);
+            goto fail;
+        }
+        pushStatement(count++, statementNode);
+    }
+
+    replaceChildren(container, i, j - i, newStatements, count);
+
+    // Everything after the new statements moved by `delta` tokens
+    for (int k = i + count; k < container->childCount; k++) {
+        container->children[k]->tokenOffset += delta;
+    }
+    container->tokenSpan += delta;
+    return count > 0 ? count : 1;
+
+fail:
+    for (int k = 0; k < count; k++) {
+        freeParseTree(newStatements[k]);
+    }
+    return 0;
+}
+
+// Function to descend to the innermost block containing the edit, then reparse there.
+// Returns the number of statements rebuilt (0 if this level could not absorb the edit).
+static int reparseContainer(ParseTreeNode* container, int containerStart, int isBlock,
+                            int editStart, int oldEditEnd, int delta) {
+    int first, last;
+    statementRange(container, isBlock, &first, &last);
+
+    int i = findStatement(container, first, last, editStart - containerStart);
+    if (i < last) {
+        ParseTreeNode* statement = container->children[i];
+        int statementStart = containerStart + statement->tokenOffset;
+
+        if (oldEditEnd <= statementStart + statement->tokenSpan && editStart >= statementStart) {
+            NestedBlock blocks[64];
+            int blockCount = 0;
+            if (strcmp(statement->label, "Block") == 0) {
+                blocks[blockCount].block = statement;
+                blocks[blockCount].offset = 0;
+                blockCount++;
+            } else {
+                collectBlocks(statement, blocks, &blockCount, 64);
+            }
+
+            for (int b = 0; b < blockCount; b++) {
+                ParseTreeNode* block = blocks[b].block;
+                int blockStart = statementStart + blocks[b].offset;
+                if (editStart < blockStart || oldEditEnd > blockStart + block->tokenSpan) {
+                    continue;
+                }
+
+                int rebuilt = reparseContainer(block, blockStart, 1, editStart, oldEditEnd, delta);
+                if (!rebuilt) break;
+
+                // Later blocks of the same statement, the statement and its later siblings move
+                if (block != statement) {
+                    for (int other = 0; other < blockCount; other++) {
+                        if (blocks[other].offset > blocks[b].offset) {
+                            blocks[other].block->tokenOffset += delta;
+                        }
+                    }
+                    statement->tokenSpan += delta;
+                }
+                for (int k = i + 1; k < container->childCount; k++) {
+                    container->children[k]->tokenOffset += delta;
+                }
+                container->tokenSpan += delta;
+                return rebuilt;
+            }
+        }
+    }
+
+    return reparseStatements(container, containerStart, isBlock, editStart, oldEditEnd, delta);
+}
+
+// Function to (re)parse the whole stream into `program`
+static void parseWholeProgram(ParsedProgram* program) {
+    int errorsBefore = syntaxErrorCount;
+    currentTokenIndex = 0;
+    program->root = parseProgram();
+    program->errorCount = syntaxErrorCount - errorsBefore;
+}
+
+ParsedProgram* parseTokenStream(Token* tokens, int count) {
+    ParsedProgram* program = (ParsedProgram*)calloc(1, sizeof(ParsedProgram));
+    if (!program) {
+        fprintf(stderr, "Error: Memory allocation failed for parsed program.\n");
+        exit(EXIT_FAILURE);
+    }
+    tokenStream = tokens;
+    totalTokens = count;
+    parseWholeProgram(program);
+    return program;
+}
+
+// Function to bring the tree up to date after an edit of the token stream.
+// Trees that contained errors are always rebuilt, since error recovery can
+// skip tokens that no statement span accounts for. Lazy trees are rebuilt
+// too: deferred blocks remember absolute token positions.
+void reparseEdit(ParsedProgram* program, Token* tokens, int count, const TokenEdit* edit) {
+    tokenStream = tokens;
+    totalTokens = count;
+    program->reparsedStatements = 0;
+
+    // Edits that only moved whitespace leave the tree unchanged
+    if (edit->firstToken == edit->oldEnd && edit->firstToken == edit->newEnd) {
+        return;
+    }
+
+    int rebuilt = 0;
+    if (program->root && program->errorCount == 0 && !lazyBlocks) {
+        int previousDebug = parserDebug;
+        parserDebug = 0;
+        rebuilt = reparseContainer(program->root, 0, 0, edit->firstToken, edit->oldEnd,
+                                   edit->newEnd - edit->oldEnd);
+        parserDebug = previousDebug;
+    }
+
+    if (rebuilt) {
+        program->reparsedStatements = rebuilt;
+    } else {
+        freeParseTree(program->root);
+        parseWholeProgram(program);
+        program->reparsedStatements = program->root ? program->root->childCount : 0;
+        program->fullReparses++;
+    }
+}
+
+void freeParsedProgram(ParsedProgram* program) {
+    if (!program) return;
+    freeParseTree(program->root);
+    free(program);
+}
@@ -0,0 +1,27 @@
+#ifndef INCREMENTAL_PARSER_H
+#define INCREMENTAL_PARSER_H
+
+#include "token.h"
+#include "parse_tree.h"
+#include "incremental_lexer.h"
+
+// Parse tree of an in-memory token stream that can be updated after edits.
+// Statement, Block and brace nodes carry token spans (see ParseTreeNode);
+// an edit reparses only the innermost statement list that encloses it.
+typedef struct {
+    ParseTreeNode* root;
+    int errorCount;          // Syntax errors reported by the last (re)parse
+    int reparsedStatements;  // Statements rebuilt by the last reparseEdit
+    int fullReparses;        // Edits that fell back to parsing the whole program
+} ParsedProgram;
+
+// Parse a whole token stream
+ParsedProgram* parseTokenStream(Token* tokens, int count);
+
+// Update the tree after the token stream changed as described by `edit`.
+// `tokens`/`count` describe the stream after the edit.
+void reparseEdit(ParsedProgram* program, Token* tokens, int count, const TokenEdit* edit);
+
+void freeParsedProgram(ParsedProgram* program);
+
+#endif // INCREMENTAL_PARSER_H
@@ -0,0 +1,236 @@
+#include "input_reader.h"
+#include <stdlib.h>
+#include <string.h>
+#include "arithmetic.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define INPUT_MAPPING 1
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <io.h>
+#endif
+
+#define INPUT_BLOCK (1 << 16)
+#define INPUT_TOKEN 256       // Longest field looked at in one piece (fscanf's %255s)
+
+struct InputReader {
+    FILE* file;
+    const char* data;         // Unread input is data[position .. length)
+    size_t length;
+    size_t position;
+    char* block;              // Owned buffer when reading through the stream
+    size_t blockStart;        // Stream offset of block[0]
+    long start;               // Stream offset when the reader opened, -1 when it cannot seek
+    int lineByLine;           // Terminal: never wait for more than one line
+    int finished;             // The stream has no more data
+    void* mapping;
+    size_t mappingSize;
+};
+
+InputReader* openInputReader(FILE* file) {
+    InputReader* reader = (InputReader*)calloc(1, sizeof(InputReader));
+    if (!reader) {
+        fprintf(stderr, "Error: Memory allocation failed for input.\n");
+        exit(EXIT_FAILURE);
+    }
+    reader->file = file;
+    reader->start = ftell(file);
+
+#ifdef INPUT_MAPPING
+    struct stat info;
+    int fd = fileno(file);
+    reader->lineByLine = isatty(fd);
+    if (reader->start >= 0 && fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > reader->start) {
+        void* mapping = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED) {
+            reader->mapping = mapping;
+            reader->mappingSize = (size_t)info.st_size;
+            reader->data = (const char*)mapping;
+            reader->position = (size_t)reader->start;
+            reader->length = (size_t)info.st_size;
+            reader->finished = 1;
+            return reader;
+        }
+    }
+#endif
+
+#ifdef _WIN32
+    reader->lineByLine = _isatty(_fileno(file));
+#elif !defined(INPUT_MAPPING)
+    reader->lineByLine = 1; // Cannot tell: do not wait for more than a line
+#endif
+    reader->block = (char*)malloc(INPUT_BLOCK);
+    if (!reader->block) {
+        fprintf(stderr, "Error: Memory allocation failed for input.\n");
+        exit(EXIT_FAILURE);
+    }
+    reader->data = reader->block;
+    return reader;
+}
+
+// Function to read more of the stream after what is buffered, keeping the unread part
+static int fill(InputReader* reader) {
+    if (reader->finished) return 0;
+    if (reader->position > 0) {
+        size_t unread = reader->length - reader->position;
+        memmove(reader->block, reader->block + reader->position, unread);
+        reader->blockStart += reader->position;
+        reader->length = unread;
+        reader->position = 0;
+    }
+    size_t room = INPUT_BLOCK - reader->length;
+    if (room < 2) return 0; // Only when looking further ahead than any field needs
+    size_t added;
+    if (reader->lineByLine) {
+        added = fgets(reader->block + reader->length, (int)room, reader->file) ? strlen(reader->block + reader->length) : 0;
+    } else {
+        added = fread(reader->block + reader->length, 1, room, reader->file);
+    }
+    if (added == 0) reader->finished = 1;
+    reader->length += added;
+    return added > 0;
+}
+
+// Function to look `offset` characters ahead of the read position (EOF past the end)
+static inline int peekAt(InputReader* reader, size_t offset) {
+    while (reader->position + offset >= reader->length) {
+        if (!fill(reader)) return EOF;
+    }
+    return (unsigned char)reader->data[reader->position + offset];
+}
+
+static inline int isSpace(int c) {
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+static void skipSpace(InputReader* reader) {
+    while (isSpace(peekAt(reader, 0))) reader->position++;
+}
+
+int inputInteractive(const InputReader* reader) {
+    return reader->lineByLine;
+}
+
+int readInputInt(InputReader* reader, int32_t* value) {
+    skipSpace(reader);
+    int c = peekAt(reader, 0);
+    int negative = c == '-';
+    if (c == '-' || c == '+') reader->position++;
+    uint32_t magnitude = 0;
+    int digits = 0;
+    while ((c = peekAt(reader, 0)) >= '0' && c <= '9') {
+        magnitude = magnitude * 10u + (uint32_t)(c - '0');
+        digits++;
+        reader->position++;
+    }
+    if (digits == 0) return 0;
+    *value = negative ? intNeg((int32_t)magnitude) : (int32_t)magnitude;
+    return 1;
+}
+
+// Powers of ten a double holds exactly
+static const double exactPowers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                     1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+int readInputFloat(InputReader* reader, double* value) {
+    skipSpace(reader);
+
+    // Plain decimals whose digits and power of ten are both exact in a double are
+    // one correctly rounded multiplication or division away; strtod takes the rest
+    size_t i = 0;
+    int c = peekAt(reader, 0);
+    int negative = c == '-';
+    if (c == '-' || c == '+') i++;
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    while ((c = peekAt(reader, i)) >= '0' && c <= '9' && i < INPUT_TOKEN) {
+        mantissa = mantissa * 10u + (uint64_t)(c - '0');
+        digits++;
+        i++;
+    }
+    if (c == '.') {
+        i++;
+        while ((c = peekAt(reader, i)) >= '0' && c <= '9' && i < INPUT_TOKEN) {
+            mantissa = mantissa * 10u + (uint64_t)(c - '0');
+            digits++;
+            exponent--;
+            i++;
+        }
+    }
+    if ((c == 'e' || c == 'E') && digits > 0) {
+        size_t e = i + 1;
+        int sign = peekAt(reader, e);
+        if (sign == '-' || sign == '+') e++;
+        int power = 0, powerDigits = 0;
+        while ((c = peekAt(reader, e)) >= '0' && c <= '9' && power < 10000 && e < INPUT_TOKEN) {
+            power = power * 10 + (c - '0');
+            powerDigits++;
+            e++;
+        }
+        if (powerDigits > 0) {
+            exponent += sign == '-' ? -power : power;
+            i = e;
+            c = peekAt(reader, i);
+        }
+    }
+    if (digits > 0 && digits <= 19 && mantissa <= (UINT64_C(1) << 53) && exponent >= -22 && exponent <= 22 &&
+        (c == EOF || isSpace(c))) {
+        double result = (double)mantissa;
+        result = exponent < 0 ? result / exactPowers[-exponent] : result * exactPowers[exponent];
+        *value = negative ? -result : result;
+        reader->position += i;
+        return 1;
+    }
+
+    char token[INPUT_TOKEN];
+    size_t length = 0;
+    while (length < sizeof(token) - 1 && (c = peekAt(reader, length)) != EOF && !isSpace(c)) {
+        token[length++] = (char)c;
+    }
+    token[length] = '\0';
+    char* end;
+    *value = strtod(token, &end);
+    reader->position += (size_t)(end - token);
+    return end != token;
+}
+
+int readInputChar(InputReader* reader, int32_t* value) {
+    skipSpace(reader);
+    int c = peekAt(reader, 0);
+    if (c == EOF) return 0;
+    reader->position++;
+    *value = c;
+    return 1;
+}
+
+int readInputWord(InputReader* reader, char* word, size_t size) {
+    skipSpace(reader);
+    size_t length = 0;
+    int c;
+    while (length + 1 < size && (c = peekAt(reader, 0)) != EOF && !isSpace(c)) {
+        word[length++] = (char)c;
+        reader->position++;
+    }
+    word[length] = '\0';
+    return length > 0;
+}
+
+void closeInputReader(InputReader* reader) {
+    if (!reader) return;
+#ifdef INPUT_MAPPING
+    if (reader->mapping) {
+        fseek(reader->file, (long)reader->position, SEEK_SET);
+        munmap(reader->mapping, reader->mappingSize);
+        free(reader);
+        return;
+    }
+#endif
+    if (reader->start >= 0 && !reader->lineByLine) {
+        fseek(reader->file, reader->start + (long)(reader->blockStart + reader->position), SEEK_SET);
+    }
+    free(reader->block);
+    free(reader);
+}
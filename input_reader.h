@@ -0,0 +1,28 @@
+#ifndef INPUT_READER_H
+#define INPUT_READER_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+// Buffered reader behind input(). A redirected regular file is mapped into
+// memory (POSIX) from the stream's current position; a terminal is read a
+// line at a time and anything else (pipes) in large blocks. Each field is
+// scanned by hand the way fscanf reads it: leading whitespace is skipped and
+// only the characters of the field are consumed.
+typedef struct InputReader InputReader;
+
+InputReader* openInputReader(FILE* file);
+
+int readInputInt(InputReader* reader, int32_t* value);    // "%d"; wraps like int arithmetic
+int readInputFloat(InputReader* reader, double* value);   // "%lf"
+int readInputChar(InputReader* reader, int32_t* value);   // " %c"
+int readInputWord(InputReader* reader, char* word, size_t size); // "%s", at most size - 1 characters
+
+int inputInteractive(const InputReader* reader); // Non-zero: reading from a terminal
+
+// Release the reader. A stream that can seek is left just after the last field
+// read; from a pipe, what was read ahead is gone.
+void closeInputReader(InputReader* reader);
+
+#endif // INPUT_READER_H
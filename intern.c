@@ -0,0 +1,325 @@
+#include "intern.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INTERN_INITIAL_SLOTS 64                  // Per shard (1024 across the table)
+#define INTERN_MAX_BACKOFF 1024                   // Pause instructions between lock checks
+
+// Global table used by the lexer front end, parser and later passes
+static InternTable* globalTable = NULL;
+
+// ---------------------------------------
+// Locking (only inserts into concurrent tables lock, one shard at a time)
+// ---------------------------------------
+
+// Tell the core we are spinning so a hyper-thread sibling can use the pipeline
+#if defined(__x86_64__) || defined(__i386__)
+#define cpuRelax() __builtin_ia32_pause()
+#elif defined(__aarch64__) || defined(__arm__)
+#define cpuRelax() __asm__ __volatile__("yield")
+#else
+#define cpuRelax() ((void)0)
+#endif
+
+static void acquireLock(const InternTable* table, InternShard* shard) {
+    if (!table->concurrent) return;
+    unsigned backoff = 1;
+    while (atomic_exchange_explicit(&shard->lock, 1, memory_order_acquire)) {
+        // Spin on a plain load with exponential backoff until the holder releases the shard
+        while (atomic_load_explicit(&shard->lock, memory_order_relaxed)) {
+            for (unsigned i = 0; i < backoff; i++) {
+                cpuRelax();
+            }
+            if (backoff < INTERN_MAX_BACKOFF) {
+                backoff *= 2;
+            }
+        }
+    }
+}
+
+static void releaseLock(const InternTable* table, InternShard* shard) {
+    if (!table->concurrent) return;
+    atomic_store_explicit(&shard->lock, 0, memory_order_release);
+}
+
+// ---------------------------------------
+// Helpers
+// ---------------------------------------
+
+// FNV-1a hash over the raw bytes
+static uint32_t hashBytes(const char* text, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)text[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void* allocOrDie(size_t size) {
+    void* memory = calloc(1, size);
+    if (!memory) {
+        fprintf(stderr, "Error: Memory allocation failed in intern table.\n");
+        exit(EXIT_FAILURE);
+    }
+    return memory;
+}
+
+// The top hash bits pick the shard; the low bits pick the slot inside it
+static InternShard* shardFor(InternTable* table, uint32_t hash) {
+    return &table->shards[hash >> (32 - INTERN_SHARD_BITS)];
+}
+
+static InternSlots* createSlots(uint32_t capacity) {
+    InternSlots* slots = (InternSlots*)allocOrDie(sizeof(InternSlots) + capacity * sizeof(_Atomic uint32_t));
+    slots->mask = capacity - 1;
+    for (uint32_t i = 0; i < capacity; i++) {
+        atomic_init(&slots->ids[i], SYMBOL_NONE);
+    }
+    return slots;
+}
+
+// Copy bytes into the shard's arena and return the stable, null-terminated copy
+static const char* arenaCopy(InternShard* shard, const char* text, size_t length) {
+    InternChunk* chunk = shard->arena;
+    if (!chunk || chunk->used + length + 1 > chunk->capacity) {
+        size_t capacity = INTERN_ARENA_CHUNK;
+        if (length + 1 > capacity) {
+            capacity = length + 1;
+        }
+        InternChunk* fresh = (InternChunk*)allocOrDie(sizeof(InternChunk) + capacity);
+        fresh->capacity = capacity;
+        fresh->next = chunk;
+        shard->arena = fresh;
+        chunk = fresh;
+    }
+
+    char* copy = chunk->data + chunk->used;
+    memcpy(copy, text, length);
+    copy[length] = '\0';
+    chunk->used += length + 1;
+    return copy;
+}
+
+// Return the directory page for `id`, installing it if this is its first entry.
+// Two shards can race for a new page; the loser frees its copy.
+static InternPage* ensurePage(InternTable* table, SymbolId id) {
+    uint32_t index = id >> INTERN_PAGE_BITS;
+    if (index >= INTERN_MAX_PAGES) {
+        fprintf(stderr, "Error: Intern table is full (%u strings).\n",
+                atomic_load_explicit(&table->count, memory_order_relaxed));
+        exit(EXIT_FAILURE);
+    }
+    InternPage* page = atomic_load_explicit(&table->pages[index], memory_order_acquire);
+    if (page) return page;
+
+    InternPage* fresh = (InternPage*)allocOrDie(sizeof(InternPage));
+    if (atomic_compare_exchange_strong_explicit(&table->pages[index], &page, fresh,
+                                                memory_order_acq_rel, memory_order_acquire)) {
+        return fresh;
+    }
+    free(fresh);
+    return page;
+}
+
+static const InternPage* pageOf(const InternTable* table, SymbolId id) {
+    return atomic_load_explicit(&table->pages[id >> INTERN_PAGE_BITS], memory_order_acquire);
+}
+
+// Probe `slots` for `text` without locking. Returns its id, or SYMBOL_NONE with
+// `*empty` set to the slot where it belongs. Ids are loaded with acquire order,
+// so the entry behind any id we see is fully written.
+static SymbolId probe(const InternTable* table, const InternSlots* slots,
+                      const char* text, size_t length, uint32_t hash, uint32_t* empty) {
+    uint32_t slot = hash & slots->mask;
+    while (1) {
+        SymbolId id = atomic_load_explicit(&slots->ids[slot], memory_order_acquire);
+        if (id == SYMBOL_NONE) {
+            *empty = slot;
+            return SYMBOL_NONE;
+        }
+        const InternPage* page = pageOf(table, id);
+        uint32_t index = id & (INTERN_PAGE_SIZE - 1);
+        if (page->hashes[index] == hash && page->lengths[index] == length &&
+            memcmp(page->strings[index], text, length) == 0) {
+            return id;
+        }
+        slot = (slot + 1) & slots->mask;
+    }
+}
+
+// Double a shard's slot array (caller holds the shard). The old array is retired,
+// not freed, because lock-free lookups may still be walking it.
+static void growSlots(InternTable* table, InternShard* shard) {
+    InternSlots* old = atomic_load_explicit(&shard->slots, memory_order_relaxed);
+    InternSlots* grown = createSlots((old->mask + 1) * 2);
+
+    for (uint32_t i = 0; i <= old->mask; i++) {
+        SymbolId id = atomic_load_explicit(&old->ids[i], memory_order_relaxed);
+        if (id == SYMBOL_NONE) continue;
+        uint32_t slot = pageOf(table, id)->hashes[id & (INTERN_PAGE_SIZE - 1)] & grown->mask;
+        while (atomic_load_explicit(&grown->ids[slot], memory_order_relaxed) != SYMBOL_NONE) {
+            slot = (slot + 1) & grown->mask;
+        }
+        atomic_store_explicit(&grown->ids[slot], id, memory_order_relaxed);
+    }
+
+    grown->retired = old;
+    atomic_store_explicit(&shard->slots, grown, memory_order_release);
+}
+
+// ---------------------------------------
+// Table management
+// ---------------------------------------
+
+// Function to create an empty intern table
+InternTable* createInternTable(int concurrent) {
+    InternTable* table = (InternTable*)allocOrDie(sizeof(InternTable));
+    for (uint32_t i = 0; i < INTERN_SHARDS; i++) {
+        atomic_init(&table->shards[i].slots, createSlots(INTERN_INITIAL_SLOTS));
+        atomic_init(&table->shards[i].lock, 0);
+    }
+    for (uint32_t i = 0; i < INTERN_MAX_PAGES; i++) {
+        atomic_init(&table->pages[i], NULL);
+    }
+    atomic_init(&table->count, 0);
+    table->concurrent = concurrent;
+    return table;
+}
+
+// Function to release the table, its pages, its shards and their arenas
+void freeInternTable(InternTable* table) {
+    if (!table) return;
+
+    for (int index = 0; index < INTERN_MAX_PAGES; index++) {
+        free(atomic_load_explicit(&table->pages[index], memory_order_acquire));
+    }
+
+    for (uint32_t i = 0; i < INTERN_SHARDS; i++) {
+        InternShard* shard = &table->shards[i];
+        InternChunk* chunk = shard->arena;
+        while (chunk) {
+            InternChunk* next = chunk->next;
+            free(chunk);
+            chunk = next;
+        }
+        InternSlots* slots = atomic_load_explicit(&shard->slots, memory_order_acquire);
+        while (slots) {
+            InternSlots* retired = slots->retired;
+            free(slots);
+            slots = retired;
+        }
+    }
+
+    free(table);
+}
+
+// ---------------------------------------
+// Explicit-table API
+// ---------------------------------------
+
+// Function to intern `length` bytes of `text`, returning its stable id. Strings
+// already in the table are found without locking; a miss locks its shard and
+// probes again in case another thread inserted it meanwhile.
+SymbolId internStringIn(InternTable* table, const char* text, size_t length) {
+    uint32_t hash = hashBytes(text, length);
+    InternShard* shard = shardFor(table, hash);
+    uint32_t slot;
+
+    InternSlots* slots = atomic_load_explicit(&shard->slots, memory_order_acquire);
+    SymbolId id = probe(table, slots, text, length, hash, &slot);
+    if (id != SYMBOL_NONE) {
+        return id;
+    }
+
+    acquireLock(table, shard);
+
+    if (table->concurrent) {
+        slots = atomic_load_explicit(&shard->slots, memory_order_relaxed);
+        id = probe(table, slots, text, length, hash, &slot);
+    }
+    if (id == SYMBOL_NONE) {
+        // Ids start at 1 so that 0 can mean "not interned"
+        id = atomic_fetch_add_explicit(&table->count, 1, memory_order_relaxed) + 1;
+        InternPage* page = ensurePage(table, id);
+        uint32_t index = id & (INTERN_PAGE_SIZE - 1);
+        page->hashes[index] = hash;
+        page->lengths[index] = (uint32_t)length;
+        page->strings[index] = arenaCopy(shard, text, length);
+
+        // Publish the filled entry to lock-free readers
+        atomic_store_explicit(&slots->ids[slot], id, memory_order_release);
+
+        // Keep the load factor below 1/2 so probe chains stay short
+        shard->used++;
+        if (shard->used * 2 > slots->mask + 1) {
+            growSlots(table, shard);
+        }
+    }
+
+    releaseLock(table, shard);
+    return id;
+}
+
+// Function to look up an already interned string without inserting it (lock-free)
+SymbolId findInternedIn(InternTable* table, const char* text, size_t length) {
+    uint32_t hash = hashBytes(text, length);
+    uint32_t slot;
+    const InternSlots* slots = atomic_load_explicit(&shardFor(table, hash)->slots, memory_order_acquire);
+    return probe(table, slots, text, length, hash, &slot);
+}
+
+// Function to map an id back to its text (lock-free: pages never move, and an
+// id obtained from the table was published after its entry was written)
+const char* internedStringIn(const InternTable* table, SymbolId id) {
+    if (!table || id == SYMBOL_NONE || id > atomic_load_explicit(&table->count, memory_order_acquire)) {
+        return NULL;
+    }
+    const InternPage* page = pageOf(table, id);
+    return page ? page->strings[id & (INTERN_PAGE_SIZE - 1)] : NULL;
+}
+
+// Function to get the byte length of an interned string
+uint32_t internedLengthIn(const InternTable* table, SymbolId id) {
+    if (!table || id == SYMBOL_NONE || id > atomic_load_explicit(&table->count, memory_order_acquire)) {
+        return 0;
+    }
+    const InternPage* page = pageOf(table, id);
+    return page ? page->lengths[id & (INTERN_PAGE_SIZE - 1)] : 0;
+}
+
+// Function to report how many ids a table has handed out (while inserts are in
+// flight this can include entries that are still being published)
+uint32_t internedCountIn(const InternTable* table) {
+    return table ? atomic_load_explicit(&table->count, memory_order_acquire) : 0;
+}
+
+// ---------------------------------------
+// Global table
+// ---------------------------------------
+
+// Function to intern a null-terminated string in the global table
+SymbolId internString(const char* text) {
+    if (!text) return SYMBOL_NONE;
+    if (!globalTable) {
+        globalTable = createInternTable(0);
+    }
+    return internStringIn(globalTable, text, strlen(text));
+}
+
+// Function to resolve an id from the global table
+const char* internedString(SymbolId id) {
+    return internedStringIn(globalTable, id);
+}
+
+// Function to report how many distinct strings the global table holds
+uint32_t internedCount(void) {
+    return internedCountIn(globalTable);
+}
+
+// Function to drop the global table (e.g. between batch jobs) and optionally make it thread-safe
+void resetGlobalInternTable(int concurrent) {
+    freeInternTable(globalTable);
+    globalTable = createInternTable(concurrent);
+}
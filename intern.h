@@ -0,0 +1,86 @@
+#ifndef INTERN_H
+#define INTERN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__STDC_NO_ATOMICS__)
+#error "intern.c needs C11 atomics (<stdatomic.h>) for concurrent tables"
+#endif
+#include <stdatomic.h>
+
+// Symbol ids are dense 32-bit handles; 0 is reserved for "not interned"
+typedef uint32_t SymbolId;
+#define SYMBOL_NONE 0u
+
+#define INTERN_PAGE_BITS 12                        // 4096 entries per directory page
+#define INTERN_PAGE_SIZE (1u << INTERN_PAGE_BITS)
+#define INTERN_MAX_PAGES 4096                      // Up to 16M distinct strings
+#define INTERN_ARENA_CHUNK (64 * 1024)             // Bytes per arena chunk
+#define INTERN_SHARD_BITS 4                        // 16 shards, picked by the top hash bits
+#define INTERN_SHARDS (1u << INTERN_SHARD_BITS)
+
+// Arena chunk holding the interned bytes (never moves once allocated)
+typedef struct InternChunk {
+    struct InternChunk* next;
+    size_t used;
+    size_t capacity;
+    char data[];
+} InternChunk;
+
+// One page of the id -> entry directory (never moves once published)
+typedef struct {
+    const char* strings[INTERN_PAGE_SIZE];
+    uint32_t lengths[INTERN_PAGE_SIZE];
+    uint32_t hashes[INTERN_PAGE_SIZE];             // Cached for probing and growing
+} InternPage;
+
+// A shard's open-addressing slots holding ids (SYMBOL_NONE = empty). When it
+// fills up it is replaced by one twice the size; the old array stays readable
+// for lookups still walking it and is freed with the table.
+typedef struct InternSlots {
+    struct InternSlots* retired;                   // Previous, smaller array
+    uint32_t mask;                                 // Capacity - 1 (power of two)
+    _Atomic uint32_t ids[];
+} InternSlots;
+
+// One shard: its slots, arena and insert lock, padded to a cache line
+typedef struct {
+    _Atomic(InternSlots*) slots;
+    InternChunk* arena;
+    uint32_t used;                                 // Occupied slots
+    atomic_int lock;
+    char padding[64 - 2 * sizeof(void*) - 2 * sizeof(uint32_t)];
+} InternShard;
+
+// Intern table: hash shards of ids plus a paged id -> entry directory.
+// Lookups never lock: an insert fills the entry, then publishes its id in the
+// slot with a release store, and readers load slots with acquire order before
+// touching the entry. In a concurrent table, inserts lock only their shard and
+// re-probe under the lock; ids come from one atomic counter. An id read from
+// the table, or returned by internStringIn, can be resolved from any thread.
+typedef struct {
+    InternShard shards[INTERN_SHARDS];
+    _Atomic uint32_t count;                        // Ids handed out
+    _Atomic(InternPage*) pages[INTERN_MAX_PAGES];
+    int concurrent;                                // Non-zero: inserts take their shard's lock
+} InternTable;
+
+// Table management
+InternTable* createInternTable(int concurrent);
+void freeInternTable(InternTable* table);
+
+// Explicit-table API (use a concurrent table for multi-threaded batch compilation)
+SymbolId internStringIn(InternTable* table, const char* text, size_t length);
+SymbolId findInternedIn(InternTable* table, const char* text, size_t length);
+const char* internedStringIn(const InternTable* table, SymbolId id);
+uint32_t internedLengthIn(const InternTable* table, SymbolId id);
+uint32_t internedCountIn(const InternTable* table);
+
+// Global table shared by all compilation phases of one run
+SymbolId internString(const char* text);
+const char* internedString(SymbolId id);
+uint32_t internedCount(void);
+void resetGlobalInternTable(int concurrent);
+
+#endif // INTERN_H
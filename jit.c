@@ -0,0 +1,778 @@
+#if defined(__linux__) && !defined(_DEFAULT_SOURCE)
+#define _DEFAULT_SOURCE  // MAP_ANONYMOUS under strict -std= modes
+#endif
+
+#include "jit.h"
+#include <stdlib.h>
+#include <string.h>
+#include "arithmetic.h"
+#include "symbol_table.h"
+
+#if defined(__x86_64__) && defined(__linux__)
+#define JIT_X86_64 1
+#include <sys/mman.h>
+#endif
+
+struct JitCode {
+    unsigned char* memory;   // Executable mapping
+    size_t mappedSize;
+    int codeSize;
+    int* offsets;            // Native offset of every instruction (exit stubs for uncovered ones)
+    unsigned char* covered;
+    int codeCount;
+    int pinned;
+};
+
+// Printf, input, strings, switch tables, typed arrays, vector kernels and return stay in the interpreter
+static int coveredOpcode(int opcode) {
+    switch (opcode) {
+        case BC_EQ_S:
+        case BC_NE_S:
+        case BC_HASH_S:
+        case BC_SWITCH:
+        case BC_INPUT:
+        case BC_PRINT:
+        case BC_RETURN:
+            return 0;
+        default:
+            if (opcode >= BC_NEW_ARRAY_I && opcode <= BC_VECTOR_SUM_F) return 0;
+            return opcode >= 0 && opcode < BC_OPCODE_COUNT;
+    }
+}
+
+int jitCovers(const JitCode* jit, int pc) {
+    return jit && pc >= 0 && pc < jit->codeCount && jit->covered[pc];
+}
+
+int jitCodeSize(const JitCode* jit) {
+    return jit ? jit->codeSize : 0;
+}
+
+int jitPinnedRegisters(const JitCode* jit) {
+    return jit ? jit->pinned : 0;
+}
+
+void freeJit(JitCode* jit) {
+    if (!jit) return;
+#ifdef JIT_X86_64
+    if (jit->memory) munmap(jit->memory, jit->mappedSize);
+#endif
+    free(jit->offsets);
+    free(jit->covered);
+    free(jit);
+}
+
+#ifndef JIT_X86_64
+
+JitCode* compileJit(const BytecodeProgram* program) {
+    (void)program;
+    return NULL;
+}
+
+int32_t runJit(const JitCode* jit, Value* registers, int pc) {
+    (void)jit;
+    (void)registers;
+    return pc;
+}
+
+#else
+
+// ---------------------------------------
+// x86-64 encoding
+// ---------------------------------------
+
+enum { RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI, R8, R9, R10, R11, R12, R13, R14, R15 };
+enum { XMM0, XMM1 };
+
+// Condition codes: the low nibble of jcc and setcc
+enum { CC_B = 0x2, CC_AE = 0x3, CC_E = 0x4, CC_NE = 0x5, CC_A = 0x7, CC_NS = 0x9,
+       CC_P = 0xA, CC_NP = 0xB, CC_L = 0xC, CC_GE = 0xD, CC_LE = 0xE, CC_G = 0xF };
+
+// Machine registers handed to bytecode registers, best first. rbx holds the
+// register file; rax, rcx, rdx, rsi, rdi, xmm0 and xmm1 are scratch.
+static const int intPins[JIT_INT_REGISTERS] = {R12, R13, R14, R15, RBP, R8, R9, R10, R11};
+#define INT_PIN_COUNT JIT_INT_REGISTERS
+#define FLOAT_PIN_FIRST 2
+#define FLOAT_PIN_COUNT JIT_FLOAT_REGISTERS
+#define IN_MEMORY (-1)
+#define XMM_LOCATION 16  // location >= this: xmm(location - XMM_LOCATION)
+
+// A register operand, or [rbx + disp] (a slot in the register file)
+typedef struct {
+    int memory;
+    int reg;
+    int32_t disp;
+} Operand;
+
+typedef struct {
+    int position;  // Where the rel32 starts
+    int target;    // Instruction index
+} JumpPatch;
+
+typedef struct {
+    const BytecodeProgram* program;
+    unsigned char* bytes;
+    int count;
+    int capacity;
+    int* location;      // Per bytecode register: machine register, or IN_MEMORY
+    int* offsets;
+    JumpPatch* patches;
+    int patchCount;
+    int patchCapacity;
+    int epilogue;       // Offset of the shared exit path
+} Assembler;
+
+static void* allocateJit(size_t count, size_t size) {
+    void* memory = calloc(count ? count : 1, size);
+    if (!memory) {
+        fprintf(stderr, "Error: Memory allocation failed for JIT.\n");
+        exit(EXIT_FAILURE);
+    }
+    return memory;
+}
+
+static void emitByte(Assembler* as, int value) {
+    if (as->count == as->capacity) {
+        as->capacity = as->capacity ? as->capacity * 2 : 4096;
+        as->bytes = (unsigned char*)realloc(as->bytes, (size_t)as->capacity);
+        if (!as->bytes) {
+            fprintf(stderr, "Error: Memory allocation failed for JIT.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    as->bytes[as->count++] = (unsigned char)value;
+}
+
+static void emitDword(Assembler* as, int32_t value) {
+    uint32_t bits = (uint32_t)value;
+    for (int i = 0; i < 4; i++) emitByte(as, (int)((bits >> (8 * i)) & 0xFF));
+}
+
+static void emitQword(Assembler* as, uint64_t value) {
+    for (int i = 0; i < 8; i++) emitByte(as, (int)((value >> (8 * i)) & 0xFF));
+}
+
+static void patchDword(Assembler* as, int position, int32_t value) {
+    uint32_t bits = (uint32_t)value;
+    for (int i = 0; i < 4; i++) as->bytes[position + i] = (unsigned char)((bits >> (8 * i)) & 0xFF);
+}
+
+static Operand machineRegister(int reg) {
+    Operand operand = {0, reg, 0};
+    return operand;
+}
+
+// Function to find where bytecode register `r` lives while native code runs
+static Operand slot(const Assembler* as, int r) {
+    int location = as->location[r];
+    if (location == IN_MEMORY) {
+        Operand operand = {1, RBX, r * (int32_t)sizeof(Value)};
+        return operand;
+    }
+    return machineRegister(location >= XMM_LOCATION ? location - XMM_LOCATION : location);
+}
+
+// Function to emit [prefix] [REX] opcode ModRM [disp]: `reg` is the ModRM reg field
+// (a register or an opcode extension), `rm` the register or memory operand.
+// `opcode` packs 1-3 bytes, most significant first.
+static void emitOp(Assembler* as, int prefix, int wide, uint32_t opcode, int opcodeLength, int reg, Operand rm) {
+    if (prefix) emitByte(as, prefix);
+    int rex = 0x40 | (wide ? 8 : 0) | ((reg & 8) ? 4 : 0) | (!rm.memory && (rm.reg & 8) ? 1 : 0);
+    if (rex != 0x40) emitByte(as, rex);
+    for (int i = opcodeLength - 1; i >= 0; i--) emitByte(as, (int)((opcode >> (8 * i)) & 0xFF));
+
+    if (!rm.memory) {
+        emitByte(as, 0xC0 | ((reg & 7) << 3) | (rm.reg & 7));
+    } else if (rm.disp >= -128 && rm.disp <= 127) {
+        emitByte(as, 0x40 | ((reg & 7) << 3) | (rm.reg & 7));
+        emitByte(as, rm.disp & 0xFF);
+    } else {
+        emitByte(as, 0x80 | ((reg & 7) << 3) | (rm.reg & 7));
+        emitDword(as, rm.disp);
+    }
+}
+
+static int sameRegister(Operand operand, int reg) {
+    return !operand.memory && operand.reg == reg;
+}
+
+static void loadInt(Assembler* as, int reg, int r) {
+    Operand from = slot(as, r);
+    if (!sameRegister(from, reg)) emitOp(as, 0, 0, 0x8B, 1, reg, from);   // mov r32, r/m32
+}
+
+static void storeInt(Assembler* as, int r, int reg) {
+    Operand to = slot(as, r);
+    if (!sameRegister(to, reg)) emitOp(as, 0, 0, 0x89, 1, reg, to);       // mov r/m32, r32
+}
+
+static void loadFloat(Assembler* as, int xmm, int r) {
+    Operand from = slot(as, r);
+    if (sameRegister(from, xmm)) return;
+    if (from.memory) emitOp(as, 0xF2, 0, 0x0F10, 2, xmm, from);          // movsd xmm, m64
+    else emitOp(as, 0x66, 0, 0x0F28, 2, xmm, from);                      // movapd xmm, xmm
+}
+
+static void storeFloat(Assembler* as, int r, int xmm) {
+    Operand to = slot(as, r);
+    if (sameRegister(to, xmm)) return;
+    if (to.memory) emitOp(as, 0xF2, 0, 0x0F11, 2, xmm, to);              // movsd m64, xmm
+    else emitOp(as, 0x66, 0, 0x0F28, 2, to.reg, machineRegister(xmm));
+}
+
+static void moveImmediate(Assembler* as, Operand to, int32_t value) {
+    if (to.memory) {
+        emitOp(as, 0, 0, 0xC7, 1, 0, to);                                // mov r/m32, imm32
+    } else {
+        if (to.reg & 8) emitByte(as, 0x41);
+        emitByte(as, 0xB8 + (to.reg & 7));                               // mov r32, imm32
+    }
+    emitDword(as, value);
+}
+
+static void moveImmediate64(Assembler* as, int reg, uint64_t value) {
+    emitByte(as, 0x48 | ((reg & 8) ? 1 : 0));
+    emitByte(as, 0xB8 + (reg & 7));                                      // mov r64, imm64
+    emitQword(as, value);
+}
+
+// Function to emit `op r/m32, imm32` for an 0x81 group opcode (0 add, 4 and, 5 sub, 7 cmp)
+static void emitGroupImmediate(Assembler* as, int extension, Operand to, int32_t value) {
+    if (value >= -128 && value <= 127) {
+        emitOp(as, 0, 0, 0x83, 1, extension, to);
+        emitByte(as, value & 0xFF);
+    } else {
+        emitOp(as, 0, 0, 0x81, 1, extension, to);
+        emitDword(as, value);
+    }
+}
+
+static void emitSetCondition(Assembler* as, int cc, int reg) {
+    emitOp(as, 0, 0, 0x0F90 | (uint32_t)cc, 2, 0, machineRegister(reg)); // setcc r8 (al or cl)
+}
+
+// Function to jump (cc < 0: always) to instruction `target`, patched once every offset is known
+static void emitJumpTo(Assembler* as, int cc, int target) {
+    if (cc < 0) {
+        emitByte(as, 0xE9);
+    } else {
+        emitByte(as, 0x0F);
+        emitByte(as, 0x80 | cc);
+    }
+    if (as->patchCount == as->patchCapacity) {
+        as->patchCapacity = as->patchCapacity ? as->patchCapacity * 2 : 64;
+        as->patches = (JumpPatch*)realloc(as->patches, (size_t)as->patchCapacity * sizeof(JumpPatch));
+        if (!as->patches) {
+            fprintf(stderr, "Error: Memory allocation failed for JIT.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    as->patches[as->patchCount].position = as->count;
+    as->patches[as->patchCount].target = target;
+    as->patchCount++;
+    emitDword(as, 0);
+}
+
+// Function to leave native code, returning `value` to the interpreter
+static void emitExit(Assembler* as, int32_t value) {
+    moveImmediate(as, machineRegister(RAX), value);
+    emitByte(as, 0xE9);
+    emitDword(as, as->epilogue - (as->count + 4));
+}
+
+// Short forward jumps inside one instruction's code: emit, then patch at the destination
+static int emitShortJump(Assembler* as, int cc) {
+    emitByte(as, cc < 0 ? 0xEB : 0x70 | cc);
+    emitByte(as, 0);
+    return as->count - 1;
+}
+
+static void patchShortJump(Assembler* as, int position) {
+    as->bytes[position] = (unsigned char)(as->count - (position + 1));
+}
+
+// ---------------------------------------
+// Register allocation
+// ---------------------------------------
+
+// Function to list the registers an instruction reads or writes
+static int registerOperands(const BytecodeInstruction* in, int operands[3]) {
+    BytecodeInstruction copy = *in;
+    int32_t* fields[3];
+    int count = bytecodeRegisterOperands(&copy, fields);
+    for (int i = 0; i < count; i++) operands[i] = *fields[i];
+    return count;
+}
+
+// Function to keep the most used int and float registers in machine registers.
+// A use counts 8x more for every loop (backward jump range) around it. Slots
+// assignRegisterSlots() pinned keep the machine register it chose.
+static int allocateRegisters(Assembler* as) {
+    const BytecodeProgram* program = as->program;
+    if (program->registerPins) {
+        int pinned = 0;
+        for (int r = 0; r < program->registerCount; r++) {
+            int pin = program->registerPins[r];
+            as->location[r] = IN_MEMORY;
+            if (pin == 0) continue;
+            if (program->registerTypes[r] == TYPE_FLOAT) {
+                as->location[r] = XMM_LOCATION + FLOAT_PIN_FIRST + pin - 1;
+            } else {
+                as->location[r] = intPins[pin - 1];
+            }
+            pinned++;
+        }
+        return pinned;
+    }
+
+    int* depth = (int*)allocateJit((size_t)program->codeCount, sizeof(int));
+    for (int pc = 0; pc < program->codeCount; pc++) {
+        BytecodeInstruction in = program->code[pc];
+        int32_t* target = bytecodeJumpTarget(&in);
+        if (target && *target <= pc) {
+            for (int k = *target; k <= pc; k++) depth[k]++;
+        }
+    }
+
+    double* score = (double*)allocateJit((size_t)program->registerCount, sizeof(double));
+    for (int pc = 0; pc < program->codeCount; pc++) {
+        int operands[3];
+        int count = registerOperands(&program->code[pc], operands);
+        double weight = 1.0;
+        for (int k = 0; k < depth[pc] && k < 6; k++) weight *= 8.0;
+        for (int i = 0; i < count; i++) {
+            if (operands[i] >= 0 && operands[i] < program->registerCount) score[operands[i]] += weight;
+        }
+    }
+
+    for (int r = 0; r < program->registerCount; r++) as->location[r] = IN_MEMORY;
+    int ints = 0, floats = 0;
+    for (;;) {
+        int best = -1;
+        for (int r = 0; r < program->registerCount; r++) {
+            if (score[r] <= 0.0) continue;
+            int type = program->registerTypes[r];
+            int isFloat = type == TYPE_FLOAT;
+            int isInt = type == TYPE_INT || type == TYPE_CHAR || type == TYPE_BOOL;
+            if ((isFloat && floats < FLOAT_PIN_COUNT) || (isInt && ints < INT_PIN_COUNT)) {
+                if (best < 0 || score[r] > score[best]) best = r;
+            }
+        }
+        if (best < 0) break;
+        if (program->registerTypes[best] == TYPE_FLOAT) {
+            as->location[best] = XMM_LOCATION + FLOAT_PIN_FIRST + floats++;
+        } else {
+            as->location[best] = intPins[ints++];
+        }
+        score[best] = 0.0;
+    }
+    free(depth);
+    free(score);
+    return ints + floats;
+}
+
+static int callerSaved(int location) {
+    return location >= XMM_LOCATION || (location >= R8 && location <= R11);
+}
+
+// Function to move pinned registers between machine registers and the register file
+// (`toMemory`), all of them or only those a call may clobber
+static void transferPinned(Assembler* as, int toMemory, int onlyCallerSaved) {
+    for (int r = 0; r < as->program->registerCount; r++) {
+        int location = as->location[r];
+        if (location == IN_MEMORY || (onlyCallerSaved && !callerSaved(location))) continue;
+        Operand memory = {1, RBX, r * (int32_t)sizeof(Value)};
+        if (location >= XMM_LOCATION) {
+            emitOp(as, 0xF2, 0, toMemory ? 0x0F11 : 0x0F10, 2, location - XMM_LOCATION, memory);
+        } else {
+            emitOp(as, 0, 0, toMemory ? 0x89 : 0x8B, 1, location, memory);
+        }
+    }
+}
+
+// ---------------------------------------
+// Instructions
+// ---------------------------------------
+
+static int32_t callIntPow(int32_t base, int32_t exponent) {
+    return intPow(base, exponent);
+}
+
+static double callFloatPow(double base, int32_t exponent) {
+    return floatPow(base, exponent);
+}
+
+static void emitCall(Assembler* as, uint64_t function) {
+    moveImmediate64(as, RAX, function);
+    emitOp(as, 0, 0, 0xFF, 1, 2, machineRegister(RAX));                  // call rax
+}
+
+// Function to pick the register an int result is computed in: a's own when it is
+// pinned and not also the right operand, else rax
+static int intTarget(const Assembler* as, int a, int right) {
+    Operand to = slot(as, a);
+    return (!to.memory && a != right) ? to.reg : RAX;
+}
+
+static int floatTarget(const Assembler* as, int a, int right) {
+    Operand to = slot(as, a);
+    return (!to.memory && a != right) ? to.reg : XMM0;
+}
+
+// Function to compile a // or % (constant divisor when `constant`): floor semantics from
+// arithmetic.h, with a zero divisor leaving native code before anything is written
+static void compileDivision(Assembler* as, const BytecodeInstruction* in, int pc, int modulo, int constant) {
+    int32_t divisor = in->c;
+    if (constant && divisor == -1) {
+        if (modulo) {
+            moveImmediate(as, slot(as, in->a), 0);
+        } else {
+            loadInt(as, RAX, in->b);
+            emitOp(as, 0, 0, 0xF7, 1, 3, machineRegister(RAX));          // neg eax
+            storeInt(as, in->a, RAX);
+        }
+        return;
+    }
+    if (constant && divisor > 0 && (divisor & (divisor - 1)) == 0) {
+        // Floor division and modulo by 2^k are an arithmetic shift and a mask
+        int shift = 0;
+        while ((1 << shift) != divisor) shift++;
+        loadInt(as, RAX, in->b);
+        if (modulo) {
+            emitGroupImmediate(as, 4, machineRegister(RAX), divisor - 1); // and eax, 2^k - 1
+        } else if (shift) {
+            emitOp(as, 0, 0, 0xC1, 1, 7, machineRegister(RAX));          // sar eax, k
+            emitByte(as, shift);
+        }
+        storeInt(as, in->a, RAX);
+        return;
+    }
+
+    int minusOne = -1;
+    if (constant) {
+        moveImmediate(as, machineRegister(RCX), divisor);
+    } else {
+        loadInt(as, RCX, in->c);
+        emitOp(as, 0, 0, 0x85, 1, RCX, machineRegister(RCX));            // test ecx, ecx
+        int nonZero = emitShortJump(as, CC_NE);
+        emitExit(as, ~pc);
+        patchShortJump(as, nonZero);
+
+        emitGroupImmediate(as, 7, machineRegister(RCX), -1);             // cmp ecx, -1
+        int general = emitShortJump(as, CC_NE);
+        loadInt(as, RAX, in->b);
+        if (modulo) emitOp(as, 0, 0, 0x33, 1, RAX, machineRegister(RAX)); // xor eax, eax
+        else emitOp(as, 0, 0, 0xF7, 1, 3, machineRegister(RAX));         // neg eax
+        minusOne = emitShortJump(as, -1);
+        patchShortJump(as, general);
+    }
+
+    loadInt(as, RAX, in->b);
+    emitByte(as, 0x99);                                                  // cdq
+    emitOp(as, 0, 0, 0xF7, 1, 7, machineRegister(RCX));                  // idiv ecx
+    emitOp(as, 0, 0, 0x85, 1, RDX, machineRegister(RDX));                // test edx, edx
+    int exact = emitShortJump(as, CC_E);
+    if (modulo) {
+        emitOp(as, 0, 0, 0x8B, 1, RAX, machineRegister(RDX));            // mov eax, edx
+        emitOp(as, 0, 0, 0x33, 1, RAX, machineRegister(RCX));            // xor eax, ecx
+        int sameSign = emitShortJump(as, CC_NS);
+        emitOp(as, 0, 0, 0x03, 1, RDX, machineRegister(RCX));            // add edx, ecx
+        patchShortJump(as, sameSign);
+        patchShortJump(as, exact);
+        emitOp(as, 0, 0, 0x8B, 1, RAX, machineRegister(RDX));            // mov eax, edx
+    } else {
+        emitOp(as, 0, 0, 0x33, 1, RDX, machineRegister(RCX));            // xor edx, ecx
+        int sameSign = emitShortJump(as, CC_NS);
+        emitGroupImmediate(as, 5, machineRegister(RAX), 1);              // sub eax, 1
+        patchShortJump(as, sameSign);
+        patchShortJump(as, exact);
+    }
+    if (minusOne >= 0) patchShortJump(as, minusOne);
+    storeInt(as, in->a, RAX);
+}
+
+static void compileIntCompare(Assembler* as, const BytecodeInstruction* in, int cc) {
+    loadInt(as, RAX, in->b);
+    emitOp(as, 0, 0, 0x3B, 1, RAX, slot(as, in->c));                     // cmp eax, r/m32
+    emitSetCondition(as, cc, RAX);
+    emitOp(as, 0, 0, 0x0FB6, 2, RAX, machineRegister(RAX));              // movzx eax, al
+    storeInt(as, in->a, RAX);
+}
+
+// Function to compile a float comparison with C's NaN behaviour: only != is true for NaN.
+// < and <= swap the operands so every ordered test reads "above" (false when unordered).
+static void compileFloatCompare(Assembler* as, const BytecodeInstruction* in) {
+    int swap = in->opcode == BC_LT_F || in->opcode == BC_LE_F;
+    loadFloat(as, XMM0, swap ? in->c : in->b);
+    emitOp(as, 0x66, 0, 0x0F2E, 2, XMM0, slot(as, swap ? in->b : in->c)); // ucomisd
+    switch (in->opcode) {
+        case BC_EQ_F:
+            emitSetCondition(as, CC_E, RAX);
+            emitSetCondition(as, CC_NP, RCX);
+            emitOp(as, 0, 0, 0x20, 1, RCX, machineRegister(RAX));        // and al, cl
+            break;
+        case BC_NE_F:
+            emitSetCondition(as, CC_NE, RAX);
+            emitSetCondition(as, CC_P, RCX);
+            emitOp(as, 0, 0, 0x08, 1, RCX, machineRegister(RAX));        // or al, cl
+            break;
+        case BC_LT_F:
+        case BC_GT_F:
+            emitSetCondition(as, CC_A, RAX);
+            break;
+        default:
+            emitSetCondition(as, CC_AE, RAX);
+            break;
+    }
+    emitOp(as, 0, 0, 0x0FB6, 2, RAX, machineRegister(RAX));              // movzx eax, al
+    storeInt(as, in->a, RAX);
+}
+
+static void compileMove(Assembler* as, const BytecodeInstruction* in) {
+    if (in->a == in->b) return;
+    int type = as->program->registerTypes[in->a];
+    Operand to = slot(as, in->a);
+    Operand from = slot(as, in->b);
+
+    if (type == TYPE_FLOAT) {
+        if (!to.memory) loadFloat(as, to.reg, in->b);
+        else if (!from.memory) storeFloat(as, in->a, from.reg);
+        else {
+            loadFloat(as, XMM0, in->b);
+            storeFloat(as, in->a, XMM0);
+        }
+    } else if (as->location[in->a] != IN_MEMORY || as->location[in->b] != IN_MEMORY) {
+        if (!to.memory) loadInt(as, to.reg, in->b);
+        else storeInt(as, in->a, from.reg);
+    } else {
+        emitOp(as, 0, 1, 0x8B, 1, RAX, from);                            // Whole Value: strings too
+        emitOp(as, 0, 1, 0x89, 1, RAX, to);
+    }
+}
+
+static const int branchConditions[6] = {CC_E, CC_NE, CC_L, CC_LE, CC_G, CC_GE};
+static const uint32_t floatOpcodes[] = {0x0F58, 0x0F5C, 0x0F59, 0x0F5E}; // addsd subsd mulsd divsd
+
+static void compileInstruction(Assembler* as, const BytecodeInstruction* in, int pc) {
+    int opcode = in->opcode;
+    switch (opcode) {
+        case BC_LOAD_INT:
+            moveImmediate(as, slot(as, in->a), in->b);
+            break;
+
+        case BC_LOAD_FLOAT:
+        case BC_LOAD_STRING: {
+            uint64_t bits;
+            if (opcode == BC_LOAD_FLOAT) memcpy(&bits, &as->program->floats[in->b], sizeof(bits));
+            else bits = (uint64_t)(uintptr_t)as->program->strings[in->b];
+            moveImmediate64(as, RAX, bits);
+            Operand to = slot(as, in->a);
+            if (to.memory) emitOp(as, 0, 1, 0x89, 1, RAX, to);            // mov m64, rax
+            else emitOp(as, 0x66, 1, 0x0F6E, 2, to.reg, machineRegister(RAX)); // movq xmm, rax
+            break;
+        }
+
+        case BC_MOVE:
+            compileMove(as, in);
+            break;
+
+        case BC_INT_TO_FLOAT: {
+            int target = floatTarget(as, in->a, -1);
+            emitOp(as, 0x66, 0, 0x0F57, 2, target, machineRegister(target)); // xorpd: no false dependency
+            emitOp(as, 0xF2, 0, 0x0F2A, 2, target, slot(as, in->b));      // cvtsi2sd xmm, r/m32
+            storeFloat(as, in->a, target);
+            break;
+        }
+
+        case BC_ADD_I:
+        case BC_SUB_I:
+        case BC_MUL_I: {
+            int target = intTarget(as, in->a, in->c);
+            loadInt(as, target, in->b);
+            if (opcode == BC_MUL_I) emitOp(as, 0, 0, 0x0FAF, 2, target, slot(as, in->c)); // imul
+            else emitOp(as, 0, 0, opcode == BC_ADD_I ? 0x03 : 0x2B, 1, target, slot(as, in->c));
+            storeInt(as, in->a, target);
+            break;
+        }
+
+        case BC_ADD_IK: {
+            int target = intTarget(as, in->a, -1);
+            loadInt(as, target, in->b);
+            emitGroupImmediate(as, 0, machineRegister(target), in->c);
+            storeInt(as, in->a, target);
+            break;
+        }
+
+        case BC_MUL_IK: {
+            int target = intTarget(as, in->a, -1);
+            emitOp(as, 0, 0, 0x69, 1, target, slot(as, in->b));           // imul r32, r/m32, imm32
+            emitDword(as, in->c);
+            storeInt(as, in->a, target);
+            break;
+        }
+
+        case BC_FLOOR_DIV_I:
+        case BC_MOD_I:
+        case BC_FLOOR_DIV_IK:
+        case BC_MOD_IK:
+            compileDivision(as, in, pc, opcode == BC_MOD_I || opcode == BC_MOD_IK,
+                            opcode == BC_FLOOR_DIV_IK || opcode == BC_MOD_IK);
+            break;
+
+        case BC_POW_I:
+        case BC_POW_F:
+            // Arguments are read before the call; pins it may clobber go through memory
+            transferPinned(as, 1, 1);
+            if (opcode == BC_POW_F) loadFloat(as, XMM0, in->b);
+            else loadInt(as, RDI, in->b);
+            loadInt(as, opcode == BC_POW_F ? RDI : RSI, in->c);
+            emitCall(as, opcode == BC_POW_F ? (uint64_t)(uintptr_t)&callFloatPow
+                                            : (uint64_t)(uintptr_t)&callIntPow);
+            transferPinned(as, 0, 1);
+            if (opcode == BC_POW_F) storeFloat(as, in->a, XMM0);
+            else storeInt(as, in->a, RAX);
+            break;
+
+        case BC_ADD_F:
+        case BC_SUB_F:
+        case BC_MUL_F:
+        case BC_DIV_F: {
+            int target = floatTarget(as, in->a, in->c);
+            loadFloat(as, target, in->b);
+            emitOp(as, 0xF2, 0, floatOpcodes[opcode - BC_ADD_F], 2, target, slot(as, in->c));
+            storeFloat(as, in->a, target);
+            break;
+        }
+
+        case BC_EQ_I: case BC_NE_I: case BC_LT_I:
+        case BC_LE_I: case BC_GT_I: case BC_GE_I:
+            compileIntCompare(as, in, branchConditions[opcode - BC_EQ_I]);
+            break;
+
+        case BC_EQ_F: case BC_NE_F: case BC_LT_F:
+        case BC_LE_F: case BC_GT_F: case BC_GE_F:
+            compileFloatCompare(as, in);
+            break;
+
+        case BC_NOT:
+            loadInt(as, RAX, in->b);
+            emitOp(as, 0, 0, 0x85, 1, RAX, machineRegister(RAX));        // test eax, eax
+            emitSetCondition(as, CC_E, RAX);
+            emitOp(as, 0, 0, 0x0FB6, 2, RAX, machineRegister(RAX));
+            storeInt(as, in->a, RAX);
+            break;
+
+        case BC_JUMP:
+            if (in->a != pc + 1) emitJumpTo(as, -1, in->a);
+            break;
+
+        case BC_JUMP_IF_TRUE:
+        case BC_JUMP_IF_FALSE: {
+            Operand condition = slot(as, in->a);
+            if (condition.memory) emitGroupImmediate(as, 7, condition, 0); // cmp dword [m], 0
+            else emitOp(as, 0, 0, 0x85, 1, condition.reg, condition);      // test r32, r32
+            emitJumpTo(as, opcode == BC_JUMP_IF_TRUE ? CC_NE : CC_E, in->b);
+            break;
+        }
+
+        default:
+            if (opcode >= BC_BRANCH_EQ_I && opcode <= BC_BRANCH_GE_I) {
+                Operand left = slot(as, in->a);
+                if (left.memory) {
+                    loadInt(as, RAX, in->a);
+                    left = machineRegister(RAX);
+                }
+                emitOp(as, 0, 0, 0x3B, 1, left.reg, slot(as, in->b));     // cmp r32, r/m32
+                emitJumpTo(as, branchConditions[opcode - BC_BRANCH_EQ_I], in->c);
+            } else if (opcode >= BC_BRANCH_EQ_IK && opcode <= BC_BRANCH_GE_IK) {
+                emitGroupImmediate(as, 7, slot(as, in->a), in->b);        // cmp r/m32, imm
+                emitJumpTo(as, branchConditions[opcode - BC_BRANCH_EQ_IK], in->c);
+            }
+            break;
+    }
+}
+
+// ---------------------------------------
+// Compilation
+// ---------------------------------------
+
+// Native entry: int32_t code(Value* registers, const void* target). The prologue
+// saves the callee-saved registers, loads the pins and jumps to `target`; every
+// exit stores the pins back and returns the value left in eax.
+static void emitPrologueAndEpilogue(Assembler* as) {
+    static const unsigned char saves[] = {0x53, 0x55, 0x41, 0x54, 0x41, 0x55, 0x41, 0x56, 0x41, 0x57};
+    static const unsigned char restores[] = {0x41, 0x5F, 0x41, 0x5E, 0x41, 0x5D, 0x41, 0x5C, 0x5D, 0x5B};
+    for (size_t i = 0; i < sizeof(saves); i++) emitByte(as, saves[i]);   // push rbx, rbp, r12-r15
+    emitByte(as, 0x48); emitByte(as, 0x83); emitByte(as, 0xEC); emitByte(as, 0x08); // sub rsp, 8: align calls
+    emitOp(as, 0, 1, 0x89, 1, RDI, machineRegister(RBX));                // mov rbx, rdi
+    transferPinned(as, 0, 0);
+    emitOp(as, 0, 0, 0xFF, 1, 4, machineRegister(RSI));                  // jmp rsi
+
+    as->epilogue = as->count;
+    transferPinned(as, 1, 0);
+    emitByte(as, 0x48); emitByte(as, 0x83); emitByte(as, 0xC4); emitByte(as, 0x08); // add rsp, 8
+    for (size_t i = 0; i < sizeof(restores); i++) emitByte(as, restores[i]);
+    emitByte(as, 0xC3);                                                  // ret
+}
+
+JitCode* compileJit(const BytecodeProgram* program) {
+    if (sizeof(Value) != 8 || program->codeCount == 0) return NULL;
+
+    Assembler as;
+    memset(&as, 0, sizeof(as));
+    as.program = program;
+    as.location = (int*)allocateJit((size_t)program->registerCount, sizeof(int));
+    as.offsets = (int*)allocateJit((size_t)program->codeCount, sizeof(int));
+
+    JitCode* jit = (JitCode*)allocateJit(1, sizeof(JitCode));
+    jit->codeCount = program->codeCount;
+    jit->covered = (unsigned char*)allocateJit((size_t)program->codeCount, 1);
+    jit->pinned = allocateRegisters(&as);
+    emitPrologueAndEpilogue(&as);
+
+    // Uncovered instructions compile to an exit that hands their index to the interpreter
+    for (int pc = 0; pc < program->codeCount; pc++) {
+        as.offsets[pc] = as.count;
+        jit->covered[pc] = (unsigned char)coveredOpcode(program->code[pc].opcode);
+        if (jit->covered[pc]) compileInstruction(&as, &program->code[pc], pc);
+        else emitExit(&as, pc);
+    }
+    for (int i = 0; i < as.patchCount; i++) {
+        const JumpPatch* patch = &as.patches[i];
+        patchDword(&as, patch->position, as.offsets[patch->target] - (patch->position + 4));
+    }
+
+    // Written while writable, then flipped to executable
+    size_t page = 4096;
+    jit->mappedSize = ((size_t)as.count + page - 1) / page * page;
+    void* memory = mmap(NULL, jit->mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory != MAP_FAILED) {
+        memcpy(memory, as.bytes, (size_t)as.count);
+        if (mprotect(memory, jit->mappedSize, PROT_READ | PROT_EXEC) == 0) {
+            jit->memory = (unsigned char*)memory;
+        } else {
+            munmap(memory, jit->mappedSize);
+        }
+    }
+    jit->codeSize = as.count;
+    jit->offsets = as.offsets;
+    free(as.bytes);
+    free(as.location);
+    free(as.patches);
+    if (!jit->memory) {
+        freeJit(jit);
+        return NULL;
+    }
+    return jit;
+}
+
+typedef int32_t (*NativeCode)(Value* registers, const void* target);
+
+int32_t runJit(const JitCode* jit, Value* registers, int pc) {
+    NativeCode code;
+    void* entry = jit->memory;
+    memcpy(&code, &entry, sizeof(code)); // Object to function pointer without a pedantic cast
+    return code(registers, jit->memory + jit->offsets[pc]);
+}
+
+#endif // JIT_X86_64
@@ -0,0 +1,35 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include <stdint.h>
+#include "bytecode.h"
+#include "vm.h"
+
+// Baseline x86-64 compiler for the bytecode's numeric instructions. Each
+// covered instruction becomes machine code in one mmap'd block; printf,
+// input, string comparisons and return are left to the interpreter, which
+// enters the native code at the instruction after them. The most used int
+// and float registers of loops live in machine registers while native code
+// runs and are written back to the register file when it exits.
+typedef struct JitCode JitCode;
+
+// Machine registers available to bytecode registers, for assignRegisterSlots()
+#define JIT_INT_REGISTERS 9
+#define JIT_FLOAT_REGISTERS 14
+
+// Compile `program`; NULL where the JIT is unavailable (not x86-64 Linux, or
+// no executable memory), in which case the caller just interprets.
+JitCode* compileJit(const BytecodeProgram* program);
+
+int jitCovers(const JitCode* jit, int pc);    // Non-zero: instruction `pc` has native code
+
+// Run native code from covered instruction `pc` over `registers`. Returns the
+// uncovered instruction to interpret next, or ~pc of an int division or
+// modulo by zero (not executed, so the interpreter can report it).
+int32_t runJit(const JitCode* jit, Value* registers, int pc);
+
+int jitCodeSize(const JitCode* jit);          // Bytes of machine code
+int jitPinnedRegisters(const JitCode* jit);   // Bytecode registers kept in machine registers
+void freeJit(JitCode* jit);
+
+#endif // JIT_H
@@ -8,6 +8,7 @@
 #include "utils.h"
 #include "comment_handler.h"
 #include "config.h"
+#include "source_map.h"
 
 int main() {
     // Initialize files
@@ -16,33 +17,40 @@ int main() {
         return 1; // Error already handled in `initializeFiles`
     }
 
+    // Read the whole source once and index its line starts
+    SourceMap *source = readSourceMap(handles->sourceFile, handles->fileName);
+
+    // Line buffer large enough for the longest source line
+    size_t longestLine = 0;
+    for (int i = 1; i <= source->lineCount; i++) {
+        size_t length = sourceLineLength(source, i);
+        if (length > longestLine) longestLine = length;
+    }
+    char *line = (char *)malloc(longestLine + 1);
+    if (!line) {
+        fprintf(stderr, "Error: Memory allocation failed for line buffer.\n");
+        freeSourceMap(source);
+        closeFiles(handles);
+        return 1;
+    }
+
     // Process the source file line by line
-    char line[256];
     int lineNumber = 1;
     int inComment = 0; // Multi-line comment flag
 
-    while (fgets(line, sizeof(line), handles->sourceFile)) {
-        // Trim whitespace
-        trimWhitespace(line);
-
-        // Skip empty lines
-        if (strlen(line) == 0) {
-            lineNumber++;
-            continue;
-        }
-
-        // Handle multi-line comments
-        if (handleComments(line, &inComment, lineNumber, handles->symbolTable)) {
-            lineNumber++;
-            continue; // Skip the rest of the line if still inside a comment
-        }
+    while (lineNumber <= source->lineCount) {
+        size_t length = sourceLineLength(source, lineNumber);
+        memcpy(line, source->text + sourceLineStart(source, lineNumber), length);
+        line[length] = '\0';
 
-        // Process the current line using the state machine
-        processLine(line, lineNumber, handles->symbolTable);
+        // Tokenize the line (handles indentation, comments and the FSM)
+        lexLine(line, source, lineNumber, &inComment, handles->symbolTable);
         lineNumber++;
     }
 
     // Close files
+    free(line);
+    freeSourceMap(source);
     closeFiles(handles);
 
     printf("Lexical analysis completed. Tokens saved in symbol_table.prsm\n");
@@ -0,0 +1,481 @@
+#include "loop_optimizer.h"
+#include <stdlib.h>
+#include <string.h>
+#include "arithmetic.h"
+#include "symbol_table.h"
+
+static void* growArray(void* array, int* capacity, int needed, size_t size) {
+    if (needed <= *capacity) return array;
+    int newCapacity = *capacity ? *capacity : 8;
+    while (newCapacity < needed) newCapacity *= 2;
+    array = realloc(array, (size_t)newCapacity * size);
+    if (!array) {
+        fprintf(stderr, "Error: Memory allocation failed for control-flow graph.\n");
+        exit(EXIT_FAILURE);
+    }
+    *capacity = newCapacity;
+    return array;
+}
+
+static void* allocateArray(int count, size_t size) {
+    void* array = calloc(count > 0 ? (size_t)count : 1, size);
+    if (!array) {
+        fprintf(stderr, "Error: Memory allocation failed for control-flow graph.\n");
+        exit(EXIT_FAILURE);
+    }
+    return array;
+}
+
+// ---------------------------------------
+// Loop-invariant code motion and strength reduction
+// ---------------------------------------
+
+int cfgLoopOptimization = 1;
+
+// What optimizeLoops() knows about a register
+typedef struct {
+    int defs;             // Writes anywhere in the CFG
+    int writes;           // Writes inside the loop being optimized
+    int readOutside;      // Header + 1 of the last loop with a read of it outside
+    unsigned char invariant; // The one write inside the loop is invariant and can move
+    unsigned char needed;    // ... and a moving instruction reads it
+} RegisterFacts;
+
+// A natural loop: its header, every block that reaches a back edge without
+// passing the header, and the block that enters it
+typedef struct {
+    int header;
+    int preheader;
+    unsigned char* inLoop;
+    RegisterFacts* facts;
+    int factCapacity;
+} NaturalLoop;
+
+// A counter stepped once per loop by `reg = reg +/- step`
+typedef struct {
+    int reg;
+    int block;            // The step's block, which only jumps back to the header
+    int opcode;           // IR_ADD or IR_SUB
+    int step;             // Register added; its value when it is a constant
+    int constant;
+    int32_t value;
+} InductionVariable;
+
+// Function to give every loop header a block that enters it from outside and
+// only jumps to it, adding one where the way in branches or is shared.
+// Returns the number added; the blocks then need renumbering.
+static int addPreheaders(Cfg* cfg) {
+    int added = 0;
+    int count = cfg->blockCount;
+    for (int h = 0; h < count; h++) {
+        if (!cfg->blocks[h].loopHeader) continue;
+        int outside = 0, entry = -1;
+        for (int p = 0; p < cfg->blocks[h].predecessorCount; p++) {
+            int predecessor = cfg->predecessors[cfg->blocks[h].firstPredecessor + p];
+            if (dominates(cfg, h, predecessor)) continue;
+            outside++;
+            entry = predecessor;
+        }
+        if (outside == 0 || (outside == 1 && cfg->blocks[entry].successorCount == 1)) continue;
+
+        int preheader = newBlock(cfg);
+        endBlockWithJump(cfg, preheader, h);
+        for (int p = 0; p < cfg->blocks[h].predecessorCount; p++) {
+            int predecessor = cfg->predecessors[cfg->blocks[h].firstPredecessor + p];
+            if (dominates(cfg, h, predecessor)) continue;
+            BasicBlock* block = &cfg->blocks[predecessor];
+            for (int s = 0; s < block->successorCount; s++) {
+                if (block->successors[s] == h) block->successors[s] = preheader;
+            }
+        }
+        added++;
+    }
+    cfg->instructionCount += added;
+    return added;
+}
+
+// Function to mark the blocks of the loop at `header` and find its preheader (-1: none)
+static void findNaturalLoop(const Cfg* cfg, NaturalLoop* loop, int* stack) {
+    const BasicBlock* header = &cfg->blocks[loop->header];
+    memset(loop->inLoop, 0, (size_t)cfg->blockCount);
+    loop->inLoop[loop->header] = 1;
+    loop->preheader = -1;
+    int depth = 0, outside = 0;
+    for (int p = 0; p < header->predecessorCount; p++) {
+        int predecessor = cfg->predecessors[header->firstPredecessor + p];
+        if (!dominates(cfg, loop->header, predecessor)) {
+            outside++;
+            loop->preheader = cfg->blocks[predecessor].successorCount == 1 ? predecessor : -1;
+        } else if (!loop->inLoop[predecessor]) {
+            loop->inLoop[predecessor] = 1;
+            stack[depth++] = predecessor;
+        }
+    }
+    while (depth > 0) {
+        const BasicBlock* block = &cfg->blocks[stack[--depth]];
+        for (int p = 0; p < block->predecessorCount; p++) {
+            int predecessor = cfg->predecessors[block->firstPredecessor + p];
+            if (loop->inLoop[predecessor]) continue;
+            loop->inLoop[predecessor] = 1;
+            stack[depth++] = predecessor;
+        }
+    }
+    if (outside != 1) loop->preheader = -1;
+}
+
+// Function to make room for facts about registers added since the last loop
+static void trackRegisters(const Cfg* cfg, NaturalLoop* loop) {
+    int old = loop->factCapacity;
+    loop->facts = (RegisterFacts*)growArray(loop->facts, &loop->factCapacity, cfg->registerCount,
+                                            sizeof(RegisterFacts));
+    memset(loop->facts + old, 0, (size_t)(loop->factCapacity - old) * sizeof(RegisterFacts));
+}
+
+// Function to count the loop's writes per register and note registers read after it
+static void scanLoopRegisters(const Cfg* cfg, NaturalLoop* loop) {
+    for (int b = 0; b < cfg->blockCount; b++) {
+        const BasicBlock* block = &cfg->blocks[b];
+        for (int i = 0; i < block->codeCount; i++) {
+            const IrInstruction* in = &block->code[i];
+            if (loop->inLoop[b]) {
+                if (in->dst >= 0) loop->facts[in->dst].writes++;
+                continue;
+            }
+            const int operands[3] = {in->a, in->b, in->c};
+            for (int k = 0; k < 3; k++) {
+                if (operands[k] >= 0) loop->facts[operands[k]].readOutside = loop->header + 1;
+            }
+        }
+    }
+}
+
+static void clearLoopRegisters(const Cfg* cfg, NaturalLoop* loop) {
+    for (int b = 0; b < cfg->blockCount; b++) {
+        if (!loop->inLoop[b]) continue;
+        const BasicBlock* block = &cfg->blocks[b];
+        for (int i = 0; i < block->codeCount; i++) {
+            int dst = block->code[i].dst;
+            if (dst < 0) continue;
+            loop->facts[dst].writes = 0;
+            loop->facts[dst].invariant = 0;
+            loop->facts[dst].needed = 0;
+        }
+    }
+}
+
+// Pure instructions that cannot stop the program, so running one on a path that
+// would have skipped it changes nothing: no int division, loads, I/O or strings
+static int isMovable(const IrInstruction* in) {
+    if (in->type == TYPE_STRING) return 0;
+    switch (in->opcode) {
+        case IR_CONST: case IR_COPY: case IR_INT_TO_FLOAT:
+        case IR_ADD: case IR_SUB: case IR_MUL: case IR_POW:
+        case IR_EQ: case IR_NE: case IR_LT: case IR_LE: case IR_GT: case IR_GE:
+        case IR_NOT: case IR_MAX: case IR_ARRAY_LENGTH:
+            return 1;
+        case IR_DIV: case IR_FLOOR_DIV: case IR_MOD:
+            return in->type == TYPE_FLOAT;
+        default:
+            return 0;
+    }
+}
+
+// Non-zero if `reg` has the same value all through the loop
+static int isInvariant(const NaturalLoop* loop, int reg) {
+    return reg < 0 || loop->facts[reg].writes == 0 || loop->facts[reg].invariant;
+}
+
+// Function to find the instructions that can move to the preheader: movable, the
+// only write of a temporary, reading only invariant registers. A constant moves
+// when it is a float (a load per iteration) or a moving instruction reads it; an
+// int constant read in its own block costs nothing as an immediate.
+static void markInvariants(const Cfg* cfg, NaturalLoop* loop) {
+    int changed = 1;
+    while (changed) {
+        changed = 0;
+        for (int b = 0; b < cfg->blockCount; b++) {
+            if (!loop->inLoop[b]) continue;
+            const BasicBlock* block = &cfg->blocks[b];
+            for (int i = 0; i < block->codeCount; i++) {
+                const IrInstruction* in = &block->code[i];
+                if (in->dst < cfg->bindingCount || loop->facts[in->dst].invariant ||
+                    loop->facts[in->dst].defs != 1 || !isMovable(in) || !isInvariant(loop, in->a) ||
+                    !isInvariant(loop, in->b)) {
+                    continue;
+                }
+                loop->facts[in->dst].invariant = 1;
+                changed = 1;
+            }
+        }
+    }
+    for (int b = 0; b < cfg->blockCount; b++) {
+        if (!loop->inLoop[b]) continue;
+        const BasicBlock* block = &cfg->blocks[b];
+        for (int i = 0; i < block->codeCount; i++) {
+            const IrInstruction* in = &block->code[i];
+            if (in->dst < 0 || !loop->facts[in->dst].invariant) continue;
+            if (in->opcode != IR_CONST || in->type == TYPE_FLOAT) loop->facts[in->dst].needed = 1;
+            if (in->opcode == IR_CONST) continue;
+            if (in->a >= 0 && loop->facts[in->a].writes) loop->facts[in->a].needed = 1;
+            if (in->b >= 0 && loop->facts[in->b].writes) loop->facts[in->b].needed = 1;
+        }
+    }
+}
+
+// Function to move the needed invariant instructions to the end of the preheader,
+// in block order (a write dominates its reads, so operands arrive first)
+static int hoistInvariants(Cfg* cfg, NaturalLoop* loop) {
+    int hoisted = 0;
+    for (int b = 0; b < cfg->blockCount; b++) {
+        if (!loop->inLoop[b]) continue;
+        BasicBlock* block = &cfg->blocks[b];
+        int kept = 0;
+        for (int i = 0; i < block->codeCount; i++) {
+            IrInstruction in = block->code[i];
+            if (in.dst >= 0 && loop->facts[in.dst].needed) {
+                *insertBeforeJump(&cfg->blocks[loop->preheader], in.opcode, in.type, -1, -1, -1) = in;
+                loop->facts[in.dst].writes = 0;
+                loop->facts[in.dst].invariant = 0;
+                loop->facts[in.dst].needed = 0;
+                hoisted++;
+            } else {
+                block->code[kept++] = in;
+            }
+        }
+        block->codeCount = kept;
+    }
+    return hoisted;
+}
+
+// Function to add an instruction at `position` in a block
+static IrInstruction* insertAt(BasicBlock* block, int position, int opcode, int type, int dst, int a, int b) {
+    block->code = (IrInstruction*)growArray(block->code, &block->codeCapacity, block->codeCount + 1,
+                                            sizeof(IrInstruction));
+    memmove(&block->code[position + 1], &block->code[position],
+            (size_t)(block->codeCount - position) * sizeof(IrInstruction));
+    block->codeCount++;
+    IrInstruction* in = &block->code[position];
+    memset(in, 0, sizeof(*in));
+    in->opcode = (unsigned char)opcode;
+    in->type = (unsigned char)type;
+    in->dst = dst;
+    in->a = a;
+    in->b = b;
+    in->c = -1;
+    return in;
+}
+
+static void removeAt(BasicBlock* block, int position) {
+    memmove(&block->code[position], &block->code[position + 1],
+            (size_t)(block->codeCount - position - 1) * sizeof(IrInstruction));
+    block->codeCount--;
+}
+
+// Function to drop the loop's constant in `reg` once nothing reads it (it would
+// still be loaded every iteration)
+static void removeUnreadConstant(Cfg* cfg, NaturalLoop* loop, int reg) {
+    if (loop->facts[reg].readOutside == loop->header + 1) return;
+    int site = -1, position = -1;
+    for (int b = 0; b < cfg->blockCount; b++) {
+        if (!loop->inLoop[b]) continue;
+        const BasicBlock* block = &cfg->blocks[b];
+        for (int i = 0; i < block->codeCount; i++) {
+            const IrInstruction* in = &block->code[i];
+            if (in->a == reg || in->b == reg || in->c == reg) return;
+            if (in->dst == reg) {
+                site = b;
+                position = i;
+            }
+        }
+    }
+    if (site < 0) return;
+    removeAt(&cfg->blocks[site], position);
+    cfg->instructionCount--;
+    loop->facts[reg].defs = 0;
+    loop->facts[reg].writes = 0;
+}
+
+// Function to find the loop's only write to `reg` when it is an int constant
+static int loopConstant(const Cfg* cfg, const NaturalLoop* loop, int reg, int32_t* value) {
+    if (reg < 0 || loop->facts[reg].writes != 1 || loop->facts[reg].defs != 1) return 0;
+    for (int b = 0; b < cfg->blockCount; b++) {
+        if (!loop->inLoop[b]) continue;
+        const BasicBlock* block = &cfg->blocks[b];
+        for (int i = 0; i < block->codeCount; i++) {
+            const IrInstruction* in = &block->code[i];
+            if (in->dst != reg) continue;
+            if (in->opcode != IR_CONST || in->type != TYPE_INT) return 0;
+            *value = in->imm.i;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Function to find the loop's counters: int registers whose one write in the loop is
+// `i = i +/- step` with an invariant step, in a block that only jumps to the header
+static int findInductionVariables(const Cfg* cfg, const NaturalLoop* loop, InductionVariable* found, int capacity) {
+    int count = 0;
+    for (int b = 0; b < cfg->blockCount && count < capacity; b++) {
+        const BasicBlock* block = &cfg->blocks[b];
+        if (!loop->inLoop[b] || block->successorCount != 1 || block->successors[0] != loop->header) continue;
+        for (int i = 0; i < block->codeCount && count < capacity; i++) {
+            const IrInstruction* in = &block->code[i];
+            if ((in->opcode != IR_ADD && in->opcode != IR_SUB) || in->type != TYPE_INT || in->a != in->dst ||
+                in->a == in->b || cfg->registerTypes[in->dst] != TYPE_INT || loop->facts[in->dst].writes != 1) {
+                continue;
+            }
+            InductionVariable* variable = &found[count];
+            variable->reg = in->dst;
+            variable->block = b;
+            variable->opcode = in->opcode;
+            variable->step = in->b;
+            variable->constant = loopConstant(cfg, loop, in->b, &variable->value);
+            if (variable->constant || loop->facts[in->b].writes == 0) count++;
+        }
+    }
+    return count;
+}
+
+static int stepPosition(const BasicBlock* block, int reg) {
+    for (int i = 0; i < block->codeCount; i++) {
+        if (block->code[i].dst == reg) return i;
+    }
+    return -1;
+}
+
+// Function to copy a value the loop uses into the preheader: registers the loop does
+// not write stay, the loop's constants get a preheader copy
+static int preheaderValue(Cfg* cfg, NaturalLoop* loop, int reg, int constant, int32_t value) {
+    if (!constant) return reg;
+    int copy = newRegister(cfg, TYPE_INT);
+    insertBeforeJump(&cfg->blocks[loop->preheader], IR_CONST, TYPE_INT, copy, -1, -1)->imm.i = value;
+    cfg->instructionCount++;
+    trackRegisters(cfg, loop);
+    loop->facts[copy].defs = 1;
+    return copy;
+}
+
+// Function to replace `t = i * k` (k invariant, t a temporary only read in the loop)
+// with t = i * k once in the preheader and t += step * k after each step of i.
+// Int arithmetic wraps, so (i + s) * k == i * k + s * k always holds.
+static int reduceMultiply(Cfg* cfg, NaturalLoop* loop, const InductionVariable* variable, int b, int position) {
+    BasicBlock* block = &cfg->blocks[b];
+    IrInstruction multiply = block->code[position];
+    int t = multiply.dst;
+    int factor = multiply.a == variable->reg ? multiply.b : multiply.a;
+    int32_t factorValue = 0;
+    int constantFactor = loopConstant(cfg, loop, factor, &factorValue);
+    if (t < cfg->bindingCount || loop->facts[t].defs != 1 || loop->facts[t].readOutside == loop->header + 1 ||
+        factor == variable->reg || (!constantFactor && loop->facts[factor].writes != 0)) {
+        return 0;
+    }
+
+    // After the step t must be stepped too, so nothing there may still want the old product
+    BasicBlock* stepBlock = &cfg->blocks[variable->block];
+    int step = stepPosition(stepBlock, variable->reg);
+    if (b != variable->block || position < step) {
+        for (int i = step + 1; i < stepBlock->codeCount; i++) {
+            const IrInstruction* in = &stepBlock->code[i];
+            if (in->a == t || in->b == t || in->c == t) return 0;
+        }
+    }
+
+    removeAt(block, position);
+    cfg->instructionCount--;
+    if (constantFactor) removeUnreadConstant(cfg, loop, factor);
+    step = stepPosition(stepBlock, variable->reg);
+
+    int k = preheaderValue(cfg, loop, factor, constantFactor, factorValue);
+    insertBeforeJump(&cfg->blocks[loop->preheader], IR_MUL, TYPE_INT, t, variable->reg, k);
+    cfg->instructionCount++;
+    int increment;
+    if (variable->constant && constantFactor) {
+        increment = newRegister(cfg, TYPE_INT);
+        insertAt(stepBlock, ++step, IR_CONST, TYPE_INT, increment, -1, -1)->imm.i =
+            intMul(variable->value, factorValue);
+        cfg->instructionCount++;
+    } else if (variable->constant && variable->value == 1) {
+        increment = k;
+    } else {
+        int s = preheaderValue(cfg, loop, variable->step, variable->constant, variable->value);
+        increment = newRegister(cfg, TYPE_INT);
+        insertBeforeJump(&cfg->blocks[loop->preheader], IR_MUL, TYPE_INT, increment, s, k);
+        cfg->instructionCount++;
+    }
+    insertAt(stepBlock, step + 1, variable->opcode, TYPE_INT, t, t, increment);
+    cfg->instructionCount++;
+    trackRegisters(cfg, loop);
+    if (increment != k) loop->facts[increment].defs = 1;
+    loop->facts[t].defs = 2;
+    loop->facts[t].writes = 1;
+    return 1;
+}
+
+// Function to strength-reduce the loop's multiplications of a counter by an invariant
+static int reduceMultiplies(Cfg* cfg, NaturalLoop* loop) {
+    InductionVariable variables[16];
+    int count = findInductionVariables(cfg, loop, variables, 16);
+    int reduced = 0;
+    for (int v = 0; v < count; v++) {
+        for (int b = 0; b < cfg->blockCount; b++) {
+            if (!loop->inLoop[b]) continue;
+            for (int i = 0; i < cfg->blocks[b].codeCount; i++) {
+                const IrInstruction* in = &cfg->blocks[b].code[i];
+                if (in->opcode != IR_MUL || in->type != TYPE_INT ||
+                    (in->a != variables[v].reg && in->b != variables[v].reg)) {
+                    continue;
+                }
+                if (reduceMultiply(cfg, loop, &variables[v], b, i)) {
+                    reduced++;
+                    i = -1; // The block lost the multiplication and perhaps its constant
+                }
+            }
+        }
+    }
+    return reduced;
+}
+
+// Loops are done innermost first (a header's number is above its enclosing
+// loop's), so what leaves an inner loop can keep moving out of the next one.
+int optimizeLoops(Cfg* cfg) {
+    cfg->hoistedInstructions = 0;
+    cfg->reducedMultiplies = 0;
+    if (!cfgLoopOptimization || cfg->loopCount == 0 || !cfg->idom) return 0;
+
+    if (addPreheaders(cfg)) {
+        int unreachable = cfg->unreachableBlocks;
+        renumberBlocks(cfg);
+        computeDominators(cfg);
+        cfg->unreachableBlocks = unreachable;
+    }
+
+    NaturalLoop loop;
+    memset(&loop, 0, sizeof(loop));
+    loop.inLoop = (unsigned char*)allocateArray(cfg->blockCount, 1);
+    int* stack = (int*)allocateArray(cfg->blockCount, sizeof(int));
+    trackRegisters(cfg, &loop);
+    for (int b = 0; b < cfg->blockCount; b++) {
+        const BasicBlock* block = &cfg->blocks[b];
+        for (int i = 0; i < block->codeCount; i++) {
+            if (block->code[i].dst >= 0) loop.facts[block->code[i].dst].defs++;
+        }
+    }
+
+    for (int h = cfg->blockCount - 1; h >= 0; h--) {
+        if (!cfg->blocks[h].loopHeader) continue;
+        loop.header = h;
+        findNaturalLoop(cfg, &loop, stack);
+        if (loop.preheader < 0) continue;
+        scanLoopRegisters(cfg, &loop);
+        markInvariants(cfg, &loop);
+        cfg->hoistedInstructions += hoistInvariants(cfg, &loop);
+        cfg->reducedMultiplies += reduceMultiplies(cfg, &loop);
+        clearLoopRegisters(cfg, &loop);
+    }
+
+    free(stack);
+    free(loop.inLoop);
+    free(loop.facts);
+    return cfg->hoistedInstructions + cfg->reducedMultiplies;
+}
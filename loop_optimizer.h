@@ -0,0 +1,18 @@
+#ifndef LOOP_OPTIMIZER_H
+#define LOOP_OPTIMIZER_H
+
+#include "cfg.h"
+
+extern int cfgLoopOptimization; // Non-zero (default): optimizeLoops() hoists and strength-reduces
+
+// Optimize every natural loop (the blocks that reach one of a header's back
+// edges without passing it), innermost first. Each gets a preheader, a block
+// that only jumps to the header, and pure instructions that cannot fail and
+// compute the same value in every iteration move there. Then t = i * k, for
+// a counter i stepped by a constant or invariant amount once per iteration,
+// becomes t = i * k in the preheader plus t += step * k after each step.
+// Run after vectorizeLoops(). Returns the instructions hoisted plus the
+// multiplications reduced.
+int optimizeLoops(Cfg* cfg);
+
+#endif // LOOP_OPTIMIZER_H
@@ -0,0 +1,292 @@
+#include "loop_vectorizer.h"
+#include <stdlib.h>
+#include "symbol_table.h"
+#include "bounds_check.h"
+
+static void* allocateArray(int count, size_t size) {
+    void* array = calloc(count > 0 ? (size_t)count : 1, size);
+    if (!array) {
+        fprintf(stderr, "Error: Memory allocation failed for control-flow graph.\n");
+        exit(EXIT_FAILURE);
+    }
+    return array;
+}
+
+// ---------------------------------------
+// Loop vectorization
+// ---------------------------------------
+
+int cfgVectorizeLoops = 1;
+
+// A counted loop whose body vectorizeLoops() can do in one kernel call
+typedef struct {
+    int header;
+    int entry;            // The one block that enters the header
+    int body, latch;      // The latch steps the counter (the body itself for one-block loops)
+    int counter, limit;
+    int type;             // TYPE_INT or TYPE_FLOAT
+    int op;               // Element operation: IR_ADD .. IR_DIV, or IR_COPY
+    int operands[2];      // Arrays read at the counter, or scalars the loop does not change (-1: none)
+    int destination;      // Array written at the counter, or -1 for a sum
+    int accumulator;      // Variable a sum adds to, or -1
+    int arrays;           // Sum: 1 (x[i]) or 2 (x[i] * y[i])
+} VectorLoop;
+
+static int inVectorLoop(const VectorLoop* loop, int b) {
+    return b == loop->header || b == loop->body || b == loop->latch;
+}
+
+// Function to find the write to `reg` inside the loop; *writes counts them
+static const IrInstruction* loopWrite(const Cfg* cfg, const VectorLoop* loop, int reg, int* writes) {
+    const int blocks[3] = {loop->header, loop->body, loop->latch};
+    const IrInstruction* found = NULL;
+    *writes = 0;
+    for (int k = 0; k < 3; k++) {
+        if (k == 2 && loop->latch == loop->body) break;
+        const BasicBlock* block = &cfg->blocks[blocks[k]];
+        for (int i = 0; i < block->codeCount; i++) {
+            if (block->code[i].dst != reg) continue;
+            found = &block->code[i];
+            (*writes)++;
+        }
+    }
+    return found;
+}
+
+// Function to tell whether `reg` holds a one-dimensional array of `type` elements
+// created before the loop (and never replaced)
+static int isVectorArray(const Cfg* cfg, const DefSites* defs, const VectorLoop* loop, int reg, int type) {
+    const IrInstruction* creation = onlyDef(cfg, defs, reg);
+    return creation && creation->opcode == IR_NEW_ARRAY && creation->b < 0 && creation->type == type &&
+           !inVectorLoop(loop, defs->block[reg]) && dominates(cfg, defs->block[reg], loop->entry);
+}
+
+// Function to resolve a value the loop computes with: an element loaded at the counter
+// (gives the array) or a scalar that is the same in every iteration
+static int vectorOperand(const Cfg* cfg, const DefSites* defs, const VectorLoop* loop, int reg,
+                         int* operand, int* isArray) {
+    int writes;
+    const IrInstruction* def = loopWrite(cfg, loop, reg, &writes);
+    *isArray = 0;
+    *operand = reg;
+    if (writes == 0) return cfg->registerTypes[reg] == loop->type;
+    if (writes != 1 || reg < cfg->bindingCount || def->type != loop->type) return 0;
+    if (def->opcode == IR_CONST) return 1; // Hoisted into the entry block
+    if (def->opcode != IR_LOAD_ELEMENT || def->b != loop->counter ||
+        !isVectorArray(cfg, defs, loop, def->a, loop->type)) {
+        return 0;
+    }
+    *isArray = 1;
+    *operand = def->a;
+    return 1;
+}
+
+// Function to tell whether anything outside the body reads a temporary computed in it
+static int escapesBody(const Cfg* cfg, const DefSites* defs, const VectorLoop* loop) {
+    for (int b = 0; b < cfg->blockCount; b++) {
+        if (b == loop->body || b == loop->latch) continue;
+        const BasicBlock* block = &cfg->blocks[b];
+        for (int i = 0; i < block->codeCount; i++) {
+            const int operands[3] = {block->code[i].a, block->code[i].b, block->code[i].c};
+            for (int k = 0; k < 3; k++) {
+                int reg = operands[k];
+                if (reg >= cfg->bindingCount && defs->count[reg] == 1 &&
+                    (defs->block[reg] == loop->body || defs->block[reg] == loop->latch)) {
+                    return 1;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+// Function to match `header` against the loops vectorizeLoops() replaces: a test
+// block of constants and `i < n`, a body that only loads, does one element
+// operation and stores or adds up, and a step of 1 at the end
+static int matchVectorLoop(const Cfg* cfg, const DefSites* defs, const CountedLoop* counted, int header,
+                           VectorLoop* loop) {
+    const BasicBlock* test = &cfg->blocks[header];
+    if (counted->counter < 0 || test->predecessorCount != 2) return 0;
+    for (int i = 0; i < test->codeCount - 2; i++) {
+        if (test->code[i].opcode != IR_CONST || test->code[i].dst < cfg->bindingCount) return 0;
+    }
+    loop->header = header;
+    loop->counter = counted->counter;
+    loop->limit = counted->limit;
+    loop->body = test->successors[0];
+    const BasicBlock* body = &cfg->blocks[loop->body];
+    if (body->successorCount != 1) return 0;
+    loop->latch = body->successors[0] == header ? loop->body : body->successors[0];
+    const BasicBlock* latch = &cfg->blocks[loop->latch];
+    if (latch->successorCount != 1 || latch->successors[0] != header ||
+        (loop->latch != loop->body && latch->predecessorCount != 1)) {
+        return 0;
+    }
+    loop->entry = -1;
+    for (int p = 0; p < test->predecessorCount; p++) {
+        int predecessor = cfg->predecessors[test->firstPredecessor + p];
+        if (predecessor != loop->latch) loop->entry = predecessor;
+    }
+    if (loop->entry < 0) return 0;
+    const BasicBlock* entry = &cfg->blocks[loop->entry];
+    if (entry->successorCount != 1 || entry->code[entry->codeCount - 1].opcode != IR_JUMP) return 0;
+
+    // The step ends the latch; everything else is constants, loads, one operation and the result
+    if (latch->codeCount < 2) return 0;
+    const IrInstruction* step = &latch->code[latch->codeCount - 2];
+    int32_t stride;
+    if (step->opcode != IR_ADD || step->dst != loop->counter || step->a != loop->counter ||
+        !constantInt(cfg, defs, step->b, &stride) || stride != 1) {
+        return 0;
+    }
+    const IrInstruction* operation = NULL;
+    const IrInstruction* result = NULL;
+    const BasicBlock* blocks[2] = {body, latch};
+    for (int k = 0; k < 2; k++) {
+        if (k == 1 && latch == body) break;
+        for (int i = 0; i < blocks[k]->codeCount - 1; i++) {
+            const IrInstruction* in = &blocks[k]->code[i];
+            if (in == step) continue;
+            switch (in->opcode) {
+                case IR_CONST:
+                    if (in->dst < cfg->bindingCount) return 0;
+                    break;
+                case IR_LOAD_ELEMENT:
+                    if (in->b != loop->counter) return 0;
+                    break;
+                case IR_ADD: case IR_SUB: case IR_MUL: case IR_DIV:
+                    if (in->dst >= cfg->bindingCount) {
+                        if (operation) return 0;
+                        operation = in;
+                    } else {
+                        if (result || in->opcode != IR_ADD || in->a != in->dst || in->dst == loop->counter) return 0;
+                        result = in;
+                    }
+                    break;
+                case IR_STORE_ELEMENT:
+                    if (result || in->b != loop->counter) return 0;
+                    result = in;
+                    break;
+                default:
+                    return 0;
+            }
+        }
+    }
+    if (!result || (result->type != TYPE_INT && result->type != TYPE_FLOAT)) return 0;
+    loop->type = result->type;
+    loop->operands[0] = loop->operands[1] = -1;
+
+    int isArray[2] = {0, 0};
+    int writes;
+    if (result->opcode == IR_STORE_ELEMENT) {
+        loop->destination = result->a;
+        loop->accumulator = -1;
+        loop->arrays = 0;
+        if (!isVectorArray(cfg, defs, loop, result->a, loop->type)) return 0;
+        const IrInstruction* value = loopWrite(cfg, loop, result->c, &writes);
+        if (operation && value == operation) {
+            if (operation->type != loop->type || (operation->opcode == IR_DIV && loop->type != TYPE_FLOAT) ||
+                !vectorOperand(cfg, defs, loop, operation->a, &loop->operands[0], &isArray[0]) ||
+                !vectorOperand(cfg, defs, loop, operation->b, &loop->operands[1], &isArray[1]) ||
+                (!isArray[0] && !isArray[1])) {
+                return 0;
+            }
+            loop->op = operation->opcode;
+        } else {
+            if (operation || !vectorOperand(cfg, defs, loop, result->c, &loop->operands[0], &isArray[0])) return 0;
+            loop->op = IR_COPY;
+        }
+    } else {
+        // A sum: the accumulator is read only by its own addition
+        loop->destination = -1;
+        loop->accumulator = result->dst;
+        loop->op = IR_ADD;
+        if (cfg->registerTypes[result->dst] != loop->type) return 0;
+        for (int k = 0; k < 2; k++) {
+            if (k == 1 && latch == body) break;
+            for (int i = 0; i < blocks[k]->codeCount; i++) {
+                const IrInstruction* in = &blocks[k]->code[i];
+                if (in != result && (in->a == result->dst || in->b == result->dst || in->c == result->dst)) return 0;
+            }
+        }
+        const IrInstruction* value = loopWrite(cfg, loop, result->b, &writes);
+        if (operation && value == operation) {
+            if (operation->opcode != IR_MUL || operation->type != loop->type ||
+                !vectorOperand(cfg, defs, loop, operation->a, &loop->operands[0], &isArray[0]) ||
+                !vectorOperand(cfg, defs, loop, operation->b, &loop->operands[1], &isArray[1]) ||
+                !isArray[0] || !isArray[1]) {
+                return 0;
+            }
+            loop->arrays = 2;
+        } else {
+            if (operation || !vectorOperand(cfg, defs, loop, result->b, &loop->operands[0], &isArray[0]) ||
+                !isArray[0]) {
+                return 0;
+            }
+            loop->arrays = 1;
+        }
+    }
+    return !escapesBody(cfg, defs, loop);
+}
+
+// Function to give a constant the loop defines a copy in the entry block; other registers stay
+static int hoistConstant(Cfg* cfg, const VectorLoop* loop, int reg) {
+    int writes;
+    const IrInstruction* def = reg >= 0 ? loopWrite(cfg, loop, reg, &writes) : NULL;
+    if (!def) return reg;
+    IrInstruction constant = *def;
+    constant.dst = newRegister(cfg, cfg->registerTypes[reg]);
+    BasicBlock* entry = &cfg->blocks[loop->entry];
+    *insertBeforeJump(entry, IR_CONST, constant.type, constant.dst, -1, -1) = constant;
+    cfg->instructionCount++;
+    return constant.dst;
+}
+
+// Function to do the whole loop from its entry block: the kernel covers [i, n) and
+// leaves i = max(i, n), so the loop's own test fails at once
+static void replaceVectorLoop(Cfg* cfg, const VectorLoop* loop) {
+    int limit = hoistConstant(cfg, loop, loop->limit);
+    int left = hoistConstant(cfg, loop, loop->operands[0]);
+    int right = hoistConstant(cfg, loop, loop->operands[1]);
+    BasicBlock* entry = &cfg->blocks[loop->entry];
+    int before = entry->codeCount;
+    if (loop->destination >= 0) {
+        insertBeforeJump(entry, IR_ARG, loop->type, -1, loop->destination, -1);
+        insertBeforeJump(entry, IR_ARG, loop->type, -1, left, -1);
+        insertBeforeJump(entry, IR_ARG, loop->type, -1, right >= 0 ? right : left, -1);
+        insertBeforeJump(entry, IR_VECTOR_MAP, loop->type, -1, loop->counter, limit)->imm.i = loop->op;
+    } else {
+        int sum = newRegister(cfg, loop->type);
+        insertBeforeJump(entry, IR_ARG, loop->type, -1, left, -1);
+        if (loop->arrays == 2) insertBeforeJump(entry, IR_ARG, loop->type, -1, right, -1);
+        insertBeforeJump(entry, IR_VECTOR_SUM, loop->type, sum, loop->counter, limit)->imm.i = loop->arrays;
+        insertBeforeJump(entry, IR_ADD, loop->type, loop->accumulator, loop->accumulator, sum);
+    }
+    insertBeforeJump(entry, IR_MAX, TYPE_INT, loop->counter, loop->counter, limit);
+    cfg->instructionCount += entry->codeCount - before;
+}
+
+// Loops are matched on the code as lowered and replaced afterwards; each replacement
+// only adds to its own entry block, which no other match looked into
+int vectorizeLoops(Cfg* cfg) {
+    cfg->vectorizedLoops = 0;
+    if (!cfgVectorizeLoops || cfg->loopCount == 0 || !cfg->idom) return 0;
+
+    DefSites defs;
+    collectDefSites(cfg, &defs);
+    VectorLoop* loops = (VectorLoop*)allocateArray(cfg->blockCount, sizeof(VectorLoop));
+    int count = 0;
+    for (int h = 0; h < cfg->blockCount; h++) {
+        CountedLoop counted;
+        findCountedLoop(cfg, &defs, h, &counted);
+        if (matchVectorLoop(cfg, &defs, &counted, h, &loops[count])) count++;
+    }
+    freeDefSites(&defs);
+
+    for (int k = 0; k < count; k++) {
+        replaceVectorLoop(cfg, &loops[k]);
+    }
+    free(loops);
+    cfg->vectorizedLoops = count;
+    return count;
+}
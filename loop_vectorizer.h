@@ -0,0 +1,17 @@
+#ifndef LOOP_VECTORIZER_H
+#define LOOP_VECTORIZER_H
+
+#include "cfg.h"
+
+extern int cfgVectorizeLoops; // Non-zero (default): vectorizeLoops() replaces what it matches
+
+// Replace counted loops (step 1, no bounds checks left in the body) that only
+// map one element-wise operation over 1D int or float arrays -- d[i] = l[i] op
+// r[i], either side possibly a loop-invariant scalar -- or add up x[i] or
+// x[i] * y[i] into a variable. The whole range [i, n) is done by one
+// IR_VECTOR_MAP or IR_VECTOR_SUM in the block that enters the loop, which then
+// sets i = max(i, n), so the original loop runs no iterations. Run after
+// eliminateBoundsChecks(). Returns the number of loops replaced.
+int vectorizeLoops(Cfg* cfg);
+
+#endif // LOOP_VECTORIZER_H
@@ -1,5 +1,136 @@
 #include "parse_tree.h"
 
+// Optional hook that parses deferred block bodies on first use
+static DeferredExpander deferredExpander = NULL;
+
+// Labels the parser creates, sorted for bsearch (strcmp order)
+typedef struct {
+    const char* label;
+    NodeKind kind;
+} NodeLabel;
+
+static const NodeLabel nodeLabels[] = {
+    {"AddressVariable", NODE_ADDRESS_VARIABLE},
+    {"ArithmeticExpr", NODE_ARITHMETIC_EXPR},
+    {"ArithmeticOperator", NODE_OPERATOR},
+    {"ArrayAccess", NODE_ARRAY_ACCESS},
+    {"ArrayDeclaration", NODE_ARRAY_DECLARATION},
+    {"ArrayInitializer", NODE_ARRAY_INITIALIZER},
+    {"AssignExpr", NODE_ASSIGN_EXPR},
+    {"AssignmentOperator", NODE_OPERATOR},
+    {"AssignmentStatement", NODE_ASSIGNMENT_STATEMENT},
+    {"Block", NODE_BLOCK},
+    {"BoolLiteral", NODE_BOOL_LITERAL},
+    {"CHAR_LITERAL", NODE_CHAR_LITERAL},
+    {"CaseClause", NODE_CASE_CLAUSE},
+    {"Comment", NODE_COMMENT},
+    {"ConditionalStatement", NODE_CONDITIONAL_STATEMENT},
+    {"DeclarationStatement", NODE_DECLARATION_STATEMENT},
+    {"DefaultClause", NODE_DEFAULT_CLAUSE},
+    {"Delimiter", NODE_DELIMITER},
+    {"DoWhileLoop", NODE_DO_WHILE_LOOP},
+    {"ExponentialExpr", NODE_EXPONENTIAL_EXPR},
+    {"Expression", NODE_EXPRESSION},
+    {"FLOAT_LITERAL", NODE_FLOAT_LITERAL},
+    {"Factor", NODE_FACTOR},
+    {"ForInit", NODE_FOR_INIT},
+    {"ForLoop", NODE_FOR_LOOP},
+    {"ForUpdate", NODE_FOR_UPDATE},
+    {"GroupedBoolExpr", NODE_GROUPED_EXPR},
+    {"GroupedExpr", NODE_GROUPED_EXPR},
+    {"IDENTIFIER", NODE_IDENTIFIER},
+    {"INT_LITERAL", NODE_INT_LITERAL},
+    {"Identifier", NODE_IDENTIFIER_EXPR},
+    {"IdentifierExpr", NODE_IDENTIFIER_EXPR},
+    {"InputStatement", NODE_INPUT_STATEMENT},
+    {"IntToFloat", NODE_INT_TO_FLOAT},
+    {"JumpStatement", NODE_JUMP_STATEMENT},
+    {"Keyword", NODE_KEYWORD},
+    {"Literal", NODE_LITERAL},
+    {"LogicalAndExpr", NODE_LOGICAL_AND_EXPR},
+    {"LogicalNotExpr", NODE_LOGICAL_NOT_EXPR},
+    {"LogicalOperator", NODE_OPERATOR},
+    {"LogicalOrExpr", NODE_LOGICAL_OR_EXPR},
+    {"NoiseWord", NODE_NOISE_WORD},
+    {"OutputList", NODE_OUTPUT_LIST},
+    {"OutputStatement", NODE_OUTPUT_STATEMENT},
+    {"Program", NODE_PROGRAM},
+    {"RelationalExpr", NODE_RELATIONAL_EXPR},
+    {"RelationalOperator", NODE_OPERATOR},
+    {"STRING_LITERAL", NODE_STRING_LITERAL},
+    {"SwitchStatement", NODE_SWITCH_STATEMENT},
+    {"Term", NODE_TERM},
+    {"UnaryExpr", NODE_UNARY_EXPR},
+    {"UnaryOperator", NODE_OPERATOR},
+    {"VariableDeclaration", NODE_VARIABLE_DECLARATION},
+    {"WhileLoop", NODE_WHILE_LOOP},
+};
+
+static int compareNodeLabel(const void* key, const void* entry) {
+    return strcmp((const char*)key, ((const NodeLabel*)entry)->label);
+}
+
+// Function to decode an operator spelling
+static OperatorCode operatorCodeOf(const char* text) {
+    char c = text[0], d = c ? text[1] : '\0', e = d ? text[2] : '\0';
+    switch (c) {
+        case '+': return d == '=' ? OP_ADD_ASSIGN : d == '+' ? OP_INCREMENT : OP_ADD;
+        case '-': return d == '=' ? OP_SUB_ASSIGN : d == '-' ? OP_DECREMENT : OP_SUB;
+        case '*': return d == '=' ? OP_MUL_ASSIGN : OP_MUL;
+        case '/':
+            if (d == '/') return e == '=' ? OP_FLOOR_DIV_ASSIGN : OP_FLOOR_DIV;
+            return d == '=' ? OP_DIV_ASSIGN : OP_DIV;
+        case '%': return d == '=' ? OP_MOD_ASSIGN : OP_MOD;
+        case '^': return OP_POW;
+        case '=': return d == '=' ? OP_EQ : OP_ASSIGN;
+        case '!': return d == '=' ? OP_NE : OP_NOT;
+        case '<': return d == '=' ? OP_LE : OP_LT;
+        case '>': return d == '=' ? OP_GE : OP_GT;
+        case '&': return d == '&' ? OP_AND : OP_NONE;
+        case '|': return d == '|' ? OP_OR : OP_NONE;
+        default: return OP_NONE;
+    }
+}
+
+// Function to derive kind, operator and literal type from the label and value
+static void classifyNode(ParseTreeNode* node) {
+    const NodeLabel* entry = (const NodeLabel*)bsearch(node->label, nodeLabels,
+                                                        sizeof(nodeLabels) / sizeof(nodeLabels[0]),
+                                                        sizeof(NodeLabel), compareNodeLabel);
+    node->kind = entry ? entry->kind : NODE_OTHER;
+    node->op = OP_NONE;
+    node->type = TYPE_UNKNOWN;
+
+    switch (node->kind) {
+        case NODE_OPERATOR:
+            node->op = operatorCodeOf(node->value);
+            break;
+        case NODE_KEYWORD:
+            if (strcmp(node->value, "true") == 0 || strcmp(node->value, "false") == 0) {
+                node->kind = NODE_BOOL_LITERAL;
+                node->type = TYPE_BOOL;
+            } else if ((node->type = symbolTypeFromName(node->value)) != TYPE_UNKNOWN) {
+                node->kind = NODE_TYPE_SPECIFIER;
+            }
+            break;
+        case NODE_INT_LITERAL: node->type = TYPE_INT; break;
+        case NODE_FLOAT_LITERAL: node->type = TYPE_FLOAT; break;
+        case NODE_CHAR_LITERAL: node->type = TYPE_CHAR; break;
+        case NODE_STRING_LITERAL: node->type = TYPE_STRING; break;
+        case NODE_BOOL_LITERAL: node->type = TYPE_BOOL; break;
+        case NODE_INT_TO_FLOAT: node->type = TYPE_FLOAT; break;
+        case NODE_LITERAL:
+            // parseLiteral keeps only the spelling
+            if (node->value[0] == '"') node->type = TYPE_STRING;
+            else if (node->value[0] == '\'') node->type = TYPE_CHAR;
+            else if (strchr(node->value, '.')) node->type = TYPE_FLOAT;
+            else node->type = TYPE_INT;
+            break;
+        default:
+            break;
+    }
+}
+
 // Function to create a new parse tree node
 ParseTreeNode* createParseTreeNode(const char* type, const char* value) {
     ParseTreeNode* node = (ParseTreeNode*)malloc(sizeof(ParseTreeNode));
@@ -21,7 +152,15 @@ ParseTreeNode* createParseTreeNode(const char* type, const char* value) {
         node->value[0] = '\0'; // Initialize as empty
     }
 
+    node->children = NULL;
     node->childCount = 0;
+    node->childCapacity = 0;
+    node->symbolId = SYMBOL_NONE;
+    node->tokenOffset = 0;
+    node->tokenSpan = 0;
+    node->deferredStart = -1;
+    node->binding = -1;
+    classifyNode(node);
     return node;
 }
 
@@ -32,15 +171,24 @@ void addChild(ParseTreeNode* parent, ParseTreeNode* child) {
         return; // Exit the function
     }
 
-    if (parent->childCount < MAX_CHILDREN) {
+    if (parent->childCount == parent->childCapacity) {
+        int newCapacity = parent->childCapacity ? parent->childCapacity * 2 : MAX_CHILDREN;
+        ParseTreeNode** grown = (ParseTreeNode**)realloc(parent->children, newCapacity * sizeof(ParseTreeNode*));
+        if (grown) {
+            parent->children = grown;
+            parent->childCapacity = newCapacity;
+        }
+    }
+
+    if (parent->childCount < parent->childCapacity) {
         parent->children[parent->childCount++] = child;
 
         // Debug: Log successful addition of child
         //printf("[DEBUG] Added child to parent.\n");
         //printf("[DEBUG] Parent Node: Label='%s', Value='%s', Current Children=%d\n",
-               parent->label, parent->value, parent->childCount);
+        //       parent->label, parent->value, parent->childCount);
         //printf("[DEBUG] Child Node: Label='%s', Value='%s'\n", 
-               child->label, child->value);
+        //       child->label, child->value);
 
     } else {
         printf("[ERROR] Too many children for node %s (childCount=%d)\n",
@@ -50,6 +198,18 @@ void addChild(ParseTreeNode* parent, ParseTreeNode* child) {
 
 
 
+// Function to install the hook that expands deferred nodes
+void setDeferredExpander(DeferredExpander expander) {
+    deferredExpander = expander;
+}
+
+// Function to make sure a node's children are parsed before a consumer walks into it
+void ensureChildren(ParseTreeNode* node) {
+    if (node && node->deferredStart >= 0 && deferredExpander) {
+        deferredExpander(node);
+    }
+}
+
 // Function to print the parse tree (preorder traversal)
 void printParseTree(ParseTreeNode* node, int depth) {
     if (!node) return;
@@ -80,6 +240,12 @@ void writeParseTreeToFile(ParseTreeNode* node, FILE* file, int depth) {
     if (node->value[0] != '\0') {
         fprintf(file, ": %s", node->value);
     }
+    if (node->deferredStart >= 0) {
+        fprintf(file, " [deferred: %d tokens]", node->tokenSpan);
+    }
+    if (NODE_IS_EXPRESSION(node->kind) && node->type != TYPE_UNKNOWN) {
+        fprintf(file, " <%s>", symbolTypeName((SymbolType)node->type));
+    }
     fprintf(file, "\n");
 
     // Write child nodes recursively
@@ -104,9 +270,41 @@ void freeParseTree(ParseTreeNode* node) {
         freeParseTree(node->children[i]); // Recursively free children
     }
 
+    free(node->children);
     free(node); // Free the current node
 }
 
+// Function to replace `count` children starting at `first` with `replacement`.
+// The replaced subtrees are freed; the replacement nodes are adopted.
+void replaceChildren(ParseTreeNode* parent, int first, int count, ParseTreeNode** replacement, int replacementCount) {
+    if (!parent || first < 0 || count < 0 || first + count > parent->childCount) {
+        printf("[ERROR] Invalid child range for node %s.\n", parent ? parent->label : "(null)");
+        return;
+    }
+
+    for (int i = first; i < first + count; i++) {
+        freeParseTree(parent->children[i]);
+    }
+
+    int newCount = parent->childCount - count + replacementCount;
+    if (newCount > parent->childCapacity) {
+        int newCapacity = parent->childCapacity ? parent->childCapacity : MAX_CHILDREN;
+        while (newCapacity < newCount) newCapacity *= 2;
+        ParseTreeNode** grown = (ParseTreeNode**)realloc(parent->children, newCapacity * sizeof(ParseTreeNode*));
+        if (!grown) {
+            fprintf(stderr, "[ERROR] Memory allocation failed for child list\n");
+            exit(EXIT_FAILURE);
+        }
+        parent->children = grown;
+        parent->childCapacity = newCapacity;
+    }
+
+    memmove(parent->children + first + replacementCount, parent->children + first + count,
+            (parent->childCount - first - count) * sizeof(ParseTreeNode*));
+    memcpy(parent->children + first, replacement, replacementCount * sizeof(ParseTreeNode*));
+    parent->childCount = newCount;
+}
+
 // Function to set the value of a parse tree node
 void setNodeValue(ParseTreeNode* node, const char* value) {
     if (!node) {
@@ -119,4 +317,53 @@ void setNodeValue(ParseTreeNode* node, const char* value) {
     } else {
         node->value[0] = '\0'; // Initialize as empty string
     }
+    classifyNode(node);
+}
+
+// Function to look through Expression/grouping wrappers that only carry one operand
+ParseTreeNode* unwrap(ParseTreeNode* node) {
+    while (node) {
+        if ((node->kind == NODE_EXPRESSION || node->kind == NODE_IDENTIFIER_EXPR ||
+             node->kind == NODE_ASSIGN_EXPR) && node->childCount == 1) {
+            node = node->children[0];
+        } else if (node->kind == NODE_GROUPED_EXPR && node->childCount == 3) {
+            node = node->children[1];
+        } else {
+            break;
+        }
+    }
+    return node;
+}
+
+// Function to copy a string or char literal's contents with escapes decoded (caller frees)
+char* decodeLiteral(const char* text) {
+    size_t length = strlen(text);
+    char* decoded = (char*)malloc(length + 1);
+    if (!decoded) {
+        fprintf(stderr, "[ERROR] Memory allocation failed for a decoded literal\n");
+        exit(EXIT_FAILURE);
+    }
+    const char* end = text + length;
+    if (length >= 2 && (text[0] == '"' || text[0] == '\'') && end[-1] == text[0]) {
+        text++;
+        end--;
+    }
+
+    char* out = decoded;
+    while (text < end) {
+        char c = *text++;
+        if (c == '\\' && text < end) {
+            c = *text++;
+            switch (c) {
+                case 'n': c = '\n'; break;
+                case 't': c = '\t'; break;
+                case 'r': c = '\r'; break;
+                case '0': c = '\0'; break;
+                default: break; // \\, \", \' stand for themselves
+            }
+        }
+        *out++ = c;
+    }
+    *out = '\0';
+    return decoded;
 }
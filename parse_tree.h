@@ -4,24 +4,111 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "intern.h"
+#include "symbol_table.h"
 
-#define MAX_CHILDREN 50 // Example: Increase the max children allowed
+#define MAX_CHILDREN 4 // Initial child capacity; the array grows on demand
+
+// Node kinds, classified once from the label when a node is created so later
+// passes can switch on an integer. Expression kinds come last (see NODE_IS_EXPRESSION).
+typedef enum {
+    NODE_OTHER,
+    NODE_PROGRAM,
+    NODE_BLOCK,
+    NODE_DECLARATION_STATEMENT,
+    NODE_VARIABLE_DECLARATION,
+    NODE_ARRAY_DECLARATION,
+    NODE_ARRAY_INITIALIZER,  // { element, ... }, nested for a second dimension
+    NODE_ASSIGNMENT_STATEMENT,
+    NODE_CONDITIONAL_STATEMENT,
+    NODE_FOR_LOOP,
+    NODE_FOR_INIT,
+    NODE_FOR_UPDATE,
+    NODE_WHILE_LOOP,
+    NODE_DO_WHILE_LOOP,
+    NODE_SWITCH_STATEMENT,   // switch ( subject ) { clause* }
+    NODE_CASE_CLAUSE,        // case Literal : statement*
+    NODE_DEFAULT_CLAUSE,     // default : statement*
+    NODE_JUMP_STATEMENT,
+    NODE_INPUT_STATEMENT,
+    NODE_OUTPUT_STATEMENT,
+    NODE_OUTPUT_LIST,
+    NODE_ADDRESS_VARIABLE,
+    NODE_COMMENT,
+    NODE_KEYWORD,
+    NODE_TYPE_SPECIFIER,     // Keyword naming a type; `type` holds it
+    NODE_DELIMITER,
+    NODE_OPERATOR,           // Any *Operator token; `op` holds which one
+    NODE_NOISE_WORD,
+
+    NODE_EXPRESSION,         // Wrapper around a whole expression
+    NODE_LOGICAL_OR_EXPR,
+    NODE_LOGICAL_AND_EXPR,
+    NODE_LOGICAL_NOT_EXPR,
+    NODE_RELATIONAL_EXPR,
+    NODE_ARITHMETIC_EXPR,
+    NODE_TERM,
+    NODE_FACTOR,             // Base ^ exponent
+    NODE_EXPONENTIAL_EXPR,
+    NODE_GROUPED_EXPR,
+    NODE_UNARY_EXPR,
+    NODE_IDENTIFIER_EXPR,    // Identifier/IdentifierExpr wrapper around an IDENTIFIER
+    NODE_ASSIGN_EXPR,
+    NODE_ARRAY_ACCESS,       // IDENTIFIER [ index ] ([ index ])?
+    NODE_INT_TO_FLOAT,       // Conversion inserted by the type checker
+    NODE_IDENTIFIER,
+    NODE_INT_LITERAL,
+    NODE_FLOAT_LITERAL,
+    NODE_CHAR_LITERAL,
+    NODE_STRING_LITERAL,
+    NODE_BOOL_LITERAL,
+    NODE_LITERAL             // Literal node whose type is read from its value
+} NodeKind;
+
+#define NODE_IS_EXPRESSION(kind) ((kind) >= NODE_EXPRESSION)
+
+// Operator codes of NODE_OPERATOR leaves
+typedef enum {
+    OP_NONE,
+    OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_FLOOR_DIV, OP_MOD, OP_POW,
+    OP_EQ, OP_NE, OP_LT, OP_LE, OP_GT, OP_GE,
+    OP_AND, OP_OR, OP_NOT,
+    OP_ASSIGN, OP_ADD_ASSIGN, OP_SUB_ASSIGN, OP_MUL_ASSIGN, OP_DIV_ASSIGN, OP_MOD_ASSIGN, OP_FLOOR_DIV_ASSIGN,
+    OP_INCREMENT, OP_DECREMENT
+} OperatorCode;
 
 // Parse Tree Node structure
 typedef struct ParseTreeNode {
     char label[50];  // Label for the node (e.g., "Program", "Expression")
     char value[50];  // Value associated with the node
-    struct ParseTreeNode* children[MAX_CHILDREN]; // Pointers to child nodes
+    struct ParseTreeNode** children; // Pointers to child nodes
     int childCount;   // Number of children
+    int childCapacity;
+    SymbolId symbolId; // Interned identifier/string id (SYMBOL_NONE if not applicable)
+    int tokenOffset;  // Statement/Block nodes: first token, relative to the enclosing tracked node
+    int tokenSpan;    // Statement/Block nodes: number of tokens covered (0 = not tracked)
+    int deferredStart; // Lazy Block: absolute token index of its '{' until the body is parsed (-1 otherwise)
+    unsigned char kind; // NodeKind
+    unsigned char op;   // OperatorCode (OP_NONE unless kind is NODE_OPERATOR)
+    unsigned char type; // SymbolType: literal/type keyword type, or the type checker's result for expressions
+    int binding;        // IDENTIFIER: declaration it resolves to, numbered by the type checker (-1 = unresolved)
 } ParseTreeNode;
 
+// Parses the body of a deferred node (installed by the parser in lazy mode)
+typedef void (*DeferredExpander)(ParseTreeNode* node);
+
 
 // Function prototypes
 ParseTreeNode* createParseTreeNode(const char* type, const char* value);
 void setNodeValue(ParseTreeNode* node, const char* value);
 void addChild(ParseTreeNode* parent, ParseTreeNode* child);
+void setDeferredExpander(DeferredExpander expander);
+void ensureChildren(ParseTreeNode* node); // Call before walking into a node that may be deferred
+void replaceChildren(ParseTreeNode* parent, int first, int count, ParseTreeNode** replacement, int replacementCount);
 void printParseTree(ParseTreeNode* node, int depth);
 void writeParseTreeToFile(ParseTreeNode* node, FILE* file, int depth); 
 void freeParseTree(ParseTreeNode* node);
+ParseTreeNode* unwrap(ParseTreeNode* node); // Skips single-operand Expression/grouping wrappers
+char* decodeLiteral(const char* text);      // String/char literal contents with escapes decoded; caller frees
 
 #endif // PARSE_TREE_H
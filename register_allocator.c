@@ -0,0 +1,289 @@
+#include "register_allocator.h"
+#include <stdlib.h>
+#include <string.h>
+#include "symbol_table.h"
+#include "dataflow.h"
+
+static void* allocateArray(int count, size_t size) {
+    void* array = calloc(count > 0 ? (size_t)count : 1, size);
+    if (!array) {
+        fprintf(stderr, "Error: Memory allocation failed for control-flow graph.\n");
+        exit(EXIT_FAILURE);
+    }
+    return array;
+}
+
+// ---------------------------------------
+// Register allocation
+// ---------------------------------------
+
+int cfgRegisterAllocation = 1;
+
+#define MAX_WEIGHT_DEPTH 6 // Loops deeper than this weigh the same
+
+// The convex hull of the positions where a register is live, in the
+// instruction numbering of the final block order
+typedef struct {
+    int reg;
+    int start, end;
+    double weight;  // Mentions, each counting 8x more for every loop around it
+    int machine;    // 1-based machine register of its class, 0 in memory
+} LiveInterval;
+
+static int compareIntervals(const void* left, const void* right) {
+    const LiveInterval* a = (const LiveInterval*)left;
+    const LiveInterval* b = (const LiveInterval*)right;
+    if (a->start != b->start) return a->start < b->start ? -1 : 1;
+    return a->reg - b->reg;
+}
+
+// Function to give every block the number of loops around it, approximated
+// like the JIT does: back edge b -> h (h dominates b) puts blocks h .. b in a loop
+static int* blockLoopDepths(const Cfg* cfg) {
+    int* depth = (int*)allocateArray(cfg->blockCount, sizeof(int));
+    for (int b = 0; b < cfg->blockCount; b++) {
+        const BasicBlock* block = &cfg->blocks[b];
+        for (int s = 0; s < block->successorCount; s++) {
+            int header = block->successors[s];
+            if (header > b || !dominates(cfg, header, b)) continue;
+            int repeated = 0;
+            for (int t = 0; t < s; t++) repeated |= block->successors[t] == header;
+            if (repeated) continue;
+            for (int k = header; k <= b; k++) depth[k]++;
+        }
+    }
+    return depth;
+}
+
+static void extendInterval(LiveInterval* interval, int position) {
+    if (interval->start < 0 || position < interval->start) interval->start = position;
+    if (position > interval->end) interval->end = position;
+}
+
+// Function to build one interval per register the code mentions. Instructions
+// are numbered in block order; an IR_ARG takes the number of the print or
+// kernel that reads it, so the values passed stay live until then. Returns the
+// number of intervals, sorted by start.
+static int buildIntervals(const Cfg* cfg, LiveInterval* intervals) {
+    Dataflow* liveness = computeLiveness(cfg);
+    int* depth = blockLoopDepths(cfg);
+    for (int r = 0; r < cfg->registerCount; r++) {
+        intervals[r].reg = r;
+        intervals[r].start = -1;
+        intervals[r].end = -1;
+        intervals[r].weight = 0.0;
+        intervals[r].machine = 0;
+    }
+
+    int position = 0;
+    for (int b = 0; b < cfg->blockCount; b++) {
+        const BasicBlock* block = &cfg->blocks[b];
+        int first = position;
+        int last = position + block->codeCount - 1;
+        double weight = 1.0;
+        for (int k = 0; k < depth[b] && k < MAX_WEIGHT_DEPTH; k++) weight *= 8.0;
+
+        const BitWord* in = dataflowSet(liveness, liveness->in, b);
+        const BitWord* out = dataflowSet(liveness, liveness->out, b);
+        for (int w = 0; w < liveness->wordCount; w++) {
+            for (BitWord bits = in[w]; bits; bits &= bits - 1) {
+                extendInterval(&intervals[w * 64 + __builtin_ctzll(bits)], first);
+            }
+            for (BitWord bits = out[w]; bits; bits &= bits - 1) {
+                extendInterval(&intervals[w * 64 + __builtin_ctzll(bits)], last);
+            }
+        }
+
+        for (int i = 0; i < block->codeCount; i++) {
+            const IrInstruction* in = &block->code[i];
+            int at = i;
+            while (at < block->codeCount - 1 && block->code[at].opcode == IR_ARG) at++;
+            const int mentioned[4] = {in->dst, in->a, in->b, in->c};
+            for (int k = 0; k < 4; k++) {
+                if (mentioned[k] < 0) continue;
+                extendInterval(&intervals[mentioned[k]], first + at);
+                intervals[mentioned[k]].weight += weight;
+            }
+        }
+        position += block->codeCount;
+    }
+    free(depth);
+    freeDataflow(liveness);
+
+    int count = 0;
+    for (int r = 0; r < cfg->registerCount; r++) {
+        if (intervals[r].start >= 0) intervals[count++] = intervals[r];
+    }
+    qsort(intervals, (size_t)count, sizeof(LiveInterval), compareIntervals);
+    return count;
+}
+
+// Function to scan the intervals of one register class in start order,
+// keeping each in one of `available` machine registers while it is live. When
+// all are taken, the lightest of the active intervals and the new one is
+// spilled to memory. An interval ends after its last position, so a result
+// never shares a register with an operand of its own instruction. A free
+// register that already held the interval's type is preferred, as the slot of
+// a machine register holds one type. Returns the number of intervals spilled.
+static int scanRegisterClass(const Cfg* cfg, LiveInterval* intervals, int count, int isFloat, int available) {
+    int* active = (int*)allocateArray(available, sizeof(int));
+    int* held = (int*)allocateArray(available, sizeof(int)); // Type each register held first, or -1
+    for (int k = 0; k < available; k++) active[k] = held[k] = -1;
+    int spilled = 0;
+    for (int i = 0; i < count; i++) {
+        int type = cfg->registerTypes[intervals[i].reg];
+        int inClass = isFloat ? type == TYPE_FLOAT : type == TYPE_INT || type == TYPE_CHAR || type == TYPE_BOOL;
+        if (!inClass) continue;
+
+        int open = -1, lightest = -1;
+        for (int k = 0; k < available; k++) {
+            if (active[k] >= 0 && intervals[active[k]].end < intervals[i].start) active[k] = -1;
+            if (active[k] < 0) {
+                int rank = held[k] == type ? 2 : held[k] < 0;
+                if (open < 0 || rank > (held[open] == type ? 2 : held[open] < 0)) open = k;
+            } else if (lightest < 0 || intervals[active[k]].weight < intervals[active[lightest]].weight) {
+                lightest = k;
+            }
+        }
+        if (open < 0 && lightest >= 0 && intervals[active[lightest]].weight < intervals[i].weight) {
+            intervals[active[lightest]].machine = 0;
+            open = lightest;
+        }
+        if (open < 0) {
+            spilled++;
+            continue;
+        }
+        if (active[open] >= 0) spilled++;
+        active[open] = i;
+        if (held[open] < 0) held[open] = type;
+        intervals[i].machine = open + 1;
+    }
+    free(active);
+    free(held);
+    return spilled;
+}
+
+// A min-heap of slots by the end of the last interval given each
+typedef struct {
+    int* slots;
+    int count;
+} SlotHeap;
+
+static void siftSlot(SlotHeap* heap, const int* slotEnd, int at) {
+    for (;;) {
+        int smallest = at;
+        for (int child = 2 * at + 1; child <= 2 * at + 2 && child < heap->count; child++) {
+            if (slotEnd[heap->slots[child]] < slotEnd[heap->slots[smallest]]) smallest = child;
+        }
+        if (smallest == at) return;
+        int swap = heap->slots[at];
+        heap->slots[at] = heap->slots[smallest];
+        heap->slots[smallest] = swap;
+        at = smallest;
+    }
+}
+
+static void pushSlot(SlotHeap* heap, const int* slotEnd, int slot) {
+    int at = heap->count++;
+    heap->slots[at] = slot;
+    while (at > 0 && slotEnd[heap->slots[(at - 1) / 2]] > slotEnd[slot]) {
+        heap->slots[at] = heap->slots[(at - 1) / 2];
+        at = (at - 1) / 2;
+    }
+    heap->slots[at] = slot;
+}
+
+static int newSlot(Cfg* cfg, int type, int pin) {
+    int slot = cfg->slotCount++;
+    cfg->slotTypes[slot] = (unsigned char)type;
+    cfg->slotPins[slot] = (unsigned char)pin;
+    return slot;
+}
+
+// Function to give every interval a slot. Intervals of one type on machine
+// register k share a slot; the rest reuse the slot of their type whose last
+// interval ended first, when it has. Arrays always get their own slot: the
+// VM frees the array a slot holds when it is overwritten and at exit.
+static void assignSlots(Cfg* cfg, const LiveInterval* intervals, int count, int intRegisters, int floatRegisters) {
+    int machines = intRegisters + floatRegisters;
+    int* pinned = (int*)allocateArray((machines + 1) * TYPE_COUNT, sizeof(int));
+    double* pinnedWeight = (double*)allocateArray((machines + 1) * TYPE_COUNT, sizeof(double));
+    int* slotEnd = (int*)allocateArray(count, sizeof(int));
+    SlotHeap heaps[TYPE_COUNT];
+    for (int t = 0; t < TYPE_COUNT; t++) {
+        heaps[t].slots = (int*)allocateArray(count, sizeof(int));
+        heaps[t].count = 0;
+    }
+    for (int i = 0; i < (machines + 1) * TYPE_COUNT; i++) pinned[i] = -1;
+
+    for (int i = 0; i < count; i++) {
+        const LiveInterval* interval = &intervals[i];
+        int type = cfg->registerTypes[interval->reg];
+        int slot;
+        if (interval->machine > 0) {
+            int machine = interval->machine + (type == TYPE_FLOAT ? intRegisters : 0);
+            int key = machine * TYPE_COUNT + type;
+            if (pinned[key] < 0) pinned[key] = newSlot(cfg, type, interval->machine);
+            slot = pinned[key];
+            pinnedWeight[key] += interval->weight;
+        } else if (type == TYPE_ARRAY) {
+            slot = newSlot(cfg, type, 0);
+        } else {
+            SlotHeap* heap = &heaps[type];
+            if (heap->count > 0 && slotEnd[heap->slots[0]] < interval->start) {
+                slot = heap->slots[0];
+                slotEnd[slot] = interval->end;
+                siftSlot(heap, slotEnd, 0);
+            } else {
+                slot = newSlot(cfg, type, 0);
+                slotEnd[slot] = interval->end;
+                pushSlot(heap, slotEnd, slot);
+            }
+        }
+        cfg->registerSlots[interval->reg] = slot;
+    }
+
+    // A machine register carrying several types keeps only its heaviest one's slot
+    for (int machine = 1; machine <= machines; machine++) {
+        int heaviest = -1;
+        for (int t = 0; t < TYPE_COUNT; t++) {
+            int key = machine * TYPE_COUNT + t;
+            if (pinned[key] < 0) continue;
+            if (heaviest < 0 || pinnedWeight[key] > pinnedWeight[heaviest]) heaviest = key;
+        }
+        for (int t = 0; t < TYPE_COUNT; t++) {
+            int key = machine * TYPE_COUNT + t;
+            if (pinned[key] >= 0 && key != heaviest) cfg->slotPins[pinned[key]] = 0;
+        }
+    }
+    for (int t = 0; t < TYPE_COUNT; t++) free(heaps[t].slots);
+    free(pinned);
+    free(pinnedWeight);
+    free(slotEnd);
+}
+
+int assignRegisterSlots(Cfg* cfg, int intRegisters, int floatRegisters) {
+    if (!cfgRegisterAllocation || cfg->registerCount == 0) return 0;
+    LiveInterval* intervals = (LiveInterval*)allocateArray(cfg->registerCount, sizeof(LiveInterval));
+    int count = buildIntervals(cfg, intervals);
+    cfg->spilledRanges = scanRegisterClass(cfg, intervals, count, 0, intRegisters) +
+                         scanRegisterClass(cfg, intervals, count, 1, floatRegisters);
+
+    free(cfg->registerSlots);
+    free(cfg->slotTypes);
+    free(cfg->slotPins);
+    cfg->registerSlots = (int*)allocateArray(cfg->registerCount, sizeof(int));
+    cfg->slotTypes = (unsigned char*)allocateArray(count, 1);
+    cfg->slotPins = (unsigned char*)allocateArray(count, 1);
+    cfg->slotCount = 0;
+    for (int r = 0; r < cfg->registerCount; r++) cfg->registerSlots[r] = -1;
+    assignSlots(cfg, intervals, count, intRegisters, floatRegisters);
+
+    cfg->liveRanges = count;
+    cfg->pinnedRanges = 0;
+    for (int i = 0; i < count; i++) {
+        if (cfg->slotPins[cfg->registerSlots[intervals[i].reg]]) cfg->pinnedRanges++;
+    }
+    free(intervals);
+    return cfg->slotCount;
+}
@@ -0,0 +1,19 @@
+#ifndef REGISTER_ALLOCATOR_H
+#define REGISTER_ALLOCATOR_H
+
+#include "cfg.h"
+
+extern int cfgRegisterAllocation; // Non-zero (default): assignRegisterSlots() shares slots between registers
+
+// Linear-scan register allocation, after eliminateDeadCode(). Each register
+// mentioned gets a live interval (the span of instruction numbers, in block
+// order, from where it is first live to where it is last; see computeLiveness()
+// in dataflow.h), and registers whose intervals do not overlap share a slot of
+// the code generators' register file. Int, char and bool intervals compete for
+// `intRegisters` machine registers and float ones for `floatRegisters`, loop
+// nesting weighting every mention; when they run out the lightest interval
+// stays in memory. The CFG keeps its registers: compileBytecode() renames them
+// to slots. Returns the number of slots.
+int assignRegisterSlots(Cfg* cfg, int intRegisters, int floatRegisters);
+
+#endif // REGISTER_ALLOCATOR_H
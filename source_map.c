@@ -0,0 +1,268 @@
+#include "source_map.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Function to append a line start to the index, growing it as needed
+static void addLineStart(SourceMap *map, size_t offset) {
+    if (map->lineCount == map->lineCapacity) {
+        int newCapacity = map->lineCapacity ? map->lineCapacity * 2 : 256;
+        size_t *grown = (size_t *)realloc(map->lineStarts, newCapacity * sizeof(size_t));
+        if (!grown) {
+            fprintf(stderr, "Error: Memory allocation failed for line index.\n");
+            exit(EXIT_FAILURE);
+        }
+        map->lineStarts = grown;
+        map->lineCapacity = newCapacity;
+    }
+    map->lineStarts[map->lineCount++] = offset;
+}
+
+// Function to build the line-start table with a single pass over the text.
+// With SSE2 the scan compares 16 bytes per step and walks the newline bitmask.
+void buildLineIndex(SourceMap *map) {
+    map->lineCount = 0;
+    addLineStart(map, 0);
+
+    const char *text = map->text;
+    size_t length = map->length;
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    const __m128i newline = _mm_set1_epi8('\n');
+    for (; i + 16 <= length; i += 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(text + i));
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline));
+        while (mask) {
+            int bit = __builtin_ctz(mask);
+            addLineStart(map, i + bit + 1);
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+    // Scalar tail (or the whole buffer without SSE2)
+    while (i < length) {
+        const char *hit = (const char *)memchr(text + i, '\n', length - i);
+        if (!hit) break;
+        i = (size_t)(hit - text) + 1;
+        addLineStart(map, i);
+    }
+}
+
+// Function to create a source map from a copy of `text`
+SourceMap* createSourceMap(const char *text, size_t length, const char *fileName) {
+    SourceMap *map = (SourceMap *)calloc(1, sizeof(SourceMap));
+    if (!map) {
+        fprintf(stderr, "Error: Memory allocation failed for source map.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    map->text = (char *)malloc(length + 1);
+    if (!map->text) {
+        fprintf(stderr, "Error: Memory allocation failed for source text.\n");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(map->text, text, length);
+    map->text[length] = '\0';
+    map->length = length;
+    map->capacity = length + 1;
+    map->fileName = fileName ? strdup(fileName) : NULL;
+
+    buildLineIndex(map);
+    return map;
+}
+
+// Function to read an already opened file into a source map
+SourceMap* readSourceMap(FILE *file, const char *fileName) {
+    if (!file) return NULL;
+
+    size_t capacity = 64 * 1024;
+    size_t length = 0;
+    char *buffer = (char *)malloc(capacity);
+    if (!buffer) {
+        fprintf(stderr, "Error: Memory allocation failed while reading source.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t got;
+    while ((got = fread(buffer + length, 1, capacity - length, file)) > 0) {
+        length += got;
+        if (length == capacity) {
+            capacity *= 2;
+            char *grown = (char *)realloc(buffer, capacity);
+            if (!grown) {
+                fprintf(stderr, "Error: Memory allocation failed while reading source.\n");
+                free(buffer);
+                exit(EXIT_FAILURE);
+            }
+            buffer = grown;
+        }
+    }
+
+    SourceMap *map = createSourceMap(buffer, length, fileName);
+    free(buffer);
+    return map;
+}
+
+// Function to open and index a source file
+SourceMap* loadSourceMap(const char *fileName) {
+    FILE *file = fopen(fileName, "rb");
+    if (!file) {
+        return NULL;
+    }
+    SourceMap *map = readSourceMap(file, fileName);
+    fclose(file);
+    return map;
+}
+
+// Function to free a source map
+void freeSourceMap(SourceMap *map) {
+    if (!map) return;
+    free(map->text);
+    free(map->lineStarts);
+    free(map->fileName);
+    free(map);
+}
+
+// Function to apply a text edit and patch the line-start table in place.
+// Only the edited lines are rescanned; later line starts are shifted.
+void editSourceMap(SourceMap *map, size_t offset, size_t deletedLength,
+                   const char *inserted, size_t insertedLength,
+                   int *firstLine, int *oldLastLine, int *newLastLine) {
+    if (offset > map->length) offset = map->length;
+    if (offset + deletedLength > map->length) deletedLength = map->length - offset;
+
+    int first = sourceLineOf(map, offset);
+    int oldLast = sourceLineOf(map, offset + deletedLength);
+
+    // Splice the text, growing the buffer geometrically
+    size_t newLength = map->length - deletedLength + insertedLength;
+    if (newLength + 1 > map->capacity) {
+        size_t newCapacity = map->capacity * 2;
+        if (newCapacity < newLength + 1) newCapacity = newLength + 1;
+        char *grown = (char *)realloc(map->text, newCapacity);
+        if (!grown) {
+            fprintf(stderr, "Error: Memory allocation failed while editing source.\n");
+            exit(EXIT_FAILURE);
+        }
+        map->text = grown;
+        map->capacity = newCapacity;
+    }
+    memmove(map->text + offset + insertedLength, map->text + offset + deletedLength,
+            map->length - offset - deletedLength + 1);
+    memcpy(map->text + offset, inserted, insertedLength);
+    map->length = newLength;
+
+    // Count the newlines introduced by the edit
+    int addedLines = 0;
+    for (size_t i = 0; i < insertedLength; i++) {
+        if (inserted[i] == '\n') addedLines++;
+    }
+
+    // Line starts after the edit keep their order but move by `delta` bytes
+    int removedLines = oldLast - first;
+    int newLineCount = map->lineCount - removedLines + addedLines;
+    while (map->lineCapacity < newLineCount) {
+        int newCapacity = map->lineCapacity * 2;
+        size_t *grown = (size_t *)realloc(map->lineStarts, newCapacity * sizeof(size_t));
+        if (!grown) {
+            fprintf(stderr, "Error: Memory allocation failed for line index.\n");
+            exit(EXIT_FAILURE);
+        }
+        map->lineStarts = grown;
+        map->lineCapacity = newCapacity;
+    }
+
+    long long delta = (long long)insertedLength - (long long)deletedLength;
+    int tailCount = map->lineCount - oldLast;
+    memmove(map->lineStarts + first + addedLines, map->lineStarts + oldLast, tailCount * sizeof(size_t));
+    for (int i = first + addedLines; i < first + addedLines + tailCount; i++) {
+        map->lineStarts[i] = (size_t)((long long)map->lineStarts[i] + delta);
+    }
+
+    // New line starts inside the inserted text
+    int next = first;
+    for (size_t i = 0; i < insertedLength; i++) {
+        if (inserted[i] == '\n') {
+            map->lineStarts[next++] = offset + i + 1;
+        }
+    }
+
+    map->lineCount = newLineCount;
+    if (firstLine) *firstLine = first;
+    if (oldLastLine) *oldLastLine = oldLast;
+    if (newLastLine) *newLastLine = first + addedLines;
+}
+
+// Function to find the 1-based line containing `offset` (binary search)
+int sourceLineOf(const SourceMap *map, size_t offset) {
+    int low = 0;
+    int high = map->lineCount - 1;
+    while (low < high) {
+        int mid = low + (high - low + 1) / 2;
+        if (map->lineStarts[mid] <= offset) {
+            low = mid;
+        } else {
+            high = mid - 1;
+        }
+    }
+    return low + 1;
+}
+
+// Function to resolve a byte offset to a 1-based line and column
+void sourceLocate(const SourceMap *map, size_t offset, int *line, int *column) {
+    int found = sourceLineOf(map, offset);
+    if (line) *line = found;
+    if (column) *column = (int)(offset - map->lineStarts[found - 1]) + 1;
+}
+
+// Function to get the byte offset where `line` starts
+size_t sourceLineStart(const SourceMap *map, int line) {
+    if (line < 1) return 0;
+    if (line > map->lineCount) return map->length;
+    return map->lineStarts[line - 1];
+}
+
+// Function to get the length of `line` without its line terminator
+size_t sourceLineLength(const SourceMap *map, int line) {
+    if (line < 1 || line > map->lineCount) return 0;
+
+    size_t start = map->lineStarts[line - 1];
+    size_t end = (line < map->lineCount) ? map->lineStarts[line] - 1 : map->length;
+    if (end > start && map->text[end - 1] == '\r') {
+        end--;
+    }
+    return end - start;
+}
+
+// Function to convert a 1-based line/column back to a byte offset
+size_t sourceOffsetOf(const SourceMap *map, int line, int column) {
+    size_t offset = sourceLineStart(map, line) + (column > 0 ? (size_t)(column - 1) : 0);
+    return offset > map->length ? map->length : offset;
+}
+
+// Function to print a source line with a caret under `column`.
+// `width` is the number of characters to underline (at least one caret is printed).
+void printSourceExcerpt(FILE *out, const SourceMap *map, int line, int column, int width) {
+    if (!out || !map || line < 1 || line > map->lineCount) return;
+
+    const char *start = map->text + sourceLineStart(map, line);
+    int length = (int)sourceLineLength(map, line);
+
+    fprintf(out, "%5d | %.*s\n", line, length, start);
+    fprintf(out, "      | ");
+
+    // Reproduce tabs so the caret lines up with the excerpt
+    for (int i = 0; i < column - 1 && i < length; i++) {
+        fputc(start[i] == '\t' ? '\t' : ' ', out);
+    }
+    fputc('^', out);
+    for (int i = 1; i < width; i++) {
+        fputc('~', out);
+    }
+    fputc('\n', out);
+}
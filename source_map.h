@@ -0,0 +1,42 @@
+#ifndef SOURCE_MAP_H
+#define SOURCE_MAP_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+// In-memory copy of a source file plus a line-start offset table.
+// Line numbers and columns are 1-based; byte offsets are 0-based.
+typedef struct {
+    char *text;          // Whole file contents (null-terminated)
+    size_t length;       // Number of bytes in `text`
+    size_t capacity;     // Bytes allocated for `text` (including the terminator)
+    size_t *lineStarts;  // lineStarts[i] = byte offset where line i + 1 begins
+    int lineCount;       // Number of entries in `lineStarts`
+    int lineCapacity;
+    char *fileName;      // Name used in diagnostics (may be NULL)
+} SourceMap;
+
+// Construction
+SourceMap* readSourceMap(FILE *file, const char *fileName); // Slurp an open file
+SourceMap* loadSourceMap(const char *fileName);             // Open, slurp and index a file
+SourceMap* createSourceMap(const char *text, size_t length, const char *fileName); // Copy a buffer
+void buildLineIndex(SourceMap *map);                         // (Re)build `lineStarts` in one scan
+void freeSourceMap(SourceMap *map);
+
+// Editing: replace `deletedLength` bytes at `offset` and patch the line index.
+// Reports the first edited line and the last affected line before/after the edit.
+void editSourceMap(SourceMap *map, size_t offset, size_t deletedLength,
+                   const char *inserted, size_t insertedLength,
+                   int *firstLine, int *oldLastLine, int *newLastLine);
+
+// Position lookup
+int sourceLineOf(const SourceMap *map, size_t offset);                    // Binary search
+void sourceLocate(const SourceMap *map, size_t offset, int *line, int *column);
+size_t sourceOffsetOf(const SourceMap *map, int line, int column);
+size_t sourceLineStart(const SourceMap *map, int line);
+size_t sourceLineLength(const SourceMap *map, int line);               // Excludes the newline
+
+// Diagnostics
+void printSourceExcerpt(FILE *out, const SourceMap *map, int line, int column, int width);
+
+#endif // SOURCE_MAP_H
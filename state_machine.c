@@ -10,6 +10,37 @@
 #include "comment_handler.h"
 #include "config.h"
 
+// Function to tokenize one raw source line, a copy of line `lineNumber` of
+// `source`. The buffer is trimmed in place; the indentation it loses is added
+// back to the offsets tokens are written with, so they point into the source.
+// Returns the multi-line comment state at the end of the line.
+int lexLine(char *line, const SourceMap *source, int lineNumber, int *inComment, FILE *symbolTable) {
+    int indent = 0;
+    while (line[indent] != '\0' && isspace((unsigned char)line[indent])) {
+        indent++;
+    }
+
+    trimWhitespace(line);
+    beginTokenLine(source, sourceLineStart(source, lineNumber) + (size_t)indent);
+
+    // Skip empty lines
+    if (strlen(line) == 0) {
+        return *inComment;
+    }
+
+    // Handle multi-line comments
+    if (handleComments(line, inComment, lineNumber, symbolTable)) {
+        return *inComment; // Skip the rest of the line if still inside a comment
+    }
+
+    // Process the current line using the state machine
+    processLine(line, lineNumber, symbolTable);
+    return *inComment;
+} // end of lexLine function
+
+
+
+
 // processLine function
 void processLine(char *line, int lineNumber, FILE *symbolTable) {
     State state = START;
@@ -24,6 +55,7 @@ void processLine(char *line, int lineNumber, FILE *symbolTable) {
 
     for (int j = 0; line[j] != '\0'; j++) {
         char c = line[j];
+        if (i == 0) setTokenStart(j); // Nothing built yet: a token starting now starts here
 
         switch (state) {
             case START:
@@ -247,7 +279,7 @@ void processLine(char *line, int lineNumber, FILE *symbolTable) {
     } else {
         // Finalize identifier
         currentToken[i] = '\0'; // Null-terminate the token
-        printf("Finalizing token: %s\n", currentToken); // Debug
+        if (lexerDebug) printf("Finalizing token: %s\n", currentToken); // Debug
 
         // Check if the identifier is prefixed with '&'
         if (currentToken[0] == '&') {
@@ -256,17 +288,17 @@ void processLine(char *line, int lineNumber, FILE *symbolTable) {
         } else {
             Token *token = keywords(currentToken, lineNumber); // Check keywords
             if (token) {
-                printf("Keyword detected: %s\n", token->value); // Debug
+                if (lexerDebug) printf("Keyword detected: %s\n", token->value); // Debug
                 writeToken(symbolTable, token->type, token->value, lineNumber);
                 free(token);
             } else if (isReservedWord(currentToken)) {
-                printf("ReservedWord detected: %s\n", currentToken); // Debug
+                if (lexerDebug) printf("ReservedWord detected: %s\n", currentToken); // Debug
                 writeToken(symbolTable, "ReservedWord", currentToken, lineNumber);
             } else if (isNoiseWord(currentToken)) {
-                printf("NoiseWord detected: %s\n", currentToken); // Debug
+                if (lexerDebug) printf("NoiseWord detected: %s\n", currentToken); // Debug
                 writeToken(symbolTable, "NoiseWord", currentToken, lineNumber);
             } else {
-                printf("IDENTIFIER detected: %s\n", currentToken); // Debug
+                if (lexerDebug) printf("IDENTIFIER detected: %s\n", currentToken); // Debug
                 writeToken(symbolTable, "IDENTIFIER", currentToken, lineNumber);
             }
         }
@@ -276,6 +308,7 @@ void processLine(char *line, int lineNumber, FILE *symbolTable) {
         memset(currentToken, '\0', sizeof(currentToken));
 
         // Handle next character
+        setTokenStart(j);
         if ((c == '+' && line[j + 1] == '+') || (c == '-' && line[j + 1] == '-')) {
             // Handle unary operators (++, --) following an identifier
             currentToken[i++] = c;
@@ -350,6 +383,7 @@ void processLine(char *line, int lineNumber, FILE *symbolTable) {
                                 i = 0;
 
                                 // Handle next character
+                                setTokenStart(j);
                                 if (isDelimiter(c)) {
                                     currentToken[i++] = c;
                                     currentToken[i] = '\0';
@@ -388,6 +422,7 @@ void processLine(char *line, int lineNumber, FILE *symbolTable) {
                                 i = 0;
 
                                 // Handle next character
+                                setTokenStart(j);
                                 if (isDelimiter(c)) {
                                     currentToken[i++] = c;
                                     currentToken[i] = '\0';
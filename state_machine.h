@@ -2,6 +2,7 @@
 #define STATE_MACHINE_H
 
 #include <stdio.h>
+#include "source_map.h"
 
 // FSM state types
 typedef enum {
@@ -50,4 +51,7 @@ typedef enum {
 // Function to process a single line using the FSM
 void processLine(char *line, int lineNumber, FILE *symbolTable);
 
+// Function to trim, comment-check and tokenize one raw source line (a copy of line `lineNumber` of `source`)
+int lexLine(char *line, const SourceMap *source, int lineNumber, int *inComment, FILE *symbolTable);
+
 #endif // STATE_MACHINE_H
@@ -0,0 +1,217 @@
+#include "symbol_table.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define SYMBOL_INITIAL_SLOTS 256
+
+static void* reallocOrDie(void* memory, size_t size) {
+    void* grown = realloc(memory, size);
+    if (!grown) {
+        fprintf(stderr, "Error: Memory allocation failed in symbol table.\n");
+        exit(EXIT_FAILURE);
+    }
+    return grown;
+}
+
+// Multiplicative hash; an odd multiplier keeps consecutive intern ids in distinct slots
+static uint32_t slotOf(const SymbolTable* table, SymbolId name) {
+    return (uint32_t)(name * 2654435769u) & table->slotMask;
+}
+
+// Function to find the slot holding `name`, or the empty slot where it belongs
+static uint32_t probe(const SymbolTable* table, SymbolId name) {
+    uint32_t slot = slotOf(table, name);
+    while (table->slotKeys[slot] != SYMBOL_NONE && table->slotKeys[slot] != name) {
+        slot = (slot + 1) & table->slotMask;
+    }
+    return slot;
+}
+
+// Double the slot arrays and reinsert every key
+static void growSlots(SymbolTable* table) {
+    SymbolId* oldKeys = table->slotKeys;
+    int* oldSymbols = table->slotSymbols;
+    uint32_t oldCapacity = table->slotMask + 1;
+
+    table->slotMask = oldCapacity * 2 - 1;
+    table->slotKeys = (SymbolId*)calloc(oldCapacity * 2, sizeof(SymbolId));
+    table->slotSymbols = (int*)malloc(oldCapacity * 2 * sizeof(int));
+    if (!table->slotKeys || !table->slotSymbols) {
+        fprintf(stderr, "Error: Memory allocation failed in symbol table.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (uint32_t i = 0; i < oldCapacity; i++) {
+        if (oldKeys[i] == SYMBOL_NONE) continue;
+        uint32_t slot = probe(table, oldKeys[i]);
+        table->slotKeys[slot] = oldKeys[i];
+        table->slotSymbols[slot] = oldSymbols[i];
+    }
+
+    free(oldKeys);
+    free(oldSymbols);
+}
+
+// ---------------------------------------
+// Table management
+// ---------------------------------------
+
+// Function to create an empty table with the program scope open
+SymbolTable* createSymbolTable(void) {
+    SymbolTable* table = (SymbolTable*)calloc(1, sizeof(SymbolTable));
+    if (!table) {
+        fprintf(stderr, "Error: Memory allocation failed for symbol table.\n");
+        exit(EXIT_FAILURE);
+    }
+    table->slotMask = SYMBOL_INITIAL_SLOTS - 1;
+    table->slotKeys = (SymbolId*)calloc(SYMBOL_INITIAL_SLOTS, sizeof(SymbolId));
+    table->slotSymbols = (int*)malloc(SYMBOL_INITIAL_SLOTS * sizeof(int));
+    if (!table->slotKeys || !table->slotSymbols) {
+        fprintf(stderr, "Error: Memory allocation failed for symbol table.\n");
+        exit(EXIT_FAILURE);
+    }
+    table->scopeDepth = -1;
+    pushScope(table);
+    return table;
+}
+
+void freeSymbolTable(SymbolTable* table) {
+    if (!table) return;
+    free(table->symbols);
+    free(table->slotKeys);
+    free(table->slotSymbols);
+    free(table->liveSymbols);
+    free(table->scopeMarks);
+    free(table);
+}
+
+// ---------------------------------------
+// Scopes
+// ---------------------------------------
+
+void pushScope(SymbolTable* table) {
+    if (table->scopeDepth + 1 == table->scopeCapacity) {
+        table->scopeCapacity = table->scopeCapacity ? table->scopeCapacity * 2 : 32;
+        table->scopeMarks = (int*)reallocOrDie(table->scopeMarks, table->scopeCapacity * sizeof(int));
+    }
+    table->scopeMarks[++table->scopeDepth] = table->liveCount;
+    table->scopeCount++;
+}
+
+// Function to close the innermost scope, making shadowed declarations visible again
+void popScope(SymbolTable* table) {
+    if (table->scopeDepth <= 0) {
+        return; // The program scope stays open
+    }
+
+    int mark = table->scopeMarks[table->scopeDepth--];
+    while (table->liveCount > mark) {
+        const Symbol* symbol = &table->symbols[table->liveSymbols[--table->liveCount]];
+        table->slotSymbols[probe(table, symbol->name)] = symbol->shadowed;
+    }
+}
+
+// ---------------------------------------
+// Declarations and uses
+// ---------------------------------------
+
+Symbol* declareSymbol(SymbolTable* table, SymbolId name, SymbolType type, int line, int column) {
+    if (name == SYMBOL_NONE) return NULL;
+
+    uint32_t slot = probe(table, name);
+    int visible = (table->slotKeys[slot] == name) ? table->slotSymbols[slot] : -1;
+    if (visible >= 0 && table->symbols[visible].scopeDepth == table->scopeDepth) {
+        return NULL; // Already declared in this scope
+    }
+
+    if (table->symbolCount == table->symbolCapacity) {
+        table->symbolCapacity = table->symbolCapacity ? table->symbolCapacity * 2 : 256;
+        table->symbols = (Symbol*)reallocOrDie(table->symbols, table->symbolCapacity * sizeof(Symbol));
+    }
+    int index = table->symbolCount++;
+    Symbol* symbol = &table->symbols[index];
+    symbol->name = name;
+    symbol->type = type;
+    symbol->scopeDepth = table->scopeDepth;
+    symbol->line = line;
+    symbol->column = column;
+    symbol->useCount = 0;
+    symbol->shadowed = visible;
+    symbol->elementType = TYPE_UNKNOWN;
+    symbol->rank = 0;
+
+    if (table->liveCount == table->liveCapacity) {
+        table->liveCapacity = table->liveCapacity ? table->liveCapacity * 2 : 256;
+        table->liveSymbols = (int*)reallocOrDie(table->liveSymbols, table->liveCapacity * sizeof(int));
+    }
+    table->liveSymbols[table->liveCount++] = index;
+
+    if (table->slotKeys[slot] != name) {
+        table->slotKeys[slot] = name;
+        table->slotUsed++;
+    }
+    table->slotSymbols[slot] = index;
+
+    // Keep the load factor below 1/2 so probe chains stay short
+    if (table->slotUsed * 2 > table->slotMask + 1) {
+        growSlots(table);
+    }
+    return symbol;
+}
+
+Symbol* lookupSymbol(const SymbolTable* table, SymbolId name) {
+    if (name == SYMBOL_NONE) return NULL;
+    uint32_t slot = probe(table, name);
+    if (table->slotKeys[slot] != name || table->slotSymbols[slot] < 0) {
+        return NULL;
+    }
+    return &table->symbols[table->slotSymbols[slot]];
+}
+
+Symbol* useSymbol(SymbolTable* table, SymbolId name) {
+    Symbol* symbol = lookupSymbol(table, name);
+    if (symbol) {
+        symbol->useCount++;
+    }
+    return symbol;
+}
+
+// ---------------------------------------
+// Type names and output
+// ---------------------------------------
+
+SymbolType symbolTypeFromName(const char* name) {
+    if (strcmp(name, "int") == 0) return TYPE_INT;
+    if (strcmp(name, "float") == 0) return TYPE_FLOAT;
+    if (strcmp(name, "char") == 0) return TYPE_CHAR;
+    if (strcmp(name, "bool") == 0) return TYPE_BOOL;
+    if (strcmp(name, "string") == 0) return TYPE_STRING;
+    return TYPE_UNKNOWN;
+}
+
+const char* symbolTypeName(SymbolType type) {
+    switch (type) {
+        case TYPE_INT: return "int";
+        case TYPE_FLOAT: return "float";
+        case TYPE_CHAR: return "char";
+        case TYPE_BOOL: return "bool";
+        case TYPE_STRING: return "string";
+        case TYPE_ARRAY: return "array";
+        default: return "unknown";
+    }
+}
+
+// Function to write every declaration as name,type,scope depth,line:column,uses
+void writeSymbolTable(const SymbolTable* table, FILE* file) {
+    for (int i = 0; i < table->symbolCount; i++) {
+        const Symbol* symbol = &table->symbols[i];
+        if (symbol->type == TYPE_ARRAY) {
+            fprintf(file, "%s,%s%s,%d,%d:%d,%d\n", internedString(symbol->name), symbolTypeName(symbol->elementType),
+                    symbol->rank == 2 ? "[][]" : "[]", symbol->scopeDepth, symbol->line, symbol->column,
+                    symbol->useCount);
+            continue;
+        }
+        fprintf(file, "%s,%s,%d,%d:%d,%d\n", internedString(symbol->name), symbolTypeName(symbol->type),
+                symbol->scopeDepth, symbol->line, symbol->column, symbol->useCount);
+    }
+}
@@ -0,0 +1,75 @@
+#ifndef SYMBOL_TABLE_H
+#define SYMBOL_TABLE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "intern.h"
+
+// Declared type of a symbol
+typedef enum {
+    TYPE_UNKNOWN,
+    TYPE_INT,
+    TYPE_FLOAT,
+    TYPE_CHAR,
+    TYPE_BOOL,
+    TYPE_STRING,
+    TYPE_ARRAY,      // Typed array; the symbol's elementType and rank describe it
+    TYPE_COUNT       // Number of type ids (dense, usable as a table index)
+} SymbolType;
+
+// One declaration. Symbols are never removed, so indices stay valid after their scope closes.
+typedef struct {
+    SymbolId name;     // Interned identifier
+    SymbolType type;
+    int scopeDepth;    // 0 = program level
+    int line;          // Declaration site
+    int column;
+    int useCount;      // Uses resolved to this declaration
+    int shadowed;      // Symbol hidden by this declaration (-1 if none)
+    SymbolType elementType; // TYPE_ARRAY: type of the elements
+    int rank;               // TYPE_ARRAY: number of dimensions (1 or 2), 0 otherwise
+} Symbol;
+
+// Scoped symbol table: one open-addressing map from identifier id to the
+// innermost visible declaration, plus a stack of live declarations so a
+// scope pop restores whatever each of its symbols shadowed.
+typedef struct {
+    Symbol* symbols;        // Every declaration, in source order
+    int symbolCount;
+    int symbolCapacity;
+
+    SymbolId* slotKeys;     // Hash slots (SYMBOL_NONE = empty)
+    int* slotSymbols;       // Visible symbol for the key (-1 = none in scope)
+    uint32_t slotMask;      // Slot capacity - 1 (power of two)
+    uint32_t slotUsed;
+
+    int* liveSymbols;       // Declarations of the open scopes, innermost last
+    int liveCount;
+    int liveCapacity;
+    int* scopeMarks;        // liveCount at each scope entry
+    int scopeDepth;
+    int scopeCapacity;
+    int scopeCount;         // Scopes opened so far (statistics)
+} SymbolTable;
+
+// Table management
+SymbolTable* createSymbolTable(void);
+void freeSymbolTable(SymbolTable* table);
+
+// Scopes
+void pushScope(SymbolTable* table);
+void popScope(SymbolTable* table);
+
+// Declarations and uses
+Symbol* declareSymbol(SymbolTable* table, SymbolId name, SymbolType type, int line, int column); // NULL if redeclared in this scope
+Symbol* lookupSymbol(const SymbolTable* table, SymbolId name);                                   // Innermost visible declaration
+Symbol* useSymbol(SymbolTable* table, SymbolId name);                                            // Lookup and count the use
+
+// Type names
+SymbolType symbolTypeFromName(const char* name);
+const char* symbolTypeName(SymbolType type);
+
+// Output: name,type,scope depth,line:column,uses (arrays as int[] or int[][])
+void writeSymbolTable(const SymbolTable* table, FILE* file);
+
+#endif // SYMBOL_TABLE_H
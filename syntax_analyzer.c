@@ -8,12 +8,41 @@
 
 #include "syntax_analyzer.h" // Custom syntax analyzer header
 #include "token.h"           // Custom token header
+#include "source_map.h"      // Line/column index for diagnostics
+#include "benchmark.h"       // --bench drivers
+#include "symbol_table.h"    // Scoped declarations
+#include "type_checker.h"    // Expression types and int-to-float conversions
+#include "constant_folder.h"  // Compile-time evaluation of constant expressions
+#include "cfg.h"              // Basic blocks and dominators
+#include "bounds_check.h"     // Array bounds checks proven unnecessary
+#include "loop_vectorizer.h"  // Array loops replaced by whole-loop kernels
+#include "loop_optimizer.h"   // Loop-invariant code motion and strength reduction
+#include "value_numbering.h"  // Redundant computations removed
+#include "dead_code.h"        // Constant branches folded and dead stores removed
+#include "register_allocator.h" // Linear-scan slots for the code generators
+#include "bytecode.h"         // Register bytecode compiled from the CFG
+#include "vm.h"               // Bytecode interpreter for --run
+#include "c_emitter.h"        // C translation for --emit-c
+#include "jit.h"              // Native code for --jit
+#include "vector_kernels.h"   // SIMD kernels behind vectorized loops
+#include "dataflow.h"         // Liveness, reaching definitions and definite assignment
 
 // Global Variables
 int currentTokenIndex = 0;        // Tracks the current token
 int totalTokens = 0;              // Total tokens available
 Token tokens[MAX_TOKENS];         // Token array
 Token* tokenStream = tokens;      // Pointer to the token array
+SourceMap* sourceMap = NULL;      // Source text for diagnostics (NULL if not found)
+int parserDebug = 1;              // Set to 0 to silence [DEBUG] tracing
+int syntaxErrorCount = 0;         // Errors reported so far (callers compare before/after)
+int spanBase = 0;                 // Start of the innermost tracked node being parsed
+int lazyBlocks = 0;               // Non-zero: defer block bodies until expandBlock()
+int* matchingDelimiter = NULL;    // Partner index of each bracket token (see buildDelimiterIndex)
+int deferredBlockCount = 0;       // Blocks whose body was skipped
+int expandedBlockCount = 0;       // Deferred blocks later expanded
+SymbolTable* semanticTable = NULL; // Declarations seen so far (NULL = not recorded)
+int semanticErrorCount = 0;       // Redeclarations and undeclared uses
+static int declaringIdentifier = 0; // Set while matchToken consumes a declared name
 int skipToMatchingDelimiter(const char* delimiter);
 
 // Function prototypes specific to syntax_analyzer.c
@@ -27,9 +56,9 @@ Token* peekNextToken();                      // Peek at the next token
 Token* peekNextToken() {
     // Ensure there's at least one more token to peek
     if (currentTokenIndex + 1 < totalTokens) {
-        return &tokens[currentTokenIndex + 1];
+        return &tokenStream[currentTokenIndex + 1];
     }
-    printf("DEBUG: No next token available. Current Index=%d, Total Tokens=%d\n",
+    if (parserDebug) printf("DEBUG: No next token available. Current Index=%d, Total Tokens=%d\n",
            currentTokenIndex, totalTokens);
     return NULL;
 }
@@ -37,8 +66,8 @@ Token* peekNextToken() {
 // Function to retrieve the next token
 Token* getNextToken() {
     if (currentTokenIndex < totalTokens) {
-        Token* currentToken = &tokens[currentTokenIndex];
-        printf("[DEBUG] getNextToken: Retrieved Token[%d]: Type='%s', Value='%s', Line=%d\n",
+        Token* currentToken = &tokenStream[currentTokenIndex];
+        if (parserDebug) printf("[DEBUG] getNextToken: Retrieved Token[%d]: Type='%s', Value='%s', Line=%d\n",
                currentTokenIndex, currentToken->type, currentToken->value, currentToken->lineNumber);
 
         // Advance the token index
@@ -46,9 +75,9 @@ Token* getNextToken() {
 
         // Check for whitespace or comments and skip if necessary
         while (currentTokenIndex < totalTokens) {
-            Token* nextToken = &tokens[currentTokenIndex];
+            Token* nextToken = &tokenStream[currentTokenIndex];
             if (strcmp(nextToken->type, "Whitespace") == 0 || strcmp(nextToken->type, "Comment") == 0) {
-                printf("[DEBUG] Skipping Token[%d]: Type='%s', Value='%s', Line=%d\n",
+                if (parserDebug) printf("[DEBUG] Skipping Token[%d]: Type='%s', Value='%s', Line=%d\n",
                        currentTokenIndex, nextToken->type, nextToken->value, nextToken->lineNumber);
                 currentTokenIndex++;
             } else {
@@ -58,7 +87,7 @@ Token* getNextToken() {
 
         return currentToken;
     } else {
-        printf("[DEBUG] getNextToken: End of token stream reached. Current Index=%d, Total Tokens=%d\n",
+        if (parserDebug) printf("[DEBUG] getNextToken: End of token stream reached. Current Index=%d, Total Tokens=%d\n",
                currentTokenIndex, totalTokens);
         return NULL; // No more tokens available
     }
@@ -69,7 +98,7 @@ Token* peekToken() {
     static int repeatCounter = 0;
 
     if (currentTokenIndex < totalTokens) {
-        Token* token = &tokens[currentTokenIndex];
+        Token* token = &tokenStream[currentTokenIndex];
 
         // Detect repetitive token peeks
         if (currentTokenIndex == previousTokenIndex) {
@@ -86,39 +115,16 @@ Token* peekToken() {
         previousTokenIndex = currentTokenIndex;
 
         // Debug output
-        printf("[DEBUG] peekToken: Current Token[%d]: Type='%s', Value='%s', Line=%d\n",
+        if (parserDebug) printf("[DEBUG] peekToken: Current Token[%d]: Type='%s', Value='%s', Line=%d\n",
                currentTokenIndex, token->type, token->value, token->lineNumber);
         return token;
     }
 
-    printf("[DEBUG] peekToken: End of token stream reached. Current Index=%d, Total Tokens=%d\n",
+    if (parserDebug) printf("[DEBUG] peekToken: End of token stream reached. Current Index=%d, Total Tokens=%d\n",
            currentTokenIndex, totalTokens);
     return NULL;
 }
 
-// Function to trim leading and trailing whitespace from a string
-void trimWhitespace(char *str) {
-    if (!str || !*str) return;
-
-    // Trim leading whitespace
-    char *start = str;
-    while (isspace((unsigned char)*start)) {
-        start++;
-    }
-
-    // Move trimmed string to the beginning
-    if (start != str) {
-        memmove(str, start, strlen(start) + 1);
-    }
-
-    // Trim trailing whitespace
-    char *end = str + strlen(str) - 1;
-    while (end >= str && isspace((unsigned char)*end)) {
-        *end = '\0';
-        end--;
-    }
-}
-
 // Token maper function = Match the tokens from the symbol table and load them using the loadTokenFromFile
 void mapToken(Token* token) {
     if (strcmp(token->type, "Delimiter") == 0) {
@@ -236,7 +242,12 @@ void mapToken(Token* token) {
     } else if (strcmp(token->type, "STRING_LITERAL") == 0) {
         strcpy(token->type, "STRING_LITERAL");
     } else if (strcmp(token->type, "ReservedWord") == 0) {
-        strcpy(token->type, "ReservedWord");
+        // The lexer reserves true/false; the parser reads them as bool literal keywords
+        if (strcmp(token->value, "true") == 0 || strcmp(token->value, "false") == 0) {
+            strcpy(token->type, "Keyword");
+        } else {
+            strcpy(token->type, "ReservedWord");
+        }
     } else if (strcmp(token->type, "NoiseWord") == 0) {
         strcpy(token->type, "NoiseWord");
     } else if (strstr(token->type, "Comment") != NULL) {
@@ -263,7 +274,7 @@ int loadTokensFromFile(const char *filename) {
 
         // Skip empty lines
         if (strlen(line) == 0) {
-            printf("[DEBUG] Skipping empty line.\n");
+            if (parserDebug) printf("[DEBUG] Skipping empty line.\n");
             continue;
         }
 
@@ -288,6 +299,10 @@ int loadTokensFromFile(const char *filename) {
         strncpy(value, firstComma + 1, sizeof(value) - 1);
         lineNumber = atoi(lastComma + 1);
 
+        // Newer token files carry the column as `line:column`
+        char *colon = strchr(lastComma + 1, ':');
+        token.column = colon ? atoi(colon + 1) : 0;
+
         // Populate the token
         strncpy(token.type, type, sizeof(token.type) - 1);
         strncpy(token.value, value, sizeof(token.value) - 1);
@@ -296,6 +311,9 @@ int loadTokensFromFile(const char *filename) {
         // Map the token to handle value-specific tokens
         mapToken(&token);
 
+        // Intern identifiers and string literals so later phases compare ids, not text
+        token.symbolId = internTokenValue(&token);
+
         // Add the token to the list
         if (totalTokens < MAX_TOKENS) {
             tokens[totalTokens++] = token;
@@ -310,17 +328,17 @@ int loadTokensFromFile(const char *filename) {
     // Print loaded tokens
     printf("\n[DEBUG] Total Tokens Loaded: %d\n", totalTokens);
     for (int i = 0; i < totalTokens; i++) {
-        printf("[DEBUG] Token[%d]: Type='%s', Value='%s', Line=%d\n",
+        if (parserDebug) printf("[DEBUG] Token[%d]: Type='%s', Value='%s', Line=%d\n",
                i, tokens[i].type, tokens[i].value, tokens[i].lineNumber);
     }
 
-    printf("[DEBUG] Completed loading tokens from %s.\n", filename);
+    if (parserDebug) printf("[DEBUG] Completed loading tokens from %s.\n", filename);
     return totalTokens;
 }
 
 // Token Matching
 ParseTreeNode* matchToken(const char* expectedType, const char* expectedValue) {
-    printf("[DEBUG] Matching Token. Expected Type='%s', Value='%s'\n", expectedType, expectedValue);
+    if (parserDebug) printf("[DEBUG] Matching Token. Expected Type='%s', Value='%s'\n", expectedType, expectedValue);
 
     Token* token = peekToken(); // Peek the current token without advancing
     if (!token) {
@@ -331,7 +349,7 @@ ParseTreeNode* matchToken(const char* expectedType, const char* expectedValue) {
     }
 
     // Log the current token
-    printf("[DEBUG] Current Token: Type='%s', Value='%s', Line=%d\n",
+    if (parserDebug) printf("[DEBUG] Current Token: Type='%s', Value='%s', Line=%d\n",
            token->type, token->value, token->lineNumber);
 
     // Check if the token matches the expected type and value
@@ -348,7 +366,7 @@ ParseTreeNode* matchToken(const char* expectedType, const char* expectedValue) {
     }
 
     // If token matches, log the match
-    printf("[DEBUG] Token matched successfully. Type='%s', Value='%s', Line=%d\n",
+    if (parserDebug) printf("[DEBUG] Token matched successfully. Type='%s', Value='%s', Line=%d\n",
            token->type, token->value, token->lineNumber);
 
     // Consume the token by advancing to the next
@@ -356,7 +374,7 @@ ParseTreeNode* matchToken(const char* expectedType, const char* expectedValue) {
     if (!token) {
         printf("[WARNING] getNextToken returned NULL after successful match.\n");
     } else {
-        printf("[DEBUG] Token advanced to: Type='%s', Value='%s', Line=%d\n",
+        if (parserDebug) printf("[DEBUG] Token advanced to: Type='%s', Value='%s', Line=%d\n",
                token->type, token->value, token->lineNumber);
     }
 
@@ -368,10 +386,46 @@ ParseTreeNode* matchToken(const char* expectedType, const char* expectedValue) {
         recoverFromError();
         return NULL;
     }
+    node->symbolId = token->symbolId;
+
+    // Resolve identifier uses against the scopes open at this point
+    if (semanticTable && !declaringIdentifier && token->symbolId != SYMBOL_NONE &&
+        strcmp(expectedType, "IDENTIFIER") == 0) {
+        noteIdentifierUse(token);
+    }
 
     return node;
 }
 
+// Function to count a use of an identifier, reporting it if nothing declares it
+void noteIdentifierUse(const Token* token) {
+    if (!useSymbol(semanticTable, token->symbolId)) {
+        char message[160];
+        snprintf(message, sizeof(message), "'%s' is used before it is declared.", internedString(token->symbolId));
+        reportSemanticError(token, message);
+    }
+}
+
+// Function to match the identifier of a declaration and enter it in the current scope
+ParseTreeNode* matchDeclaredIdentifier(const char* typeName) {
+    Token* token = peekToken();
+    declaringIdentifier = 1;
+    ParseTreeNode* node = matchToken("IDENTIFIER", token->value);
+    declaringIdentifier = 0;
+
+    if (node && semanticTable) {
+        SymbolType type = symbolTypeFromName(typeName);
+        if (!declareSymbol(semanticTable, token->symbolId, type, token->lineNumber, token->column)) {
+            const Symbol* previous = lookupSymbol(semanticTable, token->symbolId);
+            char message[160];
+            snprintf(message, sizeof(message), "'%s' is already declared in this scope (line %d).",
+                     token->value, previous ? previous->line : 0);
+            reportSemanticError(token, message);
+        }
+    }
+    return node;
+}
+
 
 // ---------------------------------------
 // Error Handling
@@ -380,25 +434,49 @@ ParseTreeNode* matchToken(const char* expectedType, const char* expectedValue) {
 // Syntax Error Notice
 int reportSyntaxError(const char* message) {
     Token* token = peekToken();
+    syntaxErrorCount++;
 
     if (token) {
         // Apply token mapping if necessary
         mapToken(token); // Ensure the token is correctly mapped before displaying
 
-        printf("Syntax Error at line %d: %s\n", token->lineNumber, message);
-        printf("DEBUG: Current Token - Type='%s', Value='%s'\n",
+        if (token->column > 0) {
+            printf("Syntax Error at line %d, column %d: %s\n", token->lineNumber, token->column, message);
+        } else {
+            printf("Syntax Error at line %d: %s\n", token->lineNumber, message);
+        }
+
+        // Show the offending source line from memory with a caret under the token
+        if (sourceMap && token->column > 0) {
+            printSourceExcerpt(stdout, sourceMap, token->lineNumber, token->column, (int)strlen(token->value));
+        }
+
+        if (parserDebug) printf("DEBUG: Current Token - Type='%s', Value='%s'\n",
                token->type, token->value);
     } else {
         printf("Syntax Error: %s\n", message);
-        printf("DEBUG: No more tokens available for context.\n");
+        if (parserDebug) printf("DEBUG: No more tokens available for context.\n");
     }
 
     printf("Attempting to recover...\n");
 }
 
+// Semantic Error Notice (no recovery needed: the tree is still well formed)
+void reportSemanticError(const Token* token, const char* message) {
+    semanticErrorCount++;
+    if (token->column > 0) {
+        printf("Semantic Error at line %d, column %d: %s\n", token->lineNumber, token->column, message);
+    } else {
+        printf("Semantic Error at line %d: %s\n", token->lineNumber, message);
+    }
+    if (sourceMap && token->column > 0) {
+        printSourceExcerpt(stdout, sourceMap, token->lineNumber, token->column, (int)strlen(token->value));
+    }
+}
+
 // Panic Mode Recovery
 int recoverFromError() {
-    printf("DEBUG: Initiating error recovery...\n");
+    if (parserDebug) printf("DEBUG: Initiating error recovery...\n");
 
     // Recovery delimiters for statement endings or block boundaries
     const char* recoveryDelimiters[] = {";", "{", "}", ")", NULL};
@@ -408,14 +486,14 @@ int recoverFromError() {
 
     Token* token;
     while ((token = peekToken()) != NULL) {
-        printf("DEBUG: Token during recovery: Type='%s', Value='%s', Line=%d\n",
+        if (parserDebug) printf("DEBUG: Token during recovery: Type='%s', Value='%s', Line=%d\n",
                token->type, token->value, token->lineNumber);
 
         // Recovery at delimiters: ';', '}', etc.
         if (strcmp(token->type, "Delimiter") == 0) {
             for (int i = 0; recoveryDelimiters[i] != NULL; i++) {
                 if (strcmp(token->value, recoveryDelimiters[i]) == 0) {
-                    printf("DEBUG: Recovered at delimiter: '%s' on line %d\n", token->value, token->lineNumber);
+                    if (parserDebug) printf("DEBUG: Recovered at delimiter: '%s' on line %d\n", token->value, token->lineNumber);
                     getNextToken(); // Consume the delimiter
                     return 1; // Recovery succeeded
                 }
@@ -426,7 +504,7 @@ int recoverFromError() {
         if (strcmp(token->type, "Keyword") == 0) {
             for (int i = 0; recoveryKeywords[i] != NULL; i++) {
                 if (strcmp(token->value, recoveryKeywords[i]) == 0) {
-                    printf("DEBUG: Recovered at keyword: '%s' on line %d\n", token->value, token->lineNumber);
+                    if (parserDebug) printf("DEBUG: Recovered at keyword: '%s' on line %d\n", token->value, token->lineNumber);
                     return 1; // Recovery succeeded
                 }
             }
@@ -434,13 +512,13 @@ int recoverFromError() {
 
         // Skip over comments explicitly
         if (strcmp(token->type, "Comment") == 0) {
-            printf("DEBUG: Skipping comment token during recovery: '%s' on line %d\n", token->value, token->lineNumber);
+            if (parserDebug) printf("DEBUG: Skipping comment token during recovery: '%s' on line %d\n", token->value, token->lineNumber);
             getNextToken(); // Consume the comment token
             continue; // Continue recovery process
         }
 
         // Skip the current token if no recovery point is found
-        printf("DEBUG: Skipping Token: Type='%s', Value='%s', Line=%d\n",
+        if (parserDebug) printf("DEBUG: Skipping Token: Type='%s', Value='%s', Line=%d\n",
                token->type, token->value, token->lineNumber);
         getNextToken();
     }
@@ -456,7 +534,7 @@ int recoverFromError() {
 // Recursive Descent Parsing Function
 // Recursive Descent Parsing Function
 ParseTreeNode* parseProgram() {
-    printf("[DEBUG] Starting parseProgram...\n");
+    if (parserDebug) printf("[DEBUG] Starting parseProgram...\n");
 
     // Create the root node for the program
     ParseTreeNode* root = createParseTreeNode("Program", NULL);
@@ -464,6 +542,14 @@ ParseTreeNode* parseProgram() {
     Token* lastToken = NULL;
     int loopSafetyCounter = 0;
 
+    int statementStart = currentTokenIndex;
+    root->tokenOffset = statementStart;
+
+    // Lazy mode skips block bodies by brace-matching
+    if (lazyBlocks) {
+        buildDelimiterIndex();
+    }
+
     // Loop through the tokens and parse statements
     while (peekToken()) {
         Token* currentToken = peekToken();
@@ -481,11 +567,12 @@ ParseTreeNode* parseProgram() {
         }
         lastToken = currentToken;
 
-        printf("[DEBUG] Parsing statement starting with Token: Type='%s', Value='%s', Line=%d\n",
+        if (parserDebug) printf("[DEBUG] Parsing statement starting with Token: Type='%s', Value='%s', Line=%d\n",
                currentToken->type, currentToken->value, currentToken->lineNumber);
 
         // Parse the current statement
-        ParseTreeNode* statementNode = parseStatement();
+        statementStart = currentTokenIndex;
+        ParseTreeNode* statementNode = parseTrackedStatement(root->tokenOffset, statementStart);
 
         if (!statementNode) {
             printf("[WARNING] Failed to parse statement at Token: Type='%s', Value='%s', Line=%d\n",
@@ -501,17 +588,80 @@ ParseTreeNode* parseProgram() {
 
         // Add the successfully parsed statement to the program tree
         addChild(root, statementNode);
-        printf("[DEBUG] Added child to root node. Current children count: %d\n", root->childCount);
+        if (parserDebug) printf("[DEBUG] Added child to root node. Current children count: %d\n", root->childCount);
     }
 
-    printf("[DEBUG] Completed parsing program.\n");
+    root->tokenSpan = currentTokenIndex - root->tokenOffset;
+
+    if (parserDebug) printf("[DEBUG] Completed parsing program.\n");
     return root;
 }
 
+// Function to parse one statement of a Program or Block and record its token span.
+// Offsets are relative to `containerStart`; blocks nested in the statement are
+// recorded relative to the statement itself (see spanBase).
+ParseTreeNode* parseTrackedStatement(int containerStart, int statementStart) {
+    int savedBase = spanBase;
+    spanBase = statementStart;
+    ParseTreeNode* statementNode = parseStatement();
+    spanBase = savedBase;
+
+    if (statementNode) {
+        statementNode->tokenOffset = statementStart - containerStart;
+        statementNode->tokenSpan = currentTokenIndex - statementStart;
+    }
+    return statementNode;
+}
+
 // ---------------------------------------
 // Main Function
 // ---------------------------------------
 
+// Function to run `program` in the interpreter and again with the JIT on the same
+// input, comparing everything they print. Returns non-zero when they agree.
+static int verifyJit(const BytecodeProgram* program) {
+    FILE* input = tmpfile();
+    FILE* outputs[2] = {tmpfile(), tmpfile()};
+    if (!input || !outputs[0] || !outputs[1]) {
+        printf("Error: Unable to create temporary files for --verify-jit\n");
+        return 0;
+    }
+
+    // Both runs read the same input, so stdin is copied once
+    int c;
+    while ((c = getchar()) != EOF) fputc(c, input);
+
+    int status[2];
+    int savedJit = vmJit;
+    for (int run = 0; run < 2; run++) {
+        rewind(input);
+        vmJit = run;
+        status[run] = runBytecode(program, input, outputs[run]);
+    }
+    vmJit = savedJit;
+
+    rewind(outputs[0]);
+    rewind(outputs[1]);
+    long bytes = 0;
+    int a, b;
+    do {
+        a = fgetc(outputs[0]);
+        b = fgetc(outputs[1]);
+        if (a != EOF && a == b) bytes++;
+    } while (a != EOF && a == b);
+
+    int same = a == b && status[0] == status[1];
+    if (same) {
+        printf("[JIT] Native code matches the interpreter: %ld bytes printed, exit status %d\n", bytes, status[0]);
+    } else {
+        printf("[JIT] MISMATCH after %ld bytes: interpreter status %d, native status %d\n", bytes, status[0], status[1]);
+    }
+    fclose(input);
+    fclose(outputs[0]);
+    fclose(outputs[1]);
+    return same;
+}
+
 int main(int argc, char* argv[]) {
 
     // Global Variables - Store tokens and tracking variables
@@ -519,12 +669,43 @@ int main(int argc, char* argv[]) {
     totalTokens = 0;
     tokenStream = tokens;
 
+    // Command-line options: [--bench NAME] [--lazy-blocks] [--run] [--jit] [--tiered] [--verify-jit] [--emit-c] [directory]
+    const char* directory = ".";
+    int runProgram = 0;
+    int verifyJitProgram = 0;
+    int emitC = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--bench") == 0 && i + 1 < argc) {
+            return runBenchmark(argv[i + 1]);
+        } else if (strcmp(argv[i], "--lazy-blocks") == 0) {
+            lazyBlocks = 1;
+            setDeferredExpander(expandBlock);
+        } else if (strcmp(argv[i], "--run") == 0) {
+            runProgram = 1;
+        } else if (strcmp(argv[i], "--jit") == 0) {
+            vmJit = 1;
+        } else if (strcmp(argv[i], "--tiered") == 0) {
+            vmTiered = 1;
+        } else if (strcmp(argv[i], "--verify-jit") == 0) {
+            verifyJitProgram = 1;
+        } else if (strcmp(argv[i], "--emit-c") == 0) {
+            emitC = 1;
+        } else if (strncmp(argv[i], "--", 2) != 0) {
+            directory = argv[i];
+        }
+    }
+
+    // Lazy mode leaves block bodies unparsed, so the backends would see an incomplete program
+    if (lazyBlocks && (runProgram || verifyJitProgram || emitC || vmJit || vmTiered)) {
+        printf("Error: --lazy-blocks cannot be combined with --run, --jit, --tiered, --verify-jit or --emit-c\n");
+        return 1;
+    }
+
     printf("\n\n[DEBUG] Starting Syntax Analysis...\n");
 
     // Open the specified directory or current directory to look for .prsm files
     struct dirent *entry;
     DIR *dp = NULL;
-    const char* directory = (argc > 1) ? argv[1] : ".";
     dp = opendir(directory);
     if (!dp) {
         printf("Error: Unable to open directory %s.\n", directory);
@@ -533,13 +714,26 @@ int main(int argc, char* argv[]) {
 
     // List .txt files
     char prsmFiles[100][256]; // Fixed buffer for simplicity
+    char sourcePath[256] = "";  // Matching .prsm source, used for diagnostics
     int fileCount = 0;
 
     printf("Available .txt files in directory '%s':\n", directory);
     while ((entry = readdir(dp))) {
-        if (strstr(entry->d_name, ".txt") && strlen(entry->d_name) > 5) {
+        const char* extension = strrchr(entry->d_name, '.');
+        if (extension && strcmp(extension, ".prsm") == 0 && sourcePath[0] == '\0') {
+            // A path too long for the buffer would name the wrong file: go without excerpts
+            if (snprintf(sourcePath, sizeof(sourcePath), "%s/%s", directory, entry->d_name) >=
+                (int)sizeof(sourcePath)) {
+                sourcePath[0] = '\0';
+            }
+        }
+        if (strstr(entry->d_name, ".txt") && strlen(entry->d_name) > 5 && fileCount < 100) {
+            // Skip names whose path would not fit
+            if (snprintf(prsmFiles[fileCount], sizeof(prsmFiles[fileCount]), "%s/%s", directory, entry->d_name) >=
+                (int)sizeof(prsmFiles[fileCount])) {
+                continue;
+            }
             printf("%d. %s\n", fileCount + 1, entry->d_name);
-            snprintf(prsmFiles[fileCount], sizeof(prsmFiles[fileCount]), "%s/%s", directory, entry->d_name);
             fileCount++;
         }
     }
@@ -566,6 +760,21 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
+    // Keep the source in memory so diagnostics never reopen the file
+    if (sourcePath[0] != '\0') {
+        sourceMap = loadSourceMap(sourcePath);
+        if (sourceMap) {
+            if (parserDebug) printf("[DEBUG] Indexed %d source lines from %s\n", sourceMap->lineCount, sourcePath);
+        }
+    }
+
+    if (parserDebug) printf("[DEBUG] Interned %u distinct identifiers and string literals.\n", internedCount());
+
+    // Record declarations while parsing (lazy mode never sees most block bodies)
+    if (!lazyBlocks) {
+        semanticTable = createSymbolTable();
+    }
+
     // Parse and build the parse tree
     ParseTreeNode* root = parseProgram();
 
@@ -575,6 +784,142 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
+    // Annotate expression types before writing, so the tree shows them (lazy mode skips most bodies)
+    if (!lazyBlocks) {
+        TypeCheckResult* typeCheck = typeCheckProgram(root, tokenStream, totalTokens);
+        for (int i = 0; i < typeCheck->errorCount; i++) {
+            const TypeError* error = &typeCheck->errors[i];
+            printf("Type Error at line %d, column %d: %s\n", error->line, error->column, error->message);
+            if (sourceMap && error->column > 0) {
+                printSourceExcerpt(stdout, sourceMap, error->line, error->column, error->width);
+            }
+        }
+        printf("Type check: %d expressions typed, %d int-to-float conversions, %d type errors\n",
+               typeCheck->typedNodes, typeCheck->conversions, typeCheck->errorCount);
+
+        // Folding and the backends trust the types and bindings, so they only run on a clean tree
+        if (typeCheck->errorCount == 0 && syntaxErrorCount == 0 && semanticErrorCount == 0) {
+            FoldResult folded = foldConstants(root, typeCheck->bindingCount);
+            printf("Constant folding: %d nodes folded, %d variable uses propagated from %d constant variables\n",
+                   folded.foldedNodes, folded.propagatedUses, folded.constantBindings);
+
+            // Lower to basic blocks: cfg.txt lists each block's code, predecessors and dominator
+            Cfg* cfg = buildCfg(root, typeCheck->bindingCount);
+            computeDominators(cfg);
+            if (cfg->strayJumps) {
+                printf("[WARNING] %d break/continue statements outside a loop were ignored.\n", cfg->strayJumps);
+            }
+            int unassigned[20];
+            int unassignedCount = findUninitializedReads(cfg, unassigned, 20);
+            for (int i = 0; i < unassignedCount && i < 20; i++) {
+                printf("[WARNING] Variable '%s' may be read before it is assigned (it starts at zero).\n",
+                       internedString(cfg->registerNames[unassigned[i]]));
+            }
+            if (unassignedCount > 20) {
+                printf("[WARNING] ... and %d more variables read before they are assigned.\n", unassignedCount - 20);
+            }
+            if (cfg->switchTables || cfg->switchSearches || cfg->switchHashes) {
+                printf("Switch dispatch: %d jump tables, %d binary search tests, %d string hashes\n",
+                       cfg->switchTables, cfg->switchSearches, cfg->switchHashes);
+            }
+            if (cfg->boundsChecks) {
+                int removed = eliminateBoundsChecks(cfg);
+                printf("Bounds checks: %d of %d removed (indices proven in range by their loops)\n",
+                       removed, cfg->boundsChecks);
+            }
+            if (vectorizeLoops(cfg)) {
+                printf("Vectorized loops: %d (run as %s kernels)\n", cfg->vectorizedLoops,
+                       vectorIsaName(vectorIsa()));
+            }
+            if (optimizeLoops(cfg)) {
+                printf("Loop optimization: %d invariant instructions hoisted out of loop bodies, "
+                       "%d multiplications strength-reduced to additions\n",
+                       cfg->hoistedInstructions, cfg->reducedMultiplies);
+            }
+            if (numberValues(cfg)) {
+                printf("Value numbering: %d redundant computations removed (%d repeated in their block, "
+                       "%d computed in a dominating block)\n",
+                       cfg->redundantInBlock + cfg->redundantDominated, cfg->redundantInBlock,
+                       cfg->redundantDominated);
+            }
+            if (eliminateDeadCode(cfg)) {
+                printf("Dead code: %d constant branches folded (%d blocks dropped), %d dead stores removed, "
+                       "%d variables never read\n",
+                       cfg->foldedBranches, cfg->deadBlocks, cfg->deadStores, cfg->unusedVariables);
+            }
+            if (assignRegisterSlots(cfg, JIT_INT_REGISTERS, JIT_FLOAT_REGISTERS)) {
+                printf("Register allocation: %d registers in %d slots (%d live ranges in machine registers, "
+                       "%d spilled)\n",
+                       cfg->registerCount, cfg->slotCount, cfg->pinnedRanges, cfg->spilledRanges);
+            }
+            FILE* cfgFile = fopen("cfg.txt", "w");
+            if (cfgFile) {
+                writeCfgToFile(cfg, cfgFile);
+                fclose(cfgFile);
+                printf("Control flow: %d blocks, %d instructions, %d edges, %d loops written to cfg.txt\n",
+                       cfg->blockCount, cfg->instructionCount, cfg->edgeCount, cfg->loopCount);
+            } else {
+                printf("Error: Unable to create cfg.txt\n");
+            }
+
+            BytecodeProgram* bytecode = compileBytecode(cfg);
+            freeCfg(cfg);
+            if (bytecode->formatMismatches) {
+                printf("[WARNING] %d printf/input conversions have no argument or one of the wrong type.\n",
+                       bytecode->formatMismatches);
+            }
+            FILE* bytecodeFile = fopen("bytecode.txt", "w");
+            if (bytecodeFile) {
+                writeBytecodeToFile(bytecode, bytecodeFile);
+                fclose(bytecodeFile);
+                printf("Bytecode: %d instructions over %d registers written to bytecode.txt\n",
+                       bytecode->codeCount, bytecode->registerCount);
+            } else {
+                printf("Error: Unable to create bytecode.txt\n");
+            }
+
+            if (emitC) {
+                FILE* cFile = fopen("program.c", "w");
+                if (cFile) {
+                    emitCProgram(root, cFile);
+                    fclose(cFile);
+                    printf("C translation written to program.c (build with: gcc -O2 -o program program.c)\n");
+                } else {
+                    printf("Error: Unable to create program.c\n");
+                }
+            }
+
+            if (verifyJitProgram) {
+                // Both runs consume the input, so this replaces --run
+                printf("\n[JIT] Running the program in the interpreter and as native code...\n");
+                fflush(stdout);
+                verifyJit(bytecode);
+            } else if (runProgram) {
+                printf("\n[RUN] Executing program%s...\n", vmJit ? " (JIT)" : vmTiered ? " (tiered)" : "");
+                fflush(stdout);
+                if (vmTiered && !vmJit) {
+                    vmTierLog = fopen("tier_trace.txt", "w");
+                    if (!vmTierLog) printf("Error: Unable to create tier_trace.txt\n");
+                }
+                double start = benchmarkNow();
+                int status = runBytecode(bytecode, stdin, stdout);
+                printf("\n[RUN] Program %s in %.3f ms\n", status == 0 ? "finished" : "stopped",
+                       (benchmarkNow() - start) * 1e3);
+                if (vmFormatMismatches) {
+                    printf("[WARNING] %d printf conversions read at run time had no argument or one of the wrong type.\n",
+                           vmFormatMismatches);
+                }
+                if (vmTierLog) {
+                    fclose(vmTierLog);
+                    vmTierLog = NULL;
+                    printf("Tier-up trace written to tier_trace.txt\n");
+                }
+            }
+            freeBytecode(bytecode);
+        }
+        freeTypeCheckResult(typeCheck);
+    }
+
     // Write the parse tree to a file
     FILE* parseTreeFile = fopen("parse_tree.txt", "w");
     if (!parseTreeFile) {
@@ -588,8 +933,30 @@ int main(int argc, char* argv[]) {
 
     printf("\nParse tree written to parse_tree.txt\n");
 
+    if (lazyBlocks) {
+        printf("Lazy blocks: %d deferred, %d expanded, %d never expanded\n",
+               deferredBlockCount, expandedBlockCount, deferredBlockCount - expandedBlockCount);
+    }
+
+    // Write the declarations: name,type,scope depth,line:column,uses
+    if (semanticTable) {
+        FILE* semanticFile = fopen("semantic_table.txt", "w");
+        if (semanticFile) {
+            writeSymbolTable(semanticTable, semanticFile);
+            fclose(semanticFile);
+            printf("Semantic table written to semantic_table.txt (%d symbols, %d scopes, %d semantic errors)\n",
+                   semanticTable->symbolCount, semanticTable->scopeCount, semanticErrorCount);
+        } else {
+            printf("Error: Unable to create semantic_table.txt\n");
+        }
+        freeSymbolTable(semanticTable);
+        semanticTable = NULL;
+    }
+
     // Free the parse tree
     freeParseTree(root);
+    freeSourceMap(sourceMap);
+    free(matchingDelimiter);
 
     printf("\n[DEBUG] Syntax Analysis Completed Successfully!\n");
     return 0;
@@ -600,7 +967,7 @@ int main(int argc, char* argv[]) {
 // ---------------------------------------
 
 ParseTreeNode* parseVariableDeclaration() {
-    printf("[DEBUG] Parsing Variable Declaration...\n");
+    if (parserDebug) printf("[DEBUG] Parsing Variable Declaration...\n");
 
     // Create a node for the variable declaration
     ParseTreeNode* varDeclNode = createParseTreeNode("VariableDeclaration", "");
@@ -625,12 +992,12 @@ ParseTreeNode* parseVariableDeclaration() {
             freeParseTree(varDeclNode);
             return NULL;
         }
-        addChild(varDeclNode, matchToken("IDENTIFIER", token->value));
+        addChild(varDeclNode, matchDeclaredIdentifier(typeSpecifierNode->value));
 
         // Check for optional initialization (e.g., `= 10` or `= x + y`)
         token = peekToken();
         if (token && strcmp(token->type, "AssignmentOperator") == 0) {
-            printf("[DEBUG] Detected assignment operator for initialization.\n");
+            if (parserDebug) printf("[DEBUG] Detected assignment operator for initialization.\n");
             addChild(varDeclNode, matchToken("AssignmentOperator", token->value)); // Match '='
 
             // Parse the full arithmetic or identifier expression
@@ -655,10 +1022,10 @@ ParseTreeNode* parseVariableDeclaration() {
 
         if (strcmp(token->type, "Delimiter") == 0) {
             if (strcmp(token->value, ",") == 0) {
-                printf("[DEBUG] Detected ',' for multiple variable declarations.\n");
+                if (parserDebug) printf("[DEBUG] Detected ',' for multiple variable declarations.\n");
                 addChild(varDeclNode, matchToken("Delimiter", ",")); // Continue parsing more variables
             } else if (strcmp(token->value, ";") == 0) {
-                printf("[DEBUG] Detected ';' to end variable declaration.\n");
+                if (parserDebug) printf("[DEBUG] Detected ';' to end variable declaration.\n");
                 addChild(varDeclNode, matchToken("Delimiter", ";")); // End parsing
                 break; // Exit loop as declaration ends
             } else {
@@ -675,17 +1042,176 @@ ParseTreeNode* parseVariableDeclaration() {
         }
     }
 
-    printf("[DEBUG] Successfully parsed Variable Declaration.\n");
+    if (parserDebug) printf("[DEBUG] Successfully parsed Variable Declaration.\n");
     return varDeclNode;
 }
 
 
+// Function to parse `{ element, ... }`; with two dimensions each element is itself a braced row
+ParseTreeNode* parseArrayInitializer(int rank) {
+    if (parserDebug) printf("[DEBUG] Parsing Array Initializer...\n");
 
+    Token* token = peekToken();
+    if (!token || strcmp(token->type, "Delimiter") != 0 || strcmp(token->value, "{") != 0) {
+        reportSyntaxError(rank == 2 ? "Expected '{' to open an array row." : "Expected '{' to open an array initializer.");
+        recoverFromError();
+        return NULL;
+    }
+
+    ParseTreeNode* initializerNode = createParseTreeNode("ArrayInitializer", "");
+    addChild(initializerNode, matchToken("Delimiter", "{"));
+
+    token = peekToken();
+    while (token && !(strcmp(token->type, "Delimiter") == 0 && strcmp(token->value, "}") == 0)) {
+        ParseTreeNode* elementNode = rank == 2 ? parseArrayInitializer(1) : parseExpression();
+        if (!elementNode) {
+            reportSyntaxError("Invalid element in array initializer.");
+            recoverFromError();
+            freeParseTree(initializerNode);
+            return NULL;
+        }
+        addChild(initializerNode, elementNode);
+
+        token = peekToken();
+        if (token && strcmp(token->type, "Delimiter") == 0 && strcmp(token->value, ",") == 0) {
+            addChild(initializerNode, matchToken("Delimiter", ","));
+            token = peekToken();
+        } else {
+            break;
+        }
+    }
+
+    if (!token || strcmp(token->type, "Delimiter") != 0 || strcmp(token->value, "}") != 0) {
+        reportSyntaxError("Expected ',' or '}' in array initializer.");
+        recoverFromError();
+        freeParseTree(initializerNode);
+        return NULL;
+    }
+    addChild(initializerNode, matchToken("Delimiter", "}"));
+
+    if (parserDebug) printf("[DEBUG] Successfully parsed Array Initializer.\n");
+    return initializerNode;
+}
+
+// Function to parse `array <type> name[rows]([columns])? (= { ... })? ;`
+ParseTreeNode* parseArrayDeclaration() {
+    if (parserDebug) printf("[DEBUG] Parsing Array Declaration...\n");
+
+    ParseTreeNode* arrayDeclNode = createParseTreeNode("ArrayDeclaration", "");
+    addChild(arrayDeclNode, matchToken("Keyword", "array"));
+
+    // Element type: any scalar type but string
+    Token* token = peekToken();
+    if (!token || strcmp(token->type, "Keyword") != 0 ||
+        !(strcmp(token->value, "int") == 0 || strcmp(token->value, "float") == 0 ||
+          strcmp(token->value, "char") == 0 || strcmp(token->value, "bool") == 0)) {
+        reportSyntaxError("Expected an array element type (int, float, char, or bool).");
+        recoverFromError();
+        freeParseTree(arrayDeclNode);
+        return NULL;
+    }
+    ParseTreeNode* typeSpecifierNode = matchToken("Keyword", token->value);
+    addChild(arrayDeclNode, typeSpecifierNode);
+
+    Token* nameToken = peekToken();
+    if (!nameToken || strcmp(nameToken->type, "IDENTIFIER") != 0) {
+        reportSyntaxError("Expected an identifier in array declaration.");
+        recoverFromError();
+        freeParseTree(arrayDeclNode);
+        return NULL;
+    }
+    int declaredSymbols = semanticTable ? semanticTable->symbolCount : 0;
+    addChild(arrayDeclNode, matchDeclaredIdentifier(typeSpecifierNode->value));
+
+    // One or two [length] dimensions
+    int rank = 0;
+    token = peekToken();
+    while (token && strcmp(token->type, "Delimiter") == 0 && strcmp(token->value, "[") == 0) {
+        if (rank == 2) {
+            reportSyntaxError("Arrays have at most two dimensions.");
+            recoverFromError();
+            freeParseTree(arrayDeclNode);
+            return NULL;
+        }
+        addChild(arrayDeclNode, matchToken("Delimiter", "["));
+        ParseTreeNode* lengthNode = parseExpression();
+        if (!lengthNode) {
+            reportSyntaxError("Expected an array length after '['.");
+            recoverFromError();
+            freeParseTree(arrayDeclNode);
+            return NULL;
+        }
+        addChild(arrayDeclNode, lengthNode);
+
+        token = peekToken();
+        if (!token || strcmp(token->type, "Delimiter") != 0 || strcmp(token->value, "]") != 0) {
+            reportSyntaxError("Expected ']' after array length.");
+            recoverFromError();
+            freeParseTree(arrayDeclNode);
+            return NULL;
+        }
+        addChild(arrayDeclNode, matchToken("Delimiter", "]"));
+        rank++;
+        token = peekToken();
+    }
+    if (rank == 0) {
+        reportSyntaxError("Expected '[' and a length after the array name.");
+        recoverFromError();
+        freeParseTree(arrayDeclNode);
+        return NULL;
+    }
+
+    // The symbol entered above (if it was not a redeclaration) is an array
+    if (semanticTable && semanticTable->symbolCount > declaredSymbols) {
+        Symbol* symbol = &semanticTable->symbols[declaredSymbols];
+        symbol->elementType = symbol->type;
+        symbol->type = TYPE_ARRAY;
+        symbol->rank = rank;
+    }
+
+    if (token && strcmp(token->type, "AssignmentOperator") == 0) {
+        if (strcmp(token->value, "=") != 0) {
+            reportSyntaxError("Expected '=' before an array initializer.");
+            recoverFromError();
+            freeParseTree(arrayDeclNode);
+            return NULL;
+        }
+        addChild(arrayDeclNode, matchToken("AssignmentOperator", "="));
+        ParseTreeNode* initializerNode = parseArrayInitializer(rank);
+        if (!initializerNode) {
+            freeParseTree(arrayDeclNode);
+            return NULL;
+        }
+        addChild(arrayDeclNode, initializerNode);
+        token = peekToken();
+    }
+
+    if (!token || strcmp(token->type, "Delimiter") != 0 || strcmp(token->value, ";") != 0) {
+        reportSyntaxError("Expected ';' after array declaration.");
+        recoverFromError();
+        freeParseTree(arrayDeclNode);
+        return NULL;
+    }
+    addChild(arrayDeclNode, matchToken("Delimiter", ";"));
+
+    if (parserDebug) printf("[DEBUG] Successfully parsed Array Declaration.\n");
+    return arrayDeclNode;
+}
+
+// Function to parse a block inside its own scope
 ParseTreeNode* parseBlock() {
-    printf("[DEBUG] Parsing Block...\n");
+    if (semanticTable) pushScope(semanticTable);
+    ParseTreeNode* blockNode = parseScopedBlock();
+    if (semanticTable) popScope(semanticTable);
+    return blockNode;
+}
+
+ParseTreeNode* parseScopedBlock() {
+    if (parserDebug) printf("[DEBUG] Parsing Block...\n");
 
     // Create a parse tree node for the block
     ParseTreeNode* blockNode = createParseTreeNode("Block", "");
+    int blockStart = currentTokenIndex;
 
     // Match '{' to start the block
     Token* token = peekToken();
@@ -695,27 +1221,66 @@ ParseTreeNode* parseBlock() {
         freeParseTree(blockNode);
         return NULL;
     }
-    addChild(blockNode, matchToken("Delimiter", "{"));
+    ParseTreeNode* openNode = matchToken("Delimiter", "{");
+    if (openNode) {
+        openNode->tokenSpan = currentTokenIndex - blockStart;
+    }
+    addChild(blockNode, openNode);
 
-    // Parse statements inside the block
+    // Lazy mode: jump to the matching '}' and leave the body for expandBlock()
+    int closeIndex = (lazyBlocks && matchingDelimiter) ? matchingDelimiter[blockStart] : -1;
+    if (closeIndex > blockStart) {
+        currentTokenIndex = closeIndex;
+        blockNode->deferredStart = blockStart;
+        deferredBlockCount++;
+    } else if (!parseBlockStatements(blockNode, blockStart)) {
+        freeParseTree(blockNode);
+        return NULL;
+    }
+
+    // Match '}' to close the block
+    token = peekToken();
+    if (!token || strcmp(token->type, "Delimiter") != 0 || strcmp(token->value, "}") != 0) {
+        reportSyntaxError("Expected '}' to close block.");
+        recoverFromError();
+        freeParseTree(blockNode);
+        return NULL;
+    }
+    int closeStart = currentTokenIndex;
+    ParseTreeNode* closeNode = matchToken("Delimiter", "}");
+    if (closeNode) {
+        closeNode->tokenOffset = closeStart - blockStart;
+        closeNode->tokenSpan = currentTokenIndex - closeStart;
+    }
+    addChild(blockNode, closeNode);
+
+    // Span of the whole block; a block used as a statement is re-based by its container
+    blockNode->tokenOffset = blockStart - spanBase;
+    blockNode->tokenSpan = currentTokenIndex - blockStart;
+
+    if (parserDebug) printf("[DEBUG] Successfully parsed Block.\n");
+    return blockNode;
+}
+
+// Function to parse the statements of a block up to (not including) its '}'
+int parseBlockStatements(ParseTreeNode* blockNode, int blockStart) {
     while (true) {
-        token = peekToken();
+        Token* token = peekToken();
         if (!token) {
             reportSyntaxError("Unexpected end of input inside block.");
             recoverFromError();
-            freeParseTree(blockNode);
-            return NULL;
+            return 0;
         }
 
         // Break on encountering '}' (end of block)
         if (strcmp(token->type, "Delimiter") == 0 && strcmp(token->value, "}") == 0) {
-            break;
+            return 1;
         }
 
         // Delegate statement parsing
-        ParseTreeNode* statementNode = parseStatement();
+        ParseTreeNode* statementNode = parseTrackedStatement(blockStart, currentTokenIndex);
         if (!statementNode) {
-            printf("[DEBUG] Failed to parse statement inside block. Attempting recovery...\n");
+            if (parserDebug) printf("[DEBUG] Failed to parse statement inside block. Attempting recovery...\n");
             recoverFromError();
             continue; // Skip invalid statements and attempt to recover
         }
@@ -723,23 +1288,70 @@ ParseTreeNode* parseBlock() {
         // Add parsed statement to the block node
         addChild(blockNode, statementNode);
     }
+}
 
-    // Match '}' to close the block
-    token = peekToken();
-    if (!token || strcmp(token->type, "Delimiter") != 0 || strcmp(token->value, "}") != 0) {
-        reportSyntaxError("Expected '}' to close block.");
-        recoverFromError();
-        freeParseTree(blockNode);
-        return NULL;
+// Function to parse the body of a block deferred in lazy mode.
+// Nested blocks of the body are deferred in turn while lazy mode is on.
+void expandBlock(ParseTreeNode* blockNode) {
+    if (!blockNode || blockNode->deferredStart < 0) {
+        return;
     }
-    addChild(blockNode, matchToken("Delimiter", "}"));
 
-    printf("[DEBUG] Successfully parsed Block.\n");
-    return blockNode;
+    int savedIndex = currentTokenIndex;
+    int savedBase = spanBase;
+    int blockStart = blockNode->deferredStart;
+
+    // Body statements go between the '{' and '}' children
+    ParseTreeNode* body = createParseTreeNode("Block", "");
+    currentTokenIndex = blockStart + blockNode->children[0]->tokenSpan;
+    parseBlockStatements(body, blockStart);
+    replaceChildren(blockNode, 1, 0, body->children, body->childCount);
+    body->childCount = 0;
+    freeParseTree(body);
+
+    blockNode->deferredStart = -1;
+    expandedBlockCount++;
+
+    currentTokenIndex = savedIndex;
+    spanBase = savedBase;
+}
+
+// Function to index matching delimiters: matchingDelimiter[i] is the partner of
+// an opening or closing '{', '(' or '[' at token i, or -1 if it has none
+void buildDelimiterIndex() {
+    free(matchingDelimiter);
+    matchingDelimiter = (int*)malloc((totalTokens > 0 ? totalTokens : 1) * sizeof(int));
+    int* stack = (int*)malloc((totalTokens > 0 ? totalTokens : 1) * sizeof(int));
+    if (!matchingDelimiter || !stack) {
+        fprintf(stderr, "Error: Memory allocation failed for delimiter index.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    int depth = 0;
+    for (int i = 0; i < totalTokens; i++) {
+        matchingDelimiter[i] = -1;
+        const Token* token = &tokenStream[i];
+        if (strcmp(token->type, "Delimiter") != 0 || token->value[1] != '\0') {
+            continue;
+        }
+
+        char c = token->value[0];
+        if (c == '{' || c == '(' || c == '[') {
+            stack[depth++] = i;
+        } else if (c == '}' || c == ')' || c == ']') {
+            char open = (c == '}') ? '{' : (c == ')') ? '(' : '[';
+            if (depth > 0 && tokenStream[stack[depth - 1]].value[0] == open) {
+                int partner = stack[--depth];
+                matchingDelimiter[partner] = i;
+                matchingDelimiter[i] = partner;
+            }
+        }
+    }
+    free(stack);
 }
 
 ParseTreeNode* parseStatementList() {
-    printf("[DEBUG] Parsing Statement List...\n");
+    if (parserDebug) printf("[DEBUG] Parsing Statement List...\n");
 
     // Create a node for the statement list
     ParseTreeNode* statementListNode = createParseTreeNode("StatementList", "");
@@ -749,7 +1361,7 @@ ParseTreeNode* parseStatementList() {
 
         // Stop parsing when encountering a closing curly brace '}'
         if (strcmp(token->type, "Delimiter") == 0 && strcmp(token->value, "}") == 0) {
-            printf("[DEBUG] End of statement list detected at '}'.\n");
+            if (parserDebug) printf("[DEBUG] End of statement list detected at '}'.\n");
             break;
         }
 
@@ -759,7 +1371,7 @@ ParseTreeNode* parseStatementList() {
              strcmp(token->value, "char") == 0 || strcmp(token->value, "bool") == 0 ||
              strcmp(token->value, "string") == 0)) {
             
-            printf("[DEBUG] Detected declaration keyword: '%s'. Parsing declaration statement...\n", token->value);
+            if (parserDebug) printf("[DEBUG] Detected declaration keyword: '%s'. Parsing declaration statement...\n", token->value);
             ParseTreeNode* declarationNode = parseDeclarationStatement();
             if (!declarationNode) {
                 reportSyntaxError("Failed to parse declaration statement.");
@@ -767,13 +1379,13 @@ ParseTreeNode* parseStatementList() {
                 continue; // Attempt to parse the next valid statement
             }
             addChild(statementListNode, declarationNode);
-            printf("[DEBUG] Added Declaration Statement to Statement List. Current children count: %d\n",
+            if (parserDebug) printf("[DEBUG] Added Declaration Statement to Statement List. Current children count: %d\n",
                    statementListNode->childCount);
             continue; // Move to the next statement
         }
 
         // **Step 2: Otherwise, parse a regular statement**
-        printf("[DEBUG] Parsing a regular statement...\n");
+        if (parserDebug) printf("[DEBUG] Parsing a regular statement...\n");
         ParseTreeNode* statementNode = parseStatement();
         if (!statementNode) {
             reportSyntaxError("Failed to parse a statement in the statement list.");
@@ -782,21 +1394,23 @@ ParseTreeNode* parseStatementList() {
         }
 
         addChild(statementListNode, statementNode);
-        printf("[DEBUG] Added Statement to Statement List. Current children count: %d\n", statementListNode->childCount);
+        if (parserDebug) printf("[DEBUG] Added Statement to Statement List. Current children count: %d\n", statementListNode->childCount);
     }
 
-    printf("[DEBUG] Successfully parsed Statement List.\n");
+    if (parserDebug) printf("[DEBUG] Successfully parsed Statement List.\n");
     return statementListNode;
 }
 
 ParseTreeNode* parseDeclarationStatement() {
-    printf("[DEBUG] Parsing Declaration Statement...\n");
+    if (parserDebug) printf("[DEBUG] Parsing Declaration Statement...\n");
 
     // Create a node for the declaration statement
     ParseTreeNode* declarationNode = createParseTreeNode("DeclarationStatement", "");
 
-    // Delegate to parseVariableDeclaration
-    ParseTreeNode* varDeclNode = parseVariableDeclaration();
+    // Delegate to parseArrayDeclaration or parseVariableDeclaration
+    Token* token = peekToken();
+    ParseTreeNode* varDeclNode = (token && strcmp(token->value, "array") == 0) ? parseArrayDeclaration()
+                                                                                 : parseVariableDeclaration();
     if (!varDeclNode) {
         reportSyntaxError("Invalid variable declaration.");
         recoverFromError();
@@ -805,12 +1419,12 @@ ParseTreeNode* parseDeclarationStatement() {
     }
     addChild(declarationNode, varDeclNode);
 
-    printf("[DEBUG] Successfully parsed Declaration Statement.\n");
+    if (parserDebug) printf("[DEBUG] Successfully parsed Declaration Statement.\n");
     return declarationNode;
 }
 
 ParseTreeNode* parseTypeSpecifier() {
-    printf("[DEBUG] Parsing Type Specifier...\n");
+    if (parserDebug) printf("[DEBUG] Parsing Type Specifier...\n");
 
     Token* token = peekToken();
     if (!token || strcmp(token->type, "Keyword") != 0 ||
@@ -831,7 +1445,7 @@ ParseTreeNode* parseTypeSpecifier() {
     }
 
     // Debug: Log the matched type specifier
-    printf("[DEBUG] Matched Type Specifier: %s\n", token->value);
+    if (parserDebug) printf("[DEBUG] Matched Type Specifier: %s\n", token->value);
 
     return typeSpecifierNode; // Return the matched parse tree node
 }
@@ -842,7 +1456,7 @@ ParseTreeNode* parseTypeSpecifier() {
 
 // Enhanced parseStatement Function
 ParseTreeNode* parseStatement() {
-    printf("[DEBUG] Parsing Statement...\n");
+    if (parserDebug) printf("[DEBUG] Parsing Statement...\n");
 
     Token* token = peekToken();
     if (!token) {
@@ -851,7 +1465,7 @@ ParseTreeNode* parseStatement() {
         return NULL;
     }
 
-    printf("[DEBUG] Current Token in parseStatement: Type='%s', Value='%s', Line=%d\n",
+    if (parserDebug) printf("[DEBUG] Current Token in parseStatement: Type='%s', Value='%s', Line=%d\n",
            token->type, token->value, token->lineNumber);
 
     ParseTreeNode* statementNode = NULL;
@@ -860,6 +1474,8 @@ ParseTreeNode* parseStatement() {
     if (strcmp(token->type, "Keyword") == 0) {
         if (strcmp(token->value, "if") == 0) {
             statementNode = parseConditionalStatement();
+        } else if (strcmp(token->value, "switch") == 0) {
+            statementNode = parseSwitchStatement();
         } else if (strcmp(token->value, "input") == 0) {
             statementNode = parseInputStatement();
         } else if (strcmp(token->value, "printf") == 0) {
@@ -870,15 +1486,16 @@ ParseTreeNode* parseStatement() {
             statementNode = parseJumpStatement();
         } else if (strcmp(token->value, "int") == 0 || strcmp(token->value, "float") == 0 ||
                    strcmp(token->value, "char") == 0 || strcmp(token->value, "bool") == 0 ||
-                   strcmp(token->value, "string") == 0) {
-            // Handle variable declarations
-            printf("[DEBUG] Detected declaration keyword: '%s'. Delegating to parseDeclarationStatement.\n", token->value);
+                   strcmp(token->value, "string") == 0 || strcmp(token->value, "array") == 0) {
+            // Handle variable and array declarations
+            if (parserDebug) printf("[DEBUG] Detected declaration keyword: '%s'. Delegating to parseDeclarationStatement.\n", token->value);
             statementNode = parseDeclarationStatement();
         }
     } else if (strcmp(token->type, "IDENTIFIER") == 0) {
-        // Handle assignment statements
+        // Handle assignment statements (to a variable or an array element)
         Token* nextToken = peekNextToken();
-        if (nextToken && strcmp(nextToken->type, "AssignmentOperator") == 0) {
+        if (nextToken && (strcmp(nextToken->type, "AssignmentOperator") == 0 ||
+                          (strcmp(nextToken->type, "Delimiter") == 0 && strcmp(nextToken->value, "[") == 0))) {
             statementNode = parseAssignmentStatement();
         } else {
             reportSyntaxError("Unrecognized identifier usage. Expected an assignment.");
@@ -900,13 +1517,13 @@ ParseTreeNode* parseStatement() {
         return NULL;
     }
 
-    printf("[DEBUG] Successfully parsed a statement.\n");
+    if (parserDebug) printf("[DEBUG] Successfully parsed a statement.\n");
     return statementNode;
 }
 
 
 ParseTreeNode* parseExponentialExpr() {
-    printf("[DEBUG] Parsing Exponential Expression...\n");
+    if (parserDebug) printf("[DEBUG] Parsing Exponential Expression...\n");
 
     // Parse the base operand first
     ParseTreeNode* baseNode = parseBase(); // Base handles literals, identifiers, or grouped expressions
@@ -920,7 +1537,7 @@ ParseTreeNode* parseExponentialExpr() {
 
     // Check and process exponentiation operators (supporting chains of '^')
     while (token && strcmp(token->type, "ArithmeticOperator") == 0 && strcmp(token->value, "^") == 0) {
-        printf("[DEBUG] Detected exponentiation operator '^'.\n");
+        if (parserDebug) printf("[DEBUG] Detected exponentiation operator '^'.\n");
 
         // Create a node for the exponential expression
         ParseTreeNode* exponentialNode = createParseTreeNode("ExponentialExpr", "^");
@@ -953,12 +1570,12 @@ ParseTreeNode* parseExponentialExpr() {
         token = peekToken();
     }
 
-    printf("[DEBUG] Successfully parsed Exponential Expression.\n");
+    if (parserDebug) printf("[DEBUG] Successfully parsed Exponential Expression.\n");
     return baseNode;
 }
 
 ParseTreeNode* parseInputStatement() {
-    printf("[DEBUG] Parsing Input Statement...\n");
+    if (parserDebug) printf("[DEBUG] Parsing Input Statement...\n");
 
     // Create the node for the input statement
     ParseTreeNode* inputNode = createParseTreeNode("InputStatement", "");
@@ -1017,12 +1634,12 @@ ParseTreeNode* parseInputStatement() {
     }
     addChild(inputNode, matchToken("Delimiter", ";"));
 
-    printf("[DEBUG] Successfully parsed Input Statement.\n");
+    if (parserDebug) printf("[DEBUG] Successfully parsed Input Statement.\n");
     return inputNode;
 }
 
 ParseTreeNode* parseExpressionList() {
-    printf("[DEBUG] Parsing Expression List...\n");
+    if (parserDebug) printf("[DEBUG] Parsing Expression List...\n");
 
     ParseTreeNode* expressionListNode = createParseTreeNode("ExpressionList", "");
 
@@ -1053,12 +1670,12 @@ ParseTreeNode* parseExpressionList() {
         token = peekToken(); // Update token for the next iteration
     }
 
-    printf("[DEBUG] Successfully parsed Expression List.\n");
+    if (parserDebug) printf("[DEBUG] Successfully parsed Expression List.\n");
     return expressionListNode;
 }
 
 ParseTreeNode* parseInputList() {
-    printf("[DEBUG] Parsing Input List...\n");
+    if (parserDebug) printf("[DEBUG] Parsing Input List...\n");
 
     ParseTreeNode* inputListNode = createParseTreeNode("InputList", "");
 
@@ -1087,12 +1704,12 @@ ParseTreeNode* parseInputList() {
         addChild(inputListNode, pairNode);
     }
 
-    printf("[DEBUG] Successfully parsed Input List.\n");
+    if (parserDebug) printf("[DEBUG] Successfully parsed Input List.\n");
     return inputListNode;
 }
 
 ParseTreeNode* parseAddressVariable() {
-    printf("[DEBUG] Parsing Address Variable...\n");
+    if (parserDebug) printf("[DEBUG] Parsing Address Variable...\n");
 
     // Create a node for the address variable
     ParseTreeNode* addressNode = createParseTreeNode("AddressVariable", "");
@@ -1108,7 +1725,7 @@ ParseTreeNode* parseAddressVariable() {
 
     // Check if the token is incorrectly recognized as a single "SpecifierIdentifier"
     if (strcmp(token->type, "SpecifierIdentifier") == 0) {
-        printf("[DEBUG] Detected SpecifierIdentifier: '%s'\n", token->value);
+        if (parserDebug) printf("[DEBUG] Detected SpecifierIdentifier: '%s'\n", token->value);
 
         // Manually extract the '&' and the actual identifier
         if (token->value[0] == '&') {
@@ -1127,7 +1744,12 @@ ParseTreeNode* parseAddressVariable() {
             }
 
             // Add extracted identifier as a node
-            addChild(addressNode, createParseTreeNode("IDENTIFIER", identifier));
+            ParseTreeNode* identifierNode = createParseTreeNode("IDENTIFIER", identifier);
+            identifierNode->symbolId = token->symbolId;
+            addChild(addressNode, identifierNode);
+            if (semanticTable) {
+                noteIdentifierUse(token);
+            }
 
             // Consume the "SpecifierIdentifier" token
             getNextToken();
@@ -1158,12 +1780,12 @@ ParseTreeNode* parseAddressVariable() {
         addChild(addressNode, matchToken("IDENTIFIER", token->value));
     }
 
-    printf("[DEBUG] Successfully parsed Address Variable.\n");
+    if (parserDebug) printf("[DEBUG] Successfully parsed Address Variable.\n");
     return addressNode;
 }
 
 ParseTreeNode* parseFormatVariablePair() {
-    printf("[DEBUG] Parsing Format-Variable Pair...\n");
+    if (parserDebug) printf("[DEBUG] Parsing Format-Variable Pair...\n");
 
     ParseTreeNode* pairNode = createParseTreeNode("FormatVariablePair", "");
 
@@ -1197,12 +1819,12 @@ ParseTreeNode* parseFormatVariablePair() {
     }
     addChild(pairNode, addressNode);
 
-    printf("[DEBUG] Successfully parsed Format-Variable Pair.\n");
+    if (parserDebug) printf("[DEBUG] Successfully parsed Format-Variable Pair.\n");
     return pairNode;
 }
 
 ParseTreeNode* parseOutputStatement() {
-    printf("[DEBUG] Parsing Output Statement...\n");
+    if (parserDebug) printf("[DEBUG] Parsing Output Statement...\n");
 
     // Create the node for the output statement
     ParseTreeNode* outputNode = createParseTreeNode("OutputStatement", "");
@@ -1240,7 +1862,12 @@ ParseTreeNode* parseOutputStatement() {
         if (strcmp(token->type, "STRING_LITERAL") == 0) {
             addChild(outputListNode, matchToken("STRING_LITERAL", token->value));
         } else if (strcmp(token->type, "IDENTIFIER") == 0) {
-            addChild(outputListNode, matchToken("IDENTIFIER", token->value));
+            Token* nextToken = peekNextToken();
+            ParseTreeNode* identifierNode = matchToken("IDENTIFIER", token->value);
+            if (nextToken && strcmp(nextToken->type, "Delimiter") == 0 && strcmp(nextToken->value, "[") == 0) {
+                identifierNode = parseArrayAccess(identifierNode);
+            }
+            addChild(outputListNode, identifierNode);
         } else if (strcmp(token->value, "&") == 0) {  // Handle <address-variable>
             ParseTreeNode* addressVarNode = createParseTreeNode("AddressVariable", "&");
             addChild(addressVarNode, matchToken("Delimiter", "&"));
@@ -1299,12 +1926,12 @@ ParseTreeNode* parseOutputStatement() {
     }
     addChild(outputNode, createParseTreeNode("Delimiter", ";"));
 
-    printf("[DEBUG] Successfully parsed Output Statement.\n");
+    if (parserDebug) printf("[DEBUG] Successfully parsed Output Statement.\n");
     return outputNode;
 }
 
 ParseTreeNode* parseAssignmentStatement() {
-    printf("[DEBUG] Parsing Assignment Statement...\n");
+    if (parserDebug) printf("[DEBUG] Parsing Assignment Statement...\n");
 
     // Create a node for the assignment statement
     ParseTreeNode* assignmentNode = createParseTreeNode("AssignmentStatement", "");
@@ -1322,8 +1949,17 @@ ParseTreeNode* parseAssignmentStatement() {
         freeParseTree(assignmentNode);
         return NULL;
     }
-    printf("[DEBUG] Matching identifier for assignment: '%s'\n", token->value);
-    addChild(assignmentNode, matchToken("IDENTIFIER", token->value));
+    if (parserDebug) printf("[DEBUG] Matching identifier for assignment: '%s'\n", token->value);
+    ParseTreeNode* targetNode = matchToken("IDENTIFIER", token->value);
+    token = peekToken();
+    if (targetNode && token && strcmp(token->type, "Delimiter") == 0 && strcmp(token->value, "[") == 0) {
+        targetNode = parseArrayAccess(targetNode);
+        if (!targetNode) {
+            freeParseTree(assignmentNode);
+            return NULL;
+        }
+    }
+    addChild(assignmentNode, targetNode);
 
     // Match the assignment operator (e.g., =, +=, -=, etc.)
     token = peekToken();
@@ -1333,11 +1969,11 @@ ParseTreeNode* parseAssignmentStatement() {
         freeParseTree(assignmentNode);
         return NULL;
     }
-    printf("[DEBUG] Matching assignment operator: '%s'\n", token->value);
+    if (parserDebug) printf("[DEBUG] Matching assignment operator: '%s'\n", token->value);
     addChild(assignmentNode, matchToken("AssignmentOperator", token->value));
 
     // **Recursively Handle Right-to-Left Chained Assignments**
-    printf("[DEBUG] Parsing right-hand side of assignment...\n");
+    if (parserDebug) printf("[DEBUG] Parsing right-hand side of assignment...\n");
     ParseTreeNode* rhsNode = parseExpression();
     if (!rhsNode) {
         reportSyntaxError("Expected an expression as the right-hand side of assignment.");
@@ -1349,7 +1985,7 @@ ParseTreeNode* parseAssignmentStatement() {
     // **Check for chained assignments**
     token = peekToken();
     while (token && strcmp(token->type, "AssignmentOperator") == 0) {
-        printf("[DEBUG] Detected Chained Assignment Operator: '%s'\n", token->value);
+        if (parserDebug) printf("[DEBUG] Detected Chained Assignment Operator: '%s'\n", token->value);
 
         // Create a new node to handle the nested assignment
         ParseTreeNode* chainedAssignNode = createParseTreeNode("AssignmentStatement", "");
@@ -1388,7 +2024,7 @@ ParseTreeNode* parseAssignmentStatement() {
         return NULL;
     }
     if (strcmp(token->type, "Delimiter") == 0 && strcmp(token->value, ";") == 0) {
-        printf("[DEBUG] Matching semicolon at the end of assignment statement.\n");
+        if (parserDebug) printf("[DEBUG] Matching semicolon at the end of assignment statement.\n");
         addChild(assignmentNode, matchToken("Delimiter", ";"));
     } else {
         reportSyntaxError("Expected ';' after assignment statement.");
@@ -1397,12 +2033,12 @@ ParseTreeNode* parseAssignmentStatement() {
         return NULL;
     }
 
-    printf("[DEBUG] Successfully parsed Assignment Statement.\n");
+    if (parserDebug) printf("[DEBUG] Successfully parsed Assignment Statement.\n");
     return assignmentNode;
 }
 
 ParseTreeNode* parseConditionalStatement() {
-    printf("[DEBUG] Parsing Conditional Statement...\n");
+    if (parserDebug) printf("[DEBUG] Parsing Conditional Statement...\n");
 
     // Create a node for the conditional statement
     ParseTreeNode* conditionalNode = createParseTreeNode("ConditionalStatement", "");
@@ -1523,12 +2159,12 @@ ParseTreeNode* parseConditionalStatement() {
         token = peekToken(); // Update token for the next iteration
     }
 
-    printf("[DEBUG] Successfully parsed Conditional Statement.\n");
+    if (parserDebug) printf("[DEBUG] Successfully parsed Conditional Statement.\n");
     return conditionalNode;
 }
 
 ParseTreeNode* parseIterativeStatement() {
-    printf("[DEBUG] Parsing Iterative Statement...\n");
+    if (parserDebug) printf("[DEBUG] Parsing Iterative Statement...\n");
 
     Token* token = peekToken();
     if (!token) {
@@ -1541,8 +2177,14 @@ ParseTreeNode* parseIterativeStatement() {
 
     // Handle "for" loop
     if (strcmp(token->type, "Keyword") == 0 && strcmp(token->value, "for") == 0) {
-        printf("[DEBUG] Detected 'for' keyword. Delegating to parseForLoop().\n");
+        if (parserDebug) printf("[DEBUG] Detected 'for' keyword. Delegating to parseForLoop().\n");
         iterativeNode = parseForLoop();
+    } else if (strcmp(token->type, "Keyword") == 0 && strcmp(token->value, "while") == 0) {
+        if (parserDebug) printf("[DEBUG] Detected 'while' keyword. Delegating to parseWhileLoop().\n");
+        iterativeNode = parseWhileLoop();
+    } else if (strcmp(token->type, "Keyword") == 0 && strcmp(token->value, "do") == 0) {
+        if (parserDebug) printf("[DEBUG] Detected 'do' keyword. Delegating to parseDoWhileLoop().\n");
+        iterativeNode = parseDoWhileLoop();
     }
 
     if (!iterativeNode) {
@@ -1551,12 +2193,12 @@ ParseTreeNode* parseIterativeStatement() {
         return NULL;
     }
 
-    printf("[DEBUG] Successfully parsed Iterative Statement.\n");
+    if (parserDebug) printf("[DEBUG] Successfully parsed Iterative Statement.\n");
     return iterativeNode;
 }
 
 ParseTreeNode* parseJumpStatement() {
-    printf("[DEBUG] Parsing Jump Statement...\n");
+    if (parserDebug) printf("[DEBUG] Parsing Jump Statement...\n");
 
     // Create the node for the jump statement
     ParseTreeNode* jumpNode = createParseTreeNode("JumpStatement", "");
@@ -1581,7 +2223,7 @@ ParseTreeNode* parseJumpStatement() {
         if (expressionNode) {
             addChild(jumpNode, expressionNode);
         } else {
-            printf("[DEBUG] No expression found after 'return', which is acceptable.\n");
+            if (parserDebug) printf("[DEBUG] No expression found after 'return', which is acceptable.\n");
         }
     }
 
@@ -1595,7 +2237,7 @@ ParseTreeNode* parseJumpStatement() {
     }
     addChild(jumpNode, matchToken("Delimiter", ";"));
 
-    printf("[DEBUG] Successfully parsed Jump Statement.\n");
+    if (parserDebug) printf("[DEBUG] Successfully parsed Jump Statement.\n");
     return jumpNode;
 }
 
@@ -1604,7 +2246,7 @@ ParseTreeNode* parseJumpStatement() {
 // ---------------------------------------
 
 ParseTreeNode* parseStatementBlock() {
-    printf("[DEBUG] Parsing Statement Block...\n");
+    if (parserDebug) printf("[DEBUG] Parsing Statement Block...\n");
 
     Token* token = peekToken();
     if (!token) {
@@ -1617,7 +2259,7 @@ ParseTreeNode* parseStatementBlock() {
 
     // If the next token is a `{`, parse it as a Block
     if (strcmp(token->type, "Delimiter") == 0 && strcmp(token->value, "{") == 0) {
-        printf("[DEBUG] Detected '{', delegating to parseBlock().\n");
+        if (parserDebug) printf("[DEBUG] Detected '{', delegating to parseBlock().\n");
         ParseTreeNode* blockNode = parseBlock();
         if (!blockNode) {
             reportSyntaxError("Failed to parse Block in Statement Block.");
@@ -1628,7 +2270,7 @@ ParseTreeNode* parseStatementBlock() {
         addChild(statementBlockNode, blockNode);
     } else {
         // Otherwise, parse a single statement
-        printf("[DEBUG] Detected standalone statement, delegating to parseStatement().\n");
+        if (parserDebug) printf("[DEBUG] Detected standalone statement, delegating to parseStatement().\n");
         ParseTreeNode* statementNode = parseStatement();
         if (!statementNode) {
             reportSyntaxError("Failed to parse standalone statement in Statement Block.");
@@ -1639,13 +2281,13 @@ ParseTreeNode* parseStatementBlock() {
         addChild(statementBlockNode, statementNode);
     }
 
-    printf("[DEBUG] Successfully parsed Statement Block.\n");
+    if (parserDebug) printf("[DEBUG] Successfully parsed Statement Block.\n");
     return statementBlockNode;
 }
 
 
 ParseTreeNode* parseIfStatement() {
-    printf("[DEBUG] Parsing If Statement...\n");
+    if (parserDebug) printf("[DEBUG] Parsing If Statement...\n");
 
     // Create a node for the If Statement
     ParseTreeNode* ifNode = createParseTreeNode("IfStatement", "");
@@ -1720,17 +2362,150 @@ ParseTreeNode* parseIfStatement() {
         addChild(ifNode, elseBlockNode);
     }
 
-    printf("[DEBUG] Successfully parsed If Statement.\n");
+    if (parserDebug) printf("[DEBUG] Successfully parsed If Statement.\n");
     return ifNode;
 }
 
+// Function to check whether a token opens a case or default clause
+static int isClauseStart(const Token* token) {
+    return token && strcmp(token->type, "Keyword") == 0 &&
+           (strcmp(token->value, "case") == 0 || strcmp(token->value, "default") == 0);
+}
+
+// Function to parse: case <literal> : <statement>* | default : <statement>*
+// Statements run on into the next clause unless one of them is a break.
+ParseTreeNode* parseSwitchClause() {
+    Token* token = peekToken();
+    int isDefault = strcmp(token->value, "default") == 0;
+    if (parserDebug) printf("[DEBUG] Parsing %s Clause...\n", isDefault ? "Default" : "Case");
+
+    ParseTreeNode* clauseNode = createParseTreeNode(isDefault ? "DefaultClause" : "CaseClause", "");
+    addChild(clauseNode, matchToken("Keyword", token->value));
+
+    if (!isDefault) {
+        token = peekToken();
+        if (!token || (strcmp(token->type, "INT_LITERAL") != 0 && strcmp(token->type, "CHAR_LITERAL") != 0 &&
+                       strcmp(token->type, "STRING_LITERAL") != 0)) {
+            reportSyntaxError("Expected an int, char or string literal after 'case'.");
+            recoverFromError();
+            freeParseTree(clauseNode);
+            return NULL;
+        }
+        addChild(clauseNode, parseLiteral());
+    }
+
+    if (!matchToken("Delimiter", ":")) {
+        reportSyntaxError(isDefault ? "Expected ':' after 'default'." : "Expected ':' after case label.");
+        recoverFromError();
+        freeParseTree(clauseNode);
+        return NULL;
+    }
+
+    // Statement spans are relative to the switch (or whatever tracked node encloses it)
+    int containerStart = spanBase;
+    while (true) {
+        token = peekToken();
+        if (!token) {
+            reportSyntaxError("Unexpected end of input inside switch.");
+            recoverFromError();
+            freeParseTree(clauseNode);
+            return NULL;
+        }
+        if (isClauseStart(token) || (strcmp(token->type, "Delimiter") == 0 && strcmp(token->value, "}") == 0)) {
+            break;
+        }
+
+        ParseTreeNode* statementNode = parseTrackedStatement(containerStart, currentTokenIndex);
+        if (!statementNode) {
+            if (parserDebug) printf("[DEBUG] Failed to parse statement inside switch. Attempting recovery...\n");
+            recoverFromError();
+            continue;
+        }
+        addChild(clauseNode, statementNode);
+    }
+    return clauseNode;
+}
+
+// Function to parse: switch ( <expression> ) { <clause>* }
+// The clauses share one scope; at most one of them is a default.
+ParseTreeNode* parseSwitchStatement() {
+    if (parserDebug) printf("[DEBUG] Parsing Switch Statement...\n");
+
+    ParseTreeNode* switchNode = createParseTreeNode("SwitchStatement", "");
+    addChild(switchNode, matchToken("Keyword", "switch"));
+
+    if (!matchToken("Delimiter", "(")) {
+        reportSyntaxError("Expected '(' after 'switch'.");
+        recoverFromError();
+        freeParseTree(switchNode);
+        return NULL;
+    }
+
+    ParseTreeNode* subjectNode = parseExpression();
+    if (!subjectNode) {
+        reportSyntaxError("Expected an expression to switch on.");
+        recoverFromError();
+        freeParseTree(switchNode);
+        return NULL;
+    }
+    addChild(switchNode, subjectNode);
+
+    if (!matchToken("Delimiter", ")")) {
+        reportSyntaxError("Expected ')' after switch expression.");
+        recoverFromError();
+        freeParseTree(switchNode);
+        return NULL;
+    }
+    if (!matchToken("Delimiter", "{")) {
+        reportSyntaxError("Expected '{' to start switch body.");
+        recoverFromError();
+        freeParseTree(switchNode);
+        return NULL;
+    }
+
+    if (semanticTable) pushScope(semanticTable);
+    int defaults = 0;
+    Token* token;
+    while ((token = peekToken()) && isClauseStart(token)) {
+        ParseTreeNode* clauseNode = parseSwitchClause();
+        if (!clauseNode) {
+            if (semanticTable) popScope(semanticTable);
+            freeParseTree(switchNode);
+            return NULL;
+        }
+        if (clauseNode->kind == NODE_DEFAULT_CLAUSE && defaults++ > 0) {
+            reportSyntaxError("Multiple default clauses in one switch.");
+        }
+        addChild(switchNode, clauseNode);
+    }
+    if (semanticTable) popScope(semanticTable);
+
+    if (!matchToken("Delimiter", "}")) {
+        reportSyntaxError("Expected 'case', 'default' or '}' in switch body.");
+        recoverFromError();
+        freeParseTree(switchNode);
+        return NULL;
+    }
+
+    if (parserDebug) printf("[DEBUG] Successfully parsed Switch Statement.\n");
+    return switchNode;
+}
+
 // ---------------------------------------
 // Loop                                         
 // ---------------------------------------
 
 // Parse For Loop
+// Function to parse a for loop; variables declared in its header are scoped to the loop
 ParseTreeNode* parseForLoop() {
-    printf("[DEBUG] Parsing For Loop...\n");
+    if (semanticTable) pushScope(semanticTable);
+    ParseTreeNode* forLoopNode = parseScopedForLoop();
+    if (semanticTable) popScope(semanticTable);
+    return forLoopNode;
+}
+
+ParseTreeNode* parseScopedForLoop() {
+    if (parserDebug) printf("[DEBUG] Parsing For Loop...\n");
 
     // Create a node for the for loop
     ParseTreeNode* forLoopNode = createParseTreeNode("ForLoop", "");
@@ -1828,18 +2603,113 @@ ParseTreeNode* parseForLoop() {
     }
     addChild(forLoopNode, bodyNode);
 
-    printf("[DEBUG] Successfully parsed For Loop.\n");
+    if (parserDebug) printf("[DEBUG] Successfully parsed For Loop.\n");
     return forLoopNode;
 }
 
 
 
+// Function to parse: while ( <expression> ) <block>
+ParseTreeNode* parseWhileLoop() {
+    if (parserDebug) printf("[DEBUG] Parsing While Loop...\n");
+
+    ParseTreeNode* whileNode = createParseTreeNode("WhileLoop", "");
+    addChild(whileNode, matchToken("Keyword", "while"));
+
+    if (!matchToken("Delimiter", "(")) {
+        reportSyntaxError("Expected '(' after 'while'.");
+        recoverFromError();
+        freeParseTree(whileNode);
+        return NULL;
+    }
+
+    ParseTreeNode* conditionNode = parseExpression();
+    if (!conditionNode) {
+        reportSyntaxError("Expected a condition in while loop.");
+        recoverFromError();
+        freeParseTree(whileNode);
+        return NULL;
+    }
+    addChild(whileNode, conditionNode);
+
+    if (!matchToken("Delimiter", ")")) {
+        reportSyntaxError("Expected ')' after while-loop condition.");
+        recoverFromError();
+        freeParseTree(whileNode);
+        return NULL;
+    }
+
+    ParseTreeNode* bodyNode = parseBlock();
+    if (!bodyNode) {
+        reportSyntaxError("Expected a statement block in while-loop body.");
+        recoverFromError();
+        freeParseTree(whileNode);
+        return NULL;
+    }
+    addChild(whileNode, bodyNode);
+
+    if (parserDebug) printf("[DEBUG] Successfully parsed While Loop.\n");
+    return whileNode;
+}
+
+// Function to parse: do <block> while ( <expression> ) ;
+ParseTreeNode* parseDoWhileLoop() {
+    if (parserDebug) printf("[DEBUG] Parsing Do-While Loop...\n");
+
+    ParseTreeNode* doNode = createParseTreeNode("DoWhileLoop", "");
+    addChild(doNode, matchToken("Keyword", "do"));
+
+    ParseTreeNode* bodyNode = parseBlock();
+    if (!bodyNode) {
+        reportSyntaxError("Expected a statement block after 'do'.");
+        recoverFromError();
+        freeParseTree(doNode);
+        return NULL;
+    }
+    addChild(doNode, bodyNode);
+
+    Token* token = peekToken();
+    if (!token || strcmp(token->type, "Keyword") != 0 || strcmp(token->value, "while") != 0) {
+        reportSyntaxError("Expected 'while' after do-loop body.");
+        recoverFromError();
+        freeParseTree(doNode);
+        return NULL;
+    }
+    addChild(doNode, matchToken("Keyword", "while"));
+
+    if (!matchToken("Delimiter", "(")) {
+        reportSyntaxError("Expected '(' after 'while'.");
+        recoverFromError();
+        freeParseTree(doNode);
+        return NULL;
+    }
+
+    ParseTreeNode* conditionNode = parseExpression();
+    if (!conditionNode) {
+        reportSyntaxError("Expected a condition in do-while loop.");
+        recoverFromError();
+        freeParseTree(doNode);
+        return NULL;
+    }
+    addChild(doNode, conditionNode);
+
+    if (!matchToken("Delimiter", ")") || !matchToken("Delimiter", ";")) {
+        reportSyntaxError("Expected ');' after do-while condition.");
+        recoverFromError();
+        freeParseTree(doNode);
+        return NULL;
+    }
+
+    if (parserDebug) printf("[DEBUG] Successfully parsed Do-While Loop.\n");
+    return doNode;
+}
+
 ParseTreeNode* parseForInit() {
-    printf("[DEBUG] Parsing For Init...\n");
+    if (parserDebug) printf("[DEBUG] Parsing For Init...\n");
 
     Token* token = peekToken();
     if (!token) {
-        printf("[DEBUG] No tokens available for for-init.\n");
+        if (parserDebug) printf("[DEBUG] No tokens available for for-init.\n");
         return NULL;
     }
 
@@ -1850,7 +2720,7 @@ ParseTreeNode* parseForInit() {
         (strcmp(token->value, "int") == 0 || strcmp(token->value, "float") == 0 ||
          strcmp(token->value, "char") == 0 || strcmp(token->value, "bool") == 0 ||
          strcmp(token->value, "string") == 0)) {
-        printf("[DEBUG] For-init detected as a variable declaration.\n");
+        if (parserDebug) printf("[DEBUG] For-init detected as a variable declaration.\n");
 
         // Parse type specifier
         ParseTreeNode* typeNode = parseTypeSpecifier();
@@ -1870,7 +2740,7 @@ ParseTreeNode* parseForInit() {
             freeParseTree(forInitNode);
             return NULL;
         }
-        addChild(forInitNode, matchToken("IDENTIFIER", token->value));
+        addChild(forInitNode, matchDeclaredIdentifier(typeNode->value));
 
         // Optional initialization (for assignment)
         token = peekToken();
@@ -1888,13 +2758,13 @@ ParseTreeNode* parseForInit() {
             addChild(forInitNode, exprNode);
         }
 
-        printf("[DEBUG] Successfully parsed variable declaration in for-init.\n");
+        if (parserDebug) printf("[DEBUG] Successfully parsed variable declaration in for-init.\n");
         return forInitNode;
     }
 
     // Otherwise, check for an assignment (for-assignment)
     if (strcmp(token->type, "IDENTIFIER") == 0) {
-        printf("[DEBUG] For-init detected as an assignment.\n");
+        if (parserDebug) printf("[DEBUG] For-init detected as an assignment.\n");
 
         // Match identifier
         ParseTreeNode* identifierNode = matchToken("IDENTIFIER", token->value);
@@ -1926,22 +2796,22 @@ ParseTreeNode* parseForInit() {
         }
         addChild(forInitNode, exprNode);
 
-        printf("[DEBUG] Successfully parsed assignment in for-init.\n");
+        if (parserDebug) printf("[DEBUG] Successfully parsed assignment in for-init.\n");
         return forInitNode;
     }
 
     // No valid for-init found
-    printf("[DEBUG] For Init is empty or invalid.\n");
+    if (parserDebug) printf("[DEBUG] For Init is empty or invalid.\n");
     freeParseTree(forInitNode);
     return NULL;
 }
 
 ParseTreeNode* parseForUpdate() {
-    printf("[DEBUG] Parsing For Update...\n");
+    if (parserDebug) printf("[DEBUG] Parsing For Update...\n");
 
     Token* token = peekToken();
     if (!token) {
-        printf("[DEBUG] No tokens available for for-update.\n");
+        if (parserDebug) printf("[DEBUG] No tokens available for for-update.\n");
         return NULL;
     }
 
@@ -1976,7 +2846,7 @@ ParseTreeNode* parseForUpdate() {
         }
     }
 
-    printf("[DEBUG] Successfully parsed For Update.\n");
+    if (parserDebug) printf("[DEBUG] Successfully parsed For Update.\n");
     return forUpdateNode;
 }
 
@@ -1985,7 +2855,7 @@ ParseTreeNode* parseForUpdate() {
 // ---------------------------------------
 
 ParseTreeNode* parseExpression() {
-    printf("[DEBUG] Parsing Expression...\n");
+    if (parserDebug) printf("[DEBUG] Parsing Expression...\n");
 
     ParseTreeNode* expressionNode = createParseTreeNode("Expression", "");
 
@@ -1997,9 +2867,9 @@ ParseTreeNode* parseExpression() {
         return NULL;
     }
 
-    // Start by parsing a relational expression (since it includes arithmetic expressions)
-    printf("[DEBUG] Delegating to parseRelationalExpr...\n");
-    ParseTreeNode* relationalExprNode = parseRelationalExpr();
+    // Start by parsing a logical AND chain (its operands are relational expressions)
+    if (parserDebug) printf("[DEBUG] Delegating to parseLogicalAndExpr...\n");
+    ParseTreeNode* relationalExprNode = parseLogicalAndExpr();
     if (!relationalExprNode) {
         reportSyntaxError("Failed to parse Relational Expression.");
         recoverFromError();
@@ -2011,7 +2881,7 @@ ParseTreeNode* parseExpression() {
     // Check if the next token is a Logical OR (`||`)
     token = peekToken();
     while (token && strcmp(token->type, "LogicalOperator") == 0 && strcmp(token->value, "||") == 0) {
-        printf("[DEBUG] Detected Logical OR Operator '||'.\n");
+        if (parserDebug) printf("[DEBUG] Detected Logical OR Operator '||'.\n");
 
         // Create a node for the Logical OR operation
         ParseTreeNode* logicalOrNode = createParseTreeNode("LogicalOrExpr", token->value);
@@ -2020,8 +2890,8 @@ ParseTreeNode* parseExpression() {
         // Match the `||` operator
         addChild(logicalOrNode, matchToken("LogicalOperator", "||"));
 
-        // Parse the next relational expression
-        ParseTreeNode* nextRelationalExprNode = parseRelationalExpr();
+        // Parse the next logical AND chain
+        ParseTreeNode* nextRelationalExprNode = parseLogicalAndExpr();
         if (!nextRelationalExprNode) {
             reportSyntaxError("Expected relational expression after Logical OR.");
             recoverFromError();
@@ -2036,15 +2906,15 @@ ParseTreeNode* parseExpression() {
         token = peekToken(); // Update token for the next iteration
     }
 
-    printf("[DEBUG] Successfully parsed Expression.\n");
+    if (parserDebug) printf("[DEBUG] Successfully parsed Expression.\n");
     return expressionNode;
 }
 
 ParseTreeNode* parseBoolExpr() {
-    printf("[DEBUG] Parsing Boolean Expression...\n");
+    if (parserDebug) printf("[DEBUG] Parsing Boolean Expression...\n");
 
-    // Parse the left-hand side as a relational expression
-    ParseTreeNode* leftOperand = parseRelationalExpr();
+    // Parse the left-hand side as a logical AND chain
+    ParseTreeNode* leftOperand = parseLogicalAndExpr();
     if (!leftOperand) {
         reportSyntaxError("Failed to parse the left-hand side of a Boolean Expression.");
         recoverFromError();
@@ -2054,7 +2924,7 @@ ParseTreeNode* parseBoolExpr() {
     Token* token = peekToken();
     // Continuously parse Logical OR (`||`) operations
     while (token && strcmp(token->type, "LogicalOperator") == 0 && strcmp(token->value, "||") == 0) {
-        printf("[DEBUG] Detected Logical OR Operator '||'.\n");
+        if (parserDebug) printf("[DEBUG] Detected Logical OR Operator '||'.\n");
 
         // Create a new node for the Logical OR expression
         ParseTreeNode* boolOrNode = createParseTreeNode("LogicalOrExpr", token->value);
@@ -2070,8 +2940,8 @@ ParseTreeNode* parseBoolExpr() {
         }
         addChild(boolOrNode, operatorNode);
 
-        // Parse the right-hand side as another relational expression
-        ParseTreeNode* rightOperand = parseRelationalExpr();
+        // Parse the right-hand side as another logical AND chain
+        ParseTreeNode* rightOperand = parseLogicalAndExpr();
         if (!rightOperand) {
             reportSyntaxError("Failed to parse the right-hand side of a Logical OR Expression.");
             recoverFromError();
@@ -2087,13 +2957,47 @@ ParseTreeNode* parseBoolExpr() {
         token = peekToken();
     }
 
-    printf("[DEBUG] Successfully parsed Boolean Expression.\n");
+    if (parserDebug) printf("[DEBUG] Successfully parsed Boolean Expression.\n");
     return leftOperand;
 }
 
 
+// Function to parse <relational-expr> ('&&' <relational-expr>)*.
+// A lone operand is returned as is, so trees without '&&' keep their shape.
+ParseTreeNode* parseLogicalAndExpr() {
+    if (parserDebug) printf("[DEBUG] Parsing Logical AND Expression...\n");
+
+    ParseTreeNode* leftOperand = parseRelationalExpr();
+    if (!leftOperand) {
+        return NULL;
+    }
+
+    Token* token = peekToken();
+    while (token && strcmp(token->type, "LogicalOperator") == 0 && strcmp(token->value, "&&") == 0) {
+        if (parserDebug) printf("[DEBUG] Detected Logical AND Operator '&&'.\n");
+
+        ParseTreeNode* logicalAndNode = createParseTreeNode("LogicalAndExpr", token->value);
+        addChild(logicalAndNode, leftOperand);
+        addChild(logicalAndNode, matchToken("LogicalOperator", "&&"));
+
+        ParseTreeNode* rightOperand = parseRelationalExpr();
+        if (!rightOperand) {
+            reportSyntaxError("Expected relational expression after Logical AND.");
+            recoverFromError();
+            freeParseTree(logicalAndNode);
+            return NULL;
+        }
+        addChild(logicalAndNode, rightOperand);
+
+        leftOperand = logicalAndNode;
+        token = peekToken();
+    }
+
+    return leftOperand;
+}
+
 ParseTreeNode* parseBoolTerm() {
-    printf("[DEBUG] Parsing Boolean Term...\n");
+    if (parserDebug) printf("[DEBUG] Parsing Boolean Term...\n");
 
     // Parse the left-hand side as a Boolean Factor
     ParseTreeNode* leftOperand = parseBoolFactor();
@@ -2106,7 +3010,7 @@ ParseTreeNode* parseBoolTerm() {
     Token* token = peekToken();
     // Continuously parse Logical AND (`&&`) operations
     while (token && strcmp(token->type, "LogicalOperator") == 0 && strcmp(token->value, "&&") == 0) {
-        printf("[DEBUG] Detected Logical AND Operator '&&'.\n");
+        if (parserDebug) printf("[DEBUG] Detected Logical AND Operator '&&'.\n");
 
         // Create a new node for the Logical AND expression
         ParseTreeNode* boolAndNode = createParseTreeNode("LogicalAndExpr", token->value);
@@ -2139,12 +3043,12 @@ ParseTreeNode* parseBoolTerm() {
         token = peekToken();
     }
 
-    printf("[DEBUG] Successfully parsed Boolean Term.\n");
+    if (parserDebug) printf("[DEBUG] Successfully parsed Boolean Term.\n");
     return leftOperand;
 }
 
 ParseTreeNode* parseBoolFactor() {
-    printf("[DEBUG] Parsing Boolean Factor...\n");
+    if (parserDebug) printf("[DEBUG] Parsing Boolean Factor...\n");
 
     Token* token = peekToken();
     if (!token) {
@@ -2155,7 +3059,7 @@ ParseTreeNode* parseBoolFactor() {
 
     // Handle Logical NOT (`!`) operator
     if (strcmp(token->type, "LogicalOperator") == 0 && strcmp(token->value, "!") == 0) {
-        printf("[DEBUG] Detected Logical NOT Operator '!'.\n");
+        if (parserDebug) printf("[DEBUG] Detected Logical NOT Operator '!'.\n");
 
         // Create a node for the NOT operator
         ParseTreeNode* notNode = createParseTreeNode("LogicalNotExpr", "!");
@@ -2171,13 +3075,13 @@ ParseTreeNode* parseBoolFactor() {
         }
         addChild(notNode, operand);
 
-        printf("[DEBUG] Successfully parsed Logical NOT Expression.\n");
+        if (parserDebug) printf("[DEBUG] Successfully parsed Logical NOT Expression.\n");
         return notNode;
     }
 
     // Handle grouped boolean expressions `( <bool-expr> )`
     if (strcmp(token->type, "Delimiter") == 0 && strcmp(token->value, "(") == 0) {
-        printf("[DEBUG] Detected '(' indicating a grouped Boolean Expression.\n");
+        if (parserDebug) printf("[DEBUG] Detected '(' indicating a grouped Boolean Expression.\n");
 
         // Create a node for the grouped expression
         ParseTreeNode* groupedExpr = createParseTreeNode("GroupedBoolExpr", "");
@@ -2203,34 +3107,34 @@ ParseTreeNode* parseBoolFactor() {
         }
         addChild(groupedExpr, matchToken("Delimiter", ")"));
 
-        printf("[DEBUG] Successfully parsed grouped Boolean Expression.\n");
+        if (parserDebug) printf("[DEBUG] Successfully parsed grouped Boolean Expression.\n");
         return groupedExpr;
     }
 
     // Check for relational expressions
     ParseTreeNode* relationalExpr = parseRelationalExpr();
     if (relationalExpr) {
-        printf("[DEBUG] Successfully parsed Relational Expression in Boolean Factor.\n");
+        if (parserDebug) printf("[DEBUG] Successfully parsed Relational Expression in Boolean Factor.\n");
         return relationalExpr;
     }
 
     // Check for boolean literals
     ParseTreeNode* boolLiteral = parseBoolLiteral();
     if (boolLiteral) {
-        printf("[DEBUG] Successfully parsed Boolean Literal in Boolean Factor.\n");
+        if (parserDebug) printf("[DEBUG] Successfully parsed Boolean Literal in Boolean Factor.\n");
         return boolLiteral;
     }
 
     // Handle arithmetic expressions (bool-expr can contain arithmetic comparisons)
     ParseTreeNode* arithmeticExpr = parseArithmeticExpr();
     if (arithmeticExpr) {
-        printf("[DEBUG] Successfully parsed Arithmetic Expression in Boolean Factor.\n");
+        if (parserDebug) printf("[DEBUG] Successfully parsed Arithmetic Expression in Boolean Factor.\n");
         return arithmeticExpr;
     }
 
     // Handle identifiers (boolean variables or function calls)
     if (strcmp(token->type, "IDENTIFIER") == 0) {
-        printf("[DEBUG] Detected Identifier: '%s'. Delegating to parseIdentifierExpr().\n", token->value);
+        if (parserDebug) printf("[DEBUG] Detected Identifier: '%s'. Delegating to parseIdentifierExpr().\n", token->value);
         return parseIdentifierExpr();
     }
 
@@ -2240,7 +3144,7 @@ ParseTreeNode* parseBoolFactor() {
 }
 
 ParseTreeNode* parseArithmeticExpr() {
-    printf("[DEBUG] Parsing Arithmetic Expression...\n");
+    if (parserDebug) printf("[DEBUG] Parsing Arithmetic Expression...\n");
 
     // Parse the left-hand side as a term (handles *, /, //, %)
     ParseTreeNode* leftOperand = parseTerm();
@@ -2255,7 +3159,7 @@ ParseTreeNode* parseArithmeticExpr() {
     // Handle addition and subtraction (lower precedence than multiplication/division)
     while (token && strcmp(token->type, "ArithmeticOperator") == 0 &&
            (strcmp(token->value, "+") == 0 || strcmp(token->value, "-") == 0)) {
-        printf("[DEBUG] Detected addition/subtraction operator '%s'.\n", token->value);
+        if (parserDebug) printf("[DEBUG] Detected addition/subtraction operator '%s'.\n", token->value);
 
         // Create a new node for the arithmetic expression
         ParseTreeNode* arithmeticNode = createParseTreeNode("ArithmeticExpr", "");
@@ -2285,12 +3189,12 @@ ParseTreeNode* parseArithmeticExpr() {
         token = peekToken();
     }
 
-    printf("[DEBUG] Successfully parsed Arithmetic Expression.\n");
+    if (parserDebug) printf("[DEBUG] Successfully parsed Arithmetic Expression.\n");
     return leftOperand;
 }
 
 ParseTreeNode* parseRelationalExpr() {
-    printf("[DEBUG] Parsing Relational Expression...\n");
+    if (parserDebug) printf("[DEBUG] Parsing Relational Expression...\n");
 
     // Parse the left-hand side as an arithmetic expression
     ParseTreeNode* leftOperand = parseArithmeticExpr();
@@ -2305,7 +3209,7 @@ ParseTreeNode* parseRelationalExpr() {
     // Handle one or more relational operators (==, !=, >, <, >=, <=)
     if (token && strcmp(token->type, "RelationalOperator") == 0) {
         while (token && strcmp(token->type, "RelationalOperator") == 0) {
-            printf("[DEBUG] Detected Relational Operator '%s'.\n", token->value);
+            if (parserDebug) printf("[DEBUG] Detected Relational Operator '%s'.\n", token->value);
 
             // Create a new node for the relational expression
             ParseTreeNode* relationalNode = createParseTreeNode("RelationalExpr", "");
@@ -2341,13 +3245,13 @@ ParseTreeNode* parseRelationalExpr() {
         }
     }
 
-    printf("[DEBUG] Successfully parsed Relational Expression.\n");
+    if (parserDebug) printf("[DEBUG] Successfully parsed Relational Expression.\n");
     return leftOperand;
 }
 
 
 ParseTreeNode* parseUnaryExpr() {
-    printf("[DEBUG] Parsing Unary Expression...\n");
+    if (parserDebug) printf("[DEBUG] Parsing Unary Expression...\n");
 
     ParseTreeNode* unaryNode = createParseTreeNode("UnaryExpr", "");
     Token* token = peekToken();
@@ -2375,7 +3279,7 @@ ParseTreeNode* parseUnaryExpr() {
         }
         addChild(unaryNode, matchToken("IDENTIFIER", nextToken->value));
 
-        printf("[DEBUG] Successfully parsed Pre-Unary Expression.\n");
+        if (parserDebug) printf("[DEBUG] Successfully parsed Pre-Unary Expression.\n");
         return unaryNode;
     }
 
@@ -2389,7 +3293,7 @@ ParseTreeNode* parseUnaryExpr() {
         if (nextToken && strcmp(nextToken->type, "UnaryOperator") == 0 && 
             (strcmp(nextToken->value, "++") == 0 || strcmp(nextToken->value, "--") == 0)) {
             addChild(unaryNode, matchToken("UnaryOperator", nextToken->value));
-            printf("[DEBUG] Successfully parsed Post-Unary Expression.\n");
+            if (parserDebug) printf("[DEBUG] Successfully parsed Post-Unary Expression.\n");
             return unaryNode;
         }
 
@@ -2408,7 +3312,7 @@ ParseTreeNode* parseUnaryExpr() {
 }
 
 ParseTreeNode* parseIdentifierExpr() {
-    printf("[DEBUG] Parsing Identifier Expression...\n");
+    if (parserDebug) printf("[DEBUG] Parsing Identifier Expression...\n");
 
     Token* token = peekToken();
     if (!token || strcmp(token->type, "IDENTIFIER") != 0) {
@@ -2423,12 +3327,52 @@ ParseTreeNode* parseIdentifierExpr() {
     // Match the identifier and add it to the node
     addChild(identifierExprNode, matchToken("IDENTIFIER", token->value));
 
-    printf("[DEBUG] Successfully parsed Identifier Expression.\n");
+    if (parserDebug) printf("[DEBUG] Successfully parsed Identifier Expression.\n");
     return identifierExprNode;
 }
 
+// Function to parse the indices after an array's name: IDENTIFIER [ expr ] ([ expr ])?
+ParseTreeNode* parseArrayAccess(ParseTreeNode* identifierNode) {
+    if (parserDebug) printf("[DEBUG] Parsing Array Access...\n");
+    if (!identifierNode) return NULL;
+
+    ParseTreeNode* accessNode = createParseTreeNode("ArrayAccess", identifierNode->value);
+    accessNode->symbolId = identifierNode->symbolId;
+    addChild(accessNode, identifierNode);
+
+    // One index per dimension; arrays have at most two
+    for (int dimension = 0; dimension < 2; dimension++) {
+        Token* token = peekToken();
+        if (!token || strcmp(token->type, "Delimiter") != 0 || strcmp(token->value, "[") != 0) {
+            break;
+        }
+        addChild(accessNode, matchToken("Delimiter", "["));
+
+        ParseTreeNode* indexNode = parseExpression();
+        if (!indexNode) {
+            reportSyntaxError("Expected an index expression after '['.");
+            recoverFromError();
+            freeParseTree(accessNode);
+            return NULL;
+        }
+        addChild(accessNode, indexNode);
+
+        token = peekToken();
+        if (!token || strcmp(token->type, "Delimiter") != 0 || strcmp(token->value, "]") != 0) {
+            reportSyntaxError("Expected ']' after array index.");
+            recoverFromError();
+            freeParseTree(accessNode);
+            return NULL;
+        }
+        addChild(accessNode, matchToken("Delimiter", "]"));
+    }
+
+    if (parserDebug) printf("[DEBUG] Successfully parsed Array Access.\n");
+    return accessNode;
+}
+
 ParseTreeNode* parseBase() {
-    printf("[DEBUG] Parsing Base...\n");
+    if (parserDebug) printf("[DEBUG] Parsing Base...\n");
 
     Token* token = peekToken();
     if (!token) {
@@ -2441,7 +3385,7 @@ ParseTreeNode* parseBase() {
 
     // Handle grouped expressions (parentheses)
     if (strcmp(token->type, "Delimiter") == 0 && strcmp(token->value, "(") == 0) {
-        printf("[DEBUG] Detected '(' indicating a grouped expression.\n");
+        if (parserDebug) printf("[DEBUG] Detected '(' indicating a grouped expression.\n");
         baseNode = createParseTreeNode("GroupedExpr", "");
 
         // Match '('
@@ -2467,7 +3411,7 @@ ParseTreeNode* parseBase() {
         }
         addChild(baseNode, matchToken("Delimiter", ")"));
 
-        printf("[DEBUG] Successfully parsed grouped expression.\n");
+        if (parserDebug) printf("[DEBUG] Successfully parsed grouped expression.\n");
         return baseNode;
     }
 
@@ -2476,28 +3420,33 @@ ParseTreeNode* parseBase() {
         strcmp(token->type, "CHAR_LITERAL") == 0 || strcmp(token->type, "STRING_LITERAL") == 0 ||
         (strcmp(token->type, "Keyword") == 0 && 
          (strcmp(token->value, "true") == 0 || strcmp(token->value, "false") == 0))) {
-        printf("[DEBUG] Detected literal: Type='%s', Value='%s'\n", token->type, token->value);
+        if (parserDebug) printf("[DEBUG] Detected literal: Type='%s', Value='%s'\n", token->type, token->value);
         baseNode = parseLiteral();
         return baseNode;
     }
 
     // Handle identifiers (e.g., variable names)
     if (strcmp(token->type, "IDENTIFIER") == 0) {
-        printf("[DEBUG] Detected Identifier: '%s'\n", token->value);
+        if (parserDebug) printf("[DEBUG] Detected Identifier: '%s'\n", token->value);
+        Token* nextToken = peekNextToken();
+        if (nextToken && strcmp(nextToken->type, "Delimiter") == 0 && strcmp(nextToken->value, "[") == 0) {
+            return parseArrayAccess(matchToken("IDENTIFIER", token->value));
+        }
         baseNode = createParseTreeNode("Identifier", token->value);
+        baseNode->symbolId = token->symbolId;
         addChild(baseNode, matchToken("IDENTIFIER", token->value));
         return baseNode;
     }
 
     // If none of the above cases match, report an error
-    printf("[DEBUG] Token did not match any valid Base cases: Type='%s', Value='%s'\n", token->type, token->value);
+    if (parserDebug) printf("[DEBUG] Token did not match any valid Base cases: Type='%s', Value='%s'\n", token->type, token->value);
     reportSyntaxError("Expected a valid Base (grouped expression, literal, or identifier).");
     recoverFromError();
     return NULL;
 }
 
 ParseTreeNode* parseFactor() {
-    printf("[DEBUG] Parsing Factor...\n");
+    if (parserDebug) printf("[DEBUG] Parsing Factor...\n");
 
     Token* token = peekToken();
     if (!token) {
@@ -2508,9 +3457,26 @@ ParseTreeNode* parseFactor() {
 
     ParseTreeNode* factorNode = NULL;
 
+    // Handle Logical NOT: `!` binds to the factor that follows it
+    if (strcmp(token->type, "LogicalOperator") == 0 && strcmp(token->value, "!") == 0) {
+        if (parserDebug) printf("[DEBUG] Detected Logical NOT Operator '!'.\n");
+        ParseTreeNode* notNode = createParseTreeNode("LogicalNotExpr", "!");
+        addChild(notNode, matchToken("LogicalOperator", "!"));
+
+        ParseTreeNode* operand = parseFactor();
+        if (!operand) {
+            reportSyntaxError("Failed to parse operand for Logical NOT.");
+            recoverFromError();
+            freeParseTree(notNode);
+            return NULL;
+        }
+        addChild(notNode, operand);
+        return notNode;
+    }
+
     // **Handle Parenthesized Expressions `(expr)`**
     if (strcmp(token->type, "Delimiter") == 0 && strcmp(token->value, "(") == 0) {
-        printf("[DEBUG] Detected '(' indicating a grouped expression.\n");
+        if (parserDebug) printf("[DEBUG] Detected '(' indicating a grouped expression.\n");
         factorNode = createParseTreeNode("GroupedExpr", "");
 
         // Match '('
@@ -2536,19 +3502,24 @@ ParseTreeNode* parseFactor() {
         }
         addChild(factorNode, matchToken("Delimiter", ")"));
 
-        printf("[DEBUG] Successfully parsed grouped expression.\n");
+        if (parserDebug) printf("[DEBUG] Successfully parsed grouped expression.\n");
     }
     // **Handle Literals and Identifiers**
     else if (strcmp(token->type, "INT_LITERAL") == 0 || strcmp(token->type, "FLOAT_LITERAL") == 0 ||
              strcmp(token->type, "CHAR_LITERAL") == 0 || strcmp(token->type, "STRING_LITERAL") == 0 ||
              (strcmp(token->type, "Keyword") == 0 &&
               (strcmp(token->value, "true") == 0 || strcmp(token->value, "false") == 0))) {
-        printf("[DEBUG] Detected Literal: Type='%s', Value='%s'\n", token->type, token->value);
+        if (parserDebug) printf("[DEBUG] Detected Literal: Type='%s', Value='%s'\n", token->type, token->value);
         factorNode = matchToken(token->type, token->value);
     }
     else if (strcmp(token->type, "IDENTIFIER") == 0) {
-        printf("[DEBUG] Detected Identifier: '%s'\n", token->value);
+        if (parserDebug) printf("[DEBUG] Detected Identifier: '%s'\n", token->value);
         factorNode = matchToken("IDENTIFIER", token->value);
+        token = peekToken();
+        if (factorNode && token && strcmp(token->type, "Delimiter") == 0 && strcmp(token->value, "[") == 0) {
+            factorNode = parseArrayAccess(factorNode);
+            if (!factorNode) return NULL;
+        }
     }
     else {
         reportSyntaxError("Expected a valid Factor (literal, identifier, or grouped expression).");
@@ -2559,7 +3530,7 @@ ParseTreeNode* parseFactor() {
     // **Fix: Handle Right-Associative Exponentiation (`^`) Inside Factor**
     token = peekToken();
     if (token && strcmp(token->type, "ArithmeticOperator") == 0 && strcmp(token->value, "^") == 0) {
-        printf("[DEBUG] Detected Exponentiation Operator '%s'.\n", token->value);
+        if (parserDebug) printf("[DEBUG] Detected Exponentiation Operator '%s'.\n", token->value);
 
         // **Ensure exponentiation remains inside Factor**
         ParseTreeNode* exponentNode = createParseTreeNode("Factor", "");  // <-- FIXED: Wrap it in `Factor`
@@ -2580,17 +3551,17 @@ ParseTreeNode* parseFactor() {
         }
         addChild(exponentNode, rightFactor);
 
-        printf("[DEBUG] Successfully parsed Factor with Exponentiation.\n");
+        if (parserDebug) printf("[DEBUG] Successfully parsed Factor with Exponentiation.\n");
         return exponentNode;  // Return the correctly structured exponentiation inside Factor
     }
 
-    printf("[DEBUG] Successfully parsed Factor.\n");
+    if (parserDebug) printf("[DEBUG] Successfully parsed Factor.\n");
     return factorNode;
 }
 
 
 ParseTreeNode* parseTerm() {
-    printf("[DEBUG] Parsing Term...\n");
+    if (parserDebug) printf("[DEBUG] Parsing Term...\n");
 
     // Parse the left-hand side as a factor (handles exponentiation inside parseFactor)
     ParseTreeNode* leftOperand = parseFactor();
@@ -2606,7 +3577,7 @@ ParseTreeNode* parseTerm() {
     while (token && strcmp(token->type, "ArithmeticOperator") == 0 &&
            (strcmp(token->value, "*") == 0 || strcmp(token->value, "/") == 0 ||
             strcmp(token->value, "//") == 0 || strcmp(token->value, "%") == 0)) {
-        printf("[DEBUG] Detected Multiplication/Division/Modulo operator '%s'.\n", token->value);
+        if (parserDebug) printf("[DEBUG] Detected Multiplication/Division/Modulo operator '%s'.\n", token->value);
 
         // Create a node for the term operation
         ParseTreeNode* termNode = createParseTreeNode("Term", "");
@@ -2636,12 +3607,12 @@ ParseTreeNode* parseTerm() {
         token = peekToken();
     }
 
-    printf("[DEBUG] Successfully parsed Term.\n");
+    if (parserDebug) printf("[DEBUG] Successfully parsed Term.\n");
     return leftOperand;
 }
 
 ParseTreeNode* parseAssignExpr() {
-    printf("[DEBUG] Parsing Assignment Expression...\n");
+    if (parserDebug) printf("[DEBUG] Parsing Assignment Expression...\n");
 
     // Create a parse tree node for the assignment expression
     ParseTreeNode* assignExprNode = createParseTreeNode("AssignExpr", "");
@@ -2660,13 +3631,13 @@ ParseTreeNode* parseAssignExpr() {
     if (strcmp(token->type, "INT_LITERAL") == 0 || strcmp(token->type, "FLOAT_LITERAL") == 0 ||
         strcmp(token->type, "CHAR_LITERAL") == 0 || strcmp(token->type, "STRING_LITERAL") == 0 ||
         (strcmp(token->type, "Keyword") == 0 && (strcmp(token->value, "true") == 0 || strcmp(token->value, "false") == 0))) {
-        printf("[DEBUG] Parsing Literal as right-hand side of Assignment Expression.\n");
+        if (parserDebug) printf("[DEBUG] Parsing Literal as right-hand side of Assignment Expression.\n");
         rhsNode = parseLiteral();
     } else if (strcmp(token->type, "RelationalOperator") == 0 || strcmp(token->type, "LogicalOperator") == 0) {
-        printf("[DEBUG] Parsing Boolean Expression as right-hand side of Assignment Expression.\n");
+        if (parserDebug) printf("[DEBUG] Parsing Boolean Expression as right-hand side of Assignment Expression.\n");
         rhsNode = parseBoolExpr();
     } else {
-        printf("[DEBUG] Parsing Arithmetic Expression as right-hand side of Assignment Expression.\n");
+        if (parserDebug) printf("[DEBUG] Parsing Arithmetic Expression as right-hand side of Assignment Expression.\n");
         rhsNode = parseArithmeticExpr();
     }
 
@@ -2678,7 +3649,7 @@ ParseTreeNode* parseAssignExpr() {
     }
     addChild(assignExprNode, rhsNode);
 
-    printf("[DEBUG] Successfully parsed Assignment Expression.\n");
+    if (parserDebug) printf("[DEBUG] Successfully parsed Assignment Expression.\n");
     return assignExprNode;
 }
 
@@ -2687,7 +3658,7 @@ ParseTreeNode* parseAssignExpr() {
 // ---------------------------------------
 
 ParseTreeNode* parseBoolLiteral() {
-    printf("[DEBUG] Parsing Boolean Literal...\n");
+    if (parserDebug) printf("[DEBUG] Parsing Boolean Literal...\n");
 
     Token* token = peekToken();
     if (!token) {
@@ -2701,7 +3672,7 @@ ParseTreeNode* parseBoolLiteral() {
         (strcmp(token->value, "true") == 0 || strcmp(token->value, "false") == 0)) {
         ParseTreeNode* boolLiteralNode = matchToken("Keyword", token->value);
         if (boolLiteralNode) {
-            printf("[DEBUG] Successfully parsed Boolean Literal: '%s'.\n", token->value);
+            if (parserDebug) printf("[DEBUG] Successfully parsed Boolean Literal: '%s'.\n", token->value);
             return createParseTreeNode("BoolLiteral", boolLiteralNode->label);
         }
     }
@@ -2712,7 +3683,7 @@ ParseTreeNode* parseBoolLiteral() {
 }
 
 ParseTreeNode* parseLiteral() {
-    printf("[DEBUG] Parsing Literal...\n");
+    if (parserDebug) printf("[DEBUG] Parsing Literal...\n");
 
     Token* token = peekToken();
     if (!token) {
@@ -2723,11 +3694,11 @@ ParseTreeNode* parseLiteral() {
 
     if (strcmp(token->type, "INT_LITERAL") == 0 || strcmp(token->type, "FLOAT_LITERAL") == 0 ||
         strcmp(token->type, "CHAR_LITERAL") == 0 || strcmp(token->type, "STRING_LITERAL") == 0) {
-        printf("[DEBUG] Matched numeric/character/string literal: %s\n", token->value);
+        if (parserDebug) printf("[DEBUG] Matched numeric/character/string literal: %s\n", token->value);
         return createParseTreeNode("Literal", matchToken(token->type, token->value)->value);
     } else if (strcmp(token->type, "Keyword") == 0 &&
                (strcmp(token->value, "true") == 0 || strcmp(token->value, "false") == 0)) {
-        printf("[DEBUG] Detected boolean literal: %s\n", token->value);
+        if (parserDebug) printf("[DEBUG] Detected boolean literal: %s\n", token->value);
         return parseBoolLiteral(); // Call `parseBoolLiteral` for "true" or "false"
     }
 
@@ -2741,7 +3712,7 @@ ParseTreeNode* parseLiteral() {
 // ---------------------------------------
 
 ParseTreeNode* parseComment() {
-    printf("[DEBUG] Parsing Comment...\n");
+    if (parserDebug) printf("[DEBUG] Parsing Comment...\n");
 
     // Create a parse tree node for the comment
     ParseTreeNode* commentNode = createParseTreeNode("Comment", "");
@@ -2759,7 +3730,7 @@ ParseTreeNode* parseComment() {
         token = getNextToken();
         // Add the comment token value as a child node
         addChild(commentNode, createParseTreeNode("CommentContent", token->value));
-        printf("[DEBUG] Parsed Comment: %s\n", token->value);
+        if (parserDebug) printf("[DEBUG] Parsed Comment: %s\n", token->value);
     } else {
         // Error for non-comment token
         char errorMessage[200];
@@ -2779,7 +3750,7 @@ ParseTreeNode* parseComment() {
 // ---------------------------------------
 
 ParseTreeNode* parseFormatString() {
-    printf("[DEBUG] Parsing Format String...\n");
+    if (parserDebug) printf("[DEBUG] Parsing Format String...\n");
 
     Token* token = peekToken();
     if (!token) {
@@ -2818,7 +3789,7 @@ ParseTreeNode* parseFormatString() {
 }
 
 ParseTreeNode* parseOutputList() {
-    printf("[DEBUG] Parsing Output List...\n");
+    if (parserDebug) printf("[DEBUG] Parsing Output List...\n");
 
     ParseTreeNode* outputListNode = createParseTreeNode("OutputList", "");
 
@@ -2851,6 +3822,6 @@ ParseTreeNode* parseOutputList() {
         token = peekToken();
     }
 
-    printf("[DEBUG] Successfully parsed Output List.\n");
+    if (parserDebug) printf("[DEBUG] Successfully parsed Output List.\n");
     return outputListNode;
 }
\ No newline at end of file
@@ -4,6 +4,8 @@
 
 #include "token.h"
 #include "parse_tree.h"
+#include "source_map.h"
+#include "symbol_table.h"
 
 // ---------------------------------------
 // Global Variables - Declaration                   // Rasty
@@ -12,6 +14,16 @@ extern int currentTokenIndex;
 extern int totalTokens;
 extern Token* tokenStream;
 extern Token tokens[MAX_TOKENS]; // Array of tokens
+extern SourceMap* sourceMap;     // In-memory source for diagnostics
+extern int parserDebug;          // Non-zero: print [DEBUG] parser tracing
+extern int syntaxErrorCount;     // Running count of reported syntax errors
+extern int spanBase;             // Token index that nested span offsets are relative to
+extern int lazyBlocks;           // Non-zero: defer block bodies (outline/indexing jobs)
+extern int* matchingDelimiter;   // Matching bracket index, built for lazy parsing
+extern int deferredBlockCount;   // Blocks deferred so far
+extern int expandedBlockCount;   // Deferred blocks expanded so far
+extern SymbolTable* semanticTable; // Scoped declarations (NULL when not recording)
+extern int semanticErrorCount;   // Redeclarations and undeclared uses reported
 
 // ---------------------------------------
 // Utility Functions - Defined in syntax_analyzer.c     // Rasty
@@ -24,6 +36,8 @@ void trimWhitespace(char* str);        // Utility to trim whitespace
 void mapToken(Token* token);           // Map token to its type/value
 int loadTokensFromFile(const char* filename); // Load tokens from a file
 ParseTreeNode* matchToken(const char* expectedType, const char* expectedValue); // Match token by type/value
+ParseTreeNode* matchDeclaredIdentifier(const char* typeName); // Match a declared name and enter it in scope
+void noteIdentifierUse(const Token* token);                   // Resolve and count an identifier use
 
 // ---------------------------------------
 // Parse Tree Handling - Defined in parse_tree.c    // Rasty
@@ -37,6 +51,12 @@ void freeParseTree(ParseTreeNode* node);                                // Free
 // Top-Level Grammar Rules                      // Rasty
 // ---------------------------------------
 ParseTreeNode* parseProgram();
+ParseTreeNode* parseTrackedStatement(int containerStart, int statementStart); // Statement plus token span
+ParseTreeNode* parseBlock();
+ParseTreeNode* parseScopedBlock();                                  // parseBlock body, inside the pushed scope
+int parseBlockStatements(ParseTreeNode* blockNode, int blockStart); // Statements up to the closing '}'
+void expandBlock(ParseTreeNode* blockNode);                       // Parse a deferred block body
+void buildDelimiterIndex();                                         // Fill matchingDelimiter
 ParseTreeNode* parseMainFunction();                              
 ParseTreeNode* parseStatementList();
 
@@ -50,6 +70,8 @@ ParseTreeNode* parseComment();
 // ---------------------------------------
 ParseTreeNode* parseDeclarationStatement();
 ParseTreeNode* parseVariableDeclaration();
+ParseTreeNode* parseArrayDeclaration();
+ParseTreeNode* parseArrayInitializer(int rank); // Rows are nested initializers when rank is 2
 ParseTreeNode* parseTypeSpecifier();
 ParseTreeNode* parseInitializer();
 
@@ -71,13 +93,18 @@ ParseTreeNode* parseJumpStatement();
 // ---------------------------------------    
 ParseTreeNode* parseIfStatement();               
 ParseTreeNode* parseStatementBlock();
+ParseTreeNode* parseSwitchStatement();
+ParseTreeNode* parseSwitchClause();              // case <literal> : ... or default : ...
 
 // ---------------------------------------
 // Loop                                         // kurt
 // ---------------------------------------
 ParseTreeNode* parseForInit();
 ParseTreeNode* parseForLoop();
+ParseTreeNode* parseScopedForLoop(); // parseForLoop body, inside the loop scope
 ParseTreeNode* parseForUpdate();                
+ParseTreeNode* parseWhileLoop();
+ParseTreeNode* parseDoWhileLoop();
 
 // ---------------------------------------
 // Expressions and Operators                    // rasty
@@ -85,6 +112,7 @@ ParseTreeNode* parseForUpdate();
 ParseTreeNode* parseExpression();
 ParseTreeNode* parseRelationalExpr();     
 ParseTreeNode* parseBoolExpr(); 
+ParseTreeNode* parseLogicalAndExpr();
 ParseTreeNode* parseAssignmentExpr();     
 ParseTreeNode* parseArithmeticExpr();
 ParseTreeNode* parseAssignExpr();
@@ -94,6 +122,7 @@ ParseTreeNode* parseUnaryExpr();
 ParseTreeNode* parseExponentialExpr();
 ParseTreeNode* parseTerm();
 ParseTreeNode* parseBase();
+ParseTreeNode* parseArrayAccess(ParseTreeNode* identifierNode); // Indices after an array's name
 
 // ---------------------------------------
 // Literals and Identifiers                     
@@ -120,6 +149,7 @@ ParseTreeNode* parseFactor();
 // Error Handling                               // Rasty
 // ---------------------------------------
 int reportSyntaxError(const char *message);
+void reportSemanticError(const Token* token, const char* message); // Report without recovery
 int recoverFromError(); // Error recovery mechanism
 
 #endif // SYNTAX_ANALYZER_H
\ No newline at end of file
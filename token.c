@@ -8,6 +8,19 @@
 #include "utils.h"
 #include "comment_handler.h"
 #include "config.h"
+#include "source_map.h"
+
+int lexerDebug = 1;
+
+// Optional in-memory receiver for tokens
+static TokenSink tokenSink = NULL;
+static void *tokenSinkContext = NULL;
+
+// Line currently being tokenized: where it starts in the source, and where in
+// it the token being built starts
+static const SourceMap *currentSource = NULL;
+static size_t lineOffset = 0;  // Byte offset of the (trimmed) line's first character
+static int tokenStart = 0;     // Index of the current token's first character in the line
 
 // Function to create a new token
 Token* makeToken(const char *type, const char *value, int lineNumber) {
@@ -25,18 +38,60 @@ Token* makeToken(const char *type, const char *value, int lineNumber) {
 
     // Assign the line number
     token->lineNumber = lineNumber;
+    token->column = 0;
+    token->symbolId = SYMBOL_NONE;
 
     return token;
 } // end of makeToken function
 
+// Function to start a new (trimmed) source line whose first character is at
+// byte `offset` of `source`
+void beginTokenLine(const SourceMap *source, size_t offset) {
+    currentSource = source;
+    lineOffset = offset;
+    tokenStart = 0;
+} // end of beginTokenLine function
+
+// Function to note where in the current line the next written token starts
+void setTokenStart(int index) {
+    tokenStart = index;
+} // end of setTokenStart function
+
+// Function to get the byte offset of the token being written
+size_t currentTokenOffset(void) {
+    return lineOffset + (size_t)tokenStart;
+} // end of currentTokenOffset function
+
+// Function to redirect written tokens to an in-memory sink
+void setTokenSink(TokenSink sink, void *context) {
+    tokenSink = sink;
+    tokenSinkContext = context;
+} // end of setTokenSink function
+
+// Function to intern the text of identifier-like and string tokens
+SymbolId internTokenValue(const Token *token) {
+    if (strcmp(token->type, "IDENTIFIER") == 0 || strcmp(token->type, "STRING_LITERAL") == 0) {
+        return internString(token->value);
+    }
+    if (strcmp(token->type, "SpecifierIdentifier") == 0 && token->value[0] == '&') {
+        return internString(token->value + 1); // `&value` refers to the variable `value`
+    }
+    return SYMBOL_NONE;
+} // end of internTokenValue function
+
 // Function to write a token to the symbol table
 void writeToken(FILE *symbolTable, const char *type, const char *value, int lineNumber) {
-    if (symbolTable != NULL && type != NULL && value != NULL) {
-        // Write token in a comma-separated format: TokenType, Value, LineNumber
-        fprintf(symbolTable, "%s,%s,%d\n", type, value, lineNumber);
+    if (tokenSink != NULL && type != NULL && value != NULL) {
+        tokenSink(tokenSinkContext, type, value, currentTokenOffset());
+    } else if (symbolTable != NULL && type != NULL && value != NULL) {
+        int column = 0;
+        if (currentSource) sourceLocate(currentSource, currentTokenOffset(), &lineNumber, &column);
+
+        // Write token in a comma-separated format: TokenType, Value, LineNumber:Column
+        fprintf(symbolTable, "%s,%s,%d:%d\n", type, value, lineNumber, column);
 
         // Debugging log
-        printf("[Debug] Written Token: Type = %s, Value = %s, Line = %d\n", type, value, lineNumber);
+        if (lexerDebug) printf("[Debug] Written Token: Type = %s, Value = %s, Line = %d, Column = %d\n", type, value, lineNumber, column);
     } else {
         fprintf(stderr, "[Error] Failed to write token: Type = %s, Value = %s, Line = %d\n", 
                 type ? type : "(null)", value ? value : "(null)", lineNumber);
@@ -2,17 +2,34 @@
 #define TOKEN_H
 
 #include <stdio.h>
+#include <stddef.h>
+#include "intern.h"
+#include "source_map.h"
 
 // Token structure
 typedef struct {
     char type[50];
     char value[50];
     int lineNumber;
+    int column;        // 1-based column of the first character (0 if unknown)
+    SymbolId symbolId; // Interned id for identifiers and string literals (SYMBOL_NONE otherwise)
 } Token;
 
+// Receives tokens in place of the symbol table file (in-memory lexing), each
+// with the byte offset of its first character in the source being lexed
+typedef void (*TokenSink)(void *context, const char *type, const char *value, size_t offset);
+
+// Set to 0 to silence per-token debug output (benchmarks, editor integration)
+extern int lexerDebug;
+
 // Function prototypes
 Token* makeToken(const char *type, const char *value, int lineNumber);
 void writeToken(FILE *symbolTable, const char *type, const char *value, int lineNumber);
+void setTokenSink(TokenSink sink, void *context);      // NULL restores file output
+SymbolId internTokenValue(const Token *token);         // Intern identifier/string token text
+void beginTokenLine(const SourceMap *source, size_t offset); // Start a line beginning at source byte `offset`
+void setTokenStart(int index);                         // The next token starts at line[index]
+size_t currentTokenOffset(void);                       // Source byte offset of the token being written
 
 // For debugging purposes
 void printToken(const Token *token); // Debug: Print token details
@@ -0,0 +1,693 @@
+#include "type_checker.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "arithmetic.h"
+#include "symbol_table.h"
+
+// Operators that share one result table
+typedef enum {
+    CLASS_NONE,
+    CLASS_ARITHMETIC, // + - *
+    CLASS_DIVISION,   // / (always float)
+    CLASS_INTEGER,    // // %
+    CLASS_POWER,      // ^ (numeric base, int exponent)
+    CLASS_ORDER,      // < <= > >=
+    CLASS_EQUALITY,   // == !=
+    CLASS_LOGICAL,    // && ||
+    CLASS_COUNT
+} OperatorClass;
+
+#define OPERATOR_COUNT (OP_DECREMENT + 1)
+#define TYPE_INVALID 0xFF // Table entry for an operand pair the operator rejects
+
+// Dense tables indexed by OperatorCode and SymbolType, filled once
+static unsigned char operatorClass[OPERATOR_COUNT];
+static unsigned char compoundBase[OPERATOR_COUNT]; // += -> +, //= -> //, ...
+static unsigned char resultType[CLASS_COUNT][TYPE_COUNT][TYPE_COUNT];
+static int tablesReady = 0;
+
+typedef struct {
+    SymbolTable* scopes;
+    const Token* tokens;
+    int tokenCount;
+    int anchor;              // Absolute first token of the innermost tracked node
+    TypeCheckResult* result;
+} TypeChecker;
+
+static int isIntegral(int type) {
+    return type == TYPE_INT || type == TYPE_CHAR;
+}
+
+static int isNumeric(int type) {
+    return isIntegral(type) || type == TYPE_FLOAT;
+}
+
+static int yieldsBool(int operatorClassId) {
+    return operatorClassId == CLASS_ORDER || operatorClassId == CLASS_EQUALITY || operatorClassId == CLASS_LOGICAL;
+}
+
+// Function to compute the result of `left op right` for one operator class
+static int ruleFor(int operatorClassId, int left, int right) {
+    // Unknown operands were already reported (see resolveName); stay quiet
+    if (left == TYPE_UNKNOWN || right == TYPE_UNKNOWN) {
+        return yieldsBool(operatorClassId) ? TYPE_BOOL : TYPE_UNKNOWN;
+    }
+
+    int wider = (left == TYPE_FLOAT || right == TYPE_FLOAT) ? TYPE_FLOAT : TYPE_INT;
+    switch (operatorClassId) {
+        case CLASS_ARITHMETIC:
+            return isNumeric(left) && isNumeric(right) ? wider : TYPE_INVALID;
+        case CLASS_DIVISION:
+            return isNumeric(left) && isNumeric(right) ? TYPE_FLOAT : TYPE_INVALID;
+        case CLASS_INTEGER:
+            return isIntegral(left) && isIntegral(right) ? TYPE_INT : TYPE_INVALID;
+        case CLASS_POWER:
+            return isNumeric(left) && isIntegral(right) ? (left == TYPE_FLOAT ? TYPE_FLOAT : TYPE_INT) : TYPE_INVALID;
+        case CLASS_ORDER:
+            return isNumeric(left) && isNumeric(right) ? TYPE_BOOL : TYPE_INVALID;
+        case CLASS_EQUALITY:
+            return (isNumeric(left) && isNumeric(right)) || left == right ? TYPE_BOOL : TYPE_INVALID;
+        case CLASS_LOGICAL:
+            return left == TYPE_BOOL && right == TYPE_BOOL ? TYPE_BOOL : TYPE_INVALID;
+        default:
+            return TYPE_INVALID;
+    }
+}
+
+static void buildTables(void) {
+    static const struct { unsigned char op, operatorClassId; } classes[] = {
+        {OP_ADD, CLASS_ARITHMETIC}, {OP_SUB, CLASS_ARITHMETIC}, {OP_MUL, CLASS_ARITHMETIC},
+        {OP_DIV, CLASS_DIVISION}, {OP_FLOOR_DIV, CLASS_INTEGER}, {OP_MOD, CLASS_INTEGER},
+        {OP_POW, CLASS_POWER},
+        {OP_LT, CLASS_ORDER}, {OP_LE, CLASS_ORDER}, {OP_GT, CLASS_ORDER}, {OP_GE, CLASS_ORDER},
+        {OP_EQ, CLASS_EQUALITY}, {OP_NE, CLASS_EQUALITY},
+        {OP_AND, CLASS_LOGICAL}, {OP_OR, CLASS_LOGICAL},
+    };
+    for (size_t i = 0; i < sizeof(classes) / sizeof(classes[0]); i++) {
+        operatorClass[classes[i].op] = classes[i].operatorClassId;
+    }
+
+    compoundBase[OP_ADD_ASSIGN] = OP_ADD;
+    compoundBase[OP_SUB_ASSIGN] = OP_SUB;
+    compoundBase[OP_MUL_ASSIGN] = OP_MUL;
+    compoundBase[OP_DIV_ASSIGN] = OP_DIV;
+    compoundBase[OP_MOD_ASSIGN] = OP_MOD;
+    compoundBase[OP_FLOOR_DIV_ASSIGN] = OP_FLOOR_DIV;
+
+    for (int c = 0; c < CLASS_COUNT; c++) {
+        for (int left = 0; left < TYPE_COUNT; left++) {
+            for (int right = 0; right < TYPE_COUNT; right++) {
+                resultType[c][left][right] = (unsigned char)ruleFor(c, left, right);
+            }
+        }
+    }
+    tablesReady = 1;
+}
+
+// ---------------------------------------
+// Diagnostics
+// ---------------------------------------
+
+static void typeError(TypeChecker* checker, const char* format, ...) {
+    TypeCheckResult* result = checker->result;
+    if (result->errorCount == result->errorCapacity) {
+        result->errorCapacity = result->errorCapacity ? result->errorCapacity * 2 : 16;
+        result->errors = (TypeError*)realloc(result->errors, result->errorCapacity * sizeof(TypeError));
+        if (!result->errors) {
+            fprintf(stderr, "Error: Memory allocation failed in type checker.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    TypeError* error = &result->errors[result->errorCount++];
+    error->line = 0;
+    error->column = 0;
+    error->width = 1;
+    if (checker->tokens && checker->anchor < checker->tokenCount) {
+        const Token* token = &checker->tokens[checker->anchor];
+        error->line = token->lineNumber;
+        error->column = token->column;
+        error->width = (int)strlen(token->value);
+    }
+
+    va_list args;
+    va_start(args, format);
+    vsnprintf(error->message, sizeof(error->message), format, args);
+    va_end(args);
+}
+
+static const char* typeName(int type) {
+    return symbolTypeName((SymbolType)type);
+}
+
+// ---------------------------------------
+// Expressions
+// ---------------------------------------
+
+static int checkExpression(TypeChecker* checker, ParseTreeNode* node);
+static void checkStatement(TypeChecker* checker, ParseTreeNode* node);
+
+// Function to wrap parent->children[index] in an IntToFloat node
+static void convertToFloat(TypeChecker* checker, ParseTreeNode* parent, int index) {
+    ParseTreeNode* operand = parent->children[index];
+    if (operand->kind == NODE_INT_TO_FLOAT) return;
+
+    ParseTreeNode* conversion = createParseTreeNode("IntToFloat", "");
+    addChild(conversion, operand);
+    parent->children[index] = conversion;
+    checker->result->conversions++;
+}
+
+// Function to check `left op right` where children are [left, operator, right]
+static int checkBinary(TypeChecker* checker, ParseTreeNode* node) {
+    ParseTreeNode* operatorNode = node->children[1];
+    int operatorClassId = operatorClass[operatorNode->op];
+    int left = checkExpression(checker, node->children[0]);
+    int right = checkExpression(checker, node->children[2]);
+
+    int result = resultType[operatorClassId][left][right];
+    if (result == TYPE_INVALID) {
+        if (operatorClassId == CLASS_INTEGER) {
+            typeError(checker, "Operator '%s' needs int operands, found %s and %s.",
+                      operatorNode->value, typeName(left), typeName(right));
+        } else if (operatorClassId == CLASS_POWER) {
+            typeError(checker, "Operator '^' needs a numeric base and an int exponent, found %s and %s.",
+                      typeName(left), typeName(right));
+        } else {
+            typeError(checker, "Operator '%s' cannot be applied to %s and %s.",
+                      operatorNode->value, typeName(left), typeName(right));
+        }
+        return yieldsBool(operatorClassId) ? TYPE_BOOL : TYPE_UNKNOWN;
+    }
+
+    // Mixed numeric operands meet as float; '/' always divides as float
+    if (operatorClassId != CLASS_POWER && operatorClassId != CLASS_INTEGER) {
+        int operandType = (operatorClassId == CLASS_DIVISION) ? TYPE_FLOAT
+                        : (left == TYPE_FLOAT || right == TYPE_FLOAT) ? TYPE_FLOAT : TYPE_UNKNOWN;
+        if (operandType == TYPE_FLOAT) {
+            if (isIntegral(left)) convertToFloat(checker, node, 0);
+            if (isIntegral(right)) convertToFloat(checker, node, 2);
+        }
+    }
+    return result;
+}
+
+// Function to check that a value of type `value` may be stored in a `target` variable.
+// `index` is the value's position in `parent`, where a conversion is inserted if needed.
+static void checkStore(TypeChecker* checker, const char* name, int target, int value,
+                       ParseTreeNode* parent, int index) {
+    if (target == TYPE_UNKNOWN || value == TYPE_UNKNOWN || target == value) return;
+    if (target == TYPE_FLOAT && isIntegral(value)) {
+        convertToFloat(checker, parent, index);
+        return;
+    }
+    if (target == TYPE_INT && value == TYPE_CHAR) return;
+
+    typeError(checker, "Cannot store a %s value in %s variable '%s'.", typeName(value), typeName(target), name);
+}
+
+// Function to check an assignment: [target, operator, value, ';'?].
+// Chained assignments nest as the value; the result is the target's type.
+static int checkAssignment(TypeChecker* checker, ParseTreeNode* node) {
+    if (node->childCount < 3) return TYPE_UNKNOWN;
+
+    ParseTreeNode* targetNode = node->children[0];
+    ParseTreeNode* operatorNode = node->children[1];
+    int target = checkExpression(checker, targetNode);
+    int value = checkExpression(checker, node->children[2]);
+    const char* name = (targetNode->kind == NODE_IDENTIFIER || targetNode->kind == NODE_ARRAY_ACCESS)
+                     ? targetNode->value : "(expression)";
+
+    int op = operatorNode->op;
+    if (op != OP_ASSIGN && compoundBase[op] != OP_NONE) {
+        int operatorClassId = operatorClass[compoundBase[op]];
+        int result = resultType[operatorClassId][target][value];
+        if (result == TYPE_INVALID) {
+            if (operatorClassId == CLASS_INTEGER) {
+                typeError(checker, "Operator '%s' needs int operands, found %s and %s.",
+                          operatorNode->value, typeName(target), typeName(value));
+            } else {
+                typeError(checker, "Operator '%s' cannot be applied to %s and %s.",
+                          operatorNode->value, typeName(target), typeName(value));
+            }
+            return target;
+        }
+        if (target != TYPE_UNKNOWN && result != TYPE_UNKNOWN && result != target) {
+            typeError(checker, "Operator '%s' gives %s, which cannot be stored back in %s variable '%s'.",
+                      operatorNode->value, typeName(result), typeName(target), name);
+            return target;
+        }
+        if (target == TYPE_FLOAT && isIntegral(value)) {
+            convertToFloat(checker, node, 2);
+        }
+        return target;
+    }
+
+    checkStore(checker, name, target, value, node, 2);
+    return target;
+}
+
+// Function to bind an IDENTIFIER to its declaration. An undeclared name is a type error
+// too (on top of the parser's semantic error), so errorCount alone keeps such a tree
+// away from folding and the backends.
+static const Symbol* resolveName(TypeChecker* checker, ParseTreeNode* name) {
+    const Symbol* symbol = lookupSymbol(checker->scopes, name->symbolId);
+    name->binding = symbol ? (int)(symbol - checker->scopes->symbols) : -1;
+    if (!symbol) typeError(checker, "'%s' is not declared in this scope.", name->value);
+    return symbol;
+}
+
+// Function to check name[index] or name[row][column]: [IDENTIFIER, '[', index, ']', ...].
+// The result is the element type.
+static int checkArrayAccess(TypeChecker* checker, ParseTreeNode* node) {
+    ParseTreeNode* name = node->children[0];
+    const Symbol* symbol = resolveName(checker, name);
+    name->type = symbol ? (unsigned char)symbol->type : TYPE_UNKNOWN;
+
+    int indices = 0;
+    for (int i = 1; i < node->childCount; i++) {
+        if (!NODE_IS_EXPRESSION(node->children[i]->kind)) continue;
+        int index = checkExpression(checker, node->children[i]);
+        if (index != TYPE_UNKNOWN && !isIntegral(index)) {
+            typeError(checker, "Array index must be int, found %s.", typeName(index));
+        }
+        indices++;
+    }
+
+    if (!symbol) return TYPE_UNKNOWN;
+    if (symbol->type != TYPE_ARRAY) {
+        typeError(checker, "'%s' is not an array.", name->value);
+        return TYPE_UNKNOWN;
+    }
+    if (indices != symbol->rank) {
+        typeError(checker, "Array '%s' has %d dimension%s but is used with %d ind%s.", name->value,
+                  symbol->rank, symbol->rank == 1 ? "" : "s", indices, indices == 1 ? "ex" : "ices");
+        return TYPE_UNKNOWN;
+    }
+    return symbol->elementType;
+}
+
+// Function to resolve, record and return the type of an expression node
+static int checkExpression(TypeChecker* checker, ParseTreeNode* node) {
+    if (!node) return TYPE_UNKNOWN;
+
+    int type = TYPE_UNKNOWN;
+    switch (node->kind) {
+        case NODE_INT_LITERAL:
+        case NODE_FLOAT_LITERAL:
+        case NODE_CHAR_LITERAL:
+        case NODE_STRING_LITERAL:
+        case NODE_BOOL_LITERAL:
+        case NODE_LITERAL:
+            type = node->type; // Known since the node was created
+            break;
+
+        case NODE_IDENTIFIER: {
+            const Symbol* symbol = resolveName(checker, node);
+            type = symbol ? symbol->type : TYPE_UNKNOWN;
+            if (type == TYPE_ARRAY) {
+                // Arrays are not values: no copies, comparisons or arithmetic on the whole array
+                typeError(checker, "Array '%s' can only be used with an index.", node->value);
+                type = TYPE_UNKNOWN;
+            }
+            break;
+        }
+
+        case NODE_ARRAY_ACCESS:
+            type = checkArrayAccess(checker, node);
+            break;
+
+        case NODE_EXPRESSION:
+        case NODE_IDENTIFIER_EXPR:
+        case NODE_ASSIGN_EXPR:
+            if (node->childCount > 0) type = checkExpression(checker, node->children[0]);
+            break;
+
+        case NODE_GROUPED_EXPR:
+            if (node->childCount > 1) type = checkExpression(checker, node->children[1]);
+            break;
+
+        case NODE_INT_TO_FLOAT:
+            if (node->childCount > 0) checkExpression(checker, node->children[0]);
+            type = TYPE_FLOAT;
+            break;
+
+        case NODE_LOGICAL_OR_EXPR:
+        case NODE_LOGICAL_AND_EXPR:
+        case NODE_RELATIONAL_EXPR:
+        case NODE_ARITHMETIC_EXPR:
+        case NODE_TERM:
+        case NODE_FACTOR:
+            if (node->childCount == 3 && node->children[1]->kind == NODE_OPERATOR) {
+                type = checkBinary(checker, node);
+            }
+            break;
+
+        case NODE_EXPONENTIAL_EXPR: {
+            // [base, exponent]: the '^' token is consumed without a node
+            if (node->childCount < 2) break;
+            int base = checkExpression(checker, node->children[0]);
+            int exponent = checkExpression(checker, node->children[1]);
+            type = resultType[CLASS_POWER][base][exponent];
+            if (type == TYPE_INVALID) {
+                typeError(checker, "Operator '^' needs a numeric base and an int exponent, found %s and %s.",
+                          typeName(base), typeName(exponent));
+                type = TYPE_UNKNOWN;
+            }
+            break;
+        }
+
+        case NODE_LOGICAL_NOT_EXPR: {
+            int operand = node->childCount > 1 ? checkExpression(checker, node->children[1]) : TYPE_UNKNOWN;
+            if (operand != TYPE_UNKNOWN && operand != TYPE_BOOL) {
+                typeError(checker, "Operator '!' needs a bool operand, found %s.", typeName(operand));
+            }
+            type = TYPE_BOOL;
+            break;
+        }
+
+        case NODE_UNARY_EXPR: {
+            // [++, x] or [x, ++]
+            for (int i = 0; i < node->childCount; i++) {
+                ParseTreeNode* child = node->children[i];
+                if (child->kind != NODE_IDENTIFIER) continue;
+                type = checkExpression(checker, child);
+                if (type != TYPE_UNKNOWN && !isNumeric(type)) {
+                    ParseTreeNode* operatorNode = node->children[i == 0 ? node->childCount - 1 : 0];
+                    typeError(checker, "Operator '%s' needs a numeric variable, found %s variable '%s'.",
+                              operatorNode->value, typeName(type), child->value);
+                }
+            }
+            break;
+        }
+
+        case NODE_ASSIGNMENT_STATEMENT:
+            type = checkAssignment(checker, node); // Chained assignment used as a value
+            break;
+
+        default:
+            checkStatement(checker, node);
+            return TYPE_UNKNOWN;
+    }
+
+    node->type = (unsigned char)type;
+    checker->result->typedNodes++;
+    return type;
+}
+
+// Function to check a condition, which must be bool
+static void checkCondition(TypeChecker* checker, ParseTreeNode* node, const char* statement) {
+    int type = checkExpression(checker, node);
+    if (type != TYPE_UNKNOWN && type != TYPE_BOOL) {
+        typeError(checker, "Condition of '%s' must be bool, found %s.", statement, typeName(type));
+    }
+}
+
+// ---------------------------------------
+// Statements
+// ---------------------------------------
+
+// Function to check [type, name, (=, value)?, (',' | ';'), name, ...] declarations
+static void checkDeclaration(TypeChecker* checker, ParseTreeNode* node) {
+    if (node->childCount == 0 || node->children[0]->kind != NODE_TYPE_SPECIFIER) return;
+    int declared = node->children[0]->type;
+
+    for (int i = 1; i < node->childCount; i++) {
+        ParseTreeNode* name = node->children[i];
+        if (name->kind != NODE_IDENTIFIER) continue;
+
+        // The name is in scope for its own initializer, as in the parser
+        const Token* site = (checker->tokens && checker->anchor < checker->tokenCount)
+                          ? &checker->tokens[checker->anchor] : NULL;
+        const Symbol* symbol = declareSymbol(checker->scopes, name->symbolId, (SymbolType)declared,
+                                             site ? site->lineNumber : 0, site ? site->column : 0);
+        if (!symbol) symbol = lookupSymbol(checker->scopes, name->symbolId); // Redeclared in this scope
+        name->type = (unsigned char)declared;
+        name->binding = symbol ? (int)(symbol - checker->scopes->symbols) : -1;
+
+        if (i + 2 < node->childCount && node->children[i + 1]->kind == NODE_OPERATOR &&
+            NODE_IS_EXPRESSION(node->children[i + 2]->kind)) {
+            int value = checkExpression(checker, node->children[i + 2]);
+            checkStore(checker, name->value, declared, value, node, i + 2);
+            i += 2;
+        }
+    }
+}
+
+// Function to check an initializer's elements against the element type; rows nest for two dimensions
+static void checkArrayInitializer(TypeChecker* checker, ParseTreeNode* node, const char* name, int element, int rank) {
+    for (int i = 0; i < node->childCount; i++) {
+        ParseTreeNode* child = node->children[i];
+        if (child->kind == NODE_ARRAY_INITIALIZER) {
+            if (rank == 2) {
+                checkArrayInitializer(checker, child, name, element, 1);
+            } else {
+                typeError(checker, "Array '%s' has one dimension, so its initializer cannot have rows.", name);
+            }
+        } else if (NODE_IS_EXPRESSION(child->kind)) {
+            int value = checkExpression(checker, child);
+            if (rank == 2) {
+                typeError(checker, "Each row of array '%s' must be a braced list.", name);
+            } else {
+                checkStore(checker, name, element, value, node, i);
+            }
+        }
+    }
+}
+
+// Function to check [array, type, name, '[', length, ']', ('[', length, ']')?, ('=', initializer)?, ';']
+static void checkArrayDeclaration(TypeChecker* checker, ParseTreeNode* node) {
+    if (node->childCount < 3 || node->children[2]->kind != NODE_IDENTIFIER) return;
+    int element = node->children[1]->type;
+    ParseTreeNode* name = node->children[2];
+
+    int rank = 0;
+    ParseTreeNode* initializer = NULL;
+    for (int i = 3; i < node->childCount; i++) {
+        if (node->children[i]->kind == NODE_ARRAY_INITIALIZER) initializer = node->children[i];
+        else if (NODE_IS_EXPRESSION(node->children[i]->kind)) rank++;
+    }
+
+    // Declared before its lengths and initializer are checked, as in the parser
+    const Token* site = (checker->tokens && checker->anchor < checker->tokenCount)
+                      ? &checker->tokens[checker->anchor] : NULL;
+    Symbol* symbol = declareSymbol(checker->scopes, name->symbolId, TYPE_ARRAY,
+                                   site ? site->lineNumber : 0, site ? site->column : 0);
+    if (symbol) {
+        symbol->elementType = (SymbolType)element;
+        symbol->rank = rank;
+    } else {
+        symbol = lookupSymbol(checker->scopes, name->symbolId); // Redeclared in this scope
+    }
+    name->type = TYPE_ARRAY;
+    name->binding = symbol ? (int)(symbol - checker->scopes->symbols) : -1;
+
+    for (int i = 3; i < node->childCount; i++) {
+        if (!NODE_IS_EXPRESSION(node->children[i]->kind)) continue;
+        int length = checkExpression(checker, node->children[i]);
+        if (length != TYPE_UNKNOWN && !isIntegral(length)) {
+            typeError(checker, "Array length must be int, found %s.", typeName(length));
+        }
+    }
+    if (initializer) checkArrayInitializer(checker, initializer, name->value, element, rank);
+}
+
+// Function to read an int or char case label ('a', '\n', ...) as the value it switches on
+static int32_t labelValue(const ParseTreeNode* label) {
+    const char* text = label->value;
+    if (label->type != TYPE_CHAR) return intFromText(text);
+    if (text[1] != '\\') return (unsigned char)text[1];
+    switch (text[2]) {
+        case 'n': return '\n';
+        case 't': return '\t';
+        case 'r': return '\r';
+        case '0': return '\0';
+        default: return (unsigned char)text[2];
+    }
+}
+
+// Function to check a switch: an int, char or string subject, case labels of a
+// matching kind and no label twice. The clauses share one scope.
+static void checkSwitch(TypeChecker* checker, ParseTreeNode* node) {
+    int subject = checkExpression(checker, node->children[1]);
+    if (subject != TYPE_UNKNOWN && !isIntegral(subject) && subject != TYPE_STRING) {
+        typeError(checker, "Switch expression must be int, char or string, found %s.", typeName(subject));
+        subject = TYPE_UNKNOWN;
+    }
+
+    pushScope(checker->scopes);
+    for (int i = 2; i < node->childCount; i++) {
+        ParseTreeNode* clause = node->children[i];
+        int first = 1; // Statements start after the keyword (and label)
+        if (clause->kind == NODE_CASE_CLAUSE) {
+            ParseTreeNode* label = clause->children[1];
+            first = 2;
+            if (subject != TYPE_UNKNOWN && isIntegral(subject) != isIntegral(label->type)) {
+                typeError(checker, "Case label %s is %s but the switch expression is %s.",
+                          label->value, typeName(label->type), typeName(subject));
+            }
+            for (int j = 2; j < i; j++) {
+                ParseTreeNode* other = node->children[j];
+                if (other->kind != NODE_CASE_CLAUSE) continue;
+                const ParseTreeNode* earlier = other->children[1];
+                int same = isIntegral(earlier->type) && isIntegral(label->type)
+                         ? labelValue(earlier) == labelValue(label)
+                         : earlier->type == label->type && strcmp(earlier->value, label->value) == 0;
+                if (same) {
+                    typeError(checker, "Duplicate case label %s in switch.", label->value);
+                    break;
+                }
+            }
+        }
+        for (int j = first; j < clause->childCount; j++) {
+            checkStatement(checker, clause->children[j]);
+        }
+    }
+    popScope(checker->scopes);
+}
+
+// Function to check every child in statement position
+static void checkChildren(TypeChecker* checker, ParseTreeNode* node) {
+    for (int i = 0; i < node->childCount; i++) {
+        ParseTreeNode* child = node->children[i];
+        if (!child) continue;
+        if (NODE_IS_EXPRESSION(child->kind)) {
+            checkExpression(checker, child);
+        } else {
+            checkStatement(checker, child);
+        }
+    }
+}
+
+static void checkStatement(TypeChecker* checker, ParseTreeNode* node) {
+    if (!node) return;
+
+    // Statement and Block spans locate errors; offsets are relative to the enclosing tracked node
+    int savedAnchor = checker->anchor;
+    if (node->tokenSpan > 0) {
+        checker->anchor += node->tokenOffset;
+    }
+
+    switch (node->kind) {
+        case NODE_BLOCK:
+            ensureChildren(node);
+            pushScope(checker->scopes);
+            checkChildren(checker, node);
+            popScope(checker->scopes);
+            break;
+
+        case NODE_VARIABLE_DECLARATION:
+            checkDeclaration(checker, node);
+            break;
+
+        case NODE_ARRAY_DECLARATION:
+            checkArrayDeclaration(checker, node);
+            break;
+
+        case NODE_FOR_INIT:
+            if (node->childCount > 0 && node->children[0]->kind == NODE_TYPE_SPECIFIER) {
+                checkDeclaration(checker, node);
+            } else {
+                checkAssignment(checker, node);
+            }
+            break;
+
+        case NODE_ASSIGNMENT_STATEMENT:
+            checkAssignment(checker, node);
+            break;
+
+        case NODE_CONDITIONAL_STATEMENT:
+            for (int i = 0; i < node->childCount; i++) {
+                ParseTreeNode* child = node->children[i];
+                if (NODE_IS_EXPRESSION(child->kind)) {
+                    checkCondition(checker, child, "if");
+                } else {
+                    checkStatement(checker, child);
+                }
+            }
+            break;
+
+        case NODE_WHILE_LOOP:
+        case NODE_DO_WHILE_LOOP:
+            for (int i = 0; i < node->childCount; i++) {
+                ParseTreeNode* child = node->children[i];
+                if (NODE_IS_EXPRESSION(child->kind)) {
+                    checkCondition(checker, child, node->kind == NODE_WHILE_LOOP ? "while" : "do-while");
+                } else {
+                    checkStatement(checker, child);
+                }
+            }
+            break;
+
+        case NODE_FOR_LOOP:
+            // The loop header has its own scope, as in the parser
+            pushScope(checker->scopes);
+            for (int i = 0; i < node->childCount; i++) {
+                ParseTreeNode* child = node->children[i];
+                if (NODE_IS_EXPRESSION(child->kind)) {
+                    checkCondition(checker, child, "for");
+                } else {
+                    checkStatement(checker, child);
+                }
+            }
+            popScope(checker->scopes);
+            break;
+
+        case NODE_SWITCH_STATEMENT:
+            checkSwitch(checker, node);
+            break;
+
+        case NODE_FOR_UPDATE:
+            for (int i = 0; i < node->childCount; i++) {
+                ParseTreeNode* child = node->children[i];
+                if (child->kind == NODE_ASSIGNMENT_STATEMENT) {
+                    checkAssignment(checker, child);
+                } else if (NODE_IS_EXPRESSION(child->kind)) {
+                    checkExpression(checker, child);
+                }
+            }
+            break;
+
+        default:
+            checkChildren(checker, node);
+            break;
+    }
+
+    checker->anchor = savedAnchor;
+}
+
+// ---------------------------------------
+// Entry point
+// ---------------------------------------
+
+// Function to type-check a whole program in one walk over the tree
+TypeCheckResult* typeCheckProgram(ParseTreeNode* root, const Token* tokens, int tokenCount) {
+    if (!tablesReady) buildTables();
+
+    TypeCheckResult* result = (TypeCheckResult*)calloc(1, sizeof(TypeCheckResult));
+    if (!result) {
+        fprintf(stderr, "Error: Memory allocation failed for type check result.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    TypeChecker checker;
+    checker.scopes = createSymbolTable();
+    checker.tokens = tokens;
+    checker.tokenCount = tokenCount;
+    checker.anchor = 0;
+    checker.result = result;
+
+    checkStatement(&checker, root);
+    result->bindingCount = checker.scopes->symbolCount;
+
+    freeSymbolTable(checker.scopes);
+    return result;
+}
+
+void freeTypeCheckResult(TypeCheckResult* result) {
+    if (!result) return;
+    free(result->errors);
+    free(result);
+}
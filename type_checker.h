@@ -0,0 +1,34 @@
+#ifndef TYPE_CHECKER_H
+#define TYPE_CHECKER_H
+
+#include "token.h"
+#include "parse_tree.h"
+
+// One type error, located at the start of the statement that contains it
+typedef struct {
+    int line;
+    int column;
+    int width;          // Length of the statement's first token (for the caret)
+    char message[160];
+} TypeError;
+
+// Outcome of one type-checking pass
+typedef struct {
+    TypeError* errors;  // In source order
+    int errorCount;
+    int errorCapacity;
+    int typedNodes;     // Expression nodes annotated
+    int conversions;    // IntToFloat nodes inserted
+    int bindingCount;   // Declarations seen; IDENTIFIER nodes' `binding` indexes them
+} TypeCheckResult;
+
+// Annotate every expression node of `root` with its type (node->type), bind
+// each IDENTIFIER to its declaration (node->binding, numbered in declaration
+// order), wrap int operands that meet a float in IntToFloat nodes, and
+// collect every mismatch instead of stopping at the first one. `tokens` is the
+// stream the tree was parsed from and is only used to locate errors (may be NULL).
+TypeCheckResult* typeCheckProgram(ParseTreeNode* root, const Token* tokens, int tokenCount);
+
+void freeTypeCheckResult(TypeCheckResult* result);
+
+#endif // TYPE_CHECKER_H
@@ -0,0 +1,71 @@
+#include "value.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+ValueArray* newValueArray(int count) {
+    ValueArray* array = (ValueArray*)malloc(sizeof(ValueArray) + (size_t)count * sizeof(TaggedValue));
+    if (!array) {
+        fprintf(stderr, "Error: Memory allocation failed for an array value.\n");
+        exit(EXIT_FAILURE);
+    }
+    array->count = count;
+    for (int i = 0; i < count; i++) array->items[i] = boxNull();
+    return array;
+}
+
+void freeValueArray(ValueArray* array) {
+    free(array);
+}
+
+TypedArray* newTypedArray(int32_t rows, int32_t columns, int elementSize) {
+    if (rows < 0 || columns < 0) return NULL;
+    if (columns > 0 && rows > TYPED_ARRAY_MAX_LENGTH / columns) return NULL;
+
+    // The header, then padding up to the first aligned address
+    size_t bytes = (size_t)rows * (size_t)columns * (size_t)elementSize;
+    size_t offset = sizeof(TypedArray) + TYPED_ARRAY_ALIGNMENT - 1;
+    char* block = (char*)calloc(1, offset + (bytes ? bytes : 1));
+    if (!block) {
+        fprintf(stderr, "Error: Memory allocation failed for an array.\n");
+        exit(EXIT_FAILURE);
+    }
+    TypedArray* array = (TypedArray*)block;
+    array->data = (void*)(((uintptr_t)block + offset) & ~(uintptr_t)(TYPED_ARRAY_ALIGNMENT - 1));
+    array->length = rows * columns;
+    array->dims[0] = rows;
+    array->dims[1] = columns;
+    array->elementSize = elementSize;
+    return array;
+}
+
+void freeTypedArray(TypedArray* array) {
+    free(array);
+}
+
+const char* valueText(TaggedValue value, char* buffer, size_t size) {
+    if (size == 0) return "";
+    switch (valueKind(value)) {
+        case VALUE_FLOAT: snprintf(buffer, size, "%f", unboxFloat(value)); break;
+        case VALUE_NULL: snprintf(buffer, size, "null"); break;
+        case VALUE_BOOL: snprintf(buffer, size, "%s", unboxInt(value) ? "true" : "false"); break;
+        case VALUE_INT: snprintf(buffer, size, "%d", unboxInt(value)); break;
+        case VALUE_CHAR: snprintf(buffer, size, "%c", (char)unboxInt(value)); break;
+        case VALUE_STRING: {
+            const char* text = unboxString(value);
+            return text ? text : "";
+        }
+        case VALUE_ARRAY: {
+            // "[a, b, c]", elements in their natural form, cut off when the buffer is full
+            const ValueArray* array = unboxArray(value);
+            size_t length = (size_t)snprintf(buffer, size, "[");
+            char element[64];
+            for (int i = 0; i < array->count && length < size; i++) {
+                length += (size_t)snprintf(buffer + length, size - length, "%s%s", i ? ", " : "",
+                                           valueText(array->items[i], element, sizeof(element)));
+            }
+            if (length < size) snprintf(buffer + length, size - length, "]");
+            break;
+        }
+    }
+    return buffer;
+}
@@ -0,0 +1,99 @@
+#ifndef VALUE_H
+#define VALUE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// Self-describing Prismatic value in 8 bytes (NaN boxing). A float is stored as
+// its own bits; every other kind hides in the payload of a negative quiet NaN:
+//
+//   bits 63..51  all ones          (no arithmetic result uses them: NaNs are
+//                                   canonicalized to 0x7FF8000000000000 on boxing)
+//   bits 50..48  kind, 1..7
+//   bits 47..0   payload: int (32 bits), char, bool, or a heap pointer
+//                (user-space addresses fit in 48 bits on x86-64 and AArch64)
+//
+// int, char, bool and null never allocate; strings and arrays are references.
+// Where the type checker knows a type (VM registers, native code) values stay
+// unboxed; boxing is for places that have to carry the type with the value.
+typedef uint64_t TaggedValue;
+
+typedef enum {
+    VALUE_FLOAT,
+    VALUE_NULL,
+    VALUE_BOOL,
+    VALUE_INT,
+    VALUE_CHAR,
+    VALUE_STRING,
+    VALUE_ARRAY,
+} ValueKind;
+
+// Heap array of values
+typedef struct {
+    int count;
+    TaggedValue items[];
+} ValueArray;
+
+#define VALUE_BOXED_MASK UINT64_C(0xFFF8000000000000)
+#define VALUE_PAYLOAD_MASK UINT64_C(0x0000FFFFFFFFFFFF)
+#define VALUE_CANONICAL_NAN UINT64_C(0x7FF8000000000000)
+#define VALUE_BOX(kind, payload) (VALUE_BOXED_MASK | ((uint64_t)(kind) << 48) | (uint64_t)(payload))
+
+static inline ValueKind valueKind(TaggedValue value) {
+    if ((value & VALUE_BOXED_MASK) != VALUE_BOXED_MASK) return VALUE_FLOAT;
+    unsigned kind = (unsigned)(value >> 48) & 7u;
+    return kind ? (ValueKind)kind : VALUE_FLOAT; // 0xFFF8000000000000 itself is a NaN
+}
+
+static inline TaggedValue boxFloat(double f) {
+    TaggedValue bits;
+    memcpy(&bits, &f, sizeof(bits));
+    return f != f ? VALUE_CANONICAL_NAN : bits;
+}
+static inline TaggedValue boxNull(void) { return VALUE_BOX(VALUE_NULL, 0); }
+static inline TaggedValue boxBool(int b) { return VALUE_BOX(VALUE_BOOL, b != 0); }
+static inline TaggedValue boxInt(int32_t i) { return VALUE_BOX(VALUE_INT, (uint32_t)i); }
+static inline TaggedValue boxChar(int32_t c) { return VALUE_BOX(VALUE_CHAR, (uint32_t)c); }
+static inline TaggedValue boxString(const char* s) { return VALUE_BOX(VALUE_STRING, (uintptr_t)s & VALUE_PAYLOAD_MASK); }
+static inline TaggedValue boxArray(ValueArray* a) { return VALUE_BOX(VALUE_ARRAY, (uintptr_t)a & VALUE_PAYLOAD_MASK); }
+
+static inline double unboxFloat(TaggedValue value) {
+    double f;
+    memcpy(&f, &value, sizeof(f));
+    return f;
+}
+static inline int32_t unboxInt(TaggedValue value) { return (int32_t)(uint32_t)value; } // int, char and bool
+static inline const char* unboxString(TaggedValue value) { return (const char*)(uintptr_t)(value & VALUE_PAYLOAD_MASK); }
+static inline ValueArray* unboxArray(TaggedValue value) { return (ValueArray*)(uintptr_t)(value & VALUE_PAYLOAD_MASK); }
+
+// Function to make an array of `count` nulls (exits when out of memory)
+ValueArray* newValueArray(int count);
+void freeValueArray(ValueArray* array);
+
+// Typed array behind the `array` keyword: elements of one type, unboxed and
+// contiguous (row-major for two dimensions) in storage aligned to 64 bytes, so
+// a row starts on a cache line and vector loads never straddle one needlessly.
+// Header and elements are one allocation.
+typedef struct {
+    void* data;          // 4-byte int, 8-byte float, 1-byte char and bool elements, zero-filled
+    int32_t length;      // dims[0] * dims[1]
+    int32_t dims[2];     // Rows and columns; a one-dimensional array has one column
+    int32_t elementSize;
+} TypedArray;
+
+#define TYPED_ARRAY_ALIGNMENT 64
+#define TYPED_ARRAY_MAX_LENGTH (1 << 28)
+
+// Function to make a rows x columns array (one column: one-dimensional); returns
+// NULL when a dimension is negative or the length exceeds TYPED_ARRAY_MAX_LENGTH,
+// exits when out of memory
+TypedArray* newTypedArray(int32_t rows, int32_t columns, int elementSize);
+void freeTypedArray(TypedArray* array);
+
+// Function to write `value` the way it reads in source (3, 2.500000, x, true, text,
+// null, [1, 2]) into `buffer`, truncated to fit; returns `buffer`, or the string
+// itself for a string value
+const char* valueText(TaggedValue value, char* buffer, size_t size);
+
+#endif // VALUE_H
@@ -0,0 +1,372 @@
+#include "value_numbering.h"
+#include <stdlib.h>
+#include <string.h>
+#include "symbol_table.h"
+
+static void* growArray(void* array, int* capacity, int needed, size_t size) {
+    if (needed <= *capacity) return array;
+    int newCapacity = *capacity ? *capacity : 8;
+    while (newCapacity < needed) newCapacity *= 2;
+    array = realloc(array, (size_t)newCapacity * size);
+    if (!array) {
+        fprintf(stderr, "Error: Memory allocation failed for control-flow graph.\n");
+        exit(EXIT_FAILURE);
+    }
+    *capacity = newCapacity;
+    return array;
+}
+
+static void* allocateArray(int count, size_t size) {
+    void* array = calloc(count > 0 ? (size_t)count : 1, size);
+    if (!array) {
+        fprintf(stderr, "Error: Memory allocation failed for control-flow graph.\n");
+        exit(EXIT_FAILURE);
+    }
+    return array;
+}
+
+// ---------------------------------------
+// Value numbering
+// ---------------------------------------
+
+int cfgValueNumbering = 2;
+
+// A computation seen on the way down the dominator tree: the operation and the
+// value numbers it reads, the value number of its result and a register holding it
+typedef struct {
+    int opcode, type;
+    int a, b;             // Operand value numbers (-1: none)
+    int64_t imm;          // Constant bits or length dimension
+    int value;
+    int holder;
+    int block;            // Block that computed it
+    int used;
+} ValueEntry;
+
+typedef struct {
+    int reg;
+    int value, epoch;
+} RegisterUndo;
+
+typedef struct {
+    int slot;
+    ValueEntry entry;
+} EntryUndo;
+
+// One block on the walk down the dominator tree, with what to undo on the way back up
+typedef struct {
+    int block;
+    int nextChild;
+    int registerMark, entryMark;
+    int epoch;
+} ValueFrame;
+
+typedef struct {
+    Cfg* cfg;
+    int* value;           // Value number per register (-1: none yet)
+    int* epoch;           // For registers written more than once: the epoch the number holds in
+    int* defs;
+    int* uses;
+    int* useBlock;        // The one block reading a register (-1: several)
+    int* replacement;     // Register read instead of a removed temporary (-1: none)
+    ValueEntry* table;
+    int tableMask;
+    RegisterUndo* registerLog;
+    int registerLogCount, registerLogCapacity;
+    EntryUndo* entryLog;
+    int entryLogCount, entryLogCapacity;
+    int nextValue;
+    int currentEpoch, nextEpoch;
+} ValueNumbering;
+
+// Pure operations that give the same result for the same operand values. Int
+// constants get numbers (so x + 1 matches x + 1) but are never removed: read
+// once in their block they cost nothing as an immediate.
+static int isNumberable(const IrInstruction* in) {
+    if (in->type == TYPE_STRING || in->dst < 0) return 0;
+    switch (in->opcode) {
+        case IR_CONST: case IR_INT_TO_FLOAT:
+        case IR_ADD: case IR_SUB: case IR_MUL: case IR_DIV: case IR_FLOOR_DIV: case IR_MOD: case IR_POW:
+        case IR_EQ: case IR_NE: case IR_LT: case IR_LE: case IR_GT: case IR_GE:
+        case IR_NOT: case IR_MAX: case IR_ARRAY_LENGTH:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static void setValue(ValueNumbering* numbering, int reg, int value) {
+    numbering->registerLog = (RegisterUndo*)growArray(numbering->registerLog, &numbering->registerLogCapacity,
+                                                      numbering->registerLogCount + 1, sizeof(RegisterUndo));
+    RegisterUndo* undo = &numbering->registerLog[numbering->registerLogCount++];
+    undo->reg = reg;
+    undo->value = numbering->value[reg];
+    undo->epoch = numbering->epoch[reg];
+    numbering->value[reg] = value;
+    numbering->epoch[reg] = numbering->currentEpoch;
+}
+
+// Function to give a register's value number. A register written more than once
+// only keeps its number below the join it was numbered after: a block entered
+// from several predecessors starts a new epoch, and the register a new number.
+static int valueOf(ValueNumbering* numbering, int reg) {
+    if (reg < 0) return -1;
+    if (numbering->value[reg] < 0 ||
+        (numbering->defs[reg] > 1 && numbering->epoch[reg] != numbering->currentEpoch)) {
+        setValue(numbering, reg, numbering->nextValue++);
+    }
+    return numbering->value[reg];
+}
+
+static uint32_t valueHash(const ValueEntry* key) {
+    uint64_t hash = ((uint64_t)(uint32_t)key->a << 32 | (uint32_t)key->b) * UINT64_C(0x9E3779B97F4A7C15);
+    hash ^= (uint64_t)key->imm * UINT64_C(0xC2B2AE3D27D4EB4F);
+    hash ^= (uint64_t)(key->opcode << 8 | key->type);
+    hash ^= hash >> 29;
+    return (uint32_t)(hash * UINT64_C(0xBF58476D1CE4E5B9) >> 32);
+}
+
+// Function to find the slot holding `key`, or the empty slot it would go in
+static int findEntry(const ValueNumbering* numbering, const ValueEntry* key) {
+    int slot = (int)(valueHash(key) & (uint32_t)numbering->tableMask);
+    for (;;) {
+        const ValueEntry* entry = &numbering->table[slot];
+        if (!entry->used || (entry->opcode == key->opcode && entry->type == key->type && entry->a == key->a &&
+                             entry->b == key->b && entry->imm == key->imm)) {
+            return slot;
+        }
+        slot = (slot + 1) & numbering->tableMask;
+    }
+}
+
+// Entries are undone last-in first-out, which leaves every probe chain as it was
+static void storeEntry(ValueNumbering* numbering, int slot, const ValueEntry* entry) {
+    numbering->entryLog = (EntryUndo*)growArray(numbering->entryLog, &numbering->entryLogCapacity,
+                                                numbering->entryLogCount + 1, sizeof(EntryUndo));
+    EntryUndo* undo = &numbering->entryLog[numbering->entryLogCount++];
+    undo->slot = slot;
+    undo->entry = numbering->table[slot];
+    numbering->table[slot] = *entry;
+}
+
+// Function to describe an instruction by its operation and operand value numbers,
+// with commutative operands and mirrored comparisons in one order
+static void valueKey(ValueNumbering* numbering, const IrInstruction* in, ValueEntry* key) {
+    memset(key, 0, sizeof(*key));
+    key->opcode = in->opcode;
+    key->type = in->type;
+    key->a = valueOf(numbering, in->a);
+    key->b = valueOf(numbering, in->b);
+    if (in->opcode == IR_CONST && in->type == TYPE_FLOAT) memcpy(&key->imm, &in->imm.f, sizeof(in->imm.f));
+    else if (in->opcode == IR_CONST || in->opcode == IR_ARRAY_LENGTH) key->imm = in->imm.i;
+
+    int swap = 0;
+    switch (in->opcode) {
+        case IR_ADD: case IR_MUL: case IR_EQ: case IR_NE: case IR_MAX:
+            swap = key->a > key->b;
+            break;
+        case IR_GT: key->opcode = IR_LT; swap = 1; break;
+        case IR_GE: key->opcode = IR_LE; swap = 1; break;
+        default: break;
+    }
+    if (swap) {
+        int a = key->a;
+        key->a = key->b;
+        key->b = a;
+    }
+}
+
+// Function to tell whether every read of `reg` can read `holder` instead: always
+// when the holder is written once, else when the reads are later in this block
+// and the holder is not written before the last of them
+static int canReadHolder(const ValueNumbering* numbering, const BasicBlock* block, int b, int position,
+                         int reg, int holder) {
+    if (numbering->defs[holder] <= 1) return 1;
+    if (numbering->uses[reg] == 0) return 1;
+    if (numbering->useBlock[reg] != b) return 0;
+    int remaining = numbering->uses[reg];
+    for (int i = position + 1; i < block->codeCount && remaining > 0; i++) {
+        const IrInstruction* in = &block->code[i];
+        remaining -= (in->a == reg) + (in->b == reg) + (in->c == reg);
+        if (in->dst == holder && remaining > 0) return 0;
+    }
+    return remaining == 0;
+}
+
+static void readInstead(ValueNumbering* numbering, int* operand) {
+    if (*operand < 0 || numbering->replacement[*operand] < 0) return;
+    numbering->uses[*operand]--;
+    *operand = numbering->replacement[*operand];
+    numbering->uses[*operand]++;
+}
+
+// Function to number one block's instructions, dropping those whose value a
+// register already holds
+static void numberBlock(ValueNumbering* numbering, int b) {
+    Cfg* cfg = numbering->cfg;
+    BasicBlock* block = &cfg->blocks[b];
+    int kept = 0;
+    for (int i = 0; i < block->codeCount; i++) {
+        IrInstruction* in = &block->code[i];
+        readInstead(numbering, &in->a);
+        readInstead(numbering, &in->b);
+        readInstead(numbering, &in->c);
+        if (!isNumberable(in)) {
+            if (in->dst >= 0) {
+                setValue(numbering, in->dst,
+                         in->opcode == IR_COPY ? valueOf(numbering, in->a) : numbering->nextValue++);
+            }
+            block->code[kept++] = *in;
+            continue;
+        }
+
+        ValueEntry key;
+        valueKey(numbering, in, &key);
+        int slot = findEntry(numbering, &key);
+        ValueEntry* entry = &numbering->table[slot];
+        int local = cfgValueNumbering == 1;
+        if (entry->used && (!local || entry->block == b)) {
+            int holder = entry->holder;
+            int removable = (in->opcode != IR_CONST || in->type == TYPE_FLOAT) && holder != in->dst &&
+                            in->dst >= cfg->bindingCount && numbering->defs[in->dst] == 1 &&
+                            valueOf(numbering, holder) == entry->value &&
+                            canReadHolder(numbering, block, b, i, in->dst, holder);
+            if (removable) {
+                numbering->replacement[in->dst] = holder;
+                if (in->a >= 0) numbering->uses[in->a]--;
+                if (in->b >= 0) numbering->uses[in->b]--;
+                if (entry->block == b) cfg->redundantInBlock++;
+                else cfg->redundantDominated++;
+                continue;
+            }
+            int value = entry->value;
+            if (valueOf(numbering, holder) != value) {
+                ValueEntry moved = *entry;
+                moved.holder = in->dst;
+                moved.block = b;
+                storeEntry(numbering, slot, &moved);
+            }
+            setValue(numbering, in->dst, value);
+        } else {
+            key.value = numbering->nextValue++;
+            key.holder = in->dst;
+            key.block = b;
+            key.used = 1;
+            storeEntry(numbering, slot, &key);
+            setValue(numbering, in->dst, key.value);
+        }
+        block->code[kept++] = *in;
+    }
+    cfg->instructionCount -= block->codeCount - kept;
+    block->codeCount = kept;
+}
+
+// Function to drop temporary int constants that lost their last reader
+static void dropUnreadConstants(ValueNumbering* numbering) {
+    Cfg* cfg = numbering->cfg;
+    for (int b = 0; b < cfg->blockCount; b++) {
+        BasicBlock* block = &cfg->blocks[b];
+        int kept = 0;
+        for (int i = 0; i < block->codeCount; i++) {
+            const IrInstruction* in = &block->code[i];
+            if (in->opcode == IR_CONST && in->dst >= cfg->bindingCount && numbering->uses[in->dst] == 0 &&
+                numbering->defs[in->dst] == 1 && in->type != TYPE_STRING) {
+                continue;
+            }
+            block->code[kept++] = *in;
+        }
+        cfg->instructionCount -= block->codeCount - kept;
+        block->codeCount = kept;
+    }
+}
+
+// The dominator tree is walked depth first. A block with one predecessor
+// continues its dominator's epoch, so registers keep their numbers into it;
+// any other block starts a new one. Numbers, entries and epochs are undone on
+// the way back up, so each block only sees what its dominators computed.
+int numberValues(Cfg* cfg) {
+    cfg->redundantInBlock = 0;
+    cfg->redundantDominated = 0;
+    if (!cfgValueNumbering || !cfg->idom) return 0;
+
+    ValueNumbering numbering;
+    memset(&numbering, 0, sizeof(numbering));
+    numbering.cfg = cfg;
+    int n = cfg->registerCount;
+    numbering.value = (int*)allocateArray(n, sizeof(int));
+    numbering.epoch = (int*)allocateArray(n, sizeof(int));
+    numbering.defs = (int*)allocateArray(n, sizeof(int));
+    numbering.uses = (int*)allocateArray(n, sizeof(int));
+    numbering.useBlock = (int*)allocateArray(n, sizeof(int));
+    numbering.replacement = (int*)allocateArray(n, sizeof(int));
+    for (int r = 0; r < n; r++) {
+        numbering.value[r] = -1;
+        numbering.useBlock[r] = -2;
+        numbering.replacement[r] = -1;
+    }
+    for (int b = 0; b < cfg->blockCount; b++) {
+        const BasicBlock* block = &cfg->blocks[b];
+        for (int i = 0; i < block->codeCount; i++) {
+            const IrInstruction* in = &block->code[i];
+            if (in->dst >= 0) numbering.defs[in->dst]++;
+            const int operands[3] = {in->a, in->b, in->c};
+            for (int k = 0; k < 3; k++) {
+                int reg = operands[k];
+                if (reg < 0) continue;
+                numbering.uses[reg]++;
+                numbering.useBlock[reg] = numbering.useBlock[reg] == -2 || numbering.useBlock[reg] == b ? b : -1;
+            }
+        }
+    }
+    int capacity = 16;
+    while (capacity < 2 * cfg->instructionCount) capacity *= 2;
+    numbering.table = (ValueEntry*)allocateArray(capacity, sizeof(ValueEntry));
+    numbering.tableMask = capacity - 1;
+
+    ValueFrame* stack = (ValueFrame*)allocateArray(cfg->blockCount, sizeof(ValueFrame));
+    int depth = 0;
+    stack[depth++] = (ValueFrame){0, 0, 0, 0, 0};
+    numberBlock(&numbering, 0);
+    while (depth > 0) {
+        ValueFrame* frame = &stack[depth - 1];
+        int first = cfg->domChildStart[frame->block];
+        if (first + frame->nextChild < cfg->domChildStart[frame->block + 1]) {
+            int child = cfg->domChildren[first + frame->nextChild++];
+            ValueFrame* next = &stack[depth++];
+            next->block = child;
+            next->nextChild = 0;
+            next->registerMark = numbering.registerLogCount;
+            next->entryMark = numbering.entryLogCount;
+            next->epoch = numbering.currentEpoch;
+            if (cfgValueNumbering == 1 || cfg->blocks[child].predecessorCount != 1) {
+                numbering.currentEpoch = ++numbering.nextEpoch;
+            }
+            numberBlock(&numbering, child);
+            continue;
+        }
+        while (numbering.registerLogCount > frame->registerMark) {
+            const RegisterUndo* undo = &numbering.registerLog[--numbering.registerLogCount];
+            numbering.value[undo->reg] = undo->value;
+            numbering.epoch[undo->reg] = undo->epoch;
+        }
+        while (numbering.entryLogCount > frame->entryMark) {
+            const EntryUndo* undo = &numbering.entryLog[--numbering.entryLogCount];
+            numbering.table[undo->slot] = undo->entry;
+        }
+        numbering.currentEpoch = frame->epoch;
+        depth--;
+    }
+    dropUnreadConstants(&numbering);
+
+    free(stack);
+    free(numbering.value);
+    free(numbering.epoch);
+    free(numbering.defs);
+    free(numbering.uses);
+    free(numbering.useBlock);
+    free(numbering.replacement);
+    free(numbering.table);
+    free(numbering.registerLog);
+    free(numbering.entryLog);
+    return cfg->redundantInBlock + cfg->redundantDominated;
+}
@@ -0,0 +1,16 @@
+#ifndef VALUE_NUMBERING_H
+#define VALUE_NUMBERING_H
+
+#include "cfg.h"
+
+extern int cfgValueNumbering; // numberValues(): 0 off, 1 within blocks, 2 (default) dominator-scoped
+
+// Hash-based value numbering (needs computeDominators). Walking the dominator
+// tree, each pure computation is looked up by its operation and the value
+// numbers of its operands; a temporary whose value an earlier register in the
+// same block or a dominating one still holds is removed and its reads read that
+// register. Registers written more than once lose their numbers at joins, so
+// the IR need not be in SSA form. Returns the number of computations removed.
+int numberValues(Cfg* cfg);
+
+#endif // VALUE_NUMBERING_H
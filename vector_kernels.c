@@ -0,0 +1,271 @@
+#include "vector_kernels.h"
+#include <stddef.h>
+#include "arithmetic.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define VECTOR_X86 1
+#include <immintrin.h>
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+// A product feeding a sum must round on its own, as in the interpreter: no fused multiply-add
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+int vectorIsaLimit = VECTOR_ISA_AVX2;
+
+VectorIsa vectorIsa(void) {
+#ifdef VECTOR_X86
+    static int supported = -1;
+    if (supported < 0) {
+        __builtin_cpu_init();
+        supported = __builtin_cpu_supports("avx2") ? VECTOR_ISA_AVX2 : VECTOR_ISA_SSE2; // SSE2 is baseline x86-64
+    }
+    return (VectorIsa)(supported < vectorIsaLimit ? supported : vectorIsaLimit);
+#else
+    return VECTOR_ISA_SCALAR;
+#endif
+}
+
+const char* vectorIsaName(VectorIsa isa) {
+    switch (isa) {
+        case VECTOR_ISA_AVX2: return "AVX2";
+        case VECTOR_ISA_SSE2: return "SSE2";
+        default: return "scalar";
+    }
+}
+
+// ---------------------------------------
+// Scalar forms (also the tails)
+// ---------------------------------------
+
+static void mapIntScalar(VectorOp op, int32_t* dst, const int32_t* left, int32_t leftScalar,
+                         const int32_t* right, int32_t rightScalar, int32_t count) {
+    for (int32_t k = 0; k < count; k++) {
+        int32_t x = left ? left[k] : leftScalar;
+        int32_t y = right ? right[k] : rightScalar;
+        switch (op) {
+            case VECTOR_ADD: dst[k] = intAdd(x, y); break;
+            case VECTOR_SUB: dst[k] = intSub(x, y); break;
+            case VECTOR_MUL: dst[k] = intMul(x, y); break;
+            default: dst[k] = x; break;
+        }
+    }
+}
+
+static void mapFloatScalar(VectorOp op, double* dst, const double* left, double leftScalar,
+                           const double* right, double rightScalar, int32_t count) {
+    for (int32_t k = 0; k < count; k++) {
+        double x = left ? left[k] : leftScalar;
+        double y = right ? right[k] : rightScalar;
+        switch (op) {
+            case VECTOR_ADD: dst[k] = x + y; break;
+            case VECTOR_SUB: dst[k] = x - y; break;
+            case VECTOR_MUL: dst[k] = x * y; break;
+            case VECTOR_DIV: dst[k] = x / y; break;
+            default: dst[k] = x; break;
+        }
+    }
+}
+
+static int32_t sumIntScalar(const int32_t* a, const int32_t* b, int32_t count) {
+    int32_t sum = 0;
+    for (int32_t k = 0; k < count; k++) sum = intAdd(sum, b ? intMul(a[k], b[k]) : a[k]);
+    return sum;
+}
+
+// Function to finish a float sum from its 8 running sums, in the documented order
+static double finishSum(const double sums[8], const double* a, const double* b, int32_t k, int32_t count) {
+    double sum = ((sums[0] + sums[4]) + (sums[2] + sums[6])) + ((sums[1] + sums[5]) + (sums[3] + sums[7]));
+    for (; k < count; k++) sum += b ? a[k] * b[k] : a[k];
+    return sum;
+}
+
+static double sumFloatScalar(const double* a, const double* b, int32_t count) {
+    double sums[8] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+    int32_t k = 0;
+    for (; k + 8 <= count; k += 8) {
+        for (int lane = 0; lane < 8; lane++) sums[lane] += b ? a[k + lane] * b[k + lane] : a[k + lane];
+    }
+    return finishSum(sums, a, b, k, count);
+}
+
+#ifdef VECTOR_X86
+
+// ---------------------------------------
+// SSE2 and AVX2
+// ---------------------------------------
+
+// SSE2 has no 32-bit multiply keeping the low halves: two 32x32->64 multiplies
+// (even and odd lanes), then the low halves interleaved back
+static inline __m128i mulloSse2(__m128i x, __m128i y) {
+    __m128i even = _mm_mul_epu32(x, y);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(x, 32), _mm_srli_epi64(y, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+// One map kernel per instruction set and element type. A scalar operand is
+// read from a buffer of copies at a fixed offset (k & 0), so the loop has no branch.
+#define DEFINE_MAP(name, target, Element, lanes, load, store, add, sub, mul, div, scalarTail)           \
+    static target void name(VectorOp op, Element* dst, const Element* left, Element leftScalar,         \
+                            const Element* right, Element rightScalar, int32_t count) {                \
+        Element leftLanes[lanes], rightLanes[lanes];                                                   \
+        for (int lane = 0; lane < (lanes); lane++) {                                                   \
+            leftLanes[lane] = leftScalar;                                                              \
+            rightLanes[lane] = rightScalar;                                                            \
+        }                                                                                              \
+        const Element* lp = left ? left : leftLanes;                                                   \
+        const Element* rp = right ? right : rightLanes;                                                \
+        int32_t leftMask = left ? -1 : 0, rightMask = right ? -1 : 0;                                  \
+        int32_t k = 0;                                                                                 \
+        switch (op) {                                                                                  \
+            case VECTOR_ADD:                                                                           \
+                for (; k + (lanes) <= count; k += (lanes))                                             \
+                    store(dst + k, add(load(lp + (k & leftMask)), load(rp + (k & rightMask))));        \
+                break;                                                                                 \
+            case VECTOR_SUB:                                                                           \
+                for (; k + (lanes) <= count; k += (lanes))                                             \
+                    store(dst + k, sub(load(lp + (k & leftMask)), load(rp + (k & rightMask))));        \
+                break;                                                                                 \
+            case VECTOR_MUL:                                                                           \
+                for (; k + (lanes) <= count; k += (lanes))                                             \
+                    store(dst + k, mul(load(lp + (k & leftMask)), load(rp + (k & rightMask))));        \
+                break;                                                                                 \
+            case VECTOR_DIV:                                                                           \
+                for (; k + (lanes) <= count; k += (lanes))                                             \
+                    store(dst + k, div(load(lp + (k & leftMask)), load(rp + (k & rightMask))));        \
+                break;                                                                                 \
+            default:                                                                                   \
+                for (; k + (lanes) <= count; k += (lanes)) store(dst + k, load(lp + (k & leftMask)));  \
+                break;                                                                                 \
+        }                                                                                              \
+        scalarTail(op, dst + k, left ? left + k : NULL, leftScalar, right ? right + k : NULL,         \
+                   rightScalar, count - k);                                                            \
+    }
+
+#define LOAD_I128(p) _mm_loadu_si128((const __m128i*)(p))
+#define STORE_I128(p, v) _mm_storeu_si128((__m128i*)(p), (v))
+#define LOAD_I256(p) _mm256_loadu_si256((const __m256i*)(p))
+#define STORE_I256(p, v) _mm256_storeu_si256((__m256i*)(p), (v))
+#define NO_INT_DIV(x, y) (x) // Int division never reaches a kernel
+
+DEFINE_MAP(mapIntSse2, , int32_t, 4, LOAD_I128, STORE_I128, _mm_add_epi32, _mm_sub_epi32, mulloSse2,
+           NO_INT_DIV, mapIntScalar)
+DEFINE_MAP(mapIntAvx2, TARGET_AVX2, int32_t, 8, LOAD_I256, STORE_I256, _mm256_add_epi32, _mm256_sub_epi32,
+           _mm256_mullo_epi32, NO_INT_DIV, mapIntScalar)
+DEFINE_MAP(mapFloatSse2, , double, 2, _mm_loadu_pd, _mm_storeu_pd, _mm_add_pd, _mm_sub_pd, _mm_mul_pd,
+           _mm_div_pd, mapFloatScalar)
+DEFINE_MAP(mapFloatAvx2, TARGET_AVX2, double, 4, _mm256_loadu_pd, _mm256_storeu_pd, _mm256_add_pd,
+           _mm256_sub_pd, _mm256_mul_pd, _mm256_div_pd, mapFloatScalar)
+
+static int32_t sumIntSse2(const int32_t* a, const int32_t* b, int32_t count) {
+    __m128i acc = _mm_setzero_si128();
+    int32_t k = 0;
+    for (; k + 4 <= count; k += 4) {
+        __m128i x = LOAD_I128(a + k);
+        acc = _mm_add_epi32(acc, b ? mulloSse2(x, LOAD_I128(b + k)) : x);
+    }
+    int32_t lanes[4];
+    STORE_I128(lanes, acc);
+    int32_t sum = intAdd(intAdd(lanes[0], lanes[1]), intAdd(lanes[2], lanes[3]));
+    return intAdd(sum, sumIntScalar(a + k, b ? b + k : NULL, count - k));
+}
+
+static TARGET_AVX2 int32_t sumIntAvx2(const int32_t* a, const int32_t* b, int32_t count) {
+    __m256i acc = _mm256_setzero_si256();
+    int32_t k = 0;
+    for (; k + 8 <= count; k += 8) {
+        __m256i x = LOAD_I256(a + k);
+        acc = _mm256_add_epi32(acc, b ? _mm256_mullo_epi32(x, LOAD_I256(b + k)) : x);
+    }
+    int32_t lanes[8];
+    STORE_I256(lanes, acc);
+    int32_t sum = 0;
+    for (int lane = 0; lane < 8; lane++) sum = intAdd(sum, lanes[lane]);
+    return intAdd(sum, sumIntScalar(a + k, b ? b + k : NULL, count - k));
+}
+
+// Running sums 0-1, 2-3, 4-5 and 6-7 in four registers
+static double sumFloatSse2(const double* a, const double* b, int32_t count) {
+    __m128d acc[4] = {_mm_setzero_pd(), _mm_setzero_pd(), _mm_setzero_pd(), _mm_setzero_pd()};
+    int32_t k = 0;
+    for (; k + 8 <= count; k += 8) {
+        for (int part = 0; part < 4; part++) {
+            __m128d x = _mm_loadu_pd(a + k + 2 * part);
+            acc[part] = _mm_add_pd(acc[part], b ? _mm_mul_pd(x, _mm_loadu_pd(b + k + 2 * part)) : x);
+        }
+    }
+    double sums[8];
+    for (int part = 0; part < 4; part++) _mm_storeu_pd(sums + 2 * part, acc[part]);
+    return finishSum(sums, a, b, k, count);
+}
+
+// Running sums 0-3 and 4-7 in two registers
+static TARGET_AVX2 double sumFloatAvx2(const double* a, const double* b, int32_t count) {
+    __m256d low = _mm256_setzero_pd(), high = _mm256_setzero_pd();
+    int32_t k = 0;
+    for (; k + 8 <= count; k += 8) {
+        __m256d x = _mm256_loadu_pd(a + k);
+        __m256d y = _mm256_loadu_pd(a + k + 4);
+        if (b) {
+            x = _mm256_mul_pd(x, _mm256_loadu_pd(b + k));
+            y = _mm256_mul_pd(y, _mm256_loadu_pd(b + k + 4));
+        }
+        low = _mm256_add_pd(low, x);
+        high = _mm256_add_pd(high, y);
+    }
+    double sums[8];
+    _mm256_storeu_pd(sums, low);
+    _mm256_storeu_pd(sums + 4, high);
+    return finishSum(sums, a, b, k, count);
+}
+
+#endif // VECTOR_X86
+
+// ---------------------------------------
+// Dispatch
+// ---------------------------------------
+
+void vectorMapInt(VectorOp op, int32_t* dst, const int32_t* left, int32_t leftScalar,
+                  const int32_t* right, int32_t rightScalar, int32_t count) {
+    switch (vectorIsa()) {
+#ifdef VECTOR_X86
+        case VECTOR_ISA_AVX2: mapIntAvx2(op, dst, left, leftScalar, right, rightScalar, count); return;
+        case VECTOR_ISA_SSE2: mapIntSse2(op, dst, left, leftScalar, right, rightScalar, count); return;
+#endif
+        default: mapIntScalar(op, dst, left, leftScalar, right, rightScalar, count); return;
+    }
+}
+
+void vectorMapFloat(VectorOp op, double* dst, const double* left, double leftScalar,
+                    const double* right, double rightScalar, int32_t count) {
+    switch (vectorIsa()) {
+#ifdef VECTOR_X86
+        case VECTOR_ISA_AVX2: mapFloatAvx2(op, dst, left, leftScalar, right, rightScalar, count); return;
+        case VECTOR_ISA_SSE2: mapFloatSse2(op, dst, left, leftScalar, right, rightScalar, count); return;
+#endif
+        default: mapFloatScalar(op, dst, left, leftScalar, right, rightScalar, count); return;
+    }
+}
+
+int32_t vectorSumInt(const int32_t* a, const int32_t* b, int32_t count) {
+    switch (vectorIsa()) {
+#ifdef VECTOR_X86
+        case VECTOR_ISA_AVX2: return sumIntAvx2(a, b, count);
+        case VECTOR_ISA_SSE2: return sumIntSse2(a, b, count);
+#endif
+        default: return sumIntScalar(a, b, count);
+    }
+}
+
+double vectorSumFloat(const double* a, const double* b, int32_t count) {
+    switch (vectorIsa()) {
+#ifdef VECTOR_X86
+        case VECTOR_ISA_AVX2: return sumFloatAvx2(a, b, count);
+        case VECTOR_ISA_SSE2: return sumFloatSse2(a, b, count);
+#endif
+        default: return sumFloatScalar(a, b, count);
+    }
+}
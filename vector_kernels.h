@@ -0,0 +1,51 @@
+#ifndef VECTOR_KERNELS_H
+#define VECTOR_KERNELS_H
+
+#include <stdint.h>
+
+// Whole-loop kernels behind vectorized array loops (see vectorizeLoops() in
+// loop_vectorizer.h). Each runs `count` iterations with SSE2 or AVX2, picked once per
+// process from what the CPU supports, and finishes the remainder in scalar
+// code.
+//
+// Results match the interpreter's scalar loop exactly except for float sums:
+// int arithmetic wraps in every lane as it does in arithmetic.h, and an
+// element-wise float operation is one IEEE operation per element in either
+// form. A float sum or dot product instead keeps 8 running sums, where sum k
+// takes elements k, k + 8, k + 16, ... in order. The sums combine as
+// ((s0 + s4) + (s2 + s6)) + ((s1 + s5) + (s3 + s7)), and then the last
+// count % 8 elements are added in order. This order is the same on every
+// instruction set, so a program prints the same digits everywhere. It
+// differs from strict left-to-right addition by at most the usual
+// reassociation error, about count * 2^-53 * sum(|x|).
+typedef enum {
+    VECTOR_ADD,
+    VECTOR_SUB,
+    VECTOR_MUL,
+    VECTOR_DIV,        // Float only
+    VECTOR_COPY,       // dst = left
+} VectorOp;
+
+typedef enum {
+    VECTOR_ISA_SCALAR,
+    VECTOR_ISA_SSE2,
+    VECTOR_ISA_AVX2,
+} VectorIsa;
+
+extern int vectorIsaLimit; // Highest VectorIsa to use (default AVX2); lower it to compare
+
+VectorIsa vectorIsa(void);            // What the kernels run with: supported and within the limit
+const char* vectorIsaName(VectorIsa isa);
+
+// dst[k] = left[k] op right[k] for k < count. A NULL left or right stands for
+// its scalar in every lane; dst may be left or right (in place).
+void vectorMapInt(VectorOp op, int32_t* dst, const int32_t* left, int32_t leftScalar,
+                  const int32_t* right, int32_t rightScalar, int32_t count);
+void vectorMapFloat(VectorOp op, double* dst, const double* left, double leftScalar,
+                    const double* right, double rightScalar, int32_t count);
+
+// Sum of a[k] (b NULL) or of a[k] * b[k] for k < count
+int32_t vectorSumInt(const int32_t* a, const int32_t* b, int32_t count);   // Wraps; exact in any order
+double vectorSumFloat(const double* a, const double* b, int32_t count);    // In the order described above
+
+#endif // VECTOR_KERNELS_H
@@ -0,0 +1,744 @@
+#include "vm.h"
+#include <stdlib.h>
+#include <string.h>
+#include "arithmetic.h"
+#include "symbol_table.h"
+#include "jit.h"
+#include "benchmark.h"
+#include "value.h"
+#include "format.h"
+#include "input_reader.h"
+#include "vector_kernels.h"
+
+// Strings read by input() live until the run ends
+typedef struct {
+    char** items;
+    int count;
+    int capacity;
+} StringPool;
+
+static char* keepString(StringPool* pool, const char* text) {
+    if (pool->count == pool->capacity) {
+        pool->capacity = pool->capacity ? pool->capacity * 2 : 8;
+        pool->items = (char**)realloc(pool->items, (size_t)pool->capacity * sizeof(char*));
+        if (!pool->items) {
+            fprintf(stderr, "Error: Memory allocation failed for input strings.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    size_t length = strlen(text) + 1;
+    char* copy = (char*)malloc(length);
+    if (!copy) {
+        fprintf(stderr, "Error: Memory allocation failed for input strings.\n");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(copy, text, length);
+    pool->items[pool->count++] = copy;
+    return copy;
+}
+
+// ---------------------------------------
+// printf and input
+// ---------------------------------------
+
+// printf output collects here and reaches the FILE in large writes: before
+// input() waits, before a runtime error is reported and when the run ends
+typedef struct {
+    FILE* file;
+    char* data;
+    size_t length;
+} OutputBuffer;
+
+#define VM_OUTPUT_BUFFER (1 << 16)
+
+static void flushOutput(OutputBuffer* out) {
+    if (out->length) fwrite(out->data, 1, out->length, out->file);
+    out->length = 0;
+}
+
+// Function to make room for `size` bytes (size <= VM_OUTPUT_BUFFER) and return where they go
+static char* reserveOutput(OutputBuffer* out, size_t size) {
+    if (out->length + size > VM_OUTPUT_BUFFER) flushOutput(out);
+    return out->data + out->length;
+}
+
+static void writeOutput(OutputBuffer* out, const char* text, size_t length) {
+    if (length > VM_OUTPUT_BUFFER / 2) {
+        flushOutput(out);
+        fwrite(text, 1, length, out->file);
+        return;
+    }
+    memcpy(reserveOutput(out, length), text, length);
+    out->length += length;
+}
+
+// Function to box register `value` of static `type`: printf arguments are the one
+// place where values of different types travel together
+static TaggedValue boxRegister(int type, Value value) {
+    switch (type) {
+        case TYPE_FLOAT: return boxFloat(value.f);
+        case TYPE_CHAR: return boxChar(value.i);
+        case TYPE_BOOL: return boxBool(value.i);
+        case TYPE_STRING: return boxString(value.s);
+        default: return boxInt(value.i);
+    }
+}
+
+// Function to print a value the way it reads in source: 3, 2.500000, x, true, text
+static void printNatural(FILE* output, TaggedValue value) {
+    char text[256];
+    switch (valueKind(value)) {
+        case VALUE_FLOAT: fprintf(output, "%f", unboxFloat(value)); break; // Can be longer than `text`
+        case VALUE_CHAR: fputc(unboxInt(value), output); break;
+        default: fputs(valueText(value, text, sizeof(text)), output); break;
+    }
+}
+
+// Function to print one conversion `spec` (e.g. "%5.2f") with `value`, converted
+// to what the conversion expects, as C's printf would need
+static void printConversion(FILE* output, const char* spec, char conversion, TaggedValue value) {
+    int isFloat = valueKind(value) == VALUE_FLOAT;
+    switch (conversion) {
+        case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': case 'c':
+            fprintf(output, spec, isFloat ? (int)unboxFloat(value) : (int)unboxInt(value));
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G':
+            fprintf(output, spec, isFloat ? unboxFloat(value) : (double)unboxInt(value));
+            break;
+        default: {
+            // %s prints any value in its natural form
+            char text[256];
+            fprintf(output, spec, valueText(value, text, sizeof(text)));
+            break;
+        }
+    }
+}
+
+// Function to run a printf whose format was split at compile time (see FormatOp)
+static void printFormatOps(const BytecodeProgram* program, const Value* registers, const FormatOp* op,
+                           OutputBuffer* out) {
+    for (;; op++) {
+        const Value* value = &registers[op->reg];
+        switch (op->kind) {
+            case FORMAT_END:
+                return;
+            case FORMAT_TEXT:
+                if (op->length <= FORMAT_TEXT_PADDING && out->length + FORMAT_TEXT_PADDING <= VM_OUTPUT_BUFFER) {
+                    memcpy(out->data + out->length, program->formatText + op->text, FORMAT_TEXT_PADDING);
+                    out->length += (size_t)op->length;
+                } else {
+                    writeOutput(out, program->formatText + op->text, (size_t)op->length);
+                }
+                break;
+            case FORMAT_INT:
+                out->length += (size_t)formatInt(reserveOutput(out, FORMAT_INT_MAX), value->i);
+                break;
+            case FORMAT_FLOAT:
+                out->length += (size_t)formatFloat(reserveOutput(out, FORMAT_FLOAT_MAX), value->f);
+                break;
+            case FORMAT_CHAR:
+                *reserveOutput(out, 1) = (char)value->i;
+                out->length++;
+                break;
+            case FORMAT_BOOL:
+                if (value->i) writeOutput(out, "true", 4);
+                else writeOutput(out, "false", 5);
+                break;
+            case FORMAT_STRING:
+                if (value->s) writeOutput(out, value->s, strlen(value->s));
+                break;
+            default:
+                // Flags, width or precision: the C library formats it
+                flushOutput(out);
+                printConversion(out->file, program->formatText + op->text, (char)op->length,
+                                boxRegister(program->registerTypes[op->reg], *value));
+                break;
+        }
+    }
+}
+
+// Function to run printf(first, rest...). A string first argument is the format;
+// arguments its conversions do not consume are printed after it.
+static void printArguments(const BytecodeProgram* program, const Value* registers,
+                           const int* arguments, int count, FILE* output) {
+    int next = 0;
+    if (count > 0 && program->registerTypes[arguments[0]] == TYPE_STRING) {
+        const char* format = registers[arguments[0]].s;
+        next = 1;
+        for (const char* p = format ? format : ""; *p; p++) {
+            if (*p != '%') {
+                fputc(*p, output);
+                continue;
+            }
+            if (p[1] == '%') {
+                fputc('%', output);
+                p++;
+                continue;
+            }
+
+            FormatSpec spec;
+            int isConversion = scanFormatSpec(p, &spec);
+            if (!isConversion || next >= count) {
+                if (isConversion) vmFormatMismatches++;
+                fputc('%', output); // Not a conversion, or no argument left: print it as text
+                continue;
+            }
+
+            int reg = arguments[next++];
+            TaggedValue value = boxRegister(program->registerTypes[reg], registers[reg]);
+            if (spec.conversion != 's' && program->registerTypes[reg] == TYPE_STRING) {
+                vmFormatMismatches++;
+                printNatural(output, value); // A string has no number to convert
+            } else {
+                printConversion(output, spec.spec, spec.conversion, value);
+            }
+            p += spec.length - 1;
+        }
+    }
+
+    for (; next < count; next++) {
+        int reg = arguments[next];
+        printNatural(output, boxRegister(program->registerTypes[reg], registers[reg]));
+    }
+}
+
+// Function to run input("prompt %d", &x): show the prompt (the text before the
+// conversion, split off at compile time), then scan the value. Output waits in
+// the buffer unless someone at a terminal has to see the prompt first.
+static int readInput(const char* prompt, int type, Value* target, InputReader* reader, OutputBuffer* out,
+                     StringPool* strings) {
+    if (*prompt) writeOutput(out, prompt, strlen(prompt));
+    if (inputInteractive(reader)) {
+        flushOutput(out);
+        fflush(out->file);
+    }
+
+    char word[256];
+    switch (type) {
+        case TYPE_FLOAT:
+            return readInputFloat(reader, &target->f);
+        case TYPE_CHAR:
+            return readInputChar(reader, &target->i);
+        case TYPE_BOOL:
+            if (!readInputWord(reader, word, sizeof(word))) return 0;
+            target->i = strcmp(word, "true") == 0 || strcmp(word, "1") == 0;
+            return 1;
+        case TYPE_STRING:
+            if (!readInputWord(reader, word, sizeof(word))) return 0;
+            target->s = keepString(strings, word);
+            return 1;
+        default:
+            return readInputInt(reader, &target->i);
+    }
+}
+
+// Function to run a vectorized loop over [i, n): `run` is d, l, r, i, n (l and r arrays or scalars)
+static void runVectorMap(const BytecodeProgram* program, const Value* r, const int* run, int op, int isFloat) {
+    int32_t start = r[run[3]].i;
+    int32_t count = r[run[4]].i - start; // i >= 0 and n is an int, so this cannot overflow
+    if (count <= 0) return;
+    const Value* left = &r[run[1]];
+    const Value* right = &r[run[2]];
+    int leftArray = program->registerTypes[run[1]] == TYPE_ARRAY;
+    int rightArray = program->registerTypes[run[2]] == TYPE_ARRAY;
+    if (isFloat) {
+        vectorMapFloat((VectorOp)op, (double*)r[run[0]].array->data + start,
+                       leftArray ? (const double*)left->array->data + start : NULL, leftArray ? 0.0 : left->f,
+                       rightArray ? (const double*)right->array->data + start : NULL, rightArray ? 0.0 : right->f,
+                       count);
+    } else {
+        vectorMapInt((VectorOp)op, (int32_t*)r[run[0]].array->data + start,
+                     leftArray ? (const int32_t*)left->array->data + start : NULL, leftArray ? 0 : left->i,
+                     rightArray ? (const int32_t*)right->array->data + start : NULL, rightArray ? 0 : right->i,
+                     count);
+    }
+}
+
+// Function to add up a vectorized loop over [i, n): `run` is x, (y,) i, n
+static Value runVectorSum(const Value* r, const int* run, int arrays, int isFloat) {
+    Value result;
+    int32_t start = r[run[arrays]].i;
+    int32_t count = r[run[arrays + 1]].i - start;
+    if (count < 0) count = 0;
+    if (isFloat) {
+        const double* x = (const double*)r[run[0]].array->data + start;
+        result.f = vectorSumFloat(x, arrays == 2 ? (const double*)r[run[1]].array->data + start : NULL, count);
+    } else {
+        const int32_t* x = (const int32_t*)r[run[0]].array->data + start;
+        result.i = vectorSumInt(x, arrays == 2 ? (const int32_t*)r[run[1]].array->data + start : NULL, count);
+    }
+    return result;
+}
+
+// ---------------------------------------
+// Dispatch
+// ---------------------------------------
+
+// GCC and Clang get direct threading: each instruction is decoded once into
+// the address of its handler and every handler jumps straight to the next
+// one. Other compilers, or builds with -DVM_SWITCH_DISPATCH, use a switch.
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(VM_SWITCH_DISPATCH)
+#define VM_THREADED 1
+#endif
+
+// Pseudo-opcodes: hand over to native code, and count a loop header for tiering
+#define VM_JIT_ENTER BC_OPCODE_COUNT
+#define VM_LOOP_HEADER (BC_OPCODE_COUNT + 1)
+
+int vmJit = 0;
+int vmTiered = 0;
+int vmHotLoopThreshold = 1000;
+FILE* vmTierLog = NULL;
+int vmFormatMismatches = 0;
+
+#ifdef VM_THREADED
+typedef const void* VmDispatch;   // Handler address
+#else
+typedef int32_t VmDispatch;       // Opcode
+#endif
+
+typedef struct {
+    VmDispatch dispatch;
+    int32_t a, b, c;
+} VmInstruction;
+
+#ifdef VM_PROFILE
+// Dynamic opcode and opcode-pair counts, used to pick superinstructions
+static uint64_t opcodeCounts[BC_OPCODE_COUNT];
+static uint64_t pairCounts[BC_OPCODE_COUNT][BC_OPCODE_COUNT];
+static int previousOpcode = -1;
+
+static void countDispatch(int opcode) {
+    opcodeCounts[opcode]++;
+    if (previousOpcode >= 0) pairCounts[previousOpcode][opcode]++;
+    previousOpcode = opcode;
+}
+
+void writeVmProfile(FILE* file) {
+    uint64_t total = 0;
+    for (int i = 0; i < BC_OPCODE_COUNT; i++) total += opcodeCounts[i];
+    fprintf(file, "VM profile: %llu instructions dispatched\n", (unsigned long long)total);
+
+    // Print the 16 most frequent pairs, largest first
+    for (int rank = 0; rank < 16; rank++) {
+        int bestFirst = -1, bestSecond = -1;
+        uint64_t best = 0;
+        for (int i = 0; i < BC_OPCODE_COUNT; i++) {
+            for (int j = 0; j < BC_OPCODE_COUNT; j++) {
+                if (pairCounts[i][j] > best) {
+                    best = pairCounts[i][j];
+                    bestFirst = i;
+                    bestSecond = j;
+                }
+            }
+        }
+        if (bestFirst < 0) break;
+        fprintf(file, "  %5.1f%%  %-16s -> %s\n", 100.0 * (double)best / (double)(total ? total : 1),
+                bytecodeOpcodeName(bestFirst), bytecodeOpcodeName(bestSecond));
+        pairCounts[bestFirst][bestSecond] = 0;
+    }
+    memset(opcodeCounts, 0, sizeof(opcodeCounts));
+    memset(pairCounts, 0, sizeof(pairCounts));
+    previousOpcode = -1;
+}
+
+#define PROFILE_DISPATCH() countDispatch(program->code[in - code].opcode)
+#else
+#define PROFILE_DISPATCH() ((void)0)
+#endif
+
+#ifdef VM_THREADED
+#define VM_CASE(opcode) op_##opcode
+#define VM_NEXT() do { in = ip++; PROFILE_DISPATCH(); goto *in->dispatch; } while (0)
+#define VM_DISPATCH(target) goto *(target)
+#else
+#define VM_CASE(opcode) case opcode
+#define VM_NEXT() break
+#define VM_DISPATCH(target) do { dispatch = (target); goto redispatch; } while (0)
+#endif
+
+// ---------------------------------------
+// Tiering
+// ---------------------------------------
+
+// Every program starts interpreted. Each loop header (the target of a backward
+// jump) counts its visits; at vmHotLoopThreshold the program is compiled once
+// and the loop continues in native code from its header with the current
+// registers (on-stack replacement). Native code then runs on through the rest
+// of the program, so the first hot loop is where a long run reaches full speed.
+typedef struct {
+    int* loopEnd;            // Per instruction: last back-edge into it when it is a loop header, else -1
+    int* visits;
+    VmInstruction* original; // Instructions as decoded, before headers were marked
+    int loops;
+    int promoted;
+    int compiled;            // compileJit has been tried
+    double start;
+} Tiering;
+
+static void startTiering(Tiering* tiering, const BytecodeProgram* program, VmInstruction* code,
+                         VmDispatch loopHeader) {
+    int count = program->codeCount > 0 ? program->codeCount : 1;
+    tiering->loopEnd = (int*)malloc((size_t)count * sizeof(int));
+    tiering->visits = (int*)calloc((size_t)count, sizeof(int));
+    tiering->original = (VmInstruction*)malloc((size_t)count * sizeof(VmInstruction));
+    if (!tiering->loopEnd || !tiering->visits || !tiering->original) {
+        fprintf(stderr, "Error: Memory allocation failed for VM tiering.\n");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(tiering->original, code, (size_t)program->codeCount * sizeof(VmInstruction));
+    tiering->loops = tiering->promoted = tiering->compiled = 0;
+    tiering->start = benchmarkNow();
+
+    for (int pc = 0; pc < program->codeCount; pc++) tiering->loopEnd[pc] = -1;
+    for (int pc = 0; pc < program->codeCount; pc++) {
+        BytecodeInstruction in = program->code[pc];
+        int32_t* target = bytecodeJumpTarget(&in);
+        if (target && *target <= pc && pc > tiering->loopEnd[*target]) tiering->loopEnd[*target] = pc;
+    }
+    for (int pc = 0; pc < program->codeCount; pc++) {
+        if (tiering->loopEnd[pc] < 0) continue;
+        code[pc].dispatch = loopHeader;
+        tiering->loops++;
+    }
+}
+
+// Function to promote the hot loop at `header`: compile the program if needed and
+// let every covered stretch of the loop enter native code. Afterwards the header
+// dispatches to native code or, when it cannot, to its own instruction again.
+static void tierUp(Tiering* tiering, const BytecodeProgram* program, VmInstruction* code, JitCode** jit,
+                   int header, VmDispatch jitEnter) {
+    double now = (benchmarkNow() - tiering->start) * 1e3;
+    if (!tiering->compiled) {
+        tiering->compiled = 1;
+        double start = benchmarkNow();
+        *jit = compileJit(program);
+        if (vmTierLog && *jit) {
+            fprintf(vmTierLog, "%9.3f ms  compile: %d instructions -> %d bytes of x86-64, %d pinned registers, %.3f ms\n",
+                    now, program->codeCount, jitCodeSize(*jit), jitPinnedRegisters(*jit),
+                    (benchmarkNow() - start) * 1e3);
+        }
+    }
+
+    if (!*jit) {
+        // No native tier here: stop counting every loop
+        if (vmTierLog) fprintf(vmTierLog, "%9.3f ms  no native tier on this platform; interpreting\n", now);
+        for (int pc = 0; pc < program->codeCount; pc++) {
+            if (tiering->loopEnd[pc] >= 0) code[pc].dispatch = tiering->original[pc].dispatch;
+        }
+        return;
+    }
+
+    int entries = 0;
+    for (int pc = header; pc <= tiering->loopEnd[header]; pc++) {
+        if (jitCovers(*jit, pc) && (pc == header || !jitCovers(*jit, pc - 1))) {
+            code[pc].dispatch = jitEnter;
+            entries++;
+        }
+    }
+    if (!jitCovers(*jit, header)) code[header].dispatch = tiering->original[header].dispatch;
+    tiering->promoted++;
+    if (vmTierLog) {
+        fprintf(vmTierLog, "%9.3f ms  tier-up: loop %d..%d after %d back-edges, %d native entries, %s\n",
+                now, header, tiering->loopEnd[header], tiering->visits[header], entries,
+                jitCovers(*jit, header) ? "entering native code at the header (OSR)"
+                                        : "header stays interpreted (not compiled)");
+    }
+}
+
+static void finishTiering(Tiering* tiering) {
+    if (vmTierLog) {
+        fprintf(vmTierLog, "%9.3f ms  finished: %d of %d loops promoted\n",
+                (benchmarkNow() - tiering->start) * 1e3, tiering->promoted, tiering->loops);
+    }
+    free(tiering->loopEnd);
+    free(tiering->visits);
+    free(tiering->original);
+}
+
+// ---------------------------------------
+// Interpreter
+// ---------------------------------------
+
+int runBytecode(const BytecodeProgram* program, FILE* input, FILE* output) {
+#ifdef VM_THREADED
+    static const void* const handlers[BC_OPCODE_COUNT + 2] = {
+        [BC_LOAD_INT] = &&op_BC_LOAD_INT, [BC_LOAD_FLOAT] = &&op_BC_LOAD_FLOAT,
+        [BC_LOAD_STRING] = &&op_BC_LOAD_STRING, [BC_MOVE] = &&op_BC_MOVE,
+        [BC_INT_TO_FLOAT] = &&op_BC_INT_TO_FLOAT,
+        [BC_ADD_I] = &&op_BC_ADD_I, [BC_SUB_I] = &&op_BC_SUB_I, [BC_MUL_I] = &&op_BC_MUL_I,
+        [BC_FLOOR_DIV_I] = &&op_BC_FLOOR_DIV_I, [BC_MOD_I] = &&op_BC_MOD_I, [BC_POW_I] = &&op_BC_POW_I,
+        [BC_ADD_F] = &&op_BC_ADD_F, [BC_SUB_F] = &&op_BC_SUB_F, [BC_MUL_F] = &&op_BC_MUL_F,
+        [BC_DIV_F] = &&op_BC_DIV_F, [BC_POW_F] = &&op_BC_POW_F,
+        [BC_EQ_I] = &&op_BC_EQ_I, [BC_NE_I] = &&op_BC_NE_I, [BC_LT_I] = &&op_BC_LT_I,
+        [BC_LE_I] = &&op_BC_LE_I, [BC_GT_I] = &&op_BC_GT_I, [BC_GE_I] = &&op_BC_GE_I,
+        [BC_EQ_F] = &&op_BC_EQ_F, [BC_NE_F] = &&op_BC_NE_F, [BC_LT_F] = &&op_BC_LT_F,
+        [BC_LE_F] = &&op_BC_LE_F, [BC_GT_F] = &&op_BC_GT_F, [BC_GE_F] = &&op_BC_GE_F,
+        [BC_EQ_S] = &&op_BC_EQ_S, [BC_NE_S] = &&op_BC_NE_S, [BC_HASH_S] = &&op_BC_HASH_S,
+        [BC_NOT] = &&op_BC_NOT,
+        [BC_JUMP] = &&op_BC_JUMP, [BC_JUMP_IF_TRUE] = &&op_BC_JUMP_IF_TRUE,
+        [BC_JUMP_IF_FALSE] = &&op_BC_JUMP_IF_FALSE, [BC_SWITCH] = &&op_BC_SWITCH,
+        [BC_INPUT] = &&op_BC_INPUT, [BC_PRINT] = &&op_BC_PRINT, [BC_RETURN] = &&op_BC_RETURN,
+        [BC_NEW_ARRAY_I] = &&op_BC_NEW_ARRAY_I, [BC_NEW_ARRAY_F] = &&op_BC_NEW_ARRAY_F,
+        [BC_NEW_ARRAY_B] = &&op_BC_NEW_ARRAY_B, [BC_ARRAY_LENGTH] = &&op_BC_ARRAY_LENGTH,
+        [BC_CHECK_INDEX] = &&op_BC_CHECK_INDEX,
+        [BC_LOAD_ELEMENT_I] = &&op_BC_LOAD_ELEMENT_I, [BC_LOAD_ELEMENT_F] = &&op_BC_LOAD_ELEMENT_F,
+        [BC_LOAD_ELEMENT_B] = &&op_BC_LOAD_ELEMENT_B, [BC_STORE_ELEMENT_I] = &&op_BC_STORE_ELEMENT_I,
+        [BC_STORE_ELEMENT_F] = &&op_BC_STORE_ELEMENT_F, [BC_STORE_ELEMENT_B] = &&op_BC_STORE_ELEMENT_B,
+        [BC_MAX_I] = &&op_BC_MAX_I, [BC_VECTOR_MAP_I] = &&op_BC_VECTOR_MAP_I,
+        [BC_VECTOR_MAP_F] = &&op_BC_VECTOR_MAP_F, [BC_VECTOR_SUM_I] = &&op_BC_VECTOR_SUM_I,
+        [BC_VECTOR_SUM_F] = &&op_BC_VECTOR_SUM_F,
+        [BC_ADD_IK] = &&op_BC_ADD_IK, [BC_MUL_IK] = &&op_BC_MUL_IK,
+        [BC_FLOOR_DIV_IK] = &&op_BC_FLOOR_DIV_IK, [BC_MOD_IK] = &&op_BC_MOD_IK,
+        [BC_BRANCH_EQ_I] = &&op_BC_BRANCH_EQ_I, [BC_BRANCH_NE_I] = &&op_BC_BRANCH_NE_I,
+        [BC_BRANCH_LT_I] = &&op_BC_BRANCH_LT_I, [BC_BRANCH_LE_I] = &&op_BC_BRANCH_LE_I,
+        [BC_BRANCH_GT_I] = &&op_BC_BRANCH_GT_I, [BC_BRANCH_GE_I] = &&op_BC_BRANCH_GE_I,
+        [BC_BRANCH_EQ_IK] = &&op_BC_BRANCH_EQ_IK, [BC_BRANCH_NE_IK] = &&op_BC_BRANCH_NE_IK,
+        [BC_BRANCH_LT_IK] = &&op_BC_BRANCH_LT_IK, [BC_BRANCH_LE_IK] = &&op_BC_BRANCH_LE_IK,
+        [BC_BRANCH_GT_IK] = &&op_BC_BRANCH_GT_IK, [BC_BRANCH_GE_IK] = &&op_BC_BRANCH_GE_IK,
+        [VM_JIT_ENTER] = &&op_VM_JIT_ENTER, [VM_LOOP_HEADER] = &&op_VM_LOOP_HEADER,
+    };
+#define VM_DISPATCH_OF(opcode) handlers[opcode]
+#else
+#define VM_DISPATCH_OF(opcode) (opcode)
+#endif
+
+    Value* r = (Value*)calloc(program->registerCount > 0 ? (size_t)program->registerCount : 1, sizeof(Value));
+    VmInstruction* code = (VmInstruction*)malloc((program->codeCount > 0 ? (size_t)program->codeCount : 1) *
+                                                 sizeof(VmInstruction));
+    if (!r || !code) {
+        fprintf(stderr, "Error: Memory allocation failed for VM registers.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // Decode once: opcodes become handler addresses when threading
+    for (int pc = 0; pc < program->codeCount; pc++) {
+        const BytecodeInstruction* from = &program->code[pc];
+        code[pc].dispatch = VM_DISPATCH_OF(from->opcode);
+        code[pc].a = from->a;
+        code[pc].b = from->b;
+        code[pc].c = from->c;
+    }
+
+    // The interpreter only runs what native code leaves to it, so it can reach
+    // covered code at the start and after an uncovered instruction
+    JitCode* jit = vmJit ? compileJit(program) : NULL;
+    for (int pc = 0; jit && pc < program->codeCount; pc++) {
+        if (jitCovers(jit, pc) && (pc == 0 || !jitCovers(jit, pc - 1))) {
+            code[pc].dispatch = VM_DISPATCH_OF(VM_JIT_ENTER);
+        }
+    }
+
+    Tiering tiering = {NULL, NULL, NULL, 0, 0, 0, 0.0};
+    int tiered = vmTiered && !vmJit;
+    if (tiered) startTiering(&tiering, program, code, VM_DISPATCH_OF(VM_LOOP_HEADER));
+
+    const double* floats = program->floats;
+    StringPool strings = {NULL, 0, 0};
+    InputReader* reader = NULL; // Opened by the first input()
+    OutputBuffer out = {output, (char*)malloc(VM_OUTPUT_BUFFER), 0};
+    if (!out.data) {
+        fprintf(stderr, "Error: Memory allocation failed for VM output.\n");
+        exit(EXIT_FAILURE);
+    }
+    int status = 0;
+    vmFormatMismatches = 0;
+    const VmInstruction* ip = code;
+    const VmInstruction* in;
+
+#ifdef VM_THREADED
+    VM_NEXT();
+#else
+    for (;;) {
+        in = ip++;
+        PROFILE_DISPATCH();
+        VmDispatch dispatch = in->dispatch;
+    redispatch:
+        switch (dispatch) {
+#endif
+            VM_CASE(BC_LOAD_INT): r[in->a].i = in->b; VM_NEXT();
+            VM_CASE(BC_LOAD_FLOAT): r[in->a].f = floats[in->b]; VM_NEXT();
+            VM_CASE(BC_LOAD_STRING): r[in->a].s = program->strings[in->b]; VM_NEXT();
+            VM_CASE(BC_MOVE): r[in->a] = r[in->b]; VM_NEXT();
+            VM_CASE(BC_INT_TO_FLOAT): r[in->a].f = (double)r[in->b].i; VM_NEXT();
+
+            VM_CASE(BC_ADD_I): r[in->a].i = intAdd(r[in->b].i, r[in->c].i); VM_NEXT();
+            VM_CASE(BC_SUB_I): r[in->a].i = intSub(r[in->b].i, r[in->c].i); VM_NEXT();
+            VM_CASE(BC_MUL_I): r[in->a].i = intMul(r[in->b].i, r[in->c].i); VM_NEXT();
+            VM_CASE(BC_FLOOR_DIV_I):
+                if (r[in->c].i == 0) goto divisionByZero;
+                r[in->a].i = intFloorDiv(r[in->b].i, r[in->c].i);
+                VM_NEXT();
+            VM_CASE(BC_MOD_I):
+                if (r[in->c].i == 0) goto divisionByZero;
+                r[in->a].i = intMod(r[in->b].i, r[in->c].i);
+                VM_NEXT();
+            VM_CASE(BC_POW_I): r[in->a].i = intPow(r[in->b].i, r[in->c].i); VM_NEXT();
+
+            VM_CASE(BC_ADD_F): r[in->a].f = r[in->b].f + r[in->c].f; VM_NEXT();
+            VM_CASE(BC_SUB_F): r[in->a].f = r[in->b].f - r[in->c].f; VM_NEXT();
+            VM_CASE(BC_MUL_F): r[in->a].f = r[in->b].f * r[in->c].f; VM_NEXT();
+            VM_CASE(BC_DIV_F): r[in->a].f = r[in->b].f / r[in->c].f; VM_NEXT();
+            VM_CASE(BC_POW_F): r[in->a].f = floatPow(r[in->b].f, r[in->c].i); VM_NEXT();
+
+            VM_CASE(BC_EQ_I): r[in->a].i = r[in->b].i == r[in->c].i; VM_NEXT();
+            VM_CASE(BC_NE_I): r[in->a].i = r[in->b].i != r[in->c].i; VM_NEXT();
+            VM_CASE(BC_LT_I): r[in->a].i = r[in->b].i < r[in->c].i; VM_NEXT();
+            VM_CASE(BC_LE_I): r[in->a].i = r[in->b].i <= r[in->c].i; VM_NEXT();
+            VM_CASE(BC_GT_I): r[in->a].i = r[in->b].i > r[in->c].i; VM_NEXT();
+            VM_CASE(BC_GE_I): r[in->a].i = r[in->b].i >= r[in->c].i; VM_NEXT();
+            VM_CASE(BC_EQ_F): r[in->a].i = r[in->b].f == r[in->c].f; VM_NEXT();
+            VM_CASE(BC_NE_F): r[in->a].i = r[in->b].f != r[in->c].f; VM_NEXT();
+            VM_CASE(BC_LT_F): r[in->a].i = r[in->b].f < r[in->c].f; VM_NEXT();
+            VM_CASE(BC_LE_F): r[in->a].i = r[in->b].f <= r[in->c].f; VM_NEXT();
+            VM_CASE(BC_GT_F): r[in->a].i = r[in->b].f > r[in->c].f; VM_NEXT();
+            VM_CASE(BC_GE_F): r[in->a].i = r[in->b].f >= r[in->c].f; VM_NEXT();
+            VM_CASE(BC_EQ_S): r[in->a].i = strcmp(r[in->b].s, r[in->c].s) == 0; VM_NEXT();
+            VM_CASE(BC_NE_S): r[in->a].i = strcmp(r[in->b].s, r[in->c].s) != 0; VM_NEXT();
+            VM_CASE(BC_HASH_S): r[in->a].i = (int32_t)(stringHash(r[in->b].s) & (uint32_t)in->c); VM_NEXT();
+            VM_CASE(BC_NOT): r[in->a].i = !r[in->b].i; VM_NEXT();
+
+            VM_CASE(BC_JUMP): ip = code + in->a; VM_NEXT();
+            VM_CASE(BC_JUMP_IF_TRUE): if (r[in->a].i) ip = code + in->b; VM_NEXT();
+            VM_CASE(BC_JUMP_IF_FALSE): if (!r[in->a].i) ip = code + in->b; VM_NEXT();
+            VM_CASE(BC_SWITCH): {
+                const int* table = &program->jumpTables[in->c];
+                uint32_t entry = (uint32_t)r[in->a].i - (uint32_t)in->b;
+                ip = code + (entry < (uint32_t)table[0] ? table[2 + entry] : table[1]);
+                VM_NEXT();
+            }
+
+            VM_CASE(BC_INPUT):
+                if (!reader) reader = openInputReader(input);
+                if (!readInput(program->strings[in->b], in->c, &r[in->a], reader, &out, &strings)) {
+                    flushOutput(&out);
+                    fflush(output);
+                    printf("Runtime Error: Expected a %s value for input.\n", symbolTypeName((SymbolType)in->c));
+                    status = 1;
+                    goto done;
+                }
+                VM_NEXT();
+            VM_CASE(BC_PRINT):
+                if (in->c >= 0) {
+                    printFormatOps(program, r, &program->formatOps[in->c], &out);
+                } else {
+                    flushOutput(&out);
+                    printArguments(program, r, &program->arguments[in->a], in->b, output);
+                }
+                VM_NEXT();
+
+            VM_CASE(BC_RETURN):
+                goto done;
+
+            VM_CASE(BC_NEW_ARRAY_I):
+            VM_CASE(BC_NEW_ARRAY_F):
+            VM_CASE(BC_NEW_ARRAY_B): {
+                // A declaration run again (in a loop) replaces the array it made last time
+                static const int elementSizes[] = {sizeof(int32_t), sizeof(double), sizeof(uint8_t)};
+                int32_t rows = r[in->b].i, columns = in->c >= 0 ? r[in->c].i : 1;
+                TypedArray* array = newTypedArray(rows, columns, elementSizes[program->code[in - code].opcode - BC_NEW_ARRAY_I]);
+                if (!array) {
+                    flushOutput(&out);
+                    fflush(output);
+                    int64_t length = (int64_t)rows * columns;
+                    printf("Runtime Error: Array length %lld is invalid.\n",
+                           (long long)(rows < 0 ? rows : columns < 0 ? columns : length));
+                    status = 1;
+                    goto done;
+                }
+                freeTypedArray(r[in->a].array);
+                r[in->a].array = array;
+                VM_NEXT();
+            }
+            VM_CASE(BC_ARRAY_LENGTH): r[in->a].i = r[in->b].array->dims[in->c]; VM_NEXT();
+            VM_CASE(BC_CHECK_INDEX): {
+                int32_t length = r[in->a].array->dims[in->c];
+                if ((uint32_t)r[in->b].i >= (uint32_t)length) {
+                    flushOutput(&out);
+                    fflush(output);
+                    printf("Runtime Error: Array index %d is out of bounds for length %d.\n", r[in->b].i, length);
+                    status = 1;
+                    goto done;
+                }
+                VM_NEXT();
+            }
+            VM_CASE(BC_LOAD_ELEMENT_I): r[in->a].i = ((const int32_t*)r[in->b].array->data)[r[in->c].i]; VM_NEXT();
+            VM_CASE(BC_LOAD_ELEMENT_F): r[in->a].f = ((const double*)r[in->b].array->data)[r[in->c].i]; VM_NEXT();
+            VM_CASE(BC_LOAD_ELEMENT_B): r[in->a].i = ((const uint8_t*)r[in->b].array->data)[r[in->c].i]; VM_NEXT();
+            VM_CASE(BC_STORE_ELEMENT_I): ((int32_t*)r[in->a].array->data)[r[in->b].i] = r[in->c].i; VM_NEXT();
+            VM_CASE(BC_STORE_ELEMENT_F): ((double*)r[in->a].array->data)[r[in->b].i] = r[in->c].f; VM_NEXT();
+            VM_CASE(BC_STORE_ELEMENT_B): ((uint8_t*)r[in->a].array->data)[r[in->b].i] = (uint8_t)r[in->c].i; VM_NEXT();
+
+            VM_CASE(BC_MAX_I): r[in->a].i = r[in->b].i > r[in->c].i ? r[in->b].i : r[in->c].i; VM_NEXT();
+            VM_CASE(BC_VECTOR_MAP_I): runVectorMap(program, r, &program->arguments[in->a], in->b, 0); VM_NEXT();
+            VM_CASE(BC_VECTOR_MAP_F): runVectorMap(program, r, &program->arguments[in->a], in->b, 1); VM_NEXT();
+            VM_CASE(BC_VECTOR_SUM_I): r[in->a] = runVectorSum(r, &program->arguments[in->b], in->c, 0); VM_NEXT();
+            VM_CASE(BC_VECTOR_SUM_F): r[in->a] = runVectorSum(r, &program->arguments[in->b], in->c, 1); VM_NEXT();
+
+            VM_CASE(BC_ADD_IK): r[in->a].i = intAdd(r[in->b].i, in->c); VM_NEXT();
+            VM_CASE(BC_MUL_IK): r[in->a].i = intMul(r[in->b].i, in->c); VM_NEXT();
+            VM_CASE(BC_FLOOR_DIV_IK): r[in->a].i = intFloorDiv(r[in->b].i, in->c); VM_NEXT();
+            VM_CASE(BC_MOD_IK): r[in->a].i = intMod(r[in->b].i, in->c); VM_NEXT();
+
+            VM_CASE(BC_BRANCH_EQ_I): if (r[in->a].i == r[in->b].i) ip = code + in->c; VM_NEXT();
+            VM_CASE(BC_BRANCH_NE_I): if (r[in->a].i != r[in->b].i) ip = code + in->c; VM_NEXT();
+            VM_CASE(BC_BRANCH_LT_I): if (r[in->a].i < r[in->b].i) ip = code + in->c; VM_NEXT();
+            VM_CASE(BC_BRANCH_LE_I): if (r[in->a].i <= r[in->b].i) ip = code + in->c; VM_NEXT();
+            VM_CASE(BC_BRANCH_GT_I): if (r[in->a].i > r[in->b].i) ip = code + in->c; VM_NEXT();
+            VM_CASE(BC_BRANCH_GE_I): if (r[in->a].i >= r[in->b].i) ip = code + in->c; VM_NEXT();
+            VM_CASE(BC_BRANCH_EQ_IK): if (r[in->a].i == in->b) ip = code + in->c; VM_NEXT();
+            VM_CASE(BC_BRANCH_NE_IK): if (r[in->a].i != in->b) ip = code + in->c; VM_NEXT();
+            VM_CASE(BC_BRANCH_LT_IK): if (r[in->a].i < in->b) ip = code + in->c; VM_NEXT();
+            VM_CASE(BC_BRANCH_LE_IK): if (r[in->a].i <= in->b) ip = code + in->c; VM_NEXT();
+            VM_CASE(BC_BRANCH_GT_IK): if (r[in->a].i > in->b) ip = code + in->c; VM_NEXT();
+            VM_CASE(BC_BRANCH_GE_IK): if (r[in->a].i >= in->b) ip = code + in->c; VM_NEXT();
+
+            VM_CASE(VM_JIT_ENTER): {
+                int32_t next = runJit(jit, r, (int)(in - code));
+                if (next < 0) {
+                    in = code + ~next;
+                    goto divisionByZero;
+                }
+                ip = code + next;
+                VM_NEXT();
+            }
+            VM_CASE(VM_LOOP_HEADER): {
+                int pc = (int)(in - code);
+                if (++tiering.visits[pc] >= vmHotLoopThreshold) {
+                    tierUp(&tiering, program, code, &jit, pc, VM_DISPATCH_OF(VM_JIT_ENTER));
+                    VM_DISPATCH(in->dispatch);
+                }
+                VM_DISPATCH(tiering.original[pc].dispatch);
+            }
+#ifndef VM_THREADED
+            default:
+                goto done;
+        }
+    }
+#endif
+
+divisionByZero:
+    flushOutput(&out);
+    fflush(output);
+    printf("Runtime Error: Integer %s by zero.\n",
+           program->code[in - code].opcode == BC_FLOOR_DIV_I ? "division" : "modulo");
+    status = 1;
+
+done:
+    flushOutput(&out);
+    fflush(output);
+    if (tiered) finishTiering(&tiering);
+    freeJit(jit);
+    for (int i = 0; i < strings.count; i++) {
+        free(strings.items[i]);
+    }
+    free(strings.items);
+    for (int i = 0; i < program->registerCount; i++) {
+        if (program->registerTypes[i] == TYPE_ARRAY) freeTypedArray(r[i].array);
+    }
+    closeInputReader(reader);
+    free(out.data);
+    free(code);
+    free(r);
+    return status;
+}
@@ -0,0 +1,41 @@
+#ifndef VM_H
+#define VM_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "bytecode.h"
+#include "value.h"
+
+// One register. The bytecode's opcodes know which member is live.
+typedef union {
+    int32_t i;      // int, char (its code) and bool (0 or 1)
+    double f;       // float
+    const char* s;  // string
+    TypedArray* array;
+} Value;
+
+extern int vmJit; // Non-zero: run what jit.c covers as native code (x86-64 Linux only)
+
+// Tiered execution (ignored with vmJit): interpret, and compile once a loop
+// header has been reached vmHotLoopThreshold times, switching to native code
+// in the middle of that loop. Tier-up events go to vmTierLog when it is set.
+extern int vmTiered;
+extern int vmHotLoopThreshold;
+extern FILE* vmTierLog;
+
+// printf conversions of the last run whose format was only known at run time and
+// that had no argument left or a string for a numeric conversion (the string is
+// printed as it is). Formats known at compile time count in formatMismatches.
+extern int vmFormatMismatches;
+
+// Execute a compiled program: `input` feeds input(), `output` receives printf().
+// Returns 0 when the program returns, 1 after a runtime error (reported on stdout).
+int runBytecode(const BytecodeProgram* program, FILE* input, FILE* output);
+
+#ifdef VM_PROFILE
+// Print the most frequent dynamic opcode pairs since the last call, then reset the counts.
+// Only in builds with -DVM_PROFILE.
+void writeVmProfile(FILE* file);
+#endif
+
+#endif // VM_H